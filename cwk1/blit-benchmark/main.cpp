@@ -4,6 +4,12 @@
 #include <cstring>
 #include "../draw2d/image.hpp"
 #include "../draw2d/surface.hpp"
+#include "../draw2d/blit.hpp"
+#include "../draw2d/mipmap.hpp"
+#include "../draw2d/image_cache.hpp"
+#include "../draw2d/image_view.hpp"
+
+#include "../vmlib/mat22.hpp"
 
 // Forward declaration of the blit_masked function.
 void blit_masked(Surface& aSurface, ImageRGBA const& aImage, Vec2f aPosition);
@@ -19,8 +25,9 @@ void blit_no_alpha_loops_(benchmark::State& aState, const std::string& image_pat
     Surface surface(fb_width, fb_height);
     surface.clear();
 
-    // Load the source image from the provided image path.
-    auto source = load_image(image_path.c_str());
+    // Load the source image from the provided image path (through the
+    // decoded-image cache, so that setup does not decode the PNG each run).
+    auto source = load_image_cached(image_path.c_str());
 
     // Ensure that the image was loaded successfully.
     assert(source);
@@ -69,8 +76,9 @@ void blit_no_alpha_memcpy_(benchmark::State& aState, const std::string& image_pa
     Surface surface(fb_width, fb_height);
     surface.clear();
 
-    // Load the source image from the provided image path.
-    auto source = load_image(image_path.c_str());
+    // Load the source image from the provided image path (through the
+    // decoded-image cache, so that setup does not decode the PNG each run).
+    auto source = load_image_cached(image_path.c_str());
 
     // Ensure that the image was loaded successfully.
     assert(source);
@@ -122,7 +130,7 @@ void benchmark_blit_masked(benchmark::State& aState, const std::string& image_pa
     surface.clear();
 
     // Load the source image from the given image path.
-    auto source = load_image(image_path.c_str());
+    auto source = load_image_cached(image_path.c_str());
 
     // Ensure that the source image was successfully loaded.
     assert(source);
@@ -143,6 +151,123 @@ void benchmark_blit_masked(benchmark::State& aState, const std::string& image_pa
     aState.SetBytesProcessed(static_cast<int64_t>(fb_width) * fb_height * 4 * aState.iterations());
 }
 
+// The function blits a rotated and scaled image using blit_masked_affine, with the filter given by range(2).
+void benchmark_blit_affine(benchmark::State& aState, const std::string& image_path)
+{
+    auto const fb_width = std::uint32_t(aState.range(0));
+    auto const fb_height = std::uint32_t(aState.range(1));
+    auto const filter = aState.range(2) ? EBlitFilter::bilinear : EBlitFilter::nearest;
+
+    Surface surface(fb_width, fb_height);
+    surface.clear();
+
+    auto source = load_image_cached(image_path.c_str());
+    assert(source);
+
+    // Rotate by 30 degrees and scale the image such that it roughly covers the framebuffer height.
+    float const scale = float(fb_height) / float(source->get_height());
+    Mat22f const rot = make_rotation_2d(0.5236f);
+    Mat22f const transform{ scale * rot._00, scale * rot._01, scale * rot._10, scale * rot._11 };
+    Vec2f const center{ 0.5f * float(fb_width), 0.5f * float(fb_height) };
+
+    for (auto _ : aState)
+    {
+        blit_masked_affine(surface, *source, transform, center, filter);
+        benchmark::ClobberMemory();
+    }
+
+    // Each destination pixel covered by the transformed image reads (at least) one source texel and writes one pixel.
+    auto const covered = std::min<std::int64_t>(std::int64_t(fb_width) * fb_height,
+        std::int64_t(scale * source->get_width()) * std::int64_t(scale * source->get_height()));
+    aState.SetBytesProcessed(2 * covered * 4 * aState.iterations());
+}
+
+// The function draws the image at a quarter of its size. range(0) selects between sampling the full resolution image
+// with blit_masked_affine (0) and blitting from the mip chain with blit_masked_scaled (1).
+void benchmark_blit_downscaled(benchmark::State& aState, const std::string& image_path)
+{
+    auto const use_mips = aState.range(0) != 0;
+
+    Surface surface(1920, 1080);
+    surface.clear();
+
+    MipChainRGBA const chain(load_image_cached(image_path.c_str()));
+    auto const& source = chain.level(0);
+
+    constexpr float scale = 0.25f;
+    Vec2f const extent{ scale * float(source.get_width()), scale * float(source.get_height()) };
+
+    for (auto _ : aState)
+    {
+        if (use_mips)
+            blit_masked_scaled(surface, chain, {0.f, 0.f}, scale);
+        else
+            blit_masked_affine(surface, source, Mat22f{ scale, 0.f, 0.f, scale }, 0.5f * extent);
+
+        benchmark::ClobberMemory();
+    }
+
+    aState.SetBytesProcessed(std::int64_t(extent.x) * std::int64_t(extent.y) * 4 * aState.iterations());
+}
+
+// The function loads the image and generates its mip chain. range(0) selects between decoding the image with
+// load_mip_chain (0) and mapping the decoded-image cache with load_image_cached (1). The cache file is written by the
+// first cached load, outside of the timed loop.
+void benchmark_load_mip_chain(benchmark::State& aState, const std::string& image_path)
+{
+    auto const use_cache = aState.range(0) != 0;
+
+    if (use_cache)
+        load_image_cached(image_path.c_str());
+
+    for (auto _ : aState)
+    {
+        if (use_cache)
+        {
+            MipChainRGBA const chain(load_image_cached(image_path.c_str()));
+            benchmark::DoNotOptimize(chain.level_count());
+        }
+        else
+        {
+            MipChainRGBA const chain = load_mip_chain(image_path.c_str());
+            benchmark::DoNotOptimize(chain.level_count());
+        }
+    }
+
+    aState.SetLabel(use_cache ? "cached" : "decoded");
+}
+
+// The function treats the image as a sprite sheet of range(0) x range(0) pixel frames, and blits each frame to a
+// different position on the surface. The frames are views into the one decoded image; nothing is copied.
+void benchmark_blit_sprite_frames(benchmark::State& aState, const std::string& image_path)
+{
+    auto const frame_size = std::uint32_t(aState.range(0));
+
+    Surface surface(1920, 1080);
+    surface.clear();
+
+    auto source = load_image_cached(image_path.c_str());
+    assert(source);
+
+    auto const sheet = make_image_view(*source);
+    auto const frames = sprite_frame_count(sheet, frame_size, frame_size);
+    auto const columns = 1920 / frame_size;
+
+    for (auto _ : aState)
+    {
+        for (std::size_t i = 0; i < frames; ++i)
+        {
+            auto const frame = make_sprite_frame(sheet, frame_size, frame_size, i);
+            Vec2f const pos{ float((i % columns) * frame_size), float((i / columns) * frame_size) };
+            blit_masked(surface, frame, pos);
+        }
+
+        benchmark::ClobberMemory();
+    }
+
+    aState.SetBytesProcessed(std::int64_t(frames) * frame_size * frame_size * 4 * aState.iterations());
+}
+
 // Register the benchmark functions
 BENCHMARK_CAPTURE(benchmark_blit_masked, impostor, "assets/impostor.png")
     ->Args({320, 240})
@@ -203,4 +328,25 @@ BENCHMARK_CAPTURE(blit_no_alpha_memcpy_, mortal_kombat, "assets/earth.png")
     ->Args({1920, 1080})
     ->Args({7680, 4320});
 */
+BENCHMARK_CAPTURE(benchmark_blit_affine, impostor, "assets/impostor.png")
+    ->Args({1280, 720, 0})
+    ->Args({1280, 720, 1})
+    ->Args({1920, 1080, 0})
+    ->Args({1920, 1080, 1})
+    ->Args({7680, 4320, 0})
+    ->Args({7680, 4320, 1});
+
+BENCHMARK_CAPTURE(benchmark_blit_downscaled, mortal_kombat, "assets/mortal_kombat.png")
+    ->Arg(0)
+    ->Arg(1);
+
+BENCHMARK_CAPTURE(benchmark_load_mip_chain, mortal_kombat, "assets/mortal_kombat.png")
+    ->Arg(0)
+    ->Arg(1)
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_CAPTURE(benchmark_blit_sprite_frames, mortal_kombat, "assets/mortal_kombat.png")
+    ->Arg(32)
+    ->Arg(128);
+
 BENCHMARK_MAIN();
@@ -0,0 +1,265 @@
+#include "blit.hpp"
+
+#include <algorithm>
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#include "image.hpp"
+#include "surface.hpp"
+#include "scissor.hpp"
+#include "image_view.hpp"
+
+namespace
+{
+	// Source coordinates are stepped in 16.16 fixed point. Images are (much)
+	// smaller than 32k pixels in each direction, so this leaves plenty of
+	// headroom in a 32-bit integer.
+	constexpr int kFracBits = 16;
+	constexpr float kFixedOne = float(std::int32_t(1) << kFracBits);
+
+	// Range of X values (pixel indices, as floats). Inclusive lower end,
+	// exclusive upper end.
+	struct Span_
+	{
+		float lo, hi;
+	};
+
+	void clip_span_( Span_&, float aBase, float aStep, float aLimit ) noexcept;
+
+	template< EBlitFilter tFilter >
+	void blit_span_(
+		Surface&, Surface::Index aY, std::int32_t aX0, std::int32_t aX1,
+		std::int32_t aU, std::int32_t aV, std::int32_t aDU, std::int32_t aDV,
+		ImageViewRGBA const&
+	);
+}
+
+void blit_masked( Surface& aSurface, ImageViewRGBA const& aImage, Vec2f aPosition )
+{
+	// Destination of the image's (0,0) pixel. Positions are truncated, like
+	// the original blit_masked() did.
+	auto const ox = std::int64_t(aPosition.x);
+	auto const oy = std::int64_t(aPosition.y);
+
+	// Destination rectangle: the surface, restricted to the scissor
+	std::int64_t cx0 = 0, cy0 = 0;
+	auto cx1 = std::int64_t(aSurface.get_width());
+	auto cy1 = std::int64_t(aSurface.get_height());
+
+	if( auto const* scissor = current_scissor() )
+	{
+		cx0 = std::max<std::int64_t>( cx0, scissor->minX );
+		cy0 = std::max<std::int64_t>( cy0, scissor->minY );
+		cx1 = std::min<std::int64_t>( cx1, scissor->maxX );
+		cy1 = std::min<std::int64_t>( cy1, scissor->maxY );
+	}
+
+	// Visible range of source pixels [x0,x1) x [y0,y1)
+	auto const x0 = std::max<std::int64_t>( 0, cx0 - ox );
+	auto const y0 = std::max<std::int64_t>( 0, cy0 - oy );
+	auto const x1 = std::min<std::int64_t>( aImage.width, cx1 - ox );
+	auto const y1 = std::min<std::int64_t>( aImage.height, cy1 - oy );
+
+	for( auto y = y0; y < y1; ++y )
+	{
+		std::uint8_t const* texel = aImage.row( ImageViewRGBA::Index(y) ) + x0 * 4;
+		auto const dy = Surface::Index(oy + y);
+
+		for( auto x = x0; x < x1; ++x, texel += 4 )
+		{
+			if( texel[3] >= 128 )
+				aSurface.set_pixel_srgb( Surface::Index(ox + x), dy, { texel[0], texel[1], texel[2] } );
+		}
+	}
+}
+
+void blit_masked_affine( Surface& aSurface, ImageRGBA const& aImage, Mat22f const& aTransform, Vec2f const& aTranslation, EBlitFilter aFilter )
+{
+	blit_masked_affine( aSurface, make_image_view( aImage ), aTransform, aTranslation, aFilter );
+}
+
+void blit_masked_affine( Surface& aSurface, ImageViewRGBA const& aImage, Mat22f const& aTransform, Vec2f const& aTranslation, EBlitFilter aFilter )
+{
+	auto const iw = aImage.width;
+	auto const ih = aImage.height;
+	if( 0 == iw || 0 == ih )
+		return;
+
+	// The inverse transform maps destination pixels back into the source.
+	float const det = aTransform._00 * aTransform._11 - aTransform._01 * aTransform._10;
+	if( std::abs( det ) < 1e-8f )
+		return; // Degenerate; image collapses into a line or a point.
+
+	Mat22f const inv{
+		 aTransform._11 / det, -aTransform._01 / det,
+		-aTransform._10 / det,  aTransform._00 / det
+	};
+
+	Vec2f const halfExtent{ 0.5f * float(iw), 0.5f * float(ih) };
+
+	// Bounding box of the transformed image, clamped to the surface.
+	Vec2f const corners[4] = {
+		aTransform * Vec2f{ -halfExtent.x, -halfExtent.y } + aTranslation,
+		aTransform * Vec2f{ +halfExtent.x, -halfExtent.y } + aTranslation,
+		aTransform * Vec2f{ +halfExtent.x, +halfExtent.y } + aTranslation,
+		aTransform * Vec2f{ -halfExtent.x, +halfExtent.y } + aTranslation
+	};
+
+	float minX = corners[0].x, maxX = corners[0].x;
+	float minY = corners[0].y, maxY = corners[0].y;
+	for( auto const& c : corners )
+	{
+		minX = std::min( minX, c.x );
+		maxX = std::max( maxX, c.x );
+		minY = std::min( minY, c.y );
+		maxY = std::max( maxY, c.y );
+	}
+
+	float const sw = float(aSurface.get_width());
+	float const sh = float(aSurface.get_height());
+	if( maxX < 0.f || maxY < 0.f || minX >= sw || minY >= sh )
+		return;
+
+	auto x0 = std::int32_t(std::max( 0.f, std::floor( minX ) ));
+	auto x1 = std::int32_t(std::min( sw - 1.f, std::floor( maxX ) ));
+	auto y0 = std::int32_t(std::max( 0.f, std::floor( minY ) ));
+	auto y1 = std::int32_t(std::min( sh - 1.f, std::floor( maxY ) ));
+
+	// The source coordinates only depend on the destination pixel, so the
+	// scissor just removes pixels.
+	if( auto const* scissor = current_scissor() )
+	{
+		x0 = std::max( x0, std::int32_t(scissor->minX) );
+		y0 = std::max( y0, std::int32_t(scissor->minY) );
+		x1 = std::min( x1, std::int32_t(scissor->maxX) - 1 );
+		y1 = std::min( y1, std::int32_t(scissor->maxY) - 1 );
+	}
+
+	// Source coordinates (u,v) as a function of the destination pixel center
+	// (X+0.5, Y+0.5). Both are linear in X, with steps inv._00 and inv._10.
+	float const du = inv._00;
+	float const dv = inv._10;
+
+	std::int32_t const duFixed = std::int32_t(std::lround( du * kFixedOne ));
+	std::int32_t const dvFixed = std::int32_t(std::lround( dv * kFixedOne ));
+
+	for( std::int32_t y = y0; y <= y1; ++y )
+	{
+		float const dy = float(y) + 0.5f - aTranslation.y;
+		float const ux = 0.5f - aTranslation.x;
+
+		// u and v at X = 0
+		float const u0 = inv._00 * ux + inv._01 * dy + halfExtent.x;
+		float const v0 = inv._10 * ux + inv._11 * dy + halfExtent.y;
+
+		// Find the part of this row where the source coordinates are inside
+		// the image.
+		Span_ span{ float(x0), float(x1) + 1.f };
+		clip_span_( span, u0, du, float(iw) );
+		clip_span_( span, v0, dv, float(ih) );
+
+		if( !(span.lo < span.hi) )
+			continue;
+
+		auto const sx0 = std::max( x0, std::int32_t(std::ceil( span.lo )) );
+		auto const sx1 = std::min( x1, std::int32_t(std::ceil( span.hi )) - 1 );
+		if( sx0 > sx1 )
+			continue;
+
+		std::int32_t const uFixed = std::int32_t(std::lround( (u0 + du * float(sx0)) * kFixedOne ));
+		std::int32_t const vFixed = std::int32_t(std::lround( (v0 + dv * float(sx0)) * kFixedOne ));
+
+		if( EBlitFilter::bilinear == aFilter )
+			blit_span_<EBlitFilter::bilinear>( aSurface, Surface::Index(y), sx0, sx1, uFixed, vFixed, duFixed, dvFixed, aImage );
+		else
+			blit_span_<EBlitFilter::nearest>( aSurface, Surface::Index(y), sx0, sx1, uFixed, vFixed, duFixed, dvFixed, aImage );
+	}
+}
+
+namespace
+{
+	void clip_span_( Span_& aSpan, float aBase, float aStep, float aLimit ) noexcept
+	{
+		if( 0.f == aStep )
+		{
+			// Constant along the row: either all in or all out.
+			if( aBase < 0.f || aBase >= aLimit )
+				aSpan.hi = aSpan.lo;
+
+			return;
+		}
+
+		float const a = (0.f - aBase) / aStep;
+		float const b = (aLimit - aBase) / aStep;
+
+		aSpan.lo = std::max( aSpan.lo, std::min( a, b ) );
+		aSpan.hi = std::min( aSpan.hi, std::max( a, b ) );
+	}
+
+	template< EBlitFilter tFilter >
+	void blit_span_( Surface& aSurface, Surface::Index aY, std::int32_t aX0, std::int32_t aX1, std::int32_t aU, std::int32_t aV, std::int32_t aDU, std::int32_t aDV, ImageViewRGBA const& aImage )
+	{
+		std::uint8_t const* src = aImage.data;
+
+		std::int32_t const maxU = std::int32_t(aImage.width) - 1;
+		std::int32_t const maxV = std::int32_t(aImage.height) - 1;
+		std::ptrdiff_t const pitch = std::ptrdiff_t(aImage.pitch);
+
+		for( std::int32_t x = aX0; x <= aX1; ++x, aU += aDU, aV += aDV )
+		{
+			if constexpr( EBlitFilter::nearest == tFilter )
+			{
+				// The span was computed such that the sample is inside the
+				// image; the clamp only guards against rounding in the last
+				// fixed-point bits.
+				std::int32_t const iu = std::clamp( aU >> kFracBits, 0, maxU );
+				std::int32_t const iv = std::clamp( aV >> kFracBits, 0, maxV );
+
+				std::uint8_t const* texel = src + iv * pitch + iu * 4;
+				if( texel[3] >= 128 )
+					aSurface.set_pixel_srgb( Surface::Index(x), aY, { texel[0], texel[1], texel[2] } );
+			}
+			else
+			{
+				// Texel centers are at half-integer coordinates.
+				std::int32_t const su = aU - (std::int32_t(1) << (kFracBits-1));
+				std::int32_t const sv = aV - (std::int32_t(1) << (kFracBits-1));
+
+				std::int32_t const iu = su >> kFracBits;
+				std::int32_t const iv = sv >> kFracBits;
+
+				// 8-bit interpolation weights
+				std::uint32_t const fu = std::uint32_t(su >> (kFracBits-8)) & 0xff;
+				std::uint32_t const fv = std::uint32_t(sv >> (kFracBits-8)) & 0xff;
+
+				std::int32_t const u0 = std::clamp( iu, 0, maxU ), u1 = std::clamp( iu+1, 0, maxU );
+				std::int32_t const v0 = std::clamp( iv, 0, maxV ), v1 = std::clamp( iv+1, 0, maxV );
+
+				std::uint8_t const* t00 = src + v0 * pitch + u0 * 4;
+				std::uint8_t const* t10 = src + v0 * pitch + u1 * 4;
+				std::uint8_t const* t01 = src + v1 * pitch + u0 * 4;
+				std::uint8_t const* t11 = src + v1 * pitch + u1 * 4;
+
+				// Weights sum to 2^16. Pre-multiplying them by alpha keeps the
+				// sums below 2^32 (65536 * 255 * 255 < 2^32).
+				std::uint32_t const w00 = (256-fu) * (256-fv) * t00[3];
+				std::uint32_t const w10 = fu * (256-fv) * t10[3];
+				std::uint32_t const w01 = (256-fu) * fv * t01[3];
+				std::uint32_t const w11 = fu * fv * t11[3];
+
+				std::uint32_t const wsum = w00 + w10 + w01 + w11;
+				if( (wsum >> 16) < 128 )
+					continue;
+
+				auto const channel = [&] (int aC) {
+					std::uint32_t const s = w00*t00[aC] + w10*t10[aC] + w01*t01[aC] + w11*t11[aC];
+					return std::uint8_t((s + wsum/2) / wsum);
+				};
+
+				aSurface.set_pixel_srgb( Surface::Index(x), aY, { channel(0), channel(1), channel(2) } );
+			}
+		}
+	}
+}
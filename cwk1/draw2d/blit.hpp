@@ -0,0 +1,72 @@
+#ifndef BLIT_HPP_6F0E3A51_2C8B_4D17_9E4A_C1B5D2F7A083
+#define BLIT_HPP_6F0E3A51_2C8B_4D17_9E4A_C1B5D2F7A083
+
+#include "forward.hpp"
+
+#include "../vmlib/vec2.hpp"
+#include "../vmlib/mat22.hpp"
+
+/** Filtering used when sampling the source image of a transformed blit
+ *
+ * nearest picks the texel that the destination pixel center falls into.
+ * bilinear blends the four closest texels. The blend is done on the 8-bit
+ * sRGB values (i.e., not in linear light), weighted by alpha so that fully
+ * transparent texels do not bleed their color into the visible ones.
+ */
+enum class EBlitFilter
+{
+	nearest,
+	bilinear
+};
+
+/** Blit image with an affine transform and alpha masking
+ *
+ * Source pixels are transformed by the provided matrix and translated by the
+ * provided vector, using the same convention as LineStrip::draw():
+ *
+ *   finalPixel = matrix * imagePixel + vector
+ *
+ * Unlike blit_masked(), image coordinates are measured relative to the center
+ * of the image, so the image rotates/scales around its center and the vector
+ * gives the destination of the image center. With the identity matrix, the
+ * nearest filter and a translation of aPosition + (width/2, height/2), the
+ * result matches blit_masked( ..., aPosition ) for integer positions.
+ *
+ * Pixels whose (filtered) alpha is below 128 are skipped, like in
+ * blit_masked(). Only destination spans inside the transformed image are
+ * visited; the source coordinates are stepped in 16.16 fixed point along
+ * each span.
+ */
+void blit_masked_affine(
+	Surface&,
+	ImageRGBA const&,
+	Mat22f const& aTransform,
+	Vec2f const& aTranslation,
+	EBlitFilter = EBlitFilter::nearest
+);
+
+/** Blits from image views
+ *
+ * Same as the blit_masked() declared in image.hpp and blit_masked_affine()
+ * above, but the source is a view (see image_view.hpp). This allows drawing
+ * a sub-rectangle of an image, e.g., a single frame of a sprite sheet,
+ * without copying it. The ImageRGBA versions forward to these.
+ *
+ * blit_masked() clips the image against the surface once, and then processes
+ * the visible part row by row.
+ */
+void blit_masked(
+	Surface&,
+	ImageViewRGBA const&,
+	Vec2f aPosition
+);
+
+void blit_masked_affine(
+	Surface&,
+	ImageViewRGBA const&,
+	Mat22f const& aTransform,
+	Vec2f const& aTranslation,
+	EBlitFilter = EBlitFilter::nearest
+);
+
+#endif // BLIT_HPP_6F0E3A51_2C8B_4D17_9E4A_C1B5D2F7A083
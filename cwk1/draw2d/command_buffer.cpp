@@ -0,0 +1,533 @@
+#include "command_buffer.hpp"
+
+#include <algorithm>
+#include <type_traits>
+
+#include <cmath>
+#include <cassert>
+#include <cstring>
+
+#include "draw.hpp"
+#include "shape.hpp"
+#include "surface.hpp"
+#include "instances.hpp"
+
+namespace
+{
+	// Command types. The values are the sort order of sort_by_type().
+	enum ECommand_ : std::uint8_t
+	{
+		kCmdTriangleSolid_,
+		kCmdTriangleInterp_,
+		kCmdFan_,
+		kCmdRectangle_,
+		kCmdLine_,
+		kCmdStrip_,
+		kCmdBlit_,
+		kCmdBlitAffine_
+	};
+
+	// Pixels that a command may touch beyond its exact bounds (the line and
+	// triangle functions round to the nearest pixels).
+	constexpr float kBoundsMargin_ = 1.f;
+
+	// Fans that share a TriangleFan are passed to draw_instances() in
+	// batches of up to this many
+	constexpr std::size_t kFanBatch_ = 64;
+
+	struct LineCmd_
+	{
+		Vec2f begin, end;
+		ColorU8_sRGB color;
+	};
+
+	struct TriangleSolidCmd_
+	{
+		Vec2f p0, p1, p2;
+		ColorU8_sRGB color;
+	};
+
+	struct TriangleInterpCmd_
+	{
+		Vec2f p0, p1, p2;
+		ColorF c0, c1, c2;
+	};
+
+	struct RectangleCmd_
+	{
+		Vec2f minCorner, maxCorner;
+		ColorU8_sRGB color;
+	};
+
+	struct FanCmd_
+	{
+		TriangleFan const* fan;
+		Mat22f transform;
+		Vec2f translation;
+	};
+
+	struct StripCmd_
+	{
+		LineStrip const* strip;
+		ColorF color;
+		Mat22f transform;
+		Vec2f translation;
+	};
+
+	struct BlitCmd_
+	{
+		ImageViewRGBA image;
+		Vec2f position;
+	};
+
+	struct BlitAffineCmd_
+	{
+		ImageViewRGBA image;
+		Mat22f transform;
+		Vec2f translation;
+		EBlitFilter filter;
+	};
+
+	constexpr Mat22f kIdentity_{
+		1.f, 0.f,
+		0.f, 1.f
+	};
+
+	std::uint32_t make_key_( std::uint16_t aLayer, std::uint8_t aType ) noexcept;
+	std::uint8_t key_type_( std::uint32_t aKey ) noexcept;
+	std::uint16_t key_layer_( std::uint32_t aKey ) noexcept;
+
+	bool is_axis_aligned_( Mat22f const& ) noexcept;
+
+	template< class tCommand >
+	tCommand load_( void const* aStream, std::uint32_t aOffset ) noexcept;
+}
+
+CommandBuffer::CommandBuffer( std::pmr::memory_resource* aResource )
+	: mStream( aResource )
+	, mStreamUsed( 0 )
+	, mEntries( aResource )
+	, mLayer( 0 )
+	, mTileSize( kDefaultTileSize )
+	, mTilesX( 0 )
+	, mTilesY( 0 )
+	, mBinWidth( 0 )
+	, mBinHeight( 0 )
+	, mTileStart( aResource )
+	, mTileEntries( aResource )
+{}
+
+CommandBuffer::~CommandBuffer() = default;
+
+CommandBuffer::CommandBuffer( CommandBuffer&& ) noexcept = default;
+CommandBuffer& CommandBuffer::operator= (CommandBuffer&&) noexcept = default;
+
+
+void CommandBuffer::line( Vec2f aBegin, Vec2f aEnd, ColorU8_sRGB aColor )
+{
+	record_( kCmdLine_, LineCmd_{ aBegin, aEnd, aColor },
+		std::min( aBegin.x, aEnd.x ), std::min( aBegin.y, aEnd.y ),
+		std::max( aBegin.x, aEnd.x ), std::max( aBegin.y, aEnd.y )
+	);
+}
+
+void CommandBuffer::triangle( Vec2f aP0, Vec2f aP1, Vec2f aP2, ColorU8_sRGB aColor )
+{
+	record_( kCmdTriangleSolid_, TriangleSolidCmd_{ aP0, aP1, aP2, aColor },
+		std::min( { aP0.x, aP1.x, aP2.x } ), std::min( { aP0.y, aP1.y, aP2.y } ),
+		std::max( { aP0.x, aP1.x, aP2.x } ), std::max( { aP0.y, aP1.y, aP2.y } )
+	);
+}
+
+void CommandBuffer::triangle( Vec2f aP0, Vec2f aP1, Vec2f aP2, ColorF aC0, ColorF aC1, ColorF aC2 )
+{
+	record_( kCmdTriangleInterp_, TriangleInterpCmd_{ aP0, aP1, aP2, aC0, aC1, aC2 },
+		std::min( { aP0.x, aP1.x, aP2.x } ), std::min( { aP0.y, aP1.y, aP2.y } ),
+		std::max( { aP0.x, aP1.x, aP2.x } ), std::max( { aP0.y, aP1.y, aP2.y } )
+	);
+}
+
+void CommandBuffer::rectangle( Vec2f aMinCorner, Vec2f aMaxCorner, ColorU8_sRGB aColor )
+{
+	record_( kCmdRectangle_, RectangleCmd_{ aMinCorner, aMaxCorner, aColor },
+		aMinCorner.x, aMinCorner.y, aMaxCorner.x, aMaxCorner.y
+	);
+}
+
+void CommandBuffer::fan( TriangleFan const& aFan, Mat22f const& aTransform, Vec2f const& aTranslation, float aRadius )
+{
+	record_( kCmdFan_, FanCmd_{ &aFan, aTransform, aTranslation },
+		aTranslation.x - aRadius, aTranslation.y - aRadius,
+		aTranslation.x + aRadius, aTranslation.y + aRadius
+	);
+}
+
+void CommandBuffer::strip( LineStrip const& aStrip, ColorF const& aColor, Mat22f const& aTransform, Vec2f const& aTranslation, float aRadius )
+{
+	record_( kCmdStrip_, StripCmd_{ &aStrip, aColor, aTransform, aTranslation },
+		aTranslation.x - aRadius, aTranslation.y - aRadius,
+		aTranslation.x + aRadius, aTranslation.y + aRadius
+	);
+}
+
+void CommandBuffer::blit( ImageViewRGBA const& aImage, Vec2f aPosition )
+{
+	record_( kCmdBlit_, BlitCmd_{ aImage, aPosition },
+		aPosition.x, aPosition.y,
+		aPosition.x + float(aImage.width), aPosition.y + float(aImage.height)
+	);
+}
+
+void CommandBuffer::blit( ImageViewRGBA const& aImage, Mat22f const& aTransform, Vec2f const& aTranslation, EBlitFilter aFilter )
+{
+	// Bounding box of the transformed image; see blit_masked_affine().
+	auto const hx = 0.5f * float(aImage.width);
+	auto const hy = 0.5f * float(aImage.height);
+
+	auto const ex = std::abs( aTransform._00 ) * hx + std::abs( aTransform._01 ) * hy;
+	auto const ey = std::abs( aTransform._10 ) * hx + std::abs( aTransform._11 ) * hy;
+
+	record_( kCmdBlitAffine_, BlitAffineCmd_{ aImage, aTransform, aTranslation, aFilter },
+		aTranslation.x - ex, aTranslation.y - ey,
+		aTranslation.x + ex, aTranslation.y + ey
+	);
+}
+
+void CommandBuffer::set_layer( Layer aLayer ) noexcept
+{
+	mLayer = aLayer;
+}
+
+void CommandBuffer::clear() noexcept
+{
+	mStreamUsed = 0;
+	mEntries.clear();
+	mLayer = 0;
+
+	mTilesX = mTilesY = 0;
+}
+
+std::size_t CommandBuffer::size() const noexcept
+{
+	return mEntries.size();
+}
+
+bool CommandBuffer::empty() const noexcept
+{
+	return mEntries.empty();
+}
+
+
+void CommandBuffer::sort_by_type()
+{
+	std::stable_sort( mEntries.begin(), mEntries.end(), [] (Entry_ const& aA, Entry_ const& aB) {
+		return aA.key < aB.key;
+	} );
+
+	mTilesX = mTilesY = 0;
+}
+
+void CommandBuffer::bin( std::uint32_t aWidth, std::uint32_t aHeight, std::uint32_t aTileSize )
+{
+	mTileSize = std::max( aTileSize, std::uint32_t(1) );
+	mTilesX = (aWidth + mTileSize - 1) / mTileSize;
+	mTilesY = (aHeight + mTileSize - 1) / mTileSize;
+	mBinWidth = aWidth;
+	mBinHeight = aHeight;
+
+	auto const tileCount = std::size_t(mTilesX) * mTilesY;
+
+	// Range of tiles touched by an entry. False if the entry is outside of
+	// the surface.
+	auto const tiles = [this, aWidth, aHeight] (Entry_ const& aEntry, std::uint32_t (&aRange)[4]) {
+		auto const minX = aEntry.minX - kBoundsMargin_, minY = aEntry.minY - kBoundsMargin_;
+		auto const maxX = aEntry.maxX + kBoundsMargin_, maxY = aEntry.maxY + kBoundsMargin_;
+
+		if( maxX < 0.f || maxY < 0.f || minX >= float(aWidth) || minY >= float(aHeight) )
+			return false;
+
+		// Clamp before converting, the bounds may be infinite.
+		auto const ts = float(mTileSize);
+		aRange[0] = std::uint32_t(std::clamp( std::floor( minX / ts ), 0.f, float(mTilesX-1) ));
+		aRange[1] = std::uint32_t(std::clamp( std::floor( minY / ts ), 0.f, float(mTilesY-1) ));
+		aRange[2] = std::uint32_t(std::clamp( std::floor( maxX / ts ), 0.f, float(mTilesX-1) ));
+		aRange[3] = std::uint32_t(std::clamp( std::floor( maxY / ts ), 0.f, float(mTilesY-1) ));
+		return true;
+	};
+
+	// Counting sort into the tiles. The counts are stored two places ahead,
+	// so that filling the tiles leaves mTileStart[i] at the start of tile i.
+	mTileStart.assign( tileCount + 2, 0 );
+	if( 0 == tileCount )
+		return;
+
+	std::uint32_t range[4];
+	for( auto const& entry : mEntries )
+	{
+		if( !tiles( entry, range ) )
+			continue;
+
+		for( auto ty = range[1]; ty <= range[3]; ++ty )
+		{
+			for( auto tx = range[0]; tx <= range[2]; ++tx )
+				++mTileStart[ty * mTilesX + tx + 2];
+		}
+	}
+
+	for( std::size_t i = 2; i < tileCount + 2; ++i )
+		mTileStart[i] += mTileStart[i-1];
+
+	mTileEntries.resize( mTileStart[tileCount+1] );
+
+	auto const numEntries = std::uint32_t(mEntries.size());
+	for( std::uint32_t i = 0; i < numEntries; ++i )
+	{
+		if( !tiles( mEntries[i], range ) )
+			continue;
+
+		for( auto ty = range[1]; ty <= range[3]; ++ty )
+		{
+			for( auto tx = range[0]; tx <= range[2]; ++tx )
+				mTileEntries[mTileStart[ty * mTilesX + tx + 1]++] = i;
+		}
+	}
+}
+
+std::size_t CommandBuffer::tile_count() const noexcept
+{
+	return std::size_t(mTilesX) * mTilesY;
+}
+
+ScissorRect CommandBuffer::tile_rect( std::size_t aTile ) const noexcept
+{
+	assert( aTile < tile_count() );
+
+	auto const tx = std::uint32_t(aTile % mTilesX);
+	auto const ty = std::uint32_t(aTile / mTilesX);
+
+	return ScissorRect{
+		tx * mTileSize, ty * mTileSize,
+		std::min( (tx+1) * mTileSize, mBinWidth ), std::min( (ty+1) * mTileSize, mBinHeight )
+	};
+}
+
+
+void CommandBuffer::replay( Surface& aSurface ) const
+{
+	replay( aSurface, kIdentity_, Vec2f{ 0.f, 0.f } );
+}
+
+void CommandBuffer::replay( Surface& aSurface, Mat22f const& aTransform, Vec2f const& aTranslation ) const
+{
+	execute_range_( aSurface, mEntries.size(), [this] (std::size_t aIndex) -> Entry_ const& {
+		return mEntries[aIndex];
+	}, aTransform, aTranslation );
+}
+
+void CommandBuffer::replay_tile( Surface& aSurface, std::size_t aTile ) const
+{
+	assert( aTile < tile_count() );
+	assert( aSurface.get_width() == mBinWidth && aSurface.get_height() == mBinHeight );
+
+	ScopedScissor scissor( tile_rect( aTile ) );
+
+	auto const first = mTileStart[aTile];
+	execute_range_( aSurface, mTileStart[aTile+1] - first, [this, first] (std::size_t aIndex) -> Entry_ const& {
+		return mEntries[mTileEntries[first + aIndex]];
+	}, kIdentity_, Vec2f{ 0.f, 0.f } );
+}
+
+
+template< class tCommand >
+void CommandBuffer::record_( std::uint8_t aType, tCommand const& aCommand, float aMinX, float aMinY, float aMaxX, float aMaxY )
+{
+	static_assert( std::is_trivially_copyable_v<tCommand> );
+
+	auto const offset = (mStreamUsed + alignof(tCommand) - 1) / alignof(tCommand) * alignof(tCommand);
+	auto const end = offset + sizeof(tCommand);
+
+	// Grow the stream geometrically. The stream is never shrunk, so a buffer
+	// that is cleared and re-recorded reaches a steady size.
+	auto const capacity = mStream.size() * sizeof(std::max_align_t);
+	if( end > capacity )
+	{
+		auto const bytes = std::max( end, 2 * capacity );
+		mStream.resize( (bytes + sizeof(std::max_align_t) - 1) / sizeof(std::max_align_t) );
+	}
+
+	std::memcpy( reinterpret_cast<unsigned char*>(mStream.data()) + offset, &aCommand, sizeof(tCommand) );
+	mStreamUsed = end;
+
+	// Entries are kept sorted by layer. Recording into a lower layer than
+	// the last command inserts after the last command of that layer.
+	Entry_ const entry{ make_key_( mLayer, aType ), std::uint32_t(offset), aMinX, aMinY, aMaxX, aMaxY };
+	if( mEntries.empty() || key_layer_( mEntries.back().key ) <= mLayer )
+	{
+		mEntries.emplace_back( entry );
+	}
+	else
+	{
+		auto const pos = std::upper_bound( mEntries.begin(), mEntries.end(), mLayer, [] (Layer aLayer, Entry_ const& aEntry) {
+			return aLayer < key_layer_( aEntry.key );
+		} );
+		mEntries.insert( pos, entry );
+	}
+
+	mTilesX = mTilesY = 0;
+}
+
+void CommandBuffer::execute_( Surface& aSurface, Entry_ const& aEntry, Mat22f const& aT, Vec2f const& aV ) const
+{
+	auto const* stream = mStream.data();
+
+	switch( key_type_( aEntry.key ) )
+	{
+		case kCmdLine_: {
+			auto const cmd = load_<LineCmd_>( stream, aEntry.offset );
+			draw_line_solid( aSurface, aT * cmd.begin + aV, aT * cmd.end + aV, cmd.color );
+		} break;
+
+		case kCmdTriangleSolid_: {
+			auto const cmd = load_<TriangleSolidCmd_>( stream, aEntry.offset );
+			draw_triangle_solid( aSurface, aT * cmd.p0 + aV, aT * cmd.p1 + aV, aT * cmd.p2 + aV, cmd.color );
+		} break;
+
+		case kCmdTriangleInterp_: {
+			auto const cmd = load_<TriangleInterpCmd_>( stream, aEntry.offset );
+			draw_triangle_interp( aSurface, aT * cmd.p0 + aV, aT * cmd.p1 + aV, aT * cmd.p2 + aV, cmd.c0, cmd.c1, cmd.c2 );
+		} break;
+
+		case kCmdRectangle_: {
+			auto const cmd = load_<RectangleCmd_>( stream, aEntry.offset );
+
+			Vec2f const c0 = aT * cmd.minCorner + aV;
+			Vec2f const c2 = aT * cmd.maxCorner + aV;
+
+			if( is_axis_aligned_( aT ) )
+			{
+				draw_rectangle_solid( aSurface,
+					Vec2f{ std::min( c0.x, c2.x ), std::min( c0.y, c2.y ) },
+					Vec2f{ std::max( c0.x, c2.x ), std::max( c0.y, c2.y ) },
+					cmd.color
+				);
+			}
+			else
+			{
+				Vec2f const c1 = aT * Vec2f{ cmd.maxCorner.x, cmd.minCorner.y } + aV;
+				Vec2f const c3 = aT * Vec2f{ cmd.minCorner.x, cmd.maxCorner.y } + aV;
+
+				draw_triangle_solid( aSurface, c0, c1, c2, cmd.color );
+				draw_triangle_solid( aSurface, c0, c2, c3, cmd.color );
+			}
+		} break;
+
+		case kCmdFan_: {
+			auto const cmd = load_<FanCmd_>( stream, aEntry.offset );
+			cmd.fan->draw( aSurface, aT * cmd.transform, aT * cmd.translation + aV );
+		} break;
+
+		case kCmdStrip_: {
+			auto const cmd = load_<StripCmd_>( stream, aEntry.offset );
+			cmd.strip->draw( aSurface, cmd.color, aT * cmd.transform, aT * cmd.translation + aV );
+		} break;
+
+		case kCmdBlit_: {
+			auto const cmd = load_<BlitCmd_>( stream, aEntry.offset );
+
+			if( aT._00 == 1.f && aT._01 == 0.f && aT._10 == 0.f && aT._11 == 1.f )
+			{
+				blit_masked( aSurface, cmd.image, cmd.position + aV );
+			}
+			else
+			{
+				// blit_masked_affine() places the image by its center
+				Vec2f const center = cmd.position + Vec2f{ 0.5f * float(cmd.image.width), 0.5f * float(cmd.image.height) };
+				blit_masked_affine( aSurface, cmd.image, aT, aT * center + aV );
+			}
+		} break;
+
+		case kCmdBlitAffine_: {
+			auto const cmd = load_<BlitAffineCmd_>( stream, aEntry.offset );
+			blit_masked_affine( aSurface, cmd.image, aT * cmd.transform, aT * cmd.translation + aV, cmd.filter );
+		} break;
+
+		default:
+			assert( false );
+	}
+}
+
+template< class tEntryAt >
+void CommandBuffer::execute_range_( Surface& aSurface, std::size_t aCount, tEntryAt const& aEntryAt, Mat22f const& aT, Vec2f const& aV ) const
+{
+	auto const* stream = mStream.data();
+
+	ShapeInstance instances[kFanBatch_];
+
+	std::size_t i = 0;
+	while( i < aCount )
+	{
+		auto const& entry = aEntryAt( i );
+		if( kCmdFan_ != key_type_( entry.key ) )
+		{
+			execute_( aSurface, entry, aT, aV );
+			++i;
+			continue;
+		}
+
+		// Collect the run of fans that share this one's TriangleFan. The
+		// entries are in replay order, so drawing the run in one go keeps
+		// the order of the pixels.
+		auto const* fan = load_<FanCmd_>( stream, entry.offset ).fan;
+
+		std::size_t count = 0;
+		for( ; i < aCount && count < kFanBatch_; ++i, ++count )
+		{
+			auto const& next = aEntryAt( i );
+			if( kCmdFan_ != key_type_( next.key ) )
+				break;
+
+			auto const cmd = load_<FanCmd_>( stream, next.offset );
+			if( cmd.fan != fan )
+				break;
+
+			instances[count] = ShapeInstance{ aT * cmd.transform, aT * cmd.translation + aV };
+		}
+
+		if( 1 == count )
+			fan->draw( aSurface, instances[0].transform, instances[0].translation );
+		else
+			draw_instances( aSurface, *fan, count, instances );
+	}
+}
+
+
+namespace
+{
+	std::uint32_t make_key_( std::uint16_t aLayer, std::uint8_t aType ) noexcept
+	{
+		return std::uint32_t(aLayer) << 8 | aType;
+	}
+
+	std::uint8_t key_type_( std::uint32_t aKey ) noexcept
+	{
+		return std::uint8_t(aKey & 0xff);
+	}
+
+	std::uint16_t key_layer_( std::uint32_t aKey ) noexcept
+	{
+		return std::uint16_t(aKey >> 8);
+	}
+
+	bool is_axis_aligned_( Mat22f const& aT ) noexcept
+	{
+		return 0.f == aT._01 && 0.f == aT._10;
+	}
+
+	template< class tCommand >
+	tCommand load_( void const* aStream, std::uint32_t aOffset ) noexcept
+	{
+		tCommand ret;
+		std::memcpy( &ret, static_cast<unsigned char const*>(aStream) + aOffset, sizeof(tCommand) );
+		return ret;
+	}
+}
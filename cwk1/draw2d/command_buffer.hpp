@@ -0,0 +1,168 @@
+#ifndef COMMAND_BUFFER_HPP_3F8D61B2_A47C_4E05_9B3D_75C2E18A04F9
+#define COMMAND_BUFFER_HPP_3F8D61B2_A47C_4E05_9B3D_75C2E18A04F9
+
+#include <limits>
+#include <vector>
+#include <memory_resource>
+
+#include <cstddef>
+#include <cstdint>
+
+#include "forward.hpp"
+#include "color.hpp"
+#include "blit.hpp"
+#include "scissor.hpp"
+#include "image_view.hpp"
+
+#include "../vmlib/vec2.hpp"
+#include "../vmlib/mat22.hpp"
+
+/** Recorded draw commands
+ *
+ * A command buffer records draw calls instead of executing them. The
+ * recording is replayed to a Surface later, any number of times. Each
+ * command replays through the same function that would have been called
+ * directly (draw_line_solid(), TriangleFan::draw(), blit_masked(), ...), so
+ * the pixels are the same as when drawing immediately. Consecutive fans that
+ * share a TriangleFan replay with one draw_instances() call, which draws the
+ * same pixels as drawing them one by one.
+ *
+ * Commands are stored in a single stream, which is reused by clear(). A
+ * buffer that is re-recorded every frame therefore stops allocating after a
+ * few frames. Alternatively, a buffer that only lives for one frame can take
+ * its memory from a per-frame arena (a std::pmr::memory_resource). Static
+ * content can be recorded once, and replayed every frame with a different
+ * transform (see replay()).
+ *
+ * Triangle fans, line strips and images are referenced and not copied; they
+ * must outlive the recording.
+ *
+ * Commands replay in order of their layers (set_layer()), and in recording
+ * order within a layer. Recording layers in increasing order is cheapest;
+ * going back to a lower layer inserts into the recording.
+ *
+ * Recordings can be reordered before replaying:
+ *  - sort_by_type() groups commands of the same type, so that they replay
+ *    back to back. Commands are only reordered within a layer; use separate
+ *    layers for things that must be drawn on top of others.
+ *  - bin() sorts commands into screen tiles. Tiles are disjoint, so they can
+ *    be replayed from different threads (see replay_tile()). Commands that
+ *    are entirely outside of the surface are dropped.
+ */
+class CommandBuffer final
+{
+	public:
+		using Layer = std::uint16_t;
+
+	public: // Configuration values
+		static constexpr std::uint32_t kDefaultTileSize = 128;
+
+		// Radius for fans and strips whose extent is not known; such commands
+		// are replayed in all tiles.
+		static constexpr float kUnbounded = std::numeric_limits<float>::infinity();
+
+	public:
+		explicit CommandBuffer( std::pmr::memory_resource* = std::pmr::get_default_resource() );
+		~CommandBuffer();
+
+		// Not copyable but movable
+		CommandBuffer( CommandBuffer const& ) = delete;
+		CommandBuffer& operator= (CommandBuffer const&) = delete;
+
+		CommandBuffer( CommandBuffer&& ) noexcept;
+		CommandBuffer& operator= (CommandBuffer&&) noexcept;
+
+	public: // Recording
+		// See draw.hpp
+		void line( Vec2f aBegin, Vec2f aEnd, ColorU8_sRGB );
+
+		void triangle( Vec2f aP0, Vec2f aP1, Vec2f aP2, ColorU8_sRGB );
+		void triangle( Vec2f aP0, Vec2f aP1, Vec2f aP2, ColorF aC0, ColorF aC1, ColorF aC2 );
+
+		void rectangle( Vec2f aMinCorner, Vec2f aMaxCorner, ColorU8_sRGB );
+
+		// See TriangleFan::draw() and LineStrip::draw(). aRadius bounds the
+		// transformed shape around aTranslation; it is only used by bin().
+		void fan( TriangleFan const&, Mat22f const&, Vec2f const& aTranslation, float aRadius = kUnbounded );
+		void strip( LineStrip const&, ColorF const&, Mat22f const&, Vec2f const& aTranslation, float aRadius = kUnbounded );
+
+		// See blit.hpp
+		void blit( ImageViewRGBA const&, Vec2f aPosition );
+		void blit( ImageViewRGBA const&, Mat22f const&, Vec2f const& aTranslation, EBlitFilter = EBlitFilter::nearest );
+
+		// Layer of the commands recorded from now on. Commands replay in
+		// order of their layers, in replay(), bin() and replay_tile(); the
+		// layer starts at zero.
+		void set_layer( Layer ) noexcept;
+
+		// Remove all commands, but keep the memory. This also resets the layer
+		// and the tiles.
+		void clear() noexcept;
+
+		std::size_t size() const noexcept;
+		bool empty() const noexcept;
+
+	public: // Ordering
+		// Stable sort by layer, and by command type within each layer.
+		void sort_by_type();
+
+		/* Sort the commands into aTileSize x aTileSize tiles of a aWidth x
+		 * aHeight surface. The order of commands within a tile is the current
+		 * order. Recording more commands or sorting discards the tiles.
+		 */
+		void bin( std::uint32_t aWidth, std::uint32_t aHeight, std::uint32_t aTileSize = kDefaultTileSize );
+
+		std::size_t tile_count() const noexcept;
+		ScissorRect tile_rect( std::size_t aTile ) const noexcept;
+
+	public: // Replay
+		void replay( Surface& ) const;
+
+		/* Replay with an additional transform: all recorded positions are
+		 * transformed by the provided matrix and translated by the provided
+		 * vector, in the same way as LineStrip::draw(). Rectangles and blits
+		 * that no longer line up with the axes are replayed as two triangles
+		 * and with blit_masked_affine(), respectively.
+		 */
+		void replay( Surface&, Mat22f const&, Vec2f const& ) const;
+
+		// Replay the commands that touch a tile (see bin()), with a scissor
+		// for the tile. Different tiles may be replayed concurrently.
+		void replay_tile( Surface&, std::size_t aTile ) const;
+
+	private:
+		struct Entry_
+		{
+			std::uint32_t key; // layer and type
+			std::uint32_t offset; // into mStream
+
+			// Bounds in pixels, for bin()
+			float minX, minY, maxX, maxY;
+		};
+
+	private:
+		template< class tCommand >
+		void record_( std::uint8_t aType, tCommand const&, float aMinX, float aMinY, float aMaxX, float aMaxY );
+
+		void execute_( Surface&, Entry_ const&, Mat22f const&, Vec2f const& ) const;
+
+		// Execute the entries aEntryAt( 0 ... aCount-1 ), in order
+		template< class tEntryAt >
+		void execute_range_( Surface&, std::size_t aCount, tEntryAt const& aEntryAt, Mat22f const&, Vec2f const& ) const;
+
+	private:
+		std::pmr::vector<std::max_align_t> mStream; // command data
+		std::size_t mStreamUsed; // bytes
+
+		std::pmr::vector<Entry_> mEntries;
+		Layer mLayer;
+
+		// Tiles (see bin()). The entries of tile i are
+		// mTileEntries[mTileStart[i] ... mTileStart[i+1]).
+		std::uint32_t mTileSize, mTilesX, mTilesY;
+		std::uint32_t mBinWidth, mBinHeight;
+		std::pmr::vector<std::uint32_t> mTileStart;
+		std::pmr::vector<std::uint32_t> mTileEntries;
+};
+
+#endif // COMMAND_BUFFER_HPP_3F8D61B2_A47C_4E05_9B3D_75C2E18A04F9
@@ -1,13 +1,52 @@
 #include "draw.hpp"
 
+#include <vector>
 #include <algorithm>
 
 #include <cmath>
+#include <cstdint>
 
 //I have included this!
 #include "color.hpp"
 
 #include "surface.hpp"
+#include "scissor.hpp"
+#include "srgb_table.hpp"
+#include "draw_capture.hpp"
+
+namespace
+{
+	// Restrict a pixel bounding box [aMinX,aMaxX] x [aMinY,aMaxY] to the
+	// current scissor, if any.
+	void apply_scissor_( float& aMinX, float& aMinY, float& aMaxX, float& aMaxY ) noexcept;
+
+	/* Parts of the rows of a bounding box that a triangle can cover
+	 *
+	 * The triangle functions test each sample of the bounding box with
+	 * barycentric coordinates. Only the samples where the numerators of w0,
+	 * w1 and w2 can be non-negative (for a positive denominator) need
+	 * testing. These are found in double precision, and widened by a margin
+	 * for the rounding of the single precision test. The margin is a
+	 * heuristic (see row_spans_()), checked against testing every sample by
+	 * the "Triangle rows" test. The test itself is unchanged.
+	 */
+	struct RowSpans_
+	{
+		// Edge i is a[i] * x + b[i] * y + c[i] >= 0, where x is measured in
+		// samples from the first one
+		double a[3], b[3], c[3];
+		double last; // last sample of a row
+	};
+
+	RowSpans_ row_spans_( Vec2f aP0, Vec2f aP1, Vec2f aP2, float aDenom, float aMinX, float aMinY, float aMaxX, float aMaxY, std::size_t aSamples ) noexcept;
+
+	// Samples [aFirst, aEnd) of the row at aY
+	void row_span_( RowSpans_ const&, float aY, std::size_t& aFirst, std::size_t& aEnd ) noexcept;
+
+	// x coordinates of the samples of a row (aMinX, aMinX + 1, ..., up to
+	// aMaxX), with the rounding of stepping by one. Per thread.
+	std::vector<float> const& row_samples_( float aMinX, float aMaxX );
+}
 
 /*
     Clipping:
@@ -56,6 +95,13 @@
 
 
 void draw_line_solid(Surface& surface, Vec2f begin, Vec2f end, ColorU8_sRGB color) {
+
+    // Record the line instead of drawing it, if requested (see draw_capture.hpp)
+    if (auto* capture = current_draw_capture())
+    {
+        capture->line(begin, end, color);
+        return;
+    }
     
     /*
         The purpose of this function is to draw a solid line on the given 'surface' between points 'begin' and 'end' with the specified 'color'. The function uses 
@@ -206,11 +252,22 @@ void draw_line_solid(Surface& surface, Vec2f begin, Vec2f end, ColorU8_sRGB colo
     // We assume the maximum steps to be roughly twice the diagonal of the surface.
     int maxSteps = std::max(surface.get_width(), surface.get_height()) * 2;
 
+    // Pixels outside of the current scissor (if any) are skipped as well.
+    int clipMinX = 0, clipMinY = 0;
+    int clipMaxX = static_cast<int>(surface.get_width()), clipMaxY = static_cast<int>(surface.get_height());
+    if (auto const* scissor = current_scissor())
+    {
+        clipMinX = std::max(clipMinX, static_cast<int>(scissor->minX));
+        clipMinY = std::max(clipMinY, static_cast<int>(scissor->minY));
+        clipMaxX = std::min(clipMaxX, static_cast<int>(scissor->maxX));
+        clipMaxY = std::min(clipMaxY, static_cast<int>(scissor->maxY));
+    }
+
     // Begin the Bresenham's loop.
     while (safetyCounter < maxSteps) 
     {
         // Ensure the pixel is within the valid range of the surface dimensions before plotting.
-        if (ix0 >= 0 && ix0 < static_cast<int>(surface.get_width()) && iy0 >= 0 && iy0 < static_cast<int>(surface.get_height())) 
+        if (ix0 >= clipMinX && ix0 < clipMaxX && iy0 >= clipMinY && iy0 < clipMaxY) 
         {
             // This function call sets the color of the pixel at (ix0, iy0) position on the surface.
             surface.set_pixel_srgb(ix0, iy0, color);
@@ -294,6 +351,13 @@ void draw_triangle_wireframe( Surface& aSurface, Vec2f aP0, Vec2f aP1, Vec2f aP2
 
 
 void draw_triangle_solid(Surface& aSurface, Vec2f aP0, Vec2f aP1, Vec2f aP2, ColorU8_sRGB aColor) {
+
+    // Record the triangle instead of drawing it, if requested
+    if (auto* capture = current_draw_capture())
+    {
+        capture->triangle(aP0, aP1, aP2, aColor);
+        return;
+    }
     
     /*
         This function aims to draw a solid
@@ -324,6 +388,8 @@ void draw_triangle_solid(Surface& aSurface, Vec2f aP0, Vec2f aP1, Vec2f aP2, Col
     // Find the bottom-most y-coordinate of the triangle, but ensure it's not outside the surface's height.
     float maxY = std::min(static_cast<float>(aSurface.get_height() - 1), std::max({aP0.y, aP1.y, aP2.y}));
 
+    apply_scissor_(minX, minY, maxX, maxY);
+
     /*
         Precompute values for the barycentric coordinates
 
@@ -344,9 +410,19 @@ void draw_triangle_solid(Surface& aSurface, Vec2f aP0, Vec2f aP1, Vec2f aP2, Col
 
         += 1.0f ensures there are only integer increments. While x and y are floating point values, incrementing by 1.0f ensures
         that you move pixel by pixel.
+
+        Each row only visits the samples that the triangle can cover (see RowSpans_).
     */
+    auto const& samples = row_samples_(minX, maxX);
+    auto const spans = row_spans_(aP0, aP1, aP2, denom, minX, minY, maxX, maxY, samples.size());
+
     for (float y = minY; y <= maxY; y += 1.0f) {
-        for (float x = minX; x <= maxX; x += 1.0f) {
+        std::size_t first, end;
+        row_span_(spans, y, first, end);
+
+        for (std::size_t k = first; k < end; ++k) {
+            float const x = samples[k];
+
             // Compute barycentric coordinates for current pixel (x,y).
             // If all three values are between 0 and 1, then the point lies inside the triangle.
             float w0 = ((aP1.y - aP2.y) * (x - aP2.x) + (aP2.x - aP1.x) * (y - aP2.y)) / denom;
@@ -371,6 +447,13 @@ void draw_triangle_solid(Surface& aSurface, Vec2f aP0, Vec2f aP1, Vec2f aP2, Col
 
 void draw_triangle_interp(Surface& aSurface, Vec2f aP0, Vec2f aP1, Vec2f aP2, ColorF aC0, ColorF aC1, ColorF aC2)
 {
+    // Record the triangle instead of drawing it, if requested
+    if (auto* capture = current_draw_capture())
+    {
+        capture->triangle(aP0, aP1, aP2, aC0, aC1, aC2);
+        return;
+    }
+
     /* 
         The majority of the code is the same as the above method!
     */
@@ -380,11 +463,23 @@ void draw_triangle_interp(Surface& aSurface, Vec2f aP0, Vec2f aP1, Vec2f aP2, Co
     float maxX = std::min(static_cast<float>(aSurface.get_width() - 1), std::max({aP0.x, aP1.x, aP2.x}));
     float maxY = std::min(static_cast<float>(aSurface.get_height() - 1), std::max({aP0.y, aP1.y, aP2.y}));
 
+    apply_scissor_(minX, minY, maxX, maxY);
+
     // Precompute values for the barycentric coordinates
     float denom = (aP1.y - aP2.y) * (aP0.x - aP2.x) + (aP2.x - aP1.x) * (aP0.y - aP2.y);
 
+    auto const& samples = row_samples_(minX, maxX);
+    auto const spans = row_spans_(aP0, aP1, aP2, denom, minX, minY, maxX, maxY, samples.size());
+
+    auto const& srgb = srgb_table();
+
     for (float y = minY; y <= maxY; y += 1.0f) {
-        for (float x = minX; x <= maxX; x += 1.0f) {
+        std::size_t first, end;
+        row_span_(spans, y, first, end);
+
+        for (std::size_t k = first; k < end; ++k) {
+            float const x = samples[k];
+
             float w0 = ((aP1.y - aP2.y) * (x - aP2.x) + (aP2.x - aP1.x) * (y - aP2.y)) / denom;
             float w1 = ((aP2.y - aP0.y) * (x - aP2.x) + (aP0.x - aP2.x) * (y - aP2.y)) / denom;
             float w2 = 1.0f - w0 - w1;
@@ -428,7 +523,8 @@ void draw_triangle_interp(Surface& aSurface, Vec2f aP0, Vec2f aP1, Vec2f aP2, Co
 
                 //In the color.hpp, I have created the multiplication and the addition operator!
                 ColorF interpolatedColor = aC0 * w0 + aC1 * w1 + aC2 * w2;
-                aSurface.set_pixel_srgb(static_cast<Surface::Index>(x), static_cast<Surface::Index>(y), linear_to_srgb(interpolatedColor));
+                // Same as linear_to_srgb(interpolatedColor), but faster
+                aSurface.set_pixel_srgb(static_cast<Surface::Index>(x), static_cast<Surface::Index>(y), linear_to_srgb(srgb, interpolatedColor));
             }
         }
     }
@@ -437,28 +533,43 @@ void draw_triangle_interp(Surface& aSurface, Vec2f aP0, Vec2f aP1, Vec2f aP2, Co
 
 void draw_rectangle_solid( Surface& aSurface, Vec2f aMinCorner, Vec2f aMaxCorner, ColorU8_sRGB aColor )
 {
-	//TODO: your implementation goes here
-	//TODO: your implementation goes here
-	//TODO: your implementation goes here
+    // Fill the pixels whose centers are inside [aMinCorner, aMaxCorner), so
+    // that rectangles sharing an edge do not overlap.
+    float minX = std::ceil(aMinCorner.x - 0.5f), minY = std::ceil(aMinCorner.y - 0.5f);
+    float maxX = std::ceil(aMaxCorner.x - 0.5f), maxY = std::ceil(aMaxCorner.y - 0.5f);
+
+    // Clip to the surface and the current scissor (if any)
+    float clipMaxX = static_cast<float>(aSurface.get_width()), clipMaxY = static_cast<float>(aSurface.get_height());
+    if (auto const* scissor = current_scissor())
+    {
+        minX = std::max(minX, static_cast<float>(scissor->minX));
+        minY = std::max(minY, static_cast<float>(scissor->minY));
+        clipMaxX = std::min(clipMaxX, static_cast<float>(scissor->maxX));
+        clipMaxY = std::min(clipMaxY, static_cast<float>(scissor->maxY));
+    }
 
-	//TODO: remove the following when you start your implementation
-	(void)aSurface; // Avoid warnings about unused arguments until the function
-	(void)aMinCorner;   // is properly implemented.
-	(void)aMaxCorner;
-	(void)aColor;
+    auto const x0 = static_cast<Surface::Index>(std::max(minX, 0.f));
+    auto const y0 = static_cast<Surface::Index>(std::max(minY, 0.f));
+    auto const x1 = static_cast<Surface::Index>(std::clamp(maxX, 0.f, clipMaxX));
+    auto const y1 = static_cast<Surface::Index>(std::clamp(maxY, 0.f, clipMaxY));
+
+    for (Surface::Index y = y0; y < y1; ++y)
+    {
+        for (Surface::Index x = x0; x < x1; ++x)
+            aSurface.set_pixel_srgb(x, y, aColor);
+    }
 }
 
 void draw_rectangle_outline( Surface& aSurface, Vec2f aMinCorner, Vec2f aMaxCorner, ColorU8_sRGB aColor )
 {
-	//TODO: your implementation goes here
-	//TODO: your implementation goes here
-	//TODO: your implementation goes here
-
-	//TODO: remove the following when you start your implementation
-	(void)aSurface; // Avoid warnings about unused arguments
-	(void)aMinCorner;
-	(void)aMaxCorner;
-	(void)aColor;
+    // The four edges, through the corner pixels
+    Vec2f const c0 = aMinCorner, c2 = aMaxCorner;
+    Vec2f const c1{ aMaxCorner.x, aMinCorner.y }, c3{ aMinCorner.x, aMaxCorner.y };
+
+    draw_line_solid(aSurface, c0, c1, aColor);
+    draw_line_solid(aSurface, c1, c2, aColor);
+    draw_line_solid(aSurface, c2, c3, aColor);
+    draw_line_solid(aSurface, c3, c0, aColor);
 }
 
 /*
@@ -491,3 +602,125 @@ void draw_rectangle_outline( Surface& aSurface, Vec2f aMinCorner, Vec2f aMaxCorn
 }
 */
 
+namespace
+{
+	void apply_scissor_( float& aMinX, float& aMinY, float& aMaxX, float& aMaxY ) noexcept
+	{
+		auto const* scissor = current_scissor();
+		if( !scissor )
+			return;
+
+		// The triangle functions sample at aMin + k, k = 0, 1, ..., and write
+		// the pixel that the sample falls into. The minimum moves by whole
+		// steps, so that the samples stay the same as without a scissor;
+		// otherwise, drawing in bands would not match drawing in one go.
+		auto const minX = static_cast<float>(scissor->minX);
+		auto const minY = static_cast<float>(scissor->minY);
+
+		if( minX > aMinX ) aMinX += std::ceil( minX - aMinX );
+		if( minY > aMinY ) aMinY += std::ceil( minY - aMinY );
+
+		// Samples must be strictly below the (exclusive) maximum
+		aMaxX = std::min( aMaxX, std::nextafter( static_cast<float>(scissor->maxX), 0.f ) );
+		aMaxY = std::min( aMaxY, std::nextafter( static_cast<float>(scissor->maxY), 0.f ) );
+	}
+
+	RowSpans_ row_spans_( Vec2f aP0, Vec2f aP1, Vec2f aP2, float aDenom, float aMinX, float aMinY, float aMaxX, float aMaxY, std::size_t aSamples ) noexcept
+	{
+		// Heuristic margins, not derived bounds. The float numerators are a
+		// few roundings away from their exact values, i.e. off by a few 1e-7
+		// relative to the magnitude of their terms; 1e-5 leaves a wide gap.
+		// kUnderflow covers tiny numerators, which may round to -0 when
+		// divided (and pass). The "Triangle rows" test compares against
+		// testing every sample, including slivers and huge triangles. Larger
+		// margins only visit a few more samples.
+		constexpr double kRelativeError = 1e-5;
+		constexpr double kUnderflow = 1e-30;
+
+		RowSpans_ ret{};
+		ret.last = double(aSamples) - 1.0;
+
+		bool const finite = std::isfinite( aP0.x ) && std::isfinite( aP0.y )
+			&& std::isfinite( aP1.x ) && std::isfinite( aP1.y )
+			&& std::isfinite( aP2.x ) && std::isfinite( aP2.y )
+			&& std::isfinite( aDenom )
+		;
+		if( !finite || 0.f == aDenom )
+		{
+			// Test every sample. With a zero denominator, the barycentric
+			// coordinates are infinite or NaN, and no sample passes.
+			for( auto& c : ret.c )
+				c = finite ? -1.0 : 1.0;
+
+			return ret;
+		}
+
+		// Numerators of w0 and w1, times the sign of the denominator, are
+		// A * (x - P2.x) + B * (y - P2.y). The one of w2 is |denom| minus both.
+		double const sign = aDenom > 0.f ? 1.0 : -1.0;
+		double const x0 = aP0.x, y0 = aP0.y;
+		double const x1 = aP1.x, y1 = aP1.y;
+		double const x2 = aP2.x, y2 = aP2.y;
+
+		double const A0 = sign * (y1 - y2), B0 = sign * (x2 - x1);
+		double const A1 = sign * (y2 - y0), B1 = sign * (x0 - x2);
+
+		double const absDenom = std::abs( double(aDenom) );
+
+		// Margins for the single precision numerators in the box
+		double const dx = std::max( std::abs( aMinX - x2 ), std::abs( aMaxX - x2 ) );
+		double const dy = std::max( std::abs( aMinY - y2 ), std::abs( aMaxY - y2 ) );
+		double const tol0 = kRelativeError * (std::abs( A0 ) * dx + std::abs( B0 ) * dy) + kUnderflow * absDenom;
+		double const tol1 = kRelativeError * (std::abs( A1 ) * dx + std::abs( B1 ) * dy) + kUnderflow * absDenom;
+		double const tol2 = tol0 + tol1 + kRelativeError * absDenom;
+
+		// With x = aMinX + k
+		double const c0 = A0 * (aMinX - x2) - B0 * y2;
+		double const c1 = A1 * (aMinX - x2) - B1 * y2;
+
+		ret.a[0] = A0; ret.b[0] = B0; ret.c[0] = c0 + tol0;
+		ret.a[1] = A1; ret.b[1] = B1; ret.c[1] = c1 + tol1;
+		ret.a[2] = -A0 - A1; ret.b[2] = -B0 - B1; ret.c[2] = absDenom - c0 - c1 + tol2;
+
+		return ret;
+	}
+
+	void row_span_( RowSpans_ const& aSpans, float aY, std::size_t& aFirst, std::size_t& aEnd ) noexcept
+	{
+		// Widened by a sample on each side, as the samples are only
+		// approximately aMinX + k
+		double lo = 0.0, hi = aSpans.last;
+		for( int i = 0; i < 3; ++i )
+		{
+			auto const a = aSpans.a[i];
+			auto const c = aSpans.b[i] * aY + aSpans.c[i];
+
+			if( a > 0.0 )
+				lo = std::max( lo, std::floor( -c / a ) - 1.0 );
+			else if( a < 0.0 )
+				hi = std::min( hi, std::ceil( -c / a ) + 1.0 );
+			else if( c < 0.0 )
+				hi = -1.0;
+		}
+
+		if( lo > hi )
+		{
+			aFirst = aEnd = 0;
+			return;
+		}
+
+		aFirst = static_cast<std::size_t>(lo);
+		aEnd = static_cast<std::size_t>(hi) + 1;
+	}
+
+	std::vector<float> const& row_samples_( float aMinX, float aMaxX )
+	{
+		thread_local std::vector<float> samples;
+
+		samples.clear();
+		for( float x = aMinX; x <= aMaxX; x += 1.0f )
+			samples.emplace_back( x );
+
+		return samples;
+	}
+}
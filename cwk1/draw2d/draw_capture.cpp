@@ -0,0 +1,34 @@
+#include "draw_capture.hpp"
+
+#include "shape.hpp"
+#include "surface.hpp"
+
+namespace
+{
+	thread_local DrawCapture* tlCapture = nullptr;
+}
+
+ScopedDrawCapture::ScopedDrawCapture( DrawCapture& aCapture ) noexcept
+	: mPrevious( tlCapture )
+{
+	tlCapture = &aCapture;
+}
+
+ScopedDrawCapture::~ScopedDrawCapture()
+{
+	tlCapture = mPrevious;
+}
+
+DrawCapture* current_draw_capture() noexcept
+{
+	return tlCapture;
+}
+
+void capture_line_strip( DrawCapture& aCapture, LineStrip const& aStrip, ColorF const& aColor, Mat22f const& aTransform, Vec2f const& aTranslation )
+{
+	// Never written while capturing
+	thread_local Surface placeholder( 1, 1 );
+
+	ScopedDrawCapture scope( aCapture );
+	aStrip.draw( placeholder, aColor, aTransform, aTranslation );
+}
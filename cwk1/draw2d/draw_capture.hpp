@@ -0,0 +1,52 @@
+#ifndef DRAW_CAPTURE_HPP_62C9E0A7_1B84_4D3E_A5F2_9E07B3D18C46
+#define DRAW_CAPTURE_HPP_62C9E0A7_1B84_4D3E_A5F2_9E07B3D18C46
+
+#include "forward.hpp"
+#include "color.hpp"
+
+#include "../vmlib/vec2.hpp"
+#include "../vmlib/mat22.hpp"
+
+/** Capture of draw calls
+ *
+ * While a ScopedDrawCapture exists, draw_line_solid(), draw_triangle_solid()
+ * and draw_triangle_interp() pass their arguments to the capture instead of
+ * drawing, on the thread that created it. The Surface is not touched.
+ *
+ * This recovers the primitives that a shape is made of, without access to
+ * its vertices: drawing a TriangleFan or LineStrip with the identity
+ * transform while capturing yields its triangles or lines in object space
+ * (see draw_instances()).
+ */
+class DrawCapture
+{
+	public:
+		virtual void line( Vec2f aBegin, Vec2f aEnd, ColorU8_sRGB ) = 0;
+		virtual void triangle( Vec2f aP0, Vec2f aP1, Vec2f aP2, ColorU8_sRGB ) = 0;
+		virtual void triangle( Vec2f aP0, Vec2f aP1, Vec2f aP2, ColorF aC0, ColorF aC1, ColorF aC2 ) = 0;
+
+	protected:
+		~DrawCapture() = default;
+};
+
+class ScopedDrawCapture final
+{
+	public:
+		explicit ScopedDrawCapture( DrawCapture& ) noexcept;
+		~ScopedDrawCapture();
+
+		ScopedDrawCapture( ScopedDrawCapture const& ) = delete;
+		ScopedDrawCapture& operator= (ScopedDrawCapture const&) = delete;
+
+	private:
+		DrawCapture* mPrevious;
+};
+
+// Current thread's capture, or null if there is none
+DrawCapture* current_draw_capture() noexcept;
+
+// Draw aStrip into aCapture, i.e., capture its transformed lines. This needs
+// no Surface; a per-thread placeholder is passed to LineStrip::draw().
+void capture_line_strip( DrawCapture&, LineStrip const&, ColorF const&, Mat22f const&, Vec2f const& );
+
+#endif // DRAW_CAPTURE_HPP_62C9E0A7_1B84_4D3E_A5F2_9E07B3D18C46
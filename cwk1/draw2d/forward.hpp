@@ -8,7 +8,10 @@ class LineStrip;
 class TriangleFan;
 
 class Surface;
+class CommandBuffer;
 
 class ImageRGBA;
+class MipChainRGBA;
+struct ImageViewRGBA;
 
 #endif // FORWARD_HPP_D19DC0DD_871F_44A8_ACFF_2B948EAB8E7F
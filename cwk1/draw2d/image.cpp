@@ -9,7 +9,9 @@
 
 #include <stb_image.h>
 
+#include "blit.hpp"
 #include "surface.hpp"
+#include "image_view.hpp"
 
 #include "../support/error.hpp"
 
@@ -20,6 +22,8 @@ namespace
 		STBImageRGBA_( Index, Index, std::uint8_t* );
 		virtual ~STBImageRGBA_();
 	};
+
+	void flip_rows_( std::uint8_t*, std::size_t aWidth, std::size_t aHeight ) noexcept;
 }
 
 ImageRGBA::ImageRGBA()
@@ -35,13 +39,16 @@ std::unique_ptr<ImageRGBA> load_image( char const* aPath )
 {
 	assert( aPath );
 
-	stbi_set_flip_vertically_on_load( true );
-
+	// Note: stbi_set_flip_vertically_on_load() sets process-wide state, which
+	// makes it unsafe to decode images on several threads at once. Instead,
+	// the image is decoded as-is and the rows are flipped below.
 	int w, h, channels;
 	stbi_uc* ptr = stbi_load( aPath, &w, &h, &channels, 4 );
 	if( !ptr )
 		throw Error( "Unable to load image \"%s\"", aPath );
 
+	flip_rows_( ptr, std::size_t(w), std::size_t(h) );
+
 	return std::make_unique<STBImageRGBA_>(
 		ImageRGBA::Index(w),
 		ImageRGBA::Index(h),
@@ -65,9 +72,9 @@ std::unique_ptr<ImageRGBA> load_image( char const* aPath )
 	the pixel is considered visible and is therefore copied to a corresponding location on the target surface. The location is calculated by adding an offset 
 	to the source image's pixel coordinates, converting them to the target surface's coordinate space.
 
-	My current implementation iterates through every pixel in the source image and checks the alpha value. It is straightforward but could be inefficient if 
-	the image has a large number of transparent pixels (alpha less than 128), as it spends time checking pixels that won't be drawn. It could be made more 
-	efficient by, for example, preprocessing the image to identify and skip regions that are entirely transparent.
+	The per-pixel loop now lives in the ImageViewRGBA overload of blit_masked() (see blit.hpp), so that sub-rectangles of an image (e.g., sprite sheet 
+	frames) can be blitted as well. That version clips the image against the surface once, rather than checking the bounds of each pixel, and then 
+	walks the visible rows of the source image directly.
 
 */
 
@@ -78,42 +85,7 @@ void blit_masked( Surface& aSurface, ImageRGBA const& aImage, Vec2f aPosition )
 		Here, "aSurface" is the destination where you want to blit "aImage" (which is the source image containing pixels with RGBA values). "aPosition" is 
 		the position on "aSurface" where the top-left corner of "aImage" should be placed.
 	*/
-
-	// Iterate over all the pixels in the image by height (y-coordinate)
-    for (ImageRGBA::Index y = 0; y < aImage.get_height(); ++y)
-    {
-		 // Iterate over all the pixels in the image by width (x-coordinate)
-        for (ImageRGBA::Index x = 0; x < aImage.get_width(); ++x)
-        {
-			// Retrieve the pixel color and alpha value from the image at position (x, y)
-            ColorU8_sRGB_Alpha pixel = aImage.get_pixel(x, y);
-			
-			/*
-				If the pixel's alpha value is 128 or higher, it is visible and will be blitted to the surface. 
-				If it's less than 128, it is considered too transparent and is not drawn.
-            */
-			if (pixel.a >= 128) 
-            {
-				/*
-					"destX" and "destY" calculate the pixel's coordinates on "aSurface" where the current pixel from "aImage" should be placed. It adds the 
-					"x" and "y" offsets (aPosition.x and aPosition.y, respectively) to the current pixel's coordinates to get the correct location on aSurface.
-				*/
-
-                int destX = static_cast<int>(aPosition.x) + x;
-                int destY = static_cast<int>(aPosition.y) + y;
-
-                // Ensures that the destination coordinates (destX and destY) are within the bounds of aSurface. If the coordinates are outside aSurface, the pixel is not drawn.
-                if (destX >= 0 && destX < static_cast<int>(aSurface.get_width()) && destY >= 0 && destY < static_cast<int>(aSurface.get_height()))
-                {
-					// "convertedPixel" is created by dropping the alpha component from pixel, resulting in an RGB color that can be used on aSurface, which does not support alpha.
-                    ColorU8_sRGB convertedPixel = { pixel.r, pixel.g, pixel.b };
-
-					// Set the pixel on the surface at the destination coordinates with the RGB color of the original image pixel
-                    aSurface.set_pixel_srgb(destX, destY, convertedPixel);
-                }
-            }
-        } 
-    }
+	blit_masked( aSurface, make_image_view( aImage ), aPosition );
 }
 
 namespace
@@ -130,4 +102,14 @@ namespace
 		if( mData )
 			stbi_image_free( mData );
 	}
+
+	void flip_rows_( std::uint8_t* aData, std::size_t aWidth, std::size_t aHeight ) noexcept
+	{
+		std::size_t const pitch = aWidth * 4;
+
+		std::uint8_t* top = aData;
+		std::uint8_t* bottom = aData + (aHeight ? aHeight-1 : 0) * pitch;
+		for( ; top < bottom; top += pitch, bottom -= pitch )
+			std::swap_ranges( top, top + pitch, bottom );
+	}
 }
@@ -0,0 +1,35 @@
+#include "image_alloc.hpp"
+
+#include <cstring>
+
+namespace
+{
+	struct OwnedImageRGBA_ : public ImageRGBA
+	{
+		OwnedImageRGBA_( Index, Index );
+		virtual ~OwnedImageRGBA_();
+	};
+}
+
+std::unique_ptr<ImageRGBA> create_image( ImageRGBA::Index aWidth, ImageRGBA::Index aHeight )
+{
+	return std::make_unique<OwnedImageRGBA_>( aWidth, aHeight );
+}
+
+namespace
+{
+	OwnedImageRGBA_::OwnedImageRGBA_( Index aWidth, Index aHeight )
+	{
+		mWidth = aWidth;
+		mHeight = aHeight;
+
+		std::size_t const bytes = std::size_t(aWidth) * aHeight * 4;
+		mData = new std::uint8_t[bytes];
+		std::memset( mData, 0, bytes );
+	}
+
+	OwnedImageRGBA_::~OwnedImageRGBA_()
+	{
+		delete [] mData;
+	}
+}
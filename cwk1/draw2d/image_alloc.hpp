@@ -0,0 +1,18 @@
+#ifndef IMAGE_ALLOC_HPP_2B7D4E90_5A1C_4F3E_8C62_D94A07B1E35F
+#define IMAGE_ALLOC_HPP_2B7D4E90_5A1C_4F3E_8C62_D94A07B1E35F
+
+#include <memory>
+
+#include "forward.hpp"
+#include "image.hpp"
+
+/** Create an empty image
+ *
+ * Allocates an ImageRGBA with the given size. All pixels are initialized to
+ * fully transparent black. This is used for images that are generated at
+ * runtime (e.g., downsampled mip levels), as opposed to the ones loaded from
+ * disk with load_image().
+ */
+std::unique_ptr<ImageRGBA> create_image( ImageRGBA::Index aWidth, ImageRGBA::Index aHeight );
+
+#endif // IMAGE_ALLOC_HPP_2B7D4E90_5A1C_4F3E_8C62_D94A07B1E35F
@@ -0,0 +1,306 @@
+#include "image_cache.hpp"
+
+#include <thread>
+#include <system_error>
+#include <filesystem>
+#include <functional>
+
+#include <cstdio>
+#include <cstddef>
+#include <cstring>
+#include <cassert>
+#include <cstdint>
+
+#include "image.hpp"
+#include "image_alloc.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#	define DRAW2D_IMAGE_CACHE_MMAP 1
+#	include <fcntl.h>
+#	include <unistd.h>
+#	include <sys/mman.h>
+#	include <sys/stat.h>
+#endif
+
+namespace
+{
+	constexpr char kCacheSuffix[] = ".d2dcache";
+
+	constexpr char kCacheMagic[8] = { 'D', '2', 'D', 'I', 'M', 'G', 0, 0 };
+	constexpr std::uint32_t kCacheVersion = 1;
+
+	// Flags stored in the cache header
+	constexpr std::uint32_t kFlagFlippedVertically = 1u << 0;
+
+	struct CacheHeader_
+	{
+		char magic[8];
+		std::uint32_t version;
+		std::uint32_t flags;
+
+		std::uint32_t width;
+		std::uint32_t height;
+
+		std::uint64_t sourceSize;
+		std::int64_t sourceMTime;
+		std::uint64_t sourceHash;
+
+		std::uint64_t dataOffset;
+
+		std::uint8_t reserved_[8];
+	};
+
+	// The header size doubles as the alignment of the pixel data.
+	static_assert( sizeof(CacheHeader_) == 64 );
+
+	struct SourceInfo_
+	{
+		std::uint64_t size;
+		std::int64_t mtime;
+	};
+
+	bool source_info_( char const*, SourceInfo_& );
+	bool source_hash_( char const*, std::uint64_t& );
+
+	bool header_matches_( CacheHeader_ const&, std::uint64_t aFileSize );
+
+	std::unique_ptr<ImageRGBA> try_load_cache_( char const* aPath, std::string const& aCachePath, SourceInfo_ const& );
+	void write_cache_( std::string const& aCachePath, ImageRGBA const&, SourceInfo_ const&, std::uint64_t aHash );
+	void touch_cache_( std::string const& aCachePath, SourceInfo_ const& );
+
+#	if defined(DRAW2D_IMAGE_CACHE_MMAP)
+	struct MappedImageRGBA_ : public ImageRGBA
+	{
+		MappedImageRGBA_( Index, Index, void* aMapping, std::size_t aMappingSize, std::size_t aDataOffset );
+		virtual ~MappedImageRGBA_();
+
+		void* mapping;
+		std::size_t mappingSize;
+	};
+#	endif // ~ DRAW2D_IMAGE_CACHE_MMAP
+}
+
+std::string image_cache_path( char const* aPath )
+{
+	assert( aPath );
+	return std::string(aPath) + kCacheSuffix;
+}
+
+std::unique_ptr<ImageRGBA> load_image_cached( char const* aPath )
+{
+	assert( aPath );
+
+	SourceInfo_ info;
+	if( !source_info_( aPath, info ) )
+		return load_image( aPath ); // let load_image() report the error
+
+	auto const cachePath = image_cache_path( aPath );
+	if( auto cached = try_load_cache_( aPath, cachePath, info ) )
+		return cached;
+
+	// Cache miss: decode and (try to) store the results.
+	auto image = load_image( aPath );
+
+	std::uint64_t hash;
+	if( source_hash_( aPath, hash ) )
+		write_cache_( cachePath, *image, info, hash );
+
+	return image;
+}
+
+namespace
+{
+	bool source_info_( char const* aPath, SourceInfo_& aInfo )
+	{
+		namespace fs_ = std::filesystem;
+
+		std::error_code ec;
+		auto const size = fs_::file_size( aPath, ec );
+		if( ec )
+			return false;
+
+		auto const mtime = fs_::last_write_time( aPath, ec );
+		if( ec )
+			return false;
+
+		aInfo.size = std::uint64_t(size);
+		aInfo.mtime = std::int64_t(mtime.time_since_epoch().count());
+		return true;
+	}
+
+	bool source_hash_( char const* aPath, std::uint64_t& aHash )
+	{
+		// 64-bit FNV-1a
+		std::FILE* fin = std::fopen( aPath, "rb" );
+		if( !fin )
+			return false;
+
+		std::uint64_t hash = 14695981039346656037ull;
+
+		std::uint8_t buffer[16*1024];
+		std::size_t count;
+		while( 0 != (count = std::fread( buffer, 1, sizeof(buffer), fin )) )
+		{
+			for( std::size_t i = 0; i < count; ++i )
+			{
+				hash ^= buffer[i];
+				hash *= 1099511628211ull;
+			}
+		}
+
+		bool const ok = !std::ferror( fin );
+		std::fclose( fin );
+
+		aHash = hash;
+		return ok;
+	}
+
+	bool header_matches_( CacheHeader_ const& aHeader, std::uint64_t aFileSize )
+	{
+		if( 0 != std::memcmp( aHeader.magic, kCacheMagic, sizeof(kCacheMagic) ) )
+			return false;
+		if( kCacheVersion != aHeader.version || kFlagFlippedVertically != aHeader.flags )
+			return false;
+		if( sizeof(CacheHeader_) != aHeader.dataOffset )
+			return false;
+
+		std::uint64_t const bytes = std::uint64_t(aHeader.width) * aHeader.height * 4;
+		return aFileSize == aHeader.dataOffset + bytes;
+	}
+
+	std::unique_ptr<ImageRGBA> try_load_cache_( char const* aPath, std::string const& aCachePath, SourceInfo_ const& aInfo )
+	{
+		std::FILE* fin = std::fopen( aCachePath.c_str(), "rb" );
+		if( !fin )
+			return nullptr;
+
+		CacheHeader_ header;
+		bool const gotHeader = 1 == std::fread( &header, sizeof(header), 1, fin );
+
+		std::error_code ec;
+		auto const fileSize = std::filesystem::file_size( aCachePath, ec );
+
+		if( !gotHeader || ec || !header_matches_( header, fileSize ) || aInfo.size != header.sourceSize )
+		{
+			std::fclose( fin );
+			return nullptr;
+		}
+
+		if( aInfo.mtime != header.sourceMTime )
+		{
+			// Modified time changed; check if the contents did too.
+			std::uint64_t hash;
+			if( !source_hash_( aPath, hash ) || hash != header.sourceHash )
+			{
+				std::fclose( fin );
+				return nullptr;
+			}
+
+			touch_cache_( aCachePath, aInfo );
+		}
+
+#		if defined(DRAW2D_IMAGE_CACHE_MMAP)
+		std::fclose( fin );
+
+		int const fd = ::open( aCachePath.c_str(), O_RDONLY );
+		if( -1 == fd )
+			return nullptr;
+
+		// Private mapping: the pixels are writable through get_image_ptr(),
+		// but changes are never written back to the cache file.
+		std::size_t const mapSize = std::size_t(fileSize);
+		void* mapping = ::mmap( nullptr, mapSize, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0 );
+		::close( fd );
+
+		if( MAP_FAILED == mapping )
+			return nullptr;
+
+		return std::make_unique<MappedImageRGBA_>( header.width, header.height, mapping, mapSize, std::size_t(header.dataOffset) );
+#		else // !DRAW2D_IMAGE_CACHE_MMAP
+		auto image = create_image( header.width, header.height );
+
+		std::size_t const bytes = std::size_t(header.width) * header.height * 4;
+		bool const ok = 0 == std::fseek( fin, long(header.dataOffset), SEEK_SET )
+			&& (0 == bytes || 1 == std::fread( image->get_image_ptr(), bytes, 1, fin ));
+
+		std::fclose( fin );
+
+		if( !ok )
+			return nullptr;
+
+		return image;
+#		endif // ~ DRAW2D_IMAGE_CACHE_MMAP
+	}
+
+	void write_cache_( std::string const& aCachePath, ImageRGBA const& aImage, SourceInfo_ const& aInfo, std::uint64_t aHash )
+	{
+		CacheHeader_ header{};
+		std::memcpy( header.magic, kCacheMagic, sizeof(kCacheMagic) );
+		header.version = kCacheVersion;
+		header.flags = kFlagFlippedVertically;
+		header.width = aImage.get_width();
+		header.height = aImage.get_height();
+		header.sourceSize = aInfo.size;
+		header.sourceMTime = aInfo.mtime;
+		header.sourceHash = aHash;
+		header.dataOffset = sizeof(CacheHeader_);
+
+		// Write to a temporary file and move it into place, so that readers
+		// never observe a partially written cache file. The temporary name is
+		// unique per thread, as several threads may load the same image.
+		char suffix[64];
+		std::snprintf( suffix, sizeof(suffix), ".%zx.tmp", std::hash<std::thread::id>{}( std::this_thread::get_id() ) );
+
+		std::string const tempPath = aCachePath + suffix;
+
+		std::FILE* fout = std::fopen( tempPath.c_str(), "wb" );
+		if( !fout )
+			return;
+
+		std::size_t const bytes = std::size_t(header.width) * header.height * 4;
+		bool ok = 1 == std::fwrite( &header, sizeof(header), 1, fout );
+		ok = ok && (0 == bytes || 1 == std::fwrite( aImage.get_image_ptr(), bytes, 1, fout ));
+		ok = (0 == std::fclose( fout )) && ok;
+
+		std::error_code ec;
+		if( ok )
+			std::filesystem::rename( tempPath, aCachePath, ec );
+
+		if( !ok || ec )
+			std::filesystem::remove( tempPath, ec );
+	}
+
+	void touch_cache_( std::string const& aCachePath, SourceInfo_ const& aInfo )
+	{
+		// Record the new modification time, so that the hash does not need to
+		// be recomputed next time.
+		std::FILE* f = std::fopen( aCachePath.c_str(), "r+b" );
+		if( !f )
+			return;
+
+		if( 0 == std::fseek( f, long(offsetof(CacheHeader_,sourceMTime)), SEEK_SET ) )
+			std::fwrite( &aInfo.mtime, sizeof(aInfo.mtime), 1, f );
+
+		std::fclose( f );
+	}
+}
+
+#if defined(DRAW2D_IMAGE_CACHE_MMAP)
+namespace
+{
+	MappedImageRGBA_::MappedImageRGBA_( Index aWidth, Index aHeight, void* aMapping, std::size_t aMappingSize, std::size_t aDataOffset )
+		: mapping( aMapping )
+		, mappingSize( aMappingSize )
+	{
+		mWidth = aWidth;
+		mHeight = aHeight;
+		mData = static_cast<std::uint8_t*>(aMapping) + aDataOffset;
+	}
+
+	MappedImageRGBA_::~MappedImageRGBA_()
+	{
+		if( mapping )
+			::munmap( mapping, mappingSize );
+	}
+}
+#endif // ~ DRAW2D_IMAGE_CACHE_MMAP
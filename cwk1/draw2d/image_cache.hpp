@@ -0,0 +1,36 @@
+#ifndef IMAGE_CACHE_HPP_C3E81F27_9B4D_4A05_B6F2_5D0A7E93C1B8
+#define IMAGE_CACHE_HPP_C3E81F27_9B4D_4A05_B6F2_5D0A7E93C1B8
+
+#include <memory>
+#include <string>
+
+#include "forward.hpp"
+
+/** Load image from disk, via a cache of decoded images
+ *
+ * Decoding large PNGs with stb_image is slow. load_image_cached() stores the
+ * decoded (and vertically flipped) RGBA pixels in a raw cache file next to
+ * the asset (see image_cache_path()). Later calls map the cache file into
+ * memory instead of decoding the image again. On systems without mmap(), the
+ * cache file is read into memory with a single read instead.
+ *
+ * The cache file records the size, modification time and a 64-bit FNV-1a hash
+ * of the source file. The cache is used when size and modification time
+ * match. If only the modification time differs, the hash decides (e.g., after
+ * a fresh checkout that did not change the file's contents).
+ *
+ * The cache is best-effort: if the cache file cannot be read or written
+ * (e.g., read-only asset directory), the image is decoded with load_image()
+ * as usual. Errors from decoding the image are reported like load_image()
+ * does, i.e., by throwing an Error.
+ *
+ * Cache file layout (native endianess):
+ *   - 64 byte header (magic, version, width, height, source size/mtime/hash)
+ *   - width * height RGBA pixels, starting at offset 64
+ */
+std::unique_ptr<ImageRGBA> load_image_cached( char const* aPath );
+
+// Return path of the cache file used for the image at aPath
+std::string image_cache_path( char const* aPath );
+
+#endif // IMAGE_CACHE_HPP_C3E81F27_9B4D_4A05_B6F2_5D0A7E93C1B8
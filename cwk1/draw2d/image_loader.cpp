@@ -0,0 +1,146 @@
+#include "image_loader.hpp"
+
+#include <utility>
+#include <algorithm>
+#include <exception>
+
+#include "image.hpp"
+#include "image_cache.hpp"
+
+ImageLoader::ImageLoader( std::size_t aThreads, bool aUseCache )
+	: mThreadCount( aThreads )
+	, mUseCache( aUseCache )
+{
+	if( 0 == mThreadCount )
+		mThreadCount = std::max( 1u, std::thread::hardware_concurrency() );
+}
+
+ImageLoader::~ImageLoader()
+{
+	{
+		std::unique_lock<std::mutex> lock( mMutex );
+		mStopping = true;
+	}
+
+	mCondition.notify_all();
+
+	for( auto& thread : mThreads )
+		thread.join();
+}
+
+
+std::future<ImageLoader::ImagePtr> ImageLoader::load( std::string aPath )
+{
+	Job_ job{ std::move(aPath), {} };
+	auto future = job.result.get_future();
+
+	{
+		std::unique_lock<std::mutex> lock( mMutex );
+		start_threads_();
+		mJobs.emplace_back( std::move(job) );
+	}
+
+	mCondition.notify_one();
+	return future;
+}
+
+std::vector<std::future<ImageLoader::ImagePtr>> ImageLoader::load( std::vector<std::string> const& aPaths )
+{
+	std::vector<std::future<ImagePtr>> futures;
+	futures.reserve( aPaths.size() );
+
+	{
+		std::unique_lock<std::mutex> lock( mMutex );
+		start_threads_();
+
+		for( auto const& path : aPaths )
+		{
+			Job_ job{ path, {} };
+			futures.emplace_back( job.result.get_future() );
+			mJobs.emplace_back( std::move(job) );
+		}
+	}
+
+	mCondition.notify_all();
+	return futures;
+}
+
+std::size_t ImageLoader::thread_count() const noexcept
+{
+	return mThreadCount;
+}
+
+
+void ImageLoader::start_threads_()
+{
+	// Requires: mMutex is held
+	if( !mThreads.empty() )
+		return;
+
+	mThreads.reserve( mThreadCount );
+	for( std::size_t i = 0; i < mThreadCount; ++i )
+		mThreads.emplace_back( [this] { worker_(); } );
+}
+
+void ImageLoader::worker_()
+{
+	for( ;; )
+	{
+		Job_ job;
+
+		{
+			std::unique_lock<std::mutex> lock( mMutex );
+			mCondition.wait( lock, [this] { return mStopping || !mJobs.empty(); } );
+
+			// Drain the queue before stopping, so that no future is left
+			// without a value.
+			if( mJobs.empty() )
+				return;
+
+			job = std::move(mJobs.front());
+			mJobs.pop_front();
+		}
+
+		try
+		{
+			auto const* path = job.path.c_str();
+			job.result.set_value( mUseCache ? load_image_cached( path ) : load_image( path ) );
+		}
+		catch( ... )
+		{
+			job.result.set_exception( std::current_exception() );
+		}
+	}
+}
+
+
+std::vector<std::unique_ptr<ImageRGBA>> load_images( std::vector<std::string> const& aPaths, std::size_t aThreads )
+{
+	ImageLoader loader( std::min( aThreads ? aThreads : std::size_t(std::thread::hardware_concurrency()), aPaths.size() ) );
+
+	auto futures = loader.load( aPaths );
+
+	std::vector<std::unique_ptr<ImageRGBA>> images;
+	images.reserve( futures.size() );
+
+	std::exception_ptr error;
+	for( auto& future : futures )
+	{
+		try
+		{
+			images.emplace_back( future.get() );
+		}
+		catch( ... )
+		{
+			if( !error )
+				error = std::current_exception();
+
+			images.emplace_back( nullptr );
+		}
+	}
+
+	if( error )
+		std::rethrow_exception( error );
+
+	return images;
+}
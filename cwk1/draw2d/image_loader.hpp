@@ -0,0 +1,84 @@
+#ifndef IMAGE_LOADER_HPP_5F0B8D21_7C3A_4E96_9A14_B2E6D07C4F38
+#define IMAGE_LOADER_HPP_5F0B8D21_7C3A_4E96_9A14_B2E6D07C4F38
+
+#include <deque>
+#include <mutex>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <future>
+#include <condition_variable>
+
+#include <cstddef>
+
+#include "forward.hpp"
+
+/** Asynchronous image loader
+ *
+ * Decodes images on a small pool of worker threads. Each call to load()
+ * returns a future that receives the decoded image, or the Error thrown while
+ * loading it. Images are loaded with load_image_cached() by default, so
+ * repeated runs map the cached decoded pixels instead of decoding them again
+ * (see image_cache.hpp).
+ *
+ * load_image() and load_image_cached() are safe to call from several threads
+ * at once; ImageLoader merely takes care of the threads. The destructor waits
+ * for all queued images to finish loading.
+ *
+ * Typical use is to queue all assets up-front, do other setup work (e.g.,
+ * create the window) and then collect the images with std::future::get().
+ */
+class ImageLoader final
+{
+	public:
+		using ImagePtr = std::unique_ptr<ImageRGBA>;
+
+	public:
+		// aThreads = 0 uses std::thread::hardware_concurrency() threads.
+		// Threads are started lazily, when the first image is queued.
+		explicit ImageLoader( std::size_t aThreads = 0, bool aUseCache = true );
+		~ImageLoader();
+
+		ImageLoader( ImageLoader const& ) = delete;
+		ImageLoader& operator= (ImageLoader const&) = delete;
+
+	public:
+		std::future<ImagePtr> load( std::string aPath );
+		std::vector<std::future<ImagePtr>> load( std::vector<std::string> const& aPaths );
+
+		std::size_t thread_count() const noexcept;
+
+	private:
+		struct Job_
+		{
+			std::string path;
+			std::promise<ImagePtr> result;
+		};
+
+		void start_threads_();
+		void worker_();
+
+	private:
+		std::size_t mThreadCount;
+		bool mUseCache;
+
+		std::mutex mMutex;
+		std::condition_variable mCondition;
+
+		std::deque<Job_> mJobs;
+		bool mStopping = false;
+
+		std::vector<std::thread> mThreads;
+};
+
+/** Load several images concurrently
+ *
+ * Convenience function: loads all images with a temporary ImageLoader and
+ * waits for them. The images are returned in the order of aPaths. If loading
+ * an image fails, the Error from the first failed image is rethrown (after
+ * all images have finished loading).
+ */
+std::vector<std::unique_ptr<ImageRGBA>> load_images( std::vector<std::string> const& aPaths, std::size_t aThreads = 0 );
+
+#endif // IMAGE_LOADER_HPP_5F0B8D21_7C3A_4E96_9A14_B2E6D07C4F38
@@ -0,0 +1,55 @@
+#include "image_view.hpp"
+
+#include <cassert>
+
+#include "image.hpp"
+
+ImageViewRGBA make_image_view( ImageRGBA const& aImage )
+{
+	return ImageViewRGBA{
+		aImage.get_image_ptr(),
+		aImage.get_width(),
+		aImage.get_height(),
+		std::size_t(aImage.get_width()) * 4
+	};
+}
+
+ImageViewRGBA make_subview( ImageViewRGBA const& aView, ImageViewRGBA::Index aX, ImageViewRGBA::Index aY, ImageViewRGBA::Index aWidth, ImageViewRGBA::Index aHeight )
+{
+	assert( aX <= aView.width && aWidth <= aView.width - aX );
+	assert( aY <= aView.height && aHeight <= aView.height - aY );
+
+	return ImageViewRGBA{
+		aView.row( aY ) + std::size_t(aX) * 4,
+		aWidth,
+		aHeight,
+		aView.pitch
+	};
+}
+
+ImageViewRGBA make_sprite_frame( ImageViewRGBA const& aSheet, ImageViewRGBA::Index aFrameWidth, ImageViewRGBA::Index aFrameHeight, std::size_t aFrame )
+{
+	assert( aFrameWidth > 0 && aFrameHeight > 0 );
+	assert( aFrame < sprite_frame_count( aSheet, aFrameWidth, aFrameHeight ) );
+
+	auto const columns = aSheet.width / aFrameWidth;
+	auto const column = ImageViewRGBA::Index(aFrame % columns);
+	auto const line = ImageViewRGBA::Index(aFrame / columns);
+
+	// Lines are counted from the top of the sheet, but row 0 is at the bottom.
+	return make_subview(
+		aSheet,
+		column * aFrameWidth,
+		aSheet.height - (line+1) * aFrameHeight,
+		aFrameWidth,
+		aFrameHeight
+	);
+}
+
+std::size_t sprite_frame_count( ImageViewRGBA const& aSheet, ImageViewRGBA::Index aFrameWidth, ImageViewRGBA::Index aFrameHeight ) noexcept
+{
+	if( 0 == aFrameWidth || 0 == aFrameHeight )
+		return 0;
+
+	return std::size_t(aSheet.width / aFrameWidth) * (aSheet.height / aFrameHeight);
+}
@@ -0,0 +1,69 @@
+#ifndef IMAGE_VIEW_HPP_8A4C2E19_6B07_4F3D_95E1_D3F8A2C60B74
+#define IMAGE_VIEW_HPP_8A4C2E19_6B07_4F3D_95E1_D3F8A2C60B74
+
+#include <cstddef>
+#include <cstdint>
+
+#include "forward.hpp"
+
+/** Non-owning view of (a rectangle of) an RGBA image
+ *
+ * A view references pixels owned by somebody else (usually an ImageRGBA);
+ * the owner must outlive the view. Pixels use the same layout as ImageRGBA
+ * (four bytes per pixel, RGBA, sRGB color), but consecutive rows are pitch
+ * bytes apart, which allows a view to refer to a sub-rectangle of a larger
+ * image without copying it. This is intended for sprite sheets and animation
+ * frames, where many small images share one decoded buffer.
+ *
+ * Coordinates follow ImageRGBA: row 0 is the first row in memory, which is
+ * the bottom row of the image file (load_image() flips images vertically).
+ */
+struct ImageViewRGBA
+{
+	using Index = std::uint32_t;
+
+	std::uint8_t const* data; // first pixel, i.e., (0,0)
+	Index width, height;
+	std::size_t pitch; // bytes from one row to the next
+
+	std::uint8_t const* row( Index aY ) const noexcept
+	{
+		return data + aY * pitch;
+	}
+};
+
+// View of a whole image
+ImageViewRGBA make_image_view( ImageRGBA const& );
+
+/** Sub-rectangle of a view
+ *
+ * The rectangle starts at (aX,aY) and extends aWidth x aHeight pixels. The
+ * rectangle must be fully inside the source view.
+ */
+ImageViewRGBA make_subview(
+	ImageViewRGBA const&,
+	ImageViewRGBA::Index aX, ImageViewRGBA::Index aY,
+	ImageViewRGBA::Index aWidth, ImageViewRGBA::Index aHeight
+);
+
+/** Frame of a sprite sheet
+ *
+ * The sheet is treated as a grid of aFrameWidth x aFrameHeight frames. Frames
+ * are numbered left to right, and top to bottom as the sheet appears in the
+ * image file (i.e., frame 0 is the top-left frame on screen). Any partial
+ * frames at the right and bottom edges of the sheet (as it appears in the
+ * image file) are ignored.
+ */
+ImageViewRGBA make_sprite_frame(
+	ImageViewRGBA const& aSheet,
+	ImageViewRGBA::Index aFrameWidth, ImageViewRGBA::Index aFrameHeight,
+	std::size_t aFrame
+);
+
+// Number of complete frames in a sprite sheet (see make_sprite_frame())
+std::size_t sprite_frame_count(
+	ImageViewRGBA const& aSheet,
+	ImageViewRGBA::Index aFrameWidth, ImageViewRGBA::Index aFrameHeight
+) noexcept;
+
+#endif // IMAGE_VIEW_HPP_8A4C2E19_6B07_4F3D_95E1_D3F8A2C60B74
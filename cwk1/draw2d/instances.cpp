@@ -0,0 +1,567 @@
+#include "instances.hpp"
+
+#include <vector>
+#include <algorithm>
+
+#include <cmath>
+#include <cstdint>
+
+#include "draw.hpp"
+#include "shape.hpp"
+#include "surface.hpp"
+#include "scissor.hpp"
+#include "srgb_table.hpp"
+#include "draw_capture.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#	define INSTANCES_SSE2_ 1
+#	include <emmintrin.h>
+#endif
+
+namespace
+{
+	// Instances are culled in batches of this many
+	constexpr std::size_t kCullBatch_ = 64;
+
+	// Pixels that a primitive may touch outside of its vertices' bounds
+	constexpr float kCullMargin_ = 1.f;
+
+	// EInstanceFill::shared: pixel centers this close (in barycentric
+	// coordinates) outside of a triangle are still drawn. Two triangles that
+	// share an edge compute their coordinates with different rounding; the
+	// tolerance keeps the pixels along the edge from falling through both.
+	constexpr float kEdgeTolerance_ = 1e-5f;
+
+	constexpr Mat22f kIdentity_{
+		1.f, 0.f,
+		0.f, 1.f
+	};
+
+	// Affine function ax * x + ay * y + c of a position
+	struct Plane_
+	{
+		float ax, ay, c;
+	};
+
+	// Object space setup of a triangle, for EInstanceFill::shared
+	struct TriangleSetup_
+	{
+		std::uint32_t i0, i1, i2;
+
+		Plane_ w0, w1; // barycentric coordinates of vertices i0 and i1
+		Plane_ r, g, b; // linear color
+	};
+
+	// Shape in object space, with merged vertices
+	struct Geometry_
+	{
+		std::vector<Vec2f> positions;
+		std::vector<ColorF> colors; // per vertex (triangles only)
+
+		// Three indices per triangle, or two per line
+		std::vector<std::uint32_t> indices;
+		std::vector<ColorU8_sRGB> lineColors; // per line
+
+		float radius = 0.f; // bounding circle around the origin
+
+		// Positions split into x and y, for transform_()
+		std::vector<float> objectX, objectY;
+
+		// Positions of the current instance
+		std::vector<float> posX, posY;
+
+		// Non-degenerate triangles (EInstanceFill::shared only)
+		std::vector<TriangleSetup_> setups;
+	};
+
+	class Capture_ final : public DrawCapture
+	{
+		public:
+			explicit Capture_( Geometry_& ) noexcept;
+
+		public:
+			void line( Vec2f, Vec2f, ColorU8_sRGB ) override;
+			void triangle( Vec2f, Vec2f, Vec2f, ColorU8_sRGB ) override;
+			void triangle( Vec2f, Vec2f, Vec2f, ColorF, ColorF, ColorF ) override;
+
+		private:
+			std::uint32_t vertex_( Vec2f, ColorF );
+
+		private:
+			Geometry_& mGeometry;
+	};
+
+	// Pixel rectangle [minX,maxX) x [minY,maxY) that can be drawn to
+	struct ClipRect_
+	{
+		float minX, minY, maxX, maxY;
+	};
+
+	// Per-thread scratch geometry, emptied
+	Geometry_& scratch_geometry_();
+
+	// Split the positions for transform_()
+	void prepare_( Geometry_& );
+
+	// Set up the triangles in object space, for fill_shared_()
+	void setup_triangles_( Geometry_& );
+
+	ClipRect_ clip_rect_( Surface const& ) noexcept;
+
+	void cull_( std::size_t aCount, ShapeInstance const*, float aRadius, ClipRect_ const&, std::uint8_t* aVisible ) noexcept;
+	void transform_( Geometry_&, ShapeInstance const& ) noexcept;
+
+	// Draw the triangles of the current instance (see transform_()) with
+	// the object space setup
+	void fill_shared_( Surface&, Geometry_ const&, ShapeInstance const&, ClipRect_ const&, SrgbTable const& );
+}
+
+void draw_instances( Surface& aSurface, TriangleFan const& aFan, std::size_t aCount, ShapeInstance const* aInstances, EInstanceFill aFill )
+{
+	if( 0 == aCount )
+		return;
+
+	// Capture the fan's triangles. Nothing is drawn to the surface.
+	auto& geo = scratch_geometry_();
+	{
+		Capture_ capture( geo );
+		ScopedDrawCapture scope( capture );
+		aFan.draw( aSurface, kIdentity_, Vec2f{ 0.f, 0.f } );
+	}
+
+	prepare_( geo );
+
+	// The shared setup draws to the surface directly, so it is not used
+	// while capturing.
+	bool const shared = EInstanceFill::shared == aFill && !current_draw_capture();
+	if( shared )
+		setup_triangles_( geo );
+
+	auto const clip = clip_rect_( aSurface );
+	auto const indexCount = geo.indices.size();
+	auto const* idx = geo.indices.data();
+	auto const& srgb = srgb_table();
+
+	std::uint8_t visible[kCullBatch_];
+	for( std::size_t base = 0; base < aCount; base += kCullBatch_ )
+	{
+		auto const count = std::min( kCullBatch_, aCount - base );
+		cull_( count, aInstances + base, geo.radius, clip, visible );
+
+		for( std::size_t i = 0; i < count; ++i )
+		{
+			if( !visible[i] )
+				continue;
+
+			transform_( geo, aInstances[base+i] );
+
+			if( shared )
+			{
+				fill_shared_( aSurface, geo, aInstances[base+i], clip, srgb );
+				continue;
+			}
+
+			auto const* px = geo.posX.data();
+			auto const* py = geo.posY.data();
+			auto const* col = geo.colors.data();
+			for( std::size_t t = 0; t < indexCount; t += 3 )
+			{
+				auto const i0 = idx[t+0], i1 = idx[t+1], i2 = idx[t+2];
+				draw_triangle_interp( aSurface,
+					Vec2f{ px[i0], py[i0] }, Vec2f{ px[i1], py[i1] }, Vec2f{ px[i2], py[i2] },
+					col[i0], col[i1], col[i2]
+				);
+			}
+		}
+	}
+}
+
+void draw_instances( Surface& aSurface, LineStrip const& aStrip, ColorF const& aColor, std::size_t aCount, ShapeInstance const* aInstances )
+{
+	if( 0 == aCount )
+		return;
+
+	auto& geo = scratch_geometry_();
+	{
+		Capture_ capture( geo );
+		ScopedDrawCapture scope( capture );
+		aStrip.draw( aSurface, aColor, kIdentity_, Vec2f{ 0.f, 0.f } );
+	}
+
+	prepare_( geo );
+
+	auto const clip = clip_rect_( aSurface );
+	auto const indexCount = geo.indices.size();
+	auto const* idx = geo.indices.data();
+
+	std::uint8_t visible[kCullBatch_];
+	for( std::size_t base = 0; base < aCount; base += kCullBatch_ )
+	{
+		auto const count = std::min( kCullBatch_, aCount - base );
+		cull_( count, aInstances + base, geo.radius, clip, visible );
+
+		for( std::size_t i = 0; i < count; ++i )
+		{
+			if( !visible[i] )
+				continue;
+
+			transform_( geo, aInstances[base+i] );
+
+			auto const* px = geo.posX.data();
+			auto const* py = geo.posY.data();
+			for( std::size_t l = 0; l < indexCount; l += 2 )
+			{
+				auto const i0 = idx[l+0], i1 = idx[l+1];
+				draw_line_solid( aSurface, Vec2f{ px[i0], py[i0] }, Vec2f{ px[i1], py[i1] }, geo.lineColors[l/2] );
+			}
+		}
+	}
+}
+
+
+namespace
+{
+	Capture_::Capture_( Geometry_& aGeometry ) noexcept
+		: mGeometry( aGeometry )
+	{}
+
+	void Capture_::line( Vec2f aBegin, Vec2f aEnd, ColorU8_sRGB aColor )
+	{
+		ColorF const none{ 0.f, 0.f, 0.f };
+
+		auto const i0 = vertex_( aBegin, none );
+		auto const i1 = vertex_( aEnd, none );
+
+		mGeometry.indices.insert( mGeometry.indices.end(), { i0, i1 } );
+		mGeometry.lineColors.emplace_back( aColor );
+	}
+
+	void Capture_::triangle( Vec2f, Vec2f, Vec2f, ColorU8_sRGB )
+	{
+		// Not used by TriangleFan or LineStrip
+	}
+
+	void Capture_::triangle( Vec2f aP0, Vec2f aP1, Vec2f aP2, ColorF aC0, ColorF aC1, ColorF aC2 )
+	{
+		// Degenerate triangles are kept. Once transformed (and rounded),
+		// their vertices are usually no longer collinear, and
+		// draw_triangle_interp() may draw a few pixels for them.
+		auto const i0 = vertex_( aP0, aC0 );
+		auto const i1 = vertex_( aP1, aC1 );
+		auto const i2 = vertex_( aP2, aC2 );
+
+		mGeometry.indices.insert( mGeometry.indices.end(), { i0, i1, i2 } );
+	}
+
+	std::uint32_t Capture_::vertex_( Vec2f aPos, ColorF aCol )
+	{
+		auto& pos = mGeometry.positions;
+		auto& col = mGeometry.colors;
+
+		// Consecutive primitives of a fan or strip share vertices with the
+		// previous primitive, and with the first one (the fan's center, and
+		// the vertex that closes the fan). Only look there.
+		auto const count = pos.size();
+		auto const matches = [&] (std::size_t aIndex) {
+			return pos[aIndex].x == aPos.x && pos[aIndex].y == aPos.y
+				&& col[aIndex].r == aCol.r && col[aIndex].g == aCol.g && col[aIndex].b == aCol.b;
+		};
+
+		for( std::size_t i = count; i-- > 0 && i + 3 >= count; )
+		{
+			if( matches( i ) )
+				return std::uint32_t(i);
+		}
+		for( std::size_t i = 0; i < count && i < 3; ++i )
+		{
+			if( matches( i ) )
+				return std::uint32_t(i);
+		}
+
+		pos.emplace_back( aPos );
+		col.emplace_back( aCol );
+
+		mGeometry.radius = std::max( mGeometry.radius, length( aPos ) );
+
+		return std::uint32_t(count);
+	}
+
+
+	Geometry_& scratch_geometry_()
+	{
+		thread_local Geometry_ geo;
+
+		geo.positions.clear();
+		geo.colors.clear();
+		geo.indices.clear();
+		geo.lineColors.clear();
+		geo.setups.clear();
+		geo.radius = 0.f;
+
+		return geo;
+	}
+
+	void prepare_( Geometry_& aGeometry )
+	{
+		auto const count = aGeometry.positions.size();
+
+		aGeometry.objectX.resize( count );
+		aGeometry.objectY.resize( count );
+		aGeometry.posX.resize( count );
+		aGeometry.posY.resize( count );
+
+		for( std::size_t i = 0; i < count; ++i )
+		{
+			aGeometry.objectX[i] = aGeometry.positions[i].x;
+			aGeometry.objectY[i] = aGeometry.positions[i].y;
+		}
+	}
+
+	void setup_triangles_( Geometry_& aGeometry )
+	{
+		auto const& pos = aGeometry.positions;
+		auto const& col = aGeometry.colors;
+		auto const& idx = aGeometry.indices;
+
+		auto const channel = [] (Plane_ const& aW0, Plane_ const& aW1, double aC0, double aC1, double aC2) {
+			// c = c2 + (c0 - c2) * w0 + (c1 - c2) * w1
+			return Plane_{
+				float((aC0 - aC2) * aW0.ax + (aC1 - aC2) * aW1.ax),
+				float((aC0 - aC2) * aW0.ay + (aC1 - aC2) * aW1.ay),
+				float(aC2 + (aC0 - aC2) * aW0.c + (aC1 - aC2) * aW1.c)
+			};
+		};
+
+		for( std::size_t t = 0; t < idx.size(); t += 3 )
+		{
+			auto const i0 = idx[t+0], i1 = idx[t+1], i2 = idx[t+2];
+
+			// Same barycentric coordinates as draw_triangle_interp(), in
+			// double precision
+			double const x0 = pos[i0].x, y0 = pos[i0].y;
+			double const x1 = pos[i1].x, y1 = pos[i1].y;
+			double const x2 = pos[i2].x, y2 = pos[i2].y;
+
+			double const denom = (y1 - y2) * (x0 - x2) + (x2 - x1) * (y0 - y2);
+			if( 0.0 == denom )
+				continue;
+
+			double const a0 = (y1 - y2) / denom, b0 = (x2 - x1) / denom;
+			double const a1 = (y2 - y0) / denom, b1 = (x0 - x2) / denom;
+
+			Plane_ const w0{ float(a0), float(b0), float(-a0 * x2 - b0 * y2) };
+			Plane_ const w1{ float(a1), float(b1), float(-a1 * x2 - b1 * y2) };
+
+			TriangleSetup_ setup{};
+			setup.i0 = i0;
+			setup.i1 = i1;
+			setup.i2 = i2;
+			setup.w0 = w0;
+			setup.w1 = w1;
+			setup.r = channel( w0, w1, col[i0].r, col[i1].r, col[i2].r );
+			setup.g = channel( w0, w1, col[i0].g, col[i1].g, col[i2].g );
+			setup.b = channel( w0, w1, col[i0].b, col[i1].b, col[i2].b );
+
+			aGeometry.setups.emplace_back( setup );
+		}
+	}
+
+	ClipRect_ clip_rect_( Surface const& aSurface ) noexcept
+	{
+		ClipRect_ ret{ 0.f, 0.f, float(aSurface.get_width()), float(aSurface.get_height()) };
+
+		if( auto const* scissor = current_scissor() )
+		{
+			ret.minX = std::max( ret.minX, float(scissor->minX) );
+			ret.minY = std::max( ret.minY, float(scissor->minY) );
+			ret.maxX = std::min( ret.maxX, float(scissor->maxX) );
+			ret.maxY = std::min( ret.maxY, float(scissor->maxY) );
+		}
+
+		return ret;
+	}
+
+	void cull_( std::size_t aCount, ShapeInstance const* aInstances, float aRadius, ClipRect_ const& aClip, std::uint8_t* aVisible ) noexcept
+	{
+		// The transformed shape is inside a circle of radius |T|_F * aRadius
+		// around the translation (|T|_F is the Frobenius norm, which bounds
+		// how much T can stretch a vector).
+		std::size_t i = 0;
+
+#		if defined(INSTANCES_SSE2_)
+		static_assert( sizeof(Mat22f) == 4*sizeof(float) );
+
+		auto const radius = _mm_set1_ps( aRadius );
+		auto const margin = _mm_set1_ps( kCullMargin_ );
+		auto const minX = _mm_set1_ps( aClip.minX ), maxX = _mm_set1_ps( aClip.maxX );
+		auto const minY = _mm_set1_ps( aClip.minY ), maxY = _mm_set1_ps( aClip.maxY );
+
+		for( ; i + 4 <= aCount; i += 4 )
+		{
+			auto const* inst = aInstances + i;
+
+			// One matrix per register; after transposing, adding up the
+			// squares gives the four squared norms.
+			__m128 m0 = _mm_loadu_ps( &inst[0].transform._00 );
+			__m128 m1 = _mm_loadu_ps( &inst[1].transform._00 );
+			__m128 m2 = _mm_loadu_ps( &inst[2].transform._00 );
+			__m128 m3 = _mm_loadu_ps( &inst[3].transform._00 );
+			_MM_TRANSPOSE4_PS( m0, m1, m2, m3 );
+
+			auto const norm2 = _mm_add_ps(
+				_mm_add_ps( _mm_mul_ps( m0, m0 ), _mm_mul_ps( m1, m1 ) ),
+				_mm_add_ps( _mm_mul_ps( m2, m2 ), _mm_mul_ps( m3, m3 ) )
+			);
+			auto const r = _mm_add_ps( _mm_mul_ps( _mm_sqrt_ps( norm2 ), radius ), margin );
+
+			auto const cx = _mm_setr_ps( inst[0].translation.x, inst[1].translation.x, inst[2].translation.x, inst[3].translation.x );
+			auto const cy = _mm_setr_ps( inst[0].translation.y, inst[1].translation.y, inst[2].translation.y, inst[3].translation.y );
+
+			auto const inside = _mm_and_ps(
+				_mm_and_ps( _mm_cmpge_ps( _mm_add_ps( cx, r ), minX ), _mm_cmplt_ps( _mm_sub_ps( cx, r ), maxX ) ),
+				_mm_and_ps( _mm_cmpge_ps( _mm_add_ps( cy, r ), minY ), _mm_cmplt_ps( _mm_sub_ps( cy, r ), maxY ) )
+			);
+
+			auto const mask = _mm_movemask_ps( inside );
+			aVisible[i+0] = std::uint8_t(mask & 1);
+			aVisible[i+1] = std::uint8_t((mask >> 1) & 1);
+			aVisible[i+2] = std::uint8_t((mask >> 2) & 1);
+			aVisible[i+3] = std::uint8_t((mask >> 3) & 1);
+		}
+#		endif // ~ SSE2
+
+		for( ; i < aCount; ++i )
+		{
+			auto const& t = aInstances[i].transform;
+			auto const& c = aInstances[i].translation;
+
+			auto const norm = std::sqrt( t._00*t._00 + t._01*t._01 + t._10*t._10 + t._11*t._11 );
+			auto const r = norm * aRadius + kCullMargin_;
+
+			aVisible[i] = std::uint8_t(
+				(c.x + r >= aClip.minX) & (c.x - r < aClip.maxX) &
+				(c.y + r >= aClip.minY) & (c.y - r < aClip.maxY)
+			);
+		}
+	}
+
+	void transform_( Geometry_& aGeometry, ShapeInstance const& aInstance ) noexcept
+	{
+		// Same operations as TriangleFan::draw() (Mat22f times Vec2f, plus
+		// the translation), so that the vertices (and pixels) are identical.
+		// Separate x and y arrays let the compiler vectorize the loop.
+		auto const& t = aInstance.transform;
+		auto const& v = aInstance.translation;
+
+		auto const count = aGeometry.objectX.size();
+		auto const* inX = aGeometry.objectX.data();
+		auto const* inY = aGeometry.objectY.data();
+		auto* outX = aGeometry.posX.data();
+		auto* outY = aGeometry.posY.data();
+
+		for( std::size_t i = 0; i < count; ++i )
+		{
+			outX[i] = (t._00 * inX[i] + t._01 * inY[i]) + v.x;
+			outY[i] = (t._10 * inX[i] + t._11 * inY[i]) + v.y;
+		}
+	}
+
+	void fill_shared_( Surface& aSurface, Geometry_ const& aGeometry, ShapeInstance const& aInstance, ClipRect_ const& aClip, SrgbTable const& aSrgb )
+	{
+		// Object space positions are q = M * (p - v), with M the inverse of
+		// the instance's transform. An object space function a . q + c is
+		// thus (M^T a) . p + ... in screen space.
+		auto const& t = aInstance.transform;
+		auto const& v = aInstance.translation;
+
+		float const det = t._00 * t._11 - t._01 * t._10;
+		if( !(std::abs( det ) > 0.f) || !std::isfinite( det ) )
+			return;
+
+		float const m00 = t._11 / det, m01 = -t._01 / det;
+		float const m10 = -t._10 / det, m11 = t._00 / det;
+
+		auto const* px = aGeometry.posX.data();
+		auto const* py = aGeometry.posY.data();
+
+		for( auto const& setup : aGeometry.setups )
+		{
+			// Pixels whose centers are inside of the bounding box and the
+			// clip rectangle
+			auto const minX = std::min( { px[setup.i0], px[setup.i1], px[setup.i2] } );
+			auto const minY = std::min( { py[setup.i0], py[setup.i1], py[setup.i2] } );
+			auto const maxX = std::max( { px[setup.i0], px[setup.i1], px[setup.i2] } );
+			auto const maxY = std::max( { py[setup.i0], py[setup.i1], py[setup.i2] } );
+
+			auto const x0 = std::max( std::ceil( minX - 0.5f ), aClip.minX );
+			auto const y0 = std::max( std::ceil( minY - 0.5f ), aClip.minY );
+			auto const x1 = std::min( std::floor( maxX - 0.5f ), aClip.maxX - 1.f );
+			auto const y1 = std::min( std::floor( maxY - 0.5f ), aClip.maxY - 1.f );
+
+			if( !(x0 <= x1 && y0 <= y1) )
+				continue;
+
+			// Functions of the pixel offset from (x0, y0), evaluated at the
+			// pixel centers. Small offsets keep the rounding small.
+			float const ox = x0 + 0.5f - v.x, oy = y0 + 0.5f - v.y;
+			float const qx = m00 * ox + m01 * oy;
+			float const qy = m10 * ox + m11 * oy;
+
+			auto const to_pixels = [&] (Plane_ const& aPlane) {
+				return Plane_{
+					aPlane.ax * m00 + aPlane.ay * m10,
+					aPlane.ax * m01 + aPlane.ay * m11,
+					aPlane.ax * qx + aPlane.ay * qy + aPlane.c
+				};
+			};
+
+			Plane_ edges[3];
+			edges[0] = to_pixels( setup.w0 );
+			edges[1] = to_pixels( setup.w1 );
+			edges[2] = Plane_{ -edges[0].ax - edges[1].ax, -edges[0].ay - edges[1].ay, 1.f - edges[0].c - edges[1].c };
+
+			auto const r = to_pixels( setup.r );
+			auto const g = to_pixels( setup.g );
+			auto const b = to_pixels( setup.b );
+
+			auto const ix0 = static_cast<Surface::Index>(x0);
+			auto const iy0 = static_cast<Surface::Index>(y0);
+			auto const lastX = x1 - x0;
+			auto const rows = static_cast<Surface::Index>(y1 - y0) + 1;
+
+			for( Surface::Index j = 0; j < rows; ++j )
+			{
+				float const fy = float(j);
+
+				// Samples [lo, hi] of the row are inside of all three edges
+				float lo = 0.f, hi = lastX;
+				for( auto const& edge : edges )
+				{
+					auto const e = edge.ay * fy + edge.c + kEdgeTolerance_;
+					if( edge.ax > 0.f )
+						lo = std::max( lo, std::ceil( -e / edge.ax ) );
+					else if( edge.ax < 0.f )
+						hi = std::min( hi, std::floor( -e / edge.ax ) );
+					else if( e < 0.f )
+						hi = -1.f;
+				}
+
+				if( !(lo <= hi) )
+					continue;
+
+				float const rr = r.ay * fy + r.c;
+				float const gg = g.ay * fy + g.c;
+				float const bb = b.ay * fy + b.c;
+
+				auto const first = static_cast<Surface::Index>(lo);
+				auto const last = static_cast<Surface::Index>(hi);
+				for( auto i = first; i <= last; ++i )
+				{
+					float const fx = float(i);
+					ColorF const color{ rr + r.ax * fx, gg + g.ax * fx, bb + b.ax * fx };
+					aSurface.set_pixel_srgb( ix0 + i, iy0 + j, linear_to_srgb( aSrgb, color ) );
+				}
+			}
+		}
+	}
+}
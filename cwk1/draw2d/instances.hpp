@@ -0,0 +1,78 @@
+#ifndef INSTANCES_HPP_0B7E4D2A_58C3_4F19_A6D0_C3E92F71B845
+#define INSTANCES_HPP_0B7E4D2A_58C3_4F19_A6D0_C3E92F71B845
+
+#include <cstddef>
+
+#include "forward.hpp"
+
+#include "../vmlib/vec2.hpp"
+#include "../vmlib/mat22.hpp"
+
+/** Transform of one copy of a shape
+ *
+ * Same convention as TriangleFan::draw() and LineStrip::draw():
+ *
+ *   finalVertex = transform * vertex + translation
+ */
+struct ShapeInstance
+{
+	Mat22f transform;
+	Vec2f translation;
+};
+
+/** How draw_instances() fills a TriangleFan's triangles
+ *
+ * exact draws each triangle with draw_triangle_interp(), so the pixels are
+ * identical to TriangleFan::draw().
+ *
+ * shared sets each triangle up once, in object space: its barycentric
+ * coordinates and its colors are affine functions of the object space
+ * position. Per instance, these are moved to screen space with the inverse
+ * of the instance's transform (a few multiplications per function), and
+ * then stepped across the pixels. Pixels are sampled at their centers, like
+ * fill_polygon(). The result differs from exact at the edges of the
+ * triangles, where rounding decides, and by at most a step in the colors.
+ * Triangles that are degenerate in object space, and instances with a
+ * singular transform, are not drawn.
+ */
+enum class EInstanceFill
+{
+	exact,
+	shared
+};
+
+/** Draw many copies of one shape
+ *
+ * The result is the same as calling TriangleFan::draw() (LineStrip::draw())
+ * once per instance, in order. The work that does not depend on the
+ * instance is done once per call, though:
+ *  - the shape's triangles (lines) are captured in object space (see
+ *    draw_capture.hpp), and shared vertices are merged;
+ *  - the shape's bounding radius is computed, and instances are culled
+ *    against the surface and the current scissor in batches, four at a
+ *    time with SSE2;
+ *  - each visible instance transforms the merged vertices in one
+ *    (vectorized) pass.
+ *
+ * The triangles and lines are then drawn with draw_triangle_interp() and
+ * draw_line_solid(), which is what keeps the pixels identical. Filling
+ * usually dominates the cost; draw_triangle_interp() only tests the samples
+ * near each triangle (see draw.cpp). EInstanceFill::shared trades the
+ * identical pixels for a cheaper fill.
+ *
+ * Scratch memory is kept per thread, so steady-state calls do not allocate.
+ */
+void draw_instances(
+	Surface&,
+	TriangleFan const&,
+	std::size_t aCount, ShapeInstance const*,
+	EInstanceFill = EInstanceFill::exact
+);
+
+void draw_instances(
+	Surface&,
+	LineStrip const&, ColorF const&,
+	std::size_t aCount, ShapeInstance const*
+);
+
+#endif // INSTANCES_HPP_0B7E4D2A_58C3_4F19_A6D0_C3E92F71B845
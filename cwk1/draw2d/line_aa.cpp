@@ -0,0 +1,224 @@
+#include "line_aa.hpp"
+
+#include <algorithm>
+
+#include <cmath>
+#include <cassert>
+#include <cstdint>
+
+#include "surface.hpp"
+#include "scissor.hpp"
+
+namespace
+{
+	// Coordinates are clamped to +/- this before they are converted to
+	// integers. Anything this far out is clipped anyway.
+	constexpr float kMaxCoordinate_ = float(1 << 24);
+
+	// Linear light is stored with 12 bits per channel. This is enough to
+	// convert every sRGB value to linear and back without changes.
+	constexpr std::uint32_t kLinearMax_ = (1u << 12) - 1;
+
+	struct SrgbTables_
+	{
+		std::uint16_t toLinear[256];
+		std::uint8_t fromLinear[kLinearMax_+1];
+	};
+
+	// Color, tables and clip rectangle shared by the lines of a batch
+	struct LineTarget_
+	{
+		Surface& surface;
+		SrgbTables_ const& tables;
+
+		std::uint32_t color[3]; // linear, 12 bits
+		std::int64_t minX, minY, maxX, maxY;
+	};
+
+	SrgbTables_ const& srgb_tables_();
+
+	LineTarget_ make_target_( Surface&, ColorU8_sRGB );
+
+	// x-major (!tSteep) or y-major (tSteep) line
+	template< bool tSteep >
+	void draw_segment_( LineTarget_ const&, Vec2f aBegin, Vec2f aEnd );
+
+	// Blend aCoverage (out of 256) of the color into a pixel, given in major
+	// and minor coordinates
+	template< bool tSteep >
+	void plot_( LineTarget_ const&, std::int64_t aMajor, std::int64_t aMinor, std::uint32_t aCoverage );
+}
+
+void draw_line_aa( Surface& aSurface, Vec2f aBegin, Vec2f aEnd, ColorU8_sRGB aColor )
+{
+	LineSegment const segment{ aBegin, aEnd };
+	draw_lines_aa( aSurface, 1, &segment, aColor );
+}
+
+void draw_lines_aa( Surface& aSurface, std::size_t aCount, LineSegment const* aSegments, ColorU8_sRGB aColor )
+{
+	if( 0 == aCount )
+		return;
+
+	assert( aSegments );
+	auto const target = make_target_( aSurface, aColor );
+	if( target.minX >= target.maxX || target.minY >= target.maxY )
+		return;
+
+	for( std::size_t i = 0; i < aCount; ++i )
+	{
+		auto const& seg = aSegments[i];
+		if( std::abs( seg.end.y - seg.begin.y ) > std::abs( seg.end.x - seg.begin.x ) )
+			draw_segment_<true>( target, seg.begin, seg.end );
+		else
+			draw_segment_<false>( target, seg.begin, seg.end );
+	}
+}
+
+
+namespace
+{
+	SrgbTables_ const& srgb_tables_()
+	{
+		static SrgbTables_ const tables = [] {
+			SrgbTables_ ret{};
+			for( std::uint32_t i = 0; i < 256; ++i )
+				ret.toLinear[i] = std::uint16_t(std::lround( linear_from_srgb( std::uint8_t(i) ) * float(kLinearMax_) ));
+			for( std::uint32_t i = 0; i <= kLinearMax_; ++i )
+				ret.fromLinear[i] = linear_to_srgb( float(i) / float(kLinearMax_) );
+			return ret;
+		}();
+
+		return tables;
+	}
+
+	LineTarget_ make_target_( Surface& aSurface, ColorU8_sRGB aColor )
+	{
+		auto const& tables = srgb_tables_();
+
+		LineTarget_ ret{
+			aSurface, tables,
+			{ tables.toLinear[aColor.r], tables.toLinear[aColor.g], tables.toLinear[aColor.b] },
+			0, 0, aSurface.get_width(), aSurface.get_height()
+		};
+
+		if( auto const* scissor = current_scissor() )
+		{
+			ret.minX = std::max<std::int64_t>( ret.minX, scissor->minX );
+			ret.minY = std::max<std::int64_t>( ret.minY, scissor->minY );
+			ret.maxX = std::min<std::int64_t>( ret.maxX, scissor->maxX );
+			ret.maxY = std::min<std::int64_t>( ret.maxY, scissor->maxY );
+		}
+
+		return ret;
+	}
+
+	template< bool tSteep >
+	void draw_segment_( LineTarget_ const& aTarget, Vec2f aBegin, Vec2f aEnd )
+	{
+		// Major (u) and minor (v) coordinates, with u0 <= u1
+		auto u0 = tSteep ? aBegin.y : aBegin.x, v0 = tSteep ? aBegin.x : aBegin.y;
+		auto u1 = tSteep ? aEnd.y : aEnd.x, v1 = tSteep ? aEnd.x : aEnd.y;
+		if( u1 < u0 )
+		{
+			std::swap( u0, u1 );
+			std::swap( v0, v1 );
+		}
+
+		auto const du = u1 - u0;
+		if( !(du > 0.f) || !std::isfinite( du ) ) // zero length or NaN
+			return;
+
+		auto const minU = tSteep ? aTarget.minY : aTarget.minX;
+		auto const maxU = tSteep ? aTarget.maxY : aTarget.maxX;
+		auto const minV = tSteep ? aTarget.minX : aTarget.minY;
+		auto const maxV = tSteep ? aTarget.maxX : aTarget.maxY;
+
+		// Lines that cannot touch the clip rectangle
+		if( !(std::max( v0, v1 ) >= float(minV) - 1.f) || !(std::min( v0, v1 ) <= float(maxV) + 1.f) )
+			return;
+
+		// Columns that the line spans, [c0, c1], and the visible ones
+		auto const c0 = std::int64_t(std::floor( std::clamp( u0, -kMaxCoordinate_, kMaxCoordinate_ ) ));
+		auto const c1 = std::int64_t(std::ceil( std::clamp( u1, -kMaxCoordinate_, kMaxCoordinate_ ) )) - 1;
+
+		auto const first = std::max( c0, minU );
+		auto const last = std::min( c1, maxU-1 );
+		if( first > last )
+			return;
+
+		auto const grad = (v1 - v0) / du; // |grad| <= 1
+		auto const row_at = [&] (float aU) {
+			// Minor coordinate relative to pixel centers, i.e., the line
+			// passes through the center of row r at r.0
+			return std::clamp( v0 + (aU - u0) * grad - 0.5f, -kMaxCoordinate_, kMaxCoordinate_ );
+		};
+
+		// End columns are only partially spanned. Weight their coverage by
+		// the spanned part and sample the line in the middle of it.
+		auto const end_column = [&] (std::int64_t aColumn) {
+			auto const lo = std::max( u0, float(aColumn) );
+			auto const hi = std::min( u1, float(aColumn+1) );
+
+			auto const v = row_at( 0.5f * (lo + hi) );
+			auto const row = std::floor( v );
+			auto const frac = v - row;
+
+			auto const weight = 256.f * (hi - lo);
+			plot_<tSteep>( aTarget, aColumn, std::int64_t(row), std::uint32_t((1.f - frac) * weight + 0.5f) );
+			plot_<tSteep>( aTarget, aColumn, std::int64_t(row)+1, std::uint32_t(frac * weight + 0.5f) );
+		};
+
+		auto column = first;
+		if( column == c0 )
+			end_column( column++ );
+
+		// Interior columns: step along the line in 16.16 fixed point. The
+		// top 8 bits of the fraction are the coverage of the upper pixel.
+		auto const interiorLast = std::min( last, c1-1 );
+		if( column <= interiorLast )
+		{
+			auto v = std::int64_t(std::llround( double(row_at( float(column) + 0.5f )) * 65536.0 ));
+			auto const step = std::int64_t(std::llround( double(grad) * 65536.0 ));
+
+			for( ; column <= interiorLast; ++column, v += step )
+			{
+				auto const row = v >> 16;
+				auto const frac = std::uint32_t(v >> 8) & 0xffu;
+
+				plot_<tSteep>( aTarget, column, row, 256 - frac );
+				plot_<tSteep>( aTarget, column, row+1, frac );
+			}
+		}
+
+		if( column == c1 && column <= last )
+			end_column( column );
+	}
+
+	template< bool tSteep >
+	void plot_( LineTarget_ const& aTarget, std::int64_t aMajor, std::int64_t aMinor, std::uint32_t aCoverage )
+	{
+		auto const x = tSteep ? aMinor : aMajor;
+		auto const y = tSteep ? aMajor : aMinor;
+
+		if( 0 == aCoverage || x < aTarget.minX || x >= aTarget.maxX || y < aTarget.minY || y >= aTarget.maxY )
+			return;
+
+		assert( aCoverage <= 256 );
+
+		auto const px = Surface::Index(x), py = Surface::Index(y);
+		auto const* pixel = aTarget.surface.get_surface_ptr() + aTarget.surface.get_linear_index( px, py );
+
+		auto const& tables = aTarget.tables;
+		auto const blend = [&] (std::uint8_t aDst, std::uint32_t aSrc) {
+			auto const dst = std::uint32_t(tables.toLinear[aDst]);
+			return tables.fromLinear[(dst * (256 - aCoverage) + aSrc * aCoverage + 128) >> 8];
+		};
+
+		aTarget.surface.set_pixel_srgb( px, py, {
+			blend( pixel[0], aTarget.color[0] ),
+			blend( pixel[1], aTarget.color[1] ),
+			blend( pixel[2], aTarget.color[2] )
+		} );
+	}
+}
@@ -0,0 +1,39 @@
+#ifndef LINE_AA_HPP_5B2E9D71_C4A8_4E03_9F6B_18D7A3C0E52F
+#define LINE_AA_HPP_5B2E9D71_C4A8_4E03_9F6B_18D7A3C0E52F
+
+#include <cstddef>
+
+#include "forward.hpp"
+#include "color.hpp"
+
+#include "../vmlib/vec2.hpp"
+
+/** Antialiased lines
+ *
+ * Lines are drawn with Xiaolin Wu's algorithm: each column (or row, for
+ * steep lines) of the line covers the two pixels whose centers are closest
+ * to the line, weighted by the distance of the line to the centers. The
+ * line's position and the coverage are tracked in fixed point (16.16 and 8
+ * bits, respectively). The end columns are weighted by how much of them the
+ * line spans, so that lines with sub-pixel end points do not pop.
+ *
+ * The color is blended with the surface in linear light: pixels are
+ * converted with lookup tables (sRGB to 12 bit linear, and back), instead of
+ * calling linear_from_srgb()/linear_to_srgb() per pixel.
+ *
+ * Unlike draw_line_solid(), which is aliased and where both end points are
+ * drawn, the lines are one pixel wide and span exactly [aBegin, aEnd].
+ * Clipped to the surface and the current scissor.
+ */
+void draw_line_aa( Surface&, Vec2f aBegin, Vec2f aEnd, ColorU8_sRGB );
+
+struct LineSegment
+{
+	Vec2f begin, end;
+};
+
+// Draw many lines in one color. This only sets up the color and clipping
+// once; otherwise equivalent to calling draw_line_aa() for each segment.
+void draw_lines_aa( Surface&, std::size_t aCount, LineSegment const*, ColorU8_sRGB );
+
+#endif // LINE_AA_HPP_5B2E9D71_C4A8_4E03_9F6B_18D7A3C0E52F
@@ -0,0 +1,178 @@
+#include "mipmap.hpp"
+
+#include <array>
+#include <utility>
+#include <algorithm>
+
+#include <cmath>
+#include <cassert>
+#include <cstdint>
+
+#include "color.hpp"
+#include "image.hpp"
+#include "surface.hpp"
+#include "image_alloc.hpp"
+
+#include "../vmlib/mat22.hpp"
+
+namespace
+{
+	// linear_from_srgb() involves a std::pow(); there are only 256 distinct
+	// inputs, so tabulate them.
+	std::array<float,256> const& srgb_to_linear_table_();
+}
+
+MipChainRGBA::MipChainRGBA( std::unique_ptr<ImageRGBA> aImage, std::size_t aMaxLevels )
+{
+	assert( aImage );
+	assert( aMaxLevels >= 1 );
+
+	mLevels.emplace_back( std::move(aImage) );
+
+	while( mLevels.size() < aMaxLevels )
+	{
+		auto const& prev = *mLevels.back();
+		if( prev.get_width() <= 1 && prev.get_height() <= 1 )
+			break;
+
+		mLevels.emplace_back( downsample_box_2x( prev ) );
+	}
+}
+
+MipChainRGBA::~MipChainRGBA() = default;
+
+MipChainRGBA::MipChainRGBA( MipChainRGBA&& ) noexcept = default;
+MipChainRGBA& MipChainRGBA::operator= (MipChainRGBA&&) noexcept = default;
+
+std::size_t MipChainRGBA::level_count() const noexcept
+{
+	return mLevels.size();
+}
+ImageRGBA const& MipChainRGBA::level( std::size_t aLevel ) const noexcept
+{
+	assert( aLevel < mLevels.size() );
+	return *mLevels[aLevel];
+}
+
+std::size_t MipChainRGBA::select_level( float aScale ) const noexcept
+{
+	if( !(aScale < 1.f) )
+		return 0;
+
+	// Level L is 2^-L times the original size; pick L nearest to -log2(scale)
+	float const ideal = -std::log2( std::max( aScale, 1e-6f ) );
+	auto const level = std::size_t(ideal + 0.5f);
+
+	return std::min( level, mLevels.size()-1 );
+}
+
+
+std::unique_ptr<ImageRGBA> downsample_box_2x( ImageRGBA const& aSource )
+{
+	auto const sw = aSource.get_width();
+	auto const sh = aSource.get_height();
+
+	// Round up, such that odd sizes keep their last row/column
+	auto const dw = (sw + 1) / 2;
+	auto const dh = (sh + 1) / 2;
+
+	auto result = create_image( dw, dh );
+
+	auto const& lin = srgb_to_linear_table_();
+
+	std::uint8_t const* src = aSource.get_image_ptr();
+	std::uint8_t* dst = result->get_image_ptr();
+
+	for( ImageRGBA::Index y = 0; y < dh; ++y )
+	{
+		// Odd sizes: the last row/column has no partner; it is used twice
+		// (clamp to edge)
+		ImageRGBA::Index const sy[2] = { std::min( 2*y, sh-1 ), std::min( 2*y+1, sh-1 ) };
+
+		for( ImageRGBA::Index x = 0; x < dw; ++x )
+		{
+			ImageRGBA::Index const sx[2] = { std::min( 2*x, sw-1 ), std::min( 2*x+1, sw-1 ) };
+
+			// Alpha-weighted average of the four texels in linear light.
+			float r = 0.f, g = 0.f, b = 0.f, a = 0.f;
+			for( auto const yy : sy )
+			{
+				for( auto const xx : sx )
+				{
+					std::uint8_t const* texel = src + aSource.get_linear_index( xx, yy ) * 4;
+					float const alpha = float(texel[3]);
+
+					r += alpha * lin[texel[0]];
+					g += alpha * lin[texel[1]];
+					b += alpha * lin[texel[2]];
+					a += alpha;
+				}
+			}
+
+			std::uint8_t* out = dst + result->get_linear_index( x, y ) * 4;
+			if( a > 0.f )
+			{
+				float const norm = 1.f / a;
+				out[0] = linear_to_srgb( std::min( 1.f, r * norm ) );
+				out[1] = linear_to_srgb( std::min( 1.f, g * norm ) );
+				out[2] = linear_to_srgb( std::min( 1.f, b * norm ) );
+			}
+
+			out[3] = std::uint8_t(a * 0.25f + 0.5f);
+		}
+	}
+
+	return result;
+}
+
+MipChainRGBA load_mip_chain( char const* aPath, std::size_t aMaxLevels )
+{
+	return MipChainRGBA( load_image( aPath ), aMaxLevels );
+}
+
+
+void blit_masked_scaled( Surface& aSurface, MipChainRGBA const& aChain, Vec2f aPosition, float aScale, EBlitFilter aFilter )
+{
+	if( !(aScale > 0.f) )
+		return;
+
+	auto const& base = aChain.level( 0 );
+	auto const& image = aChain.level( aChain.select_level( aScale ) );
+
+	// Requested size in pixels, and the scale relative to the selected level
+	float const destW = aScale * float(base.get_width());
+	float const destH = aScale * float(base.get_height());
+
+	float const sx = destW / float(image.get_width());
+	float const sy = destH / float(image.get_height());
+
+	// Exact match (within half a pixel): plain masked blit.
+	if( std::abs( destW - float(image.get_width()) ) < 0.5f && std::abs( destH - float(image.get_height()) ) < 0.5f )
+	{
+		blit_masked( aSurface, image, aPosition );
+		return;
+	}
+
+	blit_masked_affine(
+		aSurface, image,
+		Mat22f{ sx, 0.f, 0.f, sy },
+		aPosition + 0.5f * Vec2f{ destW, destH },
+		aFilter
+	);
+}
+
+
+namespace
+{
+	std::array<float,256> const& srgb_to_linear_table_()
+	{
+		static std::array<float,256> const table = [] {
+			std::array<float,256> ret{};
+			for( std::size_t i = 0; i < ret.size(); ++i )
+				ret[i] = linear_from_srgb( std::uint8_t(i) );
+			return ret;
+		}();
+
+		return table;
+	}
+}
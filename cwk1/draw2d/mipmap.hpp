@@ -0,0 +1,88 @@
+#ifndef MIPMAP_HPP_93C1F5A7_0E42_4B8D_A6D3_7F25C8E9B140
+#define MIPMAP_HPP_93C1F5A7_0E42_4B8D_A6D3_7F25C8E9B140
+
+#include <memory>
+#include <vector>
+
+#include <cstddef>
+
+#include "forward.hpp"
+#include "blit.hpp"
+
+#include "../vmlib/vec2.hpp"
+
+/** Mip chain - an image with progressively downscaled versions
+ *
+ * Level 0 is the original image. Each following level is half the size of
+ * the previous one (rounded up) in each direction. Levels are generated with
+ * a 2x2 box filter; for odd sizes, the texels of the last row/column are
+ * counted twice instead of being dropped. The filtering is done in linear
+ * light and weighted by alpha, so that downscaled images neither darken nor
+ * pick up the color of fully transparent pixels.
+ *
+ * The chain is generated once, when it is constructed. Blitting from a
+ * smaller level reads less memory and aliases less than sampling the full
+ * resolution image when drawing an image at a reduced size.
+ */
+class MipChainRGBA final
+{
+	public:
+		static constexpr std::size_t kAllLevels = ~std::size_t(0);
+
+	public:
+		// Generate up to aMaxLevels levels (including the original image).
+		// Generation stops early when a level is 1x1 pixels.
+		explicit MipChainRGBA( std::unique_ptr<ImageRGBA>, std::size_t aMaxLevels = kAllLevels );
+		~MipChainRGBA();
+
+		// Not copyable but movable
+		MipChainRGBA( MipChainRGBA const& ) = delete;
+		MipChainRGBA& operator= (MipChainRGBA const&) = delete;
+
+		MipChainRGBA( MipChainRGBA&& ) noexcept;
+		MipChainRGBA& operator= (MipChainRGBA&&) noexcept;
+
+	public:
+		std::size_t level_count() const noexcept;
+		ImageRGBA const& level( std::size_t ) const noexcept;
+
+		// Pick the level that best matches drawing the original image at
+		// aScale times its size; i.e., the one whose size is nearest to the
+		// requested size in a log2 sense.
+		std::size_t select_level( float aScale ) const noexcept;
+
+	private:
+		std::vector<std::unique_ptr<ImageRGBA>> mLevels;
+};
+
+/** Generate a single downscaled level
+ *
+ * Returns an image that is half the size of the input, rounded up. See
+ * MipChainRGBA.
+ */
+std::unique_ptr<ImageRGBA> downsample_box_2x( ImageRGBA const& );
+
+/** Load an image and generate its mip chain
+ *
+ * Equivalent to MipChainRGBA( load_image( aPath ), aMaxLevels ).
+ */
+MipChainRGBA load_mip_chain( char const* aPath, std::size_t aMaxLevels = MipChainRGBA::kAllLevels );
+
+/** Blit image scaled by aScale, using the nearest mip level
+ *
+ * aPosition is the destination of the top-left corner of the image, as with
+ * blit_masked(). The destination size is aScale times the size of level 0.
+ * The level is chosen with MipChainRGBA::select_level(). If the selected
+ * level matches the requested size exactly (e.g., aScale = 0.5 and level
+ * 1), the level is blitted directly with blit_masked(); otherwise, the
+ * residual scaling is done by blit_masked_affine() with the requested filter.
+ */
+void blit_masked_scaled(
+	Surface&,
+	MipChainRGBA const&,
+	Vec2f aPosition,
+	float aScale,
+	EBlitFilter = EBlitFilter::nearest
+);
+
+#endif // MIPMAP_HPP_93C1F5A7_0E42_4B8D_A6D3_7F25C8E9B140
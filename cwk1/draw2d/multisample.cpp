@@ -0,0 +1,377 @@
+#include "multisample.hpp"
+
+#include <algorithm>
+
+#include <cmath>
+#include <cassert>
+
+#include "surface.hpp"
+#include "scissor.hpp"
+
+namespace
+{
+	// Vertices are snapped to 1/256 pixels
+	constexpr std::int64_t kSubpixelBits_ = 8;
+	constexpr std::int64_t kOne_ = std::int64_t(1) << kSubpixelBits_;
+
+	// Sample offsets are given in 1/16 pixels
+	constexpr std::int64_t kSampleScale_ = kOne_ / 16;
+
+	// Vertices are clamped to +/- this before they are converted to fixed
+	// point, which keeps the edge functions well within 64 bits.
+	constexpr float kMaxCoordinate_ = float(1 << 20);
+
+	struct Fixed_
+	{
+		std::int64_t x, y;
+	};
+
+	Fixed_ to_fixed_( Vec2f ) noexcept;
+
+	// Surface clipped to the current scissor
+	ScissorRect clip_rect_( std::uint32_t aWidth, std::uint32_t aHeight ) noexcept;
+
+	// Liang-Barsky; returns false if the line is outside of the rectangle
+	bool clip_line_( Vec2f& aBegin, Vec2f& aEnd, ScissorRect const& ) noexcept;
+
+	std::uint32_t pack_( ColorU8_sRGB ) noexcept;
+	ColorU8_sRGB unpack_( std::uint32_t ) noexcept;
+
+	ColorF saturate_( ColorF ) noexcept;
+
+	// Linear light of each sRGB value
+	float const* linear_table_();
+}
+
+MultisampleSurface::MultisampleSurface( Index aWidth, Index aHeight )
+	: mWidth( aWidth )
+	, mHeight( aHeight )
+	, mSamples( std::size_t(aWidth) * aHeight * kSamples )
+{}
+
+MultisampleSurface::Index MultisampleSurface::get_width() const noexcept
+{
+	return mWidth;
+}
+MultisampleSurface::Index MultisampleSurface::get_height() const noexcept
+{
+	return mHeight;
+}
+
+void MultisampleSurface::clear( ColorU8_sRGB aColor ) noexcept
+{
+	std::fill( mSamples.begin(), mSamples.end(), pack_( aColor ) );
+}
+
+void MultisampleSurface::triangle_solid( Vec2f aP0, Vec2f aP1, Vec2f aP2, ColorU8_sRGB aColor )
+{
+	auto const color = pack_( aColor );
+	rasterize_( aP0, aP1, aP2, [color] (std::int64_t const*, float) {
+		return color;
+	} );
+}
+
+void MultisampleSurface::triangle_interp( Vec2f aP0, Vec2f aP1, Vec2f aP2, ColorF aC0, ColorF aC1, ColorF aC2 )
+{
+	rasterize_( aP0, aP1, aP2, [&] (std::int64_t const* aEdges, float aInvArea) {
+		// The pixel center may be outside of the triangle if it is only
+		// partially covered; the color is clamped to the range that it
+		// would have inside.
+		auto const w0 = float(aEdges[0]) * aInvArea;
+		auto const w1 = float(aEdges[1]) * aInvArea;
+		auto const w2 = float(aEdges[2]) * aInvArea;
+		return pack_( linear_to_srgb( saturate_( aC0 * w0 + aC1 * w1 + aC2 * w2 ) ) );
+	} );
+}
+
+void MultisampleSurface::line_solid( Vec2f aBegin, Vec2f aEnd, ColorU8_sRGB aColor )
+{
+	auto const clip = clip_rect_( mWidth, mHeight );
+	if( !clip_line_( aBegin, aEnd, clip ) )
+		return;
+
+	// DDA, both ends included
+	auto const dx = aEnd.x - aBegin.x, dy = aEnd.y - aBegin.y;
+	auto const steps = std::size_t(std::ceil( std::max( std::abs( dx ), std::abs( dy ) ) ));
+
+	auto const color = pack_( aColor );
+	for( std::size_t i = 0; i <= steps; ++i )
+	{
+		auto const t = steps ? float(i) / float(steps) : 0.f;
+		auto const x = std::int64_t(std::floor( aBegin.x + t * dx ));
+		auto const y = std::int64_t(std::floor( aBegin.y + t * dy ));
+
+		if( x < clip.minX || x >= clip.maxX || y < clip.minY || y >= clip.maxY )
+			continue;
+
+		auto* samples = mSamples.data() + (std::size_t(y) * mWidth + std::size_t(x)) * kSamples;
+		std::fill_n( samples, kSamples, color );
+	}
+}
+
+void MultisampleSurface::resolve( Surface& aSurface ) const
+{
+	assert( aSurface.get_width() == mWidth && aSurface.get_height() == mHeight );
+
+	auto const* linear = linear_table_();
+	auto const* samples = mSamples.data();
+
+	for( Index y = 0; y < mHeight; ++y )
+	{
+		for( Index x = 0; x < mWidth; ++x, samples += kSamples )
+		{
+			auto const first = samples[0];
+			if( first == samples[1] && first == samples[2] && first == samples[3] )
+			{
+				aSurface.set_pixel_srgb( x, y, unpack_( first ) );
+				continue;
+			}
+
+			ColorF sum{ 0.f, 0.f, 0.f };
+			for( Index s = 0; s < kSamples; ++s )
+			{
+				sum.r += linear[samples[s] & 0xff];
+				sum.g += linear[(samples[s] >> 8) & 0xff];
+				sum.b += linear[(samples[s] >> 16) & 0xff];
+			}
+
+			aSurface.set_pixel_srgb( x, y, linear_to_srgb( sum * (1.f / kSamples) ) );
+		}
+	}
+}
+
+
+template< class tShade >
+void MultisampleSurface::rasterize_( Vec2f aP0, Vec2f aP1, Vec2f aP2, tShade&& aShade )
+{
+	static_assert( 4 == kSamples, "coverage test assumes four samples" );
+
+	Fixed_ const v[3] = { to_fixed_( aP0 ), to_fixed_( aP1 ), to_fixed_( aP2 ) };
+
+	// Twice the signed area. Edge functions are flipped for clockwise
+	// triangles, so that they are positive inside of every triangle.
+	auto const area = (v[1].x - v[0].x) * (v[2].y - v[0].y) - (v[1].y - v[0].y) * (v[2].x - v[0].x);
+	if( 0 == area )
+		return;
+
+	std::int64_t const sign = area > 0 ? 1 : -1;
+
+	// Bounding box in pixels, clipped
+	auto const clip = clip_rect_( mWidth, mHeight );
+	auto const minX = std::max<std::int64_t>( clip.minX, std::min( { v[0].x, v[1].x, v[2].x } ) >> kSubpixelBits_ );
+	auto const minY = std::max<std::int64_t>( clip.minY, std::min( { v[0].y, v[1].y, v[2].y } ) >> kSubpixelBits_ );
+	auto const maxX = std::min<std::int64_t>( clip.maxX, (std::max( { v[0].x, v[1].x, v[2].x } ) >> kSubpixelBits_) + 1 );
+	auto const maxY = std::min<std::int64_t>( clip.maxY, (std::max( { v[0].y, v[1].y, v[2].y } ) >> kSubpixelBits_) + 1 );
+	if( minX >= maxX || minY >= maxY )
+		return;
+
+	// Edge k is opposite of vertex k: E_k(p) = a*p.x + b*p.y + c. Samples
+	// exactly on an edge are covered if the edge points downwards (or
+	// exactly to the right). Of two triangles that share an edge, the edge
+	// points downwards in exactly one.
+	std::int64_t a[3], b[3], c[3], bias[3];
+	for( int k = 0; k < 3; ++k )
+	{
+		auto const& from = v[(k+1) % 3];
+		auto const& to = v[(k+2) % 3];
+
+		auto const dx = sign * (to.x - from.x);
+		auto const dy = sign * (to.y - from.y);
+
+		a[k] = -dy;
+		b[k] = dx;
+		c[k] = dy * from.x - dx * from.y;
+		bias[k] = (dy < 0 || (0 == dy && dx > 0)) ? 0 : -1;
+	}
+
+	auto const invArea = 1.f / float(sign * area);
+
+	for( auto y = minY; y < maxY; ++y )
+	{
+		// Edge functions at the samples and at the center of the row's
+		// first pixel
+		std::int64_t edges[3][kSamples];
+		std::int64_t center[3];
+
+		auto const px = minX * kOne_ + kOne_/2;
+		auto const py = y * kOne_ + kOne_/2;
+		for( int k = 0; k < 3; ++k )
+		{
+			center[k] = a[k] * px + b[k] * py + c[k];
+			for( Index s = 0; s < kSamples; ++s )
+			{
+				edges[k][s] = center[k] + bias[k]
+					+ a[k] * (kSampleOffsets[s][0] * kSampleScale_)
+					+ b[k] * (kSampleOffsets[s][1] * kSampleScale_)
+				;
+			}
+		}
+
+		std::int64_t const step[3] = { a[0] * kOne_, a[1] * kOne_, a[2] * kOne_ };
+
+		auto* samples = mSamples.data() + (std::size_t(y) * mWidth + std::size_t(minX)) * kSamples;
+		for( auto x = minX; x < maxX; ++x, samples += kSamples )
+		{
+			// A sample is covered if no edge function is negative
+			std::uint32_t mask = 0;
+			for( Index s = 0; s < kSamples; ++s )
+				mask |= std::uint32_t((edges[0][s] | edges[1][s] | edges[2][s]) >= 0) << s;
+
+			if( mask )
+			{
+				auto const color = aShade( center, invArea );
+				if( 0xfu == mask )
+				{
+					samples[0] = samples[1] = samples[2] = samples[3] = color;
+				}
+				else
+				{
+					for( Index s = 0; s < kSamples; ++s )
+					{
+						if( mask & (1u << s) )
+							samples[s] = color;
+					}
+				}
+			}
+
+			for( int k = 0; k < 3; ++k )
+			{
+				center[k] += step[k];
+				for( Index s = 0; s < kSamples; ++s )
+					edges[k][s] += step[k];
+			}
+		}
+	}
+}
+
+
+ScopedMultisample::ScopedMultisample( MultisampleSurface& aTarget ) noexcept
+	: mCapture( aTarget )
+	, mScope( mCapture )
+{}
+
+ScopedMultisample::Capture_::Capture_( MultisampleSurface& aTarget ) noexcept
+	: mTarget( aTarget )
+{}
+
+void ScopedMultisample::Capture_::line( Vec2f aBegin, Vec2f aEnd, ColorU8_sRGB aColor )
+{
+	mTarget.line_solid( aBegin, aEnd, aColor );
+}
+
+void ScopedMultisample::Capture_::triangle( Vec2f aP0, Vec2f aP1, Vec2f aP2, ColorU8_sRGB aColor )
+{
+	mTarget.triangle_solid( aP0, aP1, aP2, aColor );
+}
+
+void ScopedMultisample::Capture_::triangle( Vec2f aP0, Vec2f aP1, Vec2f aP2, ColorF aC0, ColorF aC1, ColorF aC2 )
+{
+	mTarget.triangle_interp( aP0, aP1, aP2, aC0, aC1, aC2 );
+}
+
+
+namespace
+{
+	Fixed_ to_fixed_( Vec2f aPoint ) noexcept
+	{
+		// NaNs end up at -kMaxCoordinate_
+		auto const fixed = [] (float aValue) {
+			if( !(aValue > -kMaxCoordinate_) )
+				aValue = -kMaxCoordinate_;
+			aValue = std::min( aValue, kMaxCoordinate_ );
+			return std::int64_t(std::llround( double(aValue) * double(kOne_) ));
+		};
+
+		return Fixed_{ fixed( aPoint.x ), fixed( aPoint.y ) };
+	}
+
+	ScissorRect clip_rect_( std::uint32_t aWidth, std::uint32_t aHeight ) noexcept
+	{
+		ScissorRect clip{ 0, 0, aWidth, aHeight };
+		if( auto const* scissor = current_scissor() )
+		{
+			clip.minX = std::max( clip.minX, scissor->minX );
+			clip.minY = std::max( clip.minY, scissor->minY );
+			clip.maxX = std::min( clip.maxX, scissor->maxX );
+			clip.maxY = std::min( clip.maxY, scissor->maxY );
+		}
+
+		return clip;
+	}
+
+	bool clip_line_( Vec2f& aBegin, Vec2f& aEnd, ScissorRect const& aClip ) noexcept
+	{
+		if( aClip.minX >= aClip.maxX || aClip.minY >= aClip.maxY )
+			return false;
+
+		auto const dx = aEnd.x - aBegin.x, dy = aEnd.y - aBegin.y;
+
+		float const p[4] = { -dx, dx, -dy, dy };
+		float const q[4] = {
+			aBegin.x - float(aClip.minX),
+			float(aClip.maxX) - aBegin.x,
+			aBegin.y - float(aClip.minY),
+			float(aClip.maxY) - aBegin.y
+		};
+
+		float t0 = 0.f, t1 = 1.f;
+		for( int i = 0; i < 4; ++i )
+		{
+			if( 0.f == p[i] )
+			{
+				if( q[i] < 0.f )
+					return false;
+				continue;
+			}
+
+			auto const t = q[i] / p[i];
+			if( p[i] < 0.f )
+				t0 = std::max( t0, t );
+			else
+				t1 = std::min( t1, t );
+		}
+
+		if( !(t0 <= t1) )
+			return false;
+
+		Vec2f const begin = aBegin;
+		aBegin = begin + t0 * Vec2f{ dx, dy };
+		aEnd = begin + t1 * Vec2f{ dx, dy };
+		return true;
+	}
+
+	std::uint32_t pack_( ColorU8_sRGB aColor ) noexcept
+	{
+		return std::uint32_t(aColor.r) | std::uint32_t(aColor.g) << 8 | std::uint32_t(aColor.b) << 16;
+	}
+
+	ColorU8_sRGB unpack_( std::uint32_t aPacked ) noexcept
+	{
+		return ColorU8_sRGB{
+			std::uint8_t(aPacked & 0xff),
+			std::uint8_t((aPacked >> 8) & 0xff),
+			std::uint8_t((aPacked >> 16) & 0xff)
+		};
+	}
+
+	ColorF saturate_( ColorF aColor ) noexcept
+	{
+		return ColorF{
+			std::clamp( aColor.r, 0.f, 1.f ),
+			std::clamp( aColor.g, 0.f, 1.f ),
+			std::clamp( aColor.b, 0.f, 1.f )
+		};
+	}
+
+	float const* linear_table_()
+	{
+		static auto const table = [] {
+			struct Table_ { float values[256]; } ret{};
+			for( std::uint32_t i = 0; i < 256; ++i )
+				ret.values[i] = linear_from_srgb( std::uint8_t(i) );
+			return ret;
+		}();
+
+		return table.values;
+	}
+}
@@ -0,0 +1,113 @@
+#ifndef MULTISAMPLE_HPP_0E6B3D94_A8C1_4F27_B5D0_7C29E4A1F836
+#define MULTISAMPLE_HPP_0E6B3D94_A8C1_4F27_B5D0_7C29E4A1F836
+
+#include <vector>
+
+#include <cstdint>
+
+#include "forward.hpp"
+#include "color.hpp"
+#include "draw_capture.hpp"
+
+#include "../vmlib/vec2.hpp"
+
+/** Multisampled render target (4x MSAA)
+ *
+ * Each pixel stores four color samples, at the positions of the rotated
+ * grid pattern. Triangles are rasterized against all four samples with
+ * fixed-point edge functions, which gives a four bit coverage mask per
+ * pixel. The pixel is shaded once (at its center), and the color is written
+ * to the covered samples only. Samples exactly on an edge belong to exactly
+ * one of the triangles that share the edge.
+ *
+ * resolve() averages the samples of each pixel in linear light into a
+ * Surface. Pixels whose samples are all equal (i.e., the inside of shapes)
+ * are copied as they are.
+ *
+ * Compared to drawing at twice the resolution and downsampling, coverage is
+ * as precise, but the color is computed once per pixel instead of four
+ * times, and fully covered pixels are written with a single store.
+ *
+ * Lines are not antialiased: they cover all samples of the pixels that
+ * draw_line_solid() would set, approximately.
+ */
+class MultisampleSurface
+{
+	public:
+		using Index = std::uint32_t;
+
+	public:
+		MultisampleSurface( Index aWidth, Index aHeight );
+
+	public:
+		Index get_width() const noexcept;
+		Index get_height() const noexcept;
+
+		void clear( ColorU8_sRGB = { 0, 0, 0 } ) noexcept;
+
+		// These are clipped to the surface and to the current scissor, like
+		// their counterparts from draw.hpp.
+		void triangle_solid( Vec2f aP0, Vec2f aP1, Vec2f aP2, ColorU8_sRGB );
+		void triangle_interp( Vec2f aP0, Vec2f aP1, Vec2f aP2, ColorF aC0, ColorF aC1, ColorF aC2 );
+		void line_solid( Vec2f aBegin, Vec2f aEnd, ColorU8_sRGB );
+
+		// Write the averaged samples to the surface, which must be the same
+		// size. Every pixel is written (the scissor is ignored).
+		void resolve( Surface& ) const;
+
+	public: // Configuration values
+		static constexpr Index kSamples = 4;
+
+		// Sample positions relative to the pixel center, in 1/16 pixels
+		static constexpr std::int32_t kSampleOffsets[kSamples][2] = {
+			{ -2, -6 }, { 6, -2 }, { -6, 2 }, { 2, 6 }
+		};
+
+	private:
+		template< class tShade >
+		void rasterize_( Vec2f aP0, Vec2f aP1, Vec2f aP2, tShade&& );
+
+	private:
+		Index mWidth, mHeight;
+
+		// kSamples per pixel, packed as 0x00BBGGRR (sRGB)
+		std::vector<std::uint32_t> mSamples;
+};
+
+/** Draw into a MultisampleSurface
+ *
+ * While a ScopedMultisample exists, draw_triangle_solid(),
+ * draw_triangle_interp() and draw_line_solid() (and with them, TriangleFan
+ * and LineStrip) draw into its MultisampleSurface instead of into the Surface
+ * that they are given, on the thread that created it. This uses the draw
+ * capture hook (see draw_capture.hpp).
+ */
+class ScopedMultisample final
+{
+	public:
+		explicit ScopedMultisample( MultisampleSurface& ) noexcept;
+
+		ScopedMultisample( ScopedMultisample const& ) = delete;
+		ScopedMultisample& operator= (ScopedMultisample const&) = delete;
+
+	private:
+		class Capture_ final : public DrawCapture
+		{
+			public:
+				explicit Capture_( MultisampleSurface& ) noexcept;
+
+			public:
+				void line( Vec2f, Vec2f, ColorU8_sRGB ) override;
+				void triangle( Vec2f, Vec2f, Vec2f, ColorU8_sRGB ) override;
+				void triangle( Vec2f, Vec2f, Vec2f, ColorF, ColorF, ColorF ) override;
+
+			private:
+				MultisampleSurface& mTarget;
+		};
+
+	private:
+		Capture_ mCapture;
+		ScopedDrawCapture mScope; // after mCapture
+};
+
+#endif // MULTISAMPLE_HPP_0E6B3D94_A8C1_4F27_B5D0_7C29E4A1F836
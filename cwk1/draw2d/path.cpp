@@ -0,0 +1,380 @@
+#include "path.hpp"
+
+#include <atomic>
+#include <algorithm>
+
+#include <cmath>
+#include <cassert>
+
+#include "draw.hpp"
+#include "surface.hpp"
+
+namespace
+{
+	// Upper limit for the segments per curve; guards against huge scales
+	constexpr std::size_t kMaxCurveSegments_ = 1024;
+
+	// Scale buckets are limited to scales in [2^-kMaxOctave_, 2^kMaxOctave_]
+	constexpr int kMaxOctave_ = 20;
+
+	std::uint64_t next_path_id_() noexcept;
+
+	// Segments needed so that a curve deviates at most aTolerance from its
+	// polyline. Uses the bound on the second derivative of the curve.
+	std::size_t quad_segments_( Vec2f aP0, Vec2f aC, Vec2f aP1, float aTolerance ) noexcept;
+	std::size_t cubic_segments_( Vec2f aP0, Vec2f aC0, Vec2f aC1, Vec2f aP1, float aTolerance ) noexcept;
+	std::size_t segments_from_bound_( float aBound, float aTolerance ) noexcept;
+
+	// Flattened path from the cache, or from per-thread scratch space
+	Path::Flattened const& flattened_( Path const&, Mat22f const&, PathCache* );
+}
+
+Path::Path()
+	: mId( next_path_id_() )
+{}
+
+Path& Path::move_to( Vec2f aPoint )
+{
+	mVerbs.emplace_back( EVerb_::move );
+	mPoints.emplace_back( aPoint );
+	modified_();
+	return *this;
+}
+
+Path& Path::line_to( Vec2f aPoint )
+{
+	mVerbs.emplace_back( EVerb_::line );
+	mPoints.emplace_back( aPoint );
+	modified_();
+	return *this;
+}
+
+Path& Path::quad_to( Vec2f aControl, Vec2f aEnd )
+{
+	mVerbs.emplace_back( EVerb_::quad );
+	mPoints.insert( mPoints.end(), { aControl, aEnd } );
+	modified_();
+	return *this;
+}
+
+Path& Path::cubic_to( Vec2f aControl0, Vec2f aControl1, Vec2f aEnd )
+{
+	mVerbs.emplace_back( EVerb_::cubic );
+	mPoints.insert( mPoints.end(), { aControl0, aControl1, aEnd } );
+	modified_();
+	return *this;
+}
+
+Path& Path::close()
+{
+	mVerbs.emplace_back( EVerb_::close );
+	modified_();
+	return *this;
+}
+
+void Path::clear()
+{
+	mVerbs.clear();
+	mPoints.clear();
+	modified_();
+}
+
+bool Path::empty() const noexcept
+{
+	return mVerbs.empty();
+}
+
+std::uint64_t Path::id() const noexcept
+{
+	return mId;
+}
+
+
+void Path::flatten( Flattened& aOut, float aTolerance ) const
+{
+	auto& points = aOut.points;
+	auto& contours = aOut.contours;
+
+	bool open = false;
+	Vec2f current{ 0.f, 0.f }, start{ 0.f, 0.f };
+
+	auto const end_contour = [&] (bool aClosed) {
+		if( !open )
+			return;
+
+		auto& contour = contours.back();
+		contour.count = std::uint32_t(points.size() - contour.first);
+		contour.closed = aClosed;
+		open = false;
+	};
+	auto const begin_contour = [&] (Vec2f aStart) {
+		end_contour( false );
+
+		contours.emplace_back( Flattened::Contour{ std::uint32_t(points.size()), 0, false } );
+		points.emplace_back( aStart );
+		start = aStart;
+		open = true;
+	};
+
+	std::size_t p = 0;
+	for( auto const verb : mVerbs )
+	{
+		switch( verb )
+		{
+			case EVerb_::move:
+				begin_contour( mPoints[p] );
+				current = mPoints[p];
+				p += 1;
+				break;
+
+			case EVerb_::line:
+				if( !open )
+					begin_contour( current );
+
+				current = mPoints[p];
+				points.emplace_back( current );
+				p += 1;
+				break;
+
+			case EVerb_::quad: {
+				if( !open )
+					begin_contour( current );
+
+				auto const p0 = current, c = mPoints[p], p1 = mPoints[p+1];
+				auto const n = quad_segments_( p0, c, p1, aTolerance );
+				for( std::size_t i = 1; i < n; ++i )
+				{
+					float const t = float(i) / float(n), s = 1.f - t;
+					points.emplace_back( (s*s) * p0 + (2.f*s*t) * c + (t*t) * p1 );
+				}
+
+				current = p1;
+				points.emplace_back( current );
+				p += 2;
+			} break;
+
+			case EVerb_::cubic: {
+				if( !open )
+					begin_contour( current );
+
+				auto const p0 = current, c0 = mPoints[p], c1 = mPoints[p+1], p1 = mPoints[p+2];
+				auto const n = cubic_segments_( p0, c0, c1, p1, aTolerance );
+				for( std::size_t i = 1; i < n; ++i )
+				{
+					float const t = float(i) / float(n), s = 1.f - t;
+					points.emplace_back( (s*s*s) * p0 + (3.f*s*s*t) * c0 + (3.f*s*t*t) * c1 + (t*t*t) * p1 );
+				}
+
+				current = p1;
+				points.emplace_back( current );
+				p += 3;
+			} break;
+
+			case EVerb_::close:
+				end_contour( true );
+				current = start;
+				break;
+		}
+	}
+
+	end_contour( false );
+	assert( p == mPoints.size() );
+}
+
+void Path::Flattened::clear() noexcept
+{
+	points.clear();
+	contours.clear();
+}
+
+void Path::modified_() noexcept
+{
+	mId = next_path_id_();
+}
+
+
+PathCache::PathCache( std::size_t aMaxEntries )
+	: mMaxEntries( std::max( aMaxEntries, std::size_t(1) ) )
+	, mUseCounter( 0 )
+	, mHits( 0 )
+	, mMisses( 0 )
+{}
+
+Path::Flattened const& PathCache::flatten( Path const& aPath, Mat22f const& aTransform )
+{
+	auto const bucket = scale_bucket( aTransform );
+	Key_ const key{ aPath.id(), bucket };
+
+	if( auto it = mEntries.find( key ); mEntries.end() != it )
+	{
+		++mHits;
+		it->second.lastUse = ++mUseCounter;
+		return it->second.flat;
+	}
+
+	++mMisses;
+
+	// Replace the least recently used entry
+	if( mEntries.size() >= mMaxEntries )
+	{
+		auto oldest = std::min_element( mEntries.begin(), mEntries.end(), [] (auto const& aA, auto const& aB) {
+			return aA.second.lastUse < aB.second.lastUse;
+		} );
+		mEntries.erase( oldest );
+	}
+
+	auto& entry = mEntries[key];
+	entry.lastUse = ++mUseCounter;
+	aPath.flatten( entry.flat, bucket_tolerance( bucket ) );
+
+	return entry.flat;
+}
+
+void PathCache::clear()
+{
+	mEntries.clear();
+}
+
+std::size_t PathCache::size() const noexcept
+{
+	return mEntries.size();
+}
+std::size_t PathCache::hits() const noexcept
+{
+	return mHits;
+}
+std::size_t PathCache::misses() const noexcept
+{
+	return mMisses;
+}
+
+int PathCache::scale_bucket( Mat22f const& aTransform ) noexcept
+{
+	// Largest singular value of the 2x2 matrix:
+	//   sigma^2 = (F^2 + sqrt(F^4 - 4 det^2)) / 2
+	// where F is the Frobenius norm.
+	auto const& t = aTransform;
+	auto const f2 = t._00*t._00 + t._01*t._01 + t._10*t._10 + t._11*t._11;
+	auto const det = t._00*t._11 - t._01*t._10;
+	auto const sigma2 = 0.5f * (f2 + std::sqrt( std::max( f2*f2 - 4.f*det*det, 0.f ) ));
+
+	constexpr int kMinBucket = -kMaxOctave_ * kBucketsPerOctave;
+	constexpr int kMaxBucket = kMaxOctave_ * kBucketsPerOctave;
+
+	// Round up, so that the bucket's scale is at least the actual scale
+	auto const bucket = std::ceil( 0.5f * std::log2( sigma2 ) * kBucketsPerOctave );
+	if( !(bucket > float(kMinBucket)) ) // also NaN
+		return kMinBucket;
+
+	return int(std::min( bucket, float(kMaxBucket) ));
+}
+
+float PathCache::bucket_tolerance( int aBucket ) noexcept
+{
+	return kTolerance / std::exp2( float(aBucket) / kBucketsPerOctave );
+}
+
+bool PathCache::Key_::operator== (Key_ const& aOther) const noexcept
+{
+	return path == aOther.path && bucket == aOther.bucket;
+}
+
+std::size_t PathCache::KeyHash_::operator() (Key_ const& aKey) const noexcept
+{
+	return std::hash<std::uint64_t>{}( aKey.path * 0x9e3779b97f4a7c15ull + std::uint32_t(aKey.bucket) );
+}
+
+
+void draw_path( Surface& aSurface, Path const& aPath, ColorU8_sRGB aColor, Mat22f const& aTransform, Vec2f const& aTranslation, PathCache* aCache )
+{
+	auto const& flat = flattened_( aPath, aTransform, aCache );
+
+	for( auto const& contour : flat.contours )
+	{
+		if( contour.count < 2 )
+			continue;
+
+		auto const* points = flat.points.data() + contour.first;
+
+		auto const first = aTransform * points[0] + aTranslation;
+		auto previous = first;
+		for( std::uint32_t i = 1; i < contour.count; ++i )
+		{
+			auto const current = aTransform * points[i] + aTranslation;
+			draw_line_solid( aSurface, previous, current, aColor );
+			previous = current;
+		}
+
+		if( contour.closed )
+			draw_line_solid( aSurface, previous, first, aColor );
+	}
+}
+
+void fill_path( Surface& aSurface, Path const& aPath, ColorU8_sRGB aColor, Mat22f const& aTransform, Vec2f const& aTranslation, EFillRule aRule, PathCache* aCache )
+{
+	auto const& flat = flattened_( aPath, aTransform, aCache );
+
+	thread_local PolygonFiller filler;
+	thread_local std::vector<Vec2f> transformed;
+
+	filler.clear();
+	for( auto const& contour : flat.contours )
+	{
+		auto const* points = flat.points.data() + contour.first;
+
+		transformed.resize( contour.count );
+		for( std::uint32_t i = 0; i < contour.count; ++i )
+			transformed[i] = aTransform * points[i] + aTranslation;
+
+		filler.add_contour( transformed.size(), transformed.data() );
+	}
+
+	filler.fill( aSurface, aColor, aRule );
+}
+
+
+namespace
+{
+	std::uint64_t next_path_id_() noexcept
+	{
+		static std::atomic<std::uint64_t> nextId{ 1 };
+		return nextId.fetch_add( 1, std::memory_order_relaxed );
+	}
+
+	std::size_t quad_segments_( Vec2f aP0, Vec2f aC, Vec2f aP1, float aTolerance ) noexcept
+	{
+		// B''(t) = 2 (p0 - 2c + p1). A segment of length h in t deviates at
+		// most h^2/8 max|B''| from the curve.
+		auto const d = aP0 - 2.f * aC + aP1;
+		return segments_from_bound_( 0.25f * length( d ), aTolerance );
+	}
+
+	std::size_t cubic_segments_( Vec2f aP0, Vec2f aC0, Vec2f aC1, Vec2f aP1, float aTolerance ) noexcept
+	{
+		// |B''(t)| <= 6 max(|p0 - 2c0 + c1|, |c0 - 2c1 + p1|) (Wang's formula)
+		auto const d0 = aP0 - 2.f * aC0 + aC1;
+		auto const d1 = aC0 - 2.f * aC1 + aP1;
+		return segments_from_bound_( 0.75f * std::max( length( d0 ), length( d1 ) ), aTolerance );
+	}
+
+	std::size_t segments_from_bound_( float aBound, float aTolerance ) noexcept
+	{
+		// Deviation with n segments is aBound / n^2
+		auto const n = std::ceil( std::sqrt( aBound / aTolerance ) );
+		if( !(n > 1.f) ) // also NaN
+			return 1;
+
+		return std::size_t(std::min( n, float(kMaxCurveSegments_) ));
+	}
+
+	Path::Flattened const& flattened_( Path const& aPath, Mat22f const& aTransform, PathCache* aCache )
+	{
+		if( aCache )
+			return aCache->flatten( aPath, aTransform );
+
+		thread_local Path::Flattened scratch;
+		scratch.clear();
+		aPath.flatten( scratch, PathCache::bucket_tolerance( PathCache::scale_bucket( aTransform ) ) );
+		return scratch;
+	}
+}
@@ -0,0 +1,177 @@
+#ifndef PATH_HPP_5C2E9B71_D3A4_4F80_9E16_B8A0F4C7D253
+#define PATH_HPP_5C2E9B71_D3A4_4F80_9E16_B8A0F4C7D253
+
+#include <vector>
+#include <unordered_map>
+
+#include <cstddef>
+#include <cstdint>
+
+#include "forward.hpp"
+#include "color.hpp"
+#include "polygon.hpp"
+
+#include "../vmlib/vec2.hpp"
+#include "../vmlib/mat22.hpp"
+
+/** Path made of lines and Bezier curves
+ *
+ * A path consists of contours. Each contour starts at the current point
+ * (initially the origin, or the point given to move_to()), and continues
+ * with lines and quadratic or cubic Bezier curves. close() connects a contour
+ * back to its start.
+ *
+ * Paths are drawn by flattening them into polylines (see flatten()), which
+ * are then drawn with draw_line_solid() or filled with PolygonFiller. Each
+ * change to a path gives it a new id(), which PathCache uses to find
+ * polylines that were flattened earlier.
+ */
+class Path
+{
+	public:
+		Path();
+
+	public:
+		Path& move_to( Vec2f );
+		Path& line_to( Vec2f );
+		Path& quad_to( Vec2f aControl, Vec2f aEnd );
+		Path& cubic_to( Vec2f aControl0, Vec2f aControl1, Vec2f aEnd );
+		Path& close();
+
+		void clear();
+
+		bool empty() const noexcept;
+
+		// Unique per path and modification
+		std::uint64_t id() const noexcept;
+
+	public:
+		// Polylines of a path
+		struct Flattened
+		{
+			struct Contour
+			{
+				std::uint32_t first, count; // points [first, first+count)
+				bool closed;
+			};
+
+			std::vector<Vec2f> points;
+			std::vector<Contour> contours;
+
+			void clear() noexcept;
+		};
+
+		// Flatten the path in object space. Curves are split into enough
+		// segments that no segment deviates more than aTolerance from the
+		// curve. Results are appended to the output.
+		void flatten( Flattened&, float aTolerance ) const;
+
+	private:
+		enum class EVerb_ : std::uint8_t
+		{
+			move,
+			line,
+			quad,
+			cubic,
+			close
+		};
+
+	private:
+		void modified_() noexcept;
+
+	private:
+		std::vector<EVerb_> mVerbs;
+		std::vector<Vec2f> mPoints; // 1, 1, 2 and 3 per move, line, quad, cubic
+		std::uint64_t mId;
+};
+
+/** Cache of flattened paths
+ *
+ * Flattening is adaptive to the transform: a path that is drawn larger is
+ * split into more segments. The transform's scale (its largest singular
+ * value) is rounded up to one of kBucketsPerOctave buckets per power of two,
+ * and the path is flattened with kTolerance pixels for that scale. Rotations,
+ * translations and small scale changes thus reuse the same polylines.
+ *
+ * Entries are keyed by Path::id() and scale bucket. Up to aMaxEntries are
+ * kept; the least recently used entry is replaced when the cache is full.
+ *
+ * A cache is not thread-safe; use one per thread.
+ */
+class PathCache
+{
+	public:
+		explicit PathCache( std::size_t aMaxEntries = 256 );
+
+	public:
+		// Flattened polylines (in object space) for drawing aPath with
+		// aTransform. The reference stays valid until the next call.
+		Path::Flattened const& flatten( Path const&, Mat22f const& aTransform );
+
+		void clear();
+
+		std::size_t size() const noexcept;
+		std::size_t hits() const noexcept;
+		std::size_t misses() const noexcept;
+
+	public: // Configuration values
+		// Maximum deviation of the polylines from the curves, in pixels
+		static constexpr float kTolerance = 0.25f;
+
+		// Scale buckets per power of two
+		static constexpr int kBucketsPerOctave = 2;
+
+		// Scale bucket of a transform, and the tolerance (in object space)
+		// to flatten with for that bucket
+		static int scale_bucket( Mat22f const& ) noexcept;
+		static float bucket_tolerance( int aBucket ) noexcept;
+
+	private:
+		struct Key_
+		{
+			std::uint64_t path;
+			std::int32_t bucket;
+
+			bool operator== (Key_ const&) const noexcept;
+		};
+		struct KeyHash_
+		{
+			std::size_t operator() (Key_ const&) const noexcept;
+		};
+
+		struct Entry_
+		{
+			Path::Flattened flat;
+			std::uint64_t lastUse;
+		};
+
+	private:
+		std::size_t mMaxEntries;
+		std::unordered_map<Key_, Entry_, KeyHash_> mEntries;
+
+		std::uint64_t mUseCounter;
+		std::size_t mHits, mMisses;
+};
+
+/** Draw a path's outline, or fill it
+ *
+ * Vertices are transformed like in LineStrip::draw(). With a cache, the
+ * flattened path is looked up (or stored) there; otherwise, the path is
+ * flattened for each call. Open contours are filled as if they were closed.
+ */
+void draw_path(
+	Surface&,
+	Path const&, ColorU8_sRGB,
+	Mat22f const& aTransform, Vec2f const& aTranslation,
+	PathCache* = nullptr
+);
+
+void fill_path(
+	Surface&,
+	Path const&, ColorU8_sRGB,
+	Mat22f const& aTransform, Vec2f const& aTranslation,
+	EFillRule = EFillRule::nonZero,
+	PathCache* = nullptr
+);
+
+#endif // PATH_HPP_5C2E9B71_D3A4_4F80_9E16_B8A0F4C7D253
@@ -0,0 +1,52 @@
+#include "points.hpp"
+
+#include <cmath>
+
+#include "surface.hpp"
+
+namespace
+{
+	template< class tGetPoint >
+	void draw_points_( Surface&, std::size_t aCount, ColorU8_sRGB const&, Vec2f aOffset, tGetPoint&& );
+}
+
+void draw_points( Surface& aSurface, Vec2f const* aPoints, std::size_t aCount, ColorU8_sRGB const& aColor, Vec2f aOffset )
+{
+	draw_points_( aSurface, aCount, aColor, aOffset, [aPoints] (std::size_t aI) {
+		return aPoints[aI];
+	} );
+}
+
+void draw_points( Surface& aSurface, float const* aX, float const* aY, std::size_t aCount, ColorU8_sRGB const& aColor, Vec2f aOffset )
+{
+	draw_points_( aSurface, aCount, aColor, aOffset, [aX, aY] (std::size_t aI) {
+		return Vec2f{ aX[aI], aY[aI] };
+	} );
+}
+
+namespace
+{
+	template< class tGetPoint >
+	void draw_points_( Surface& aSurface, std::size_t aCount, ColorU8_sRGB const& aColor, Vec2f aOffset, tGetPoint&& aGetPoint )
+	{
+		float const width = float(aSurface.get_width());
+		float const height = float(aSurface.get_height());
+
+		for( std::size_t i = 0; i < aCount; ++i )
+		{
+			auto const q = aGetPoint( i ) + aOffset;
+
+			// Written such that NaNs are rejected as well.
+			if( !(q.x >= 0.f && q.y >= 0.f) )
+				continue;
+
+			auto const x = q.x + .5f;
+			auto const y = q.y + .5f;
+			if( !(x < width && y < height) )
+				continue;
+
+			// Non-negative; truncation is the same as floor()
+			aSurface.set_pixel_srgb( Surface::Index(x), Surface::Index(y), aColor );
+		}
+	}
+}
@@ -0,0 +1,41 @@
+#ifndef POINTS_HPP_2D6F9B38_E1C4_4A7A_8B53_F07A1C9E46D2
+#define POINTS_HPP_2D6F9B38_E1C4_4A7A_8B53_F07A1C9E46D2
+
+#include <cstddef>
+
+#include "forward.hpp"
+#include "color.hpp"
+
+#include "../vmlib/vec2.hpp"
+
+/** Draw a batch of single-pixel points with one color
+ *
+ * Each point p is moved by aOffset and rounded to the nearest pixel, with
+ * halfway cases rounding up: q = p + aOffset is drawn into the pixel
+ * floor(q + 0.5). Points with a negative q are skipped, as are points whose
+ * pixel is outside of the surface. (This is the rounding that the original
+ * ParticleField::draw() used with an offset of 0.5; a q in [-0.5, 0) is
+ * therefore not drawn into row/column 0.)
+ *
+ * The points are drawn in the order they are given. Writes are scattered in
+ * memory unless the points are sorted, so for large batches, sorting the
+ * points by Y (e.g., once, if they move together) turns the draw into a
+ * linear sweep over the surface.
+ *
+ * The second form takes the X and Y coordinates as separate arrays.
+ */
+void draw_points(
+	Surface&,
+	Vec2f const* aPoints, std::size_t aCount,
+	ColorU8_sRGB const&,
+	Vec2f aOffset = Vec2f{ 0.f, 0.f }
+);
+
+void draw_points(
+	Surface&,
+	float const* aX, float const* aY, std::size_t aCount,
+	ColorU8_sRGB const&,
+	Vec2f aOffset = Vec2f{ 0.f, 0.f }
+);
+
+#endif // POINTS_HPP_2D6F9B38_E1C4_4A7A_8B53_F07A1C9E46D2
@@ -0,0 +1,287 @@
+#include "polygon.hpp"
+
+#include <algorithm>
+
+#include <cmath>
+#include <cassert>
+
+#include "surface.hpp"
+#include "draw_capture.hpp"
+
+namespace
+{
+	// Rows and columns are clamped to +/- this before they are converted to
+	// integers. Anything this far out is clipped anyway.
+	constexpr float kMaxCoordinate_ = float(1 << 24);
+
+	// Collects the lines of a LineStrip as edges
+	class EdgeCapture_ final : public DrawCapture
+	{
+		public:
+			explicit EdgeCapture_( PolygonFiller& ) noexcept;
+
+		public:
+			void line( Vec2f, Vec2f, ColorU8_sRGB ) override;
+			void triangle( Vec2f, Vec2f, Vec2f, ColorU8_sRGB ) override;
+			void triangle( Vec2f, Vec2f, Vec2f, ColorF, ColorF, ColorF ) override;
+
+		public:
+			void close();
+
+		private:
+			PolygonFiller& mFiller;
+
+			bool mEmpty;
+			Vec2f mFirst, mLast;
+	};
+
+	// Pixel index of the first pixel center at or after aCoordinate
+	std::int32_t first_center_( float aCoordinate ) noexcept;
+
+	// Per-thread filler for fill_polygon()
+	PolygonFiller& thread_filler_();
+}
+
+PolygonFiller::PolygonFiller() = default;
+
+void PolygonFiller::clear() noexcept
+{
+	mEdges.clear();
+}
+
+void PolygonFiller::add_contour( std::size_t aCount, Vec2f const* aPoints )
+{
+	if( aCount < 2 )
+		return;
+
+	assert( aPoints );
+	for( std::size_t i = 1; i < aCount; ++i )
+		add_edge( aPoints[i-1], aPoints[i] );
+
+	add_edge( aPoints[aCount-1], aPoints[0] );
+}
+
+void PolygonFiller::add_contour( LineStrip const& aStrip, Mat22f const& aTransform, Vec2f const& aTranslation )
+{
+	// LineStrip does not expose its vertices; capturing it yields its
+	// (transformed) lines.
+	EdgeCapture_ capture( *this );
+	capture_line_strip( capture, aStrip, ColorF{ 0.f, 0.f, 0.f }, aTransform, aTranslation );
+	capture.close();
+}
+
+void PolygonFiller::add_edge( Vec2f aBegin, Vec2f aEnd )
+{
+	// Horizontal edges do not cross any row
+	if( aBegin.y == aEnd.y )
+		return;
+
+	bool const down = aBegin.y < aEnd.y;
+	Vec2f const top = down ? aBegin : aEnd;
+	Vec2f const bot = down ? aEnd : aBegin;
+
+	// The edge covers the rows whose centers are in [top.y, bot.y)
+	auto const yTop = first_center_( top.y );
+	auto const yEnd = first_center_( bot.y );
+	if( yTop >= yEnd )
+		return;
+
+	auto const dxdy = (bot.x - top.x) / (bot.y - top.y);
+
+	mEdges.emplace_back( Edge_{
+		yTop, yEnd,
+		top.x + (float(yTop) + 0.5f - top.y) * dxdy,
+		dxdy,
+		down ? 1 : -1
+	} );
+}
+
+
+void PolygonFiller::fill( Surface& aSurface, ColorU8_sRGB aColor, EFillRule aRule )
+{
+	ScissorRect clip{ 0, 0, aSurface.get_width(), aSurface.get_height() };
+	if( auto const* scissor = current_scissor() )
+	{
+		clip.minX = std::max( clip.minX, scissor->minX );
+		clip.minY = std::max( clip.minY, scissor->minY );
+		clip.maxX = std::min( clip.maxX, scissor->maxX );
+		clip.maxY = std::min( clip.maxY, scissor->maxY );
+	}
+
+	scan_( clip, aRule, [&] (std::uint32_t aY, std::uint32_t aX0, std::uint32_t aX1) {
+		for( auto x = aX0; x < aX1; ++x )
+			aSurface.set_pixel_srgb( x, aY, aColor );
+	} );
+}
+
+void PolygonFiller::spans( std::vector<FillSpan>& aSpans, ScissorRect const& aClip, EFillRule aRule )
+{
+	scan_( aClip, aRule, [&] (std::uint32_t aY, std::uint32_t aX0, std::uint32_t aX1) {
+		aSpans.emplace_back( FillSpan{ aY, aX0, aX1 } );
+	} );
+}
+
+
+template< class tEmit >
+void PolygonFiller::scan_( ScissorRect const& aClip, EFillRule aRule, tEmit&& aEmit )
+{
+	if( mEdges.empty() || aClip.minX >= aClip.maxX || aClip.minY >= aClip.maxY )
+		return;
+
+	// Edge table: edges in the order in which they become active
+	std::sort( mEdges.begin(), mEdges.end(), [] (Edge_ const& aA, Edge_ const& aB) {
+		return aA.yTop < aB.yTop;
+	} );
+
+	auto const clipMinX = float(aClip.minX), clipMaxX = float(aClip.maxX);
+	auto const clipMaxY = std::int32_t(aClip.maxY);
+
+	auto const edgeCount = mEdges.size();
+	std::size_t next = 0;
+
+	mActive.clear();
+
+	auto y = std::max( std::int32_t(aClip.minY), mEdges.front().yTop );
+	while( y < clipMaxY )
+	{
+		// Skip rows without edges
+		if( mActive.empty() )
+		{
+			if( next == edgeCount )
+				break;
+
+			y = std::max( y, mEdges[next].yTop );
+			if( y >= clipMaxY )
+				break;
+		}
+
+		// Activate new edges, and retire finished ones. Edges that start
+		// above the clip rectangle become active at its first row.
+		for( ; next < edgeCount && mEdges[next].yTop <= y; ++next )
+		{
+			if( mEdges[next].yEnd > y )
+				mActive.emplace_back( std::uint32_t(next) );
+		}
+
+		mActive.erase( std::remove_if( mActive.begin(), mActive.end(), [&] (std::uint32_t aEdge) {
+			return mEdges[aEdge].yEnd <= y;
+		} ), mActive.end() );
+
+		// Crossings of this row's center, left to right. The order changes
+		// little from row to row, so insertion sort is close to linear.
+		mCrossings.clear();
+		for( auto const index : mActive )
+		{
+			auto const& edge = mEdges[index];
+			auto const x = edge.x + float(y - edge.yTop) * edge.dxdy;
+
+			mCrossings.emplace_back( Crossing_{ x, edge.winding } );
+			for( auto i = mCrossings.size()-1; i > 0 && mCrossings[i-1].x > mCrossings[i].x; --i )
+				std::swap( mCrossings[i-1], mCrossings[i] );
+		}
+
+		// Spans between crossings. Pixels whose centers are in [xa, xb) are
+		// inside.
+		auto const emit = [&] (float aXA, float aXB) {
+			auto const x0 = std::max( float(first_center_( aXA )), clipMinX );
+			auto const x1 = std::min( float(first_center_( aXB )), clipMaxX );
+
+			if( x0 < x1 )
+				aEmit( std::uint32_t(y), std::uint32_t(x0), std::uint32_t(x1) );
+		};
+
+		auto const crossingCount = mCrossings.size();
+		if( EFillRule::evenOdd == aRule )
+		{
+			for( std::size_t i = 0; i+1 < crossingCount; i += 2 )
+				emit( mCrossings[i].x, mCrossings[i+1].x );
+		}
+		else
+		{
+			std::int32_t winding = 0;
+			float start = 0.f;
+			for( std::size_t i = 0; i < crossingCount; ++i )
+			{
+				auto const previous = winding;
+				winding += mCrossings[i].winding;
+
+				if( 0 == previous && 0 != winding )
+					start = mCrossings[i].x;
+				else if( 0 != previous && 0 == winding )
+					emit( start, mCrossings[i].x );
+			}
+		}
+
+		++y;
+	}
+}
+
+
+void fill_polygon( Surface& aSurface, std::size_t aCount, Vec2f const* aPoints, ColorU8_sRGB aColor, EFillRule aRule )
+{
+	auto& filler = thread_filler_();
+	filler.add_contour( aCount, aPoints );
+	filler.fill( aSurface, aColor, aRule );
+}
+
+void fill_polygon( Surface& aSurface, LineStrip const& aStrip, ColorU8_sRGB aColor, Mat22f const& aTransform, Vec2f const& aTranslation, EFillRule aRule )
+{
+	auto& filler = thread_filler_();
+	filler.add_contour( aStrip, aTransform, aTranslation );
+	filler.fill( aSurface, aColor, aRule );
+}
+
+
+namespace
+{
+	EdgeCapture_::EdgeCapture_( PolygonFiller& aFiller ) noexcept
+		: mFiller( aFiller )
+		, mEmpty( true )
+	{}
+
+	void EdgeCapture_::line( Vec2f aBegin, Vec2f aEnd, ColorU8_sRGB )
+	{
+		if( mEmpty )
+		{
+			mFirst = aBegin;
+			mEmpty = false;
+		}
+
+		mFiller.add_edge( aBegin, aEnd );
+		mLast = aEnd;
+	}
+
+	void EdgeCapture_::triangle( Vec2f, Vec2f, Vec2f, ColorU8_sRGB )
+	{
+		// Not used by LineStrip
+	}
+
+	void EdgeCapture_::triangle( Vec2f, Vec2f, Vec2f, ColorF, ColorF, ColorF )
+	{
+		// Not used by LineStrip
+	}
+
+	void EdgeCapture_::close()
+	{
+		if( !mEmpty && (mFirst.x != mLast.x || mFirst.y != mLast.y) )
+			mFiller.add_edge( mLast, mFirst );
+	}
+
+
+	std::int32_t first_center_( float aCoordinate ) noexcept
+	{
+		// Pixel i has its center at i + 0.5. NaNs end up at -kMaxCoordinate_.
+		auto const c = std::ceil( aCoordinate - 0.5f );
+		if( !(c > -kMaxCoordinate_) )
+			return std::int32_t(-kMaxCoordinate_);
+
+		return std::int32_t(std::min( c, kMaxCoordinate_ ));
+	}
+
+	PolygonFiller& thread_filler_()
+	{
+		thread_local PolygonFiller filler;
+		filler.clear();
+		return filler;
+	}
+}
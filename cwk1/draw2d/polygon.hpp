@@ -0,0 +1,123 @@
+#ifndef POLYGON_HPP_A4F1C7D3_2E96_4B58_8D0A_71C5E3B9F264
+#define POLYGON_HPP_A4F1C7D3_2E96_4B58_8D0A_71C5E3B9F264
+
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+
+#include "forward.hpp"
+#include "color.hpp"
+#include "scissor.hpp"
+
+#include "../vmlib/vec2.hpp"
+#include "../vmlib/mat22.hpp"
+
+/** Fill rule
+ *
+ * A pixel is inside of the polygon if a ray from it crosses
+ *  - evenOdd: an odd number of edges;
+ *  - nonZero: edges whose signed crossings (+1 for downwards edges, -1 for
+ *    upwards edges) do not sum to zero.
+ *
+ * The rules differ for self-intersecting outlines and for nested contours
+ * (holes need the opposite orientation with nonZero).
+ */
+enum class EFillRule
+{
+	evenOdd,
+	nonZero
+};
+
+// Pixels [x0, x1) on row y
+struct FillSpan
+{
+	std::uint32_t y;
+	std::uint32_t x0, x1;
+};
+
+/** Scanline polygon filler
+ *
+ * Collects the edges of one or more closed contours, and then fills them
+ * row by row with an active edge table. Unlike a TriangleFan, this handles
+ * concave and self-intersecting outlines, and contours with holes.
+ *
+ * A pixel is filled if its center is inside of the polygon. Edges are
+ * half-open at the bottom (and spans at the right), so polygons that share
+ * an edge do not overlap and leave no gaps.
+ *
+ * The filler keeps its edges and scratch space between uses; reusing one
+ * filler does not allocate once it is large enough.
+ */
+class PolygonFiller
+{
+	public:
+		PolygonFiller();
+
+	public:
+		// Remove all edges
+		void clear() noexcept;
+
+		// Add a closed contour. The last point connects back to the first.
+		void add_contour( std::size_t aCount, Vec2f const* aPoints );
+
+		// Add the lines of a LineStrip, transformed like LineStrip::draw()
+		// does. The strip is closed if its ends do not meet.
+		void add_contour( LineStrip const&, Mat22f const& aTransform, Vec2f const& aTranslation );
+
+		void add_edge( Vec2f aBegin, Vec2f aEnd );
+
+	public:
+		// Fill the polygon. Clipped to the surface and the current scissor.
+		void fill( Surface&, ColorU8_sRGB, EFillRule = EFillRule::nonZero );
+
+		// Compute the spans of the polygon inside of aClip, in order of rows
+		// (and left to right within a row). The spans are appended.
+		void spans( std::vector<FillSpan>&, ScissorRect const& aClip, EFillRule = EFillRule::nonZero );
+
+	private:
+		struct Edge_
+		{
+			std::int32_t yTop, yEnd; // rows [yTop, yEnd)
+			float x; // at the center of row yTop
+			float dxdy;
+			std::int32_t winding; // +1 downwards, -1 upwards
+		};
+
+		struct Crossing_
+		{
+			float x;
+			std::int32_t winding;
+		};
+
+	private:
+		template< class tEmit >
+		void scan_( ScissorRect const&, EFillRule, tEmit&& );
+
+	private:
+		std::vector<Edge_> mEdges;
+
+		// Scratch space for scan_()
+		std::vector<std::uint32_t> mActive;
+		std::vector<Crossing_> mCrossings;
+};
+
+/** Fill polygons (see PolygonFiller)
+ *
+ * Shorthands that use a per-thread PolygonFiller.
+ */
+void fill_polygon(
+	Surface&,
+	std::size_t aCount, Vec2f const* aPoints,
+	ColorU8_sRGB,
+	EFillRule = EFillRule::nonZero
+);
+
+void fill_polygon(
+	Surface&,
+	LineStrip const&, ColorU8_sRGB,
+	Mat22f const& aTransform, Vec2f const& aTranslation,
+	EFillRule = EFillRule::nonZero
+);
+
+#endif // POLYGON_HPP_A4F1C7D3_2E96_4B58_8D0A_71C5E3B9F264
@@ -0,0 +1,41 @@
+#include "scissor.hpp"
+
+#include <algorithm>
+
+namespace
+{
+	thread_local ScissorRect const* tlScissor = nullptr;
+
+	// Empty intersections are returned with max == min
+	ScissorRect intersect_( ScissorRect const&, ScissorRect const& ) noexcept;
+}
+
+ScopedScissor::ScopedScissor( ScissorRect const& aRect ) noexcept
+	: mRect( tlScissor ? intersect_( aRect, *tlScissor ) : aRect )
+	, mPrevious( tlScissor )
+{
+	tlScissor = &mRect;
+}
+
+ScopedScissor::~ScopedScissor()
+{
+	tlScissor = mPrevious;
+}
+
+ScissorRect const* current_scissor() noexcept
+{
+	return tlScissor;
+}
+
+namespace
+{
+	ScissorRect intersect_( ScissorRect const& aA, ScissorRect const& aB ) noexcept
+	{
+		ScissorRect ret;
+		ret.minX = std::max( aA.minX, aB.minX );
+		ret.minY = std::max( aA.minY, aB.minY );
+		ret.maxX = std::max( ret.minX, std::min( aA.maxX, aB.maxX ) );
+		ret.maxY = std::max( ret.minY, std::min( aA.maxY, aB.maxY ) );
+		return ret;
+	}
+}
@@ -0,0 +1,41 @@
+#ifndef SCISSOR_HPP_E07A4C2B_9D18_4F63_B5A1_3C86F2D9E047
+#define SCISSOR_HPP_E07A4C2B_9D18_4F63_B5A1_3C86F2D9E047
+
+#include <cstdint>
+
+/** Per-thread scissor rectangle
+ *
+ * While a ScopedScissor exists, the functions from draw.hpp and the blits
+ * from blit.hpp only write pixels inside of its rectangle, on the thread that
+ * created it. This allows several threads to draw into disjoint parts of the
+ * same Surface (e.g., horizontal bands), without changing the drawing code.
+ *
+ * The rectangle covers the pixels [minX, maxX) x [minY, maxY). Scissors
+ * nest: a ScopedScissor's rectangle is intersected with the current one, so
+ * an inner scissor never widens an outer one. The previous scissor is
+ * restored when a ScopedScissor is destroyed.
+ */
+struct ScissorRect
+{
+	std::uint32_t minX, minY;
+	std::uint32_t maxX, maxY;
+};
+
+class ScopedScissor final
+{
+	public:
+		explicit ScopedScissor( ScissorRect const& ) noexcept;
+		~ScopedScissor();
+
+		ScopedScissor( ScopedScissor const& ) = delete;
+		ScopedScissor& operator= (ScopedScissor const&) = delete;
+
+	private:
+		ScissorRect mRect;
+		ScissorRect const* mPrevious;
+};
+
+// Current thread's scissor, or null if there is none
+ScissorRect const* current_scissor() noexcept;
+
+#endif // SCISSOR_HPP_E07A4C2B_9D18_4F63_B5A1_3C86F2D9E047
@@ -0,0 +1,62 @@
+#include "srgb_table.hpp"
+
+#include <limits>
+
+#include <cassert>
+#include <cstring>
+
+namespace
+{
+	float float_from_bits_( std::uint32_t ) noexcept;
+}
+
+SrgbTable const& srgb_table()
+{
+	static SrgbTable const table = [] {
+		SrgbTable ret;
+
+		// Smallest encoding in [0,1] that converts to k or more, by
+		// bisection
+		ret.threshold[0] = 0.f;
+		for( unsigned k = 1; k < 256; ++k )
+		{
+			std::uint32_t lo = 0, hi = SrgbTable::kOne;
+			while( lo < hi )
+			{
+				auto const mid = lo + (hi - lo) / 2;
+				if( linear_to_srgb( float_from_bits_( mid ) ) >= k )
+					hi = mid;
+				else
+					lo = mid + 1;
+			}
+
+			ret.threshold[k] = float_from_bits_( lo );
+		}
+
+		ret.threshold[256] = std::numeric_limits<float>::infinity();
+
+		for( std::uint32_t i = 0; i <= (SrgbTable::kOne >> SrgbTable::kBucketShift); ++i )
+		{
+			ret.bucket[i] = linear_to_srgb( float_from_bits_( i << SrgbTable::kBucketShift ) );
+
+			// linear_to_srgb( SrgbTable const&, float ) takes at most one
+			// step from the start of the bucket
+			assert( i == (SrgbTable::kOne >> SrgbTable::kBucketShift) || linear_to_srgb( float_from_bits_( ((i+1) << SrgbTable::kBucketShift) - 1 ) ) <= ret.bucket[i] + 1 );
+		}
+
+		return ret;
+	}();
+
+	return table;
+}
+
+
+namespace
+{
+	float float_from_bits_( std::uint32_t aBits ) noexcept
+	{
+		float ret;
+		std::memcpy( &ret, &aBits, sizeof(float) );
+		return ret;
+	}
+}
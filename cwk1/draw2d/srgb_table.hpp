@@ -0,0 +1,35 @@
+#ifndef SRGB_TABLE_HPP_E1585499_D7A6_4111_9B9A_A4D00DC82CCE
+#define SRGB_TABLE_HPP_E1585499_D7A6_4111_9B9A_A4D00DC82CCE
+
+#include <cstdint>
+#include <cstring>
+
+#include "color.hpp"
+
+/** Exact linear_to_srgb() for values in [0,1], without std::pow()
+ *
+ * linear_to_srgb() is monotonic, so the result for a value is the largest
+ * k whose threshold (the smallest value that converts to k or more) is at
+ * or below the value. Starting from the result at the beginning of the
+ * value's bucket of float encodings, this is at most one step (checked when
+ * the table is built), which is taken without a branch.
+ *
+ * Values outside of [0,1] (and NaN) fall back to linear_to_srgb().
+ */
+struct SrgbTable
+{
+	static constexpr std::uint32_t kOne = 0x3f800000; // encoding of 1.f
+	static constexpr unsigned kBucketShift = 16;
+
+	float threshold[257]; // threshold[256] is infinity
+	std::uint8_t bucket[(kOne >> kBucketShift) + 1];
+};
+
+// Built on first use (thread-safe)
+SrgbTable const& srgb_table();
+
+ColorU8_sRGB linear_to_srgb( SrgbTable const&, ColorF const& ) noexcept;
+std::uint8_t linear_to_srgb( SrgbTable const&, float ) noexcept;
+
+#include "srgb_table.inl"
+#endif // SRGB_TABLE_HPP_E1585499_D7A6_4111_9B9A_A4D00DC82CCE
@@ -0,0 +1,23 @@
+inline
+ColorU8_sRGB linear_to_srgb( SrgbTable const& aTable, ColorF const& aColor ) noexcept
+{
+	return ColorU8_sRGB{
+		linear_to_srgb( aTable, aColor.r ),
+		linear_to_srgb( aTable, aColor.g ),
+		linear_to_srgb( aTable, aColor.b )
+	};
+}
+
+inline
+std::uint8_t linear_to_srgb( SrgbTable const& aTable, float aValue ) noexcept
+{
+	std::uint32_t bits;
+	std::memcpy( &bits, &aValue, sizeof(float) );
+
+	// Negative, above one, or NaN
+	if( bits > SrgbTable::kOne )
+		return linear_to_srgb( aValue );
+
+	unsigned const k = aTable.bucket[bits >> SrgbTable::kBucketShift];
+	return std::uint8_t(k + (aValue >= aTable.threshold[k+1] ? 1u : 0u));
+}
@@ -0,0 +1,291 @@
+#include "stroke.hpp"
+
+#include <vector>
+#include <algorithm>
+
+#include <cmath>
+#include <cassert>
+
+#include "polygon.hpp"
+#include "surface.hpp"
+#include "draw_capture.hpp"
+
+namespace
+{
+	// Round joins and caps are polygons whose edges are at most this far
+	// (in pixels) from the circle
+	constexpr float kRoundTolerance_ = 0.25f;
+
+	constexpr float kPI_ = 3.1415926535897932385f; // pi
+
+	constexpr std::size_t kMinRoundSegments_ = 8;
+	constexpr std::size_t kMaxRoundSegments_ = 256;
+
+	// Collects the points of a LineStrip
+	class PointCapture_ final : public DrawCapture
+	{
+		public:
+			explicit PointCapture_( std::vector<Vec2f>& ) noexcept;
+
+		public:
+			void line( Vec2f, Vec2f, ColorU8_sRGB ) override;
+			void triangle( Vec2f, Vec2f, Vec2f, ColorU8_sRGB ) override;
+			void triangle( Vec2f, Vec2f, Vec2f, ColorF, ColorF, ColorF ) override;
+
+		private:
+			std::vector<Vec2f>& mPoints;
+	};
+
+	// Add the pieces of a stroke to the filler
+	void add_stroke_( PolygonFiller&, std::size_t aCount, Vec2f const* aPoints, bool aClosed, StrokeStyle const& );
+
+	// Add a convex polygon, counter-clockwise regardless of the order of
+	// aPoints. With the non-zero rule, overlapping pieces then add up
+	// instead of cancelling out.
+	void add_convex_( PolygonFiller&, std::size_t aCount, Vec2f const* aPoints );
+	void add_disk_( PolygonFiller&, Vec2f aCenter, float aRadius );
+
+	void add_join_( PolygonFiller&, Vec2f aCorner, Vec2f aIn, Vec2f aOut, StrokeStyle const& );
+
+	// Left normal
+	Vec2f perp_( Vec2f ) noexcept;
+
+	// Per-thread filler and scratch space for add_stroke_()
+	PolygonFiller& thread_filler_();
+	std::vector<Vec2f>& thread_points_();
+}
+
+void draw_line_thick( Surface& aSurface, Vec2f aBegin, Vec2f aEnd, ColorU8_sRGB aColor, StrokeStyle const& aStyle )
+{
+	Vec2f const points[] = { aBegin, aEnd };
+	draw_polyline_thick( aSurface, 2, points, aColor, aStyle );
+}
+
+void draw_polyline_thick( Surface& aSurface, std::size_t aCount, Vec2f const* aPoints, ColorU8_sRGB aColor, StrokeStyle const& aStyle, bool aClosed )
+{
+	auto& filler = thread_filler_();
+	add_stroke_( filler, aCount, aPoints, aClosed, aStyle );
+	filler.fill( aSurface, aColor, EFillRule::nonZero );
+}
+
+void draw_thick( Surface& aSurface, LineStrip const& aStrip, ColorF const& aColor, Mat22f const& aRotation, Vec2f const& aTranslation, StrokeStyle const& aStyle )
+{
+	// LineStrip does not expose its vertices; capturing it yields its
+	// (transformed) lines.
+	thread_local std::vector<Vec2f> points;
+	points.clear();
+
+	PointCapture_ capture( points );
+	capture_line_strip( capture, aStrip, aColor, aRotation, aTranslation );
+
+	bool const closed = points.size() > 2
+		&& points.front().x == points.back().x
+		&& points.front().y == points.back().y
+	;
+
+	draw_polyline_thick( aSurface, points.size(), points.data(), linear_to_srgb( aColor ), aStyle, closed );
+}
+
+
+namespace
+{
+	PointCapture_::PointCapture_( std::vector<Vec2f>& aPoints ) noexcept
+		: mPoints( aPoints )
+	{}
+
+	void PointCapture_::line( Vec2f aBegin, Vec2f aEnd, ColorU8_sRGB )
+	{
+		// Lines of a strip are consecutive; only the first one adds its
+		// beginning
+		if( mPoints.empty() )
+			mPoints.emplace_back( aBegin );
+
+		mPoints.emplace_back( aEnd );
+	}
+
+	void PointCapture_::triangle( Vec2f, Vec2f, Vec2f, ColorU8_sRGB )
+	{
+		// Not used by LineStrip
+	}
+
+	void PointCapture_::triangle( Vec2f, Vec2f, Vec2f, ColorF, ColorF, ColorF )
+	{
+		// Not used by LineStrip
+	}
+
+
+	void add_stroke_( PolygonFiller& aFiller, std::size_t aCount, Vec2f const* aPoints, bool aClosed, StrokeStyle const& aStyle )
+	{
+		auto const halfWidth = 0.5f * aStyle.width;
+		if( 0 == aCount || !(halfWidth > 0.f) )
+			return;
+
+		assert( aPoints );
+
+		// Drop repeated points; zero length lines have no direction
+		auto& points = thread_points_();
+		points.emplace_back( aPoints[0] );
+		for( std::size_t i = 1; i < aCount; ++i )
+		{
+			if( aPoints[i].x != points.back().x || aPoints[i].y != points.back().y )
+				points.emplace_back( aPoints[i] );
+		}
+
+		if( aClosed && points.size() > 1 && points.front().x == points.back().x && points.front().y == points.back().y )
+			points.pop_back();
+
+		auto const count = points.size();
+		if( count < 2 )
+			return;
+
+		bool const closed = aClosed && count > 2;
+		bool const squareCaps = !closed && ELineCap::square == aStyle.cap;
+
+		// Lines
+		auto const lines = closed ? count : count-1;
+		for( std::size_t i = 0; i < lines; ++i )
+		{
+			auto begin = points[i];
+			auto end = points[(i+1) % count];
+
+			auto const dir = (end - begin) / length( end - begin );
+			auto const side = halfWidth * perp_( dir );
+
+			if( squareCaps && 0 == i )
+				begin -= halfWidth * dir;
+			if( squareCaps && lines-1 == i )
+				end += halfWidth * dir;
+
+			Vec2f const quad[] = { begin - side, end - side, end + side, begin + side };
+			add_convex_( aFiller, 4, quad );
+		}
+
+		// Joins
+		auto const first = closed ? 0 : 1;
+		auto const last = closed ? count : count-1;
+		for( std::size_t i = first; i < last; ++i )
+		{
+			auto const prev = points[(i + count - 1) % count];
+			auto const corner = points[i];
+			auto const next = points[(i+1) % count];
+
+			add_join_(
+				aFiller, corner,
+				(corner - prev) / length( corner - prev ),
+				(next - corner) / length( next - corner ),
+				aStyle
+			);
+		}
+
+		// Round caps
+		if( !closed && ELineCap::round == aStyle.cap )
+		{
+			add_disk_( aFiller, points.front(), halfWidth );
+			add_disk_( aFiller, points.back(), halfWidth );
+		}
+	}
+
+	void add_convex_( PolygonFiller& aFiller, std::size_t aCount, Vec2f const* aPoints )
+	{
+		float area = 0.f;
+		for( std::size_t i = 0; i < aCount; ++i )
+		{
+			auto const& a = aPoints[i];
+			auto const& b = aPoints[(i+1) % aCount];
+			area += a.x * b.y - a.y * b.x;
+		}
+
+		if( area >= 0.f )
+		{
+			aFiller.add_contour( aCount, aPoints );
+			return;
+		}
+
+		for( std::size_t i = aCount; i > 0; --i )
+			aFiller.add_edge( aPoints[i % aCount], aPoints[i-1] );
+	}
+
+	void add_disk_( PolygonFiller& aFiller, Vec2f aCenter, float aRadius )
+	{
+		// Edges of a regular n-gon are at most r*(1-cos(pi/n)) from the
+		// circle
+		auto segments = kMinRoundSegments_;
+		if( aRadius > kRoundTolerance_ )
+		{
+			auto const angle = 2.f * std::acos( 1.f - kRoundTolerance_ / aRadius );
+			auto const needed = std::ceil( 2.f * kPI_ / angle );
+			segments = std::size_t(std::clamp( needed, float(kMinRoundSegments_), float(kMaxRoundSegments_) ));
+		}
+
+		// Counter-clockwise
+		auto const step = 2.f * kPI_ / float(segments);
+		auto previous = aCenter + Vec2f{ aRadius, 0.f };
+		for( std::size_t i = 1; i <= segments; ++i )
+		{
+			auto const angle = step * float(i % segments);
+			auto const current = aCenter + aRadius * Vec2f{ std::cos( angle ), std::sin( angle ) };
+			aFiller.add_edge( previous, current );
+			previous = current;
+		}
+	}
+
+	void add_join_( PolygonFiller& aFiller, Vec2f aCorner, Vec2f aIn, Vec2f aOut, StrokeStyle const& aStyle )
+	{
+		auto const halfWidth = 0.5f * aStyle.width;
+
+		// Straight on: the lines' quads already meet
+		auto const turn = aIn.x * aOut.y - aIn.y * aOut.x;
+		auto const cosine = dot( aIn, aOut );
+		if( std::abs( turn ) < 1e-6f && cosine > 0.f )
+			return;
+
+		if( ELineJoin::round == aStyle.join )
+		{
+			add_disk_( aFiller, aCorner, halfWidth );
+			return;
+		}
+
+		// The outer side is on the right for left turns
+		auto const outer = turn > 0.f ? -halfWidth : halfWidth;
+		auto const in = aCorner + outer * perp_( aIn );
+		auto const out = aCorner + outer * perp_( aOut );
+
+		if( ELineJoin::miter == aStyle.join )
+		{
+			// The tip is 1/cos(a/2) half widths from the corner, where a
+			// is the angle between the lines' normals
+			auto const cosHalf = std::sqrt( 0.5f * (1.f + cosine) );
+			if( cosHalf * aStyle.miterLimit > 1.f )
+			{
+				auto const bisector = (in - aCorner) + (out - aCorner);
+				auto const tip = aCorner + (halfWidth / (cosHalf * length( bisector ))) * bisector;
+
+				Vec2f const piece[] = { aCorner, in, tip, out };
+				add_convex_( aFiller, 4, piece );
+				return;
+			}
+		}
+
+		Vec2f const bevel[] = { aCorner, in, out };
+		add_convex_( aFiller, 3, bevel );
+	}
+
+	Vec2f perp_( Vec2f aVec ) noexcept
+	{
+		return Vec2f{ -aVec.y, aVec.x };
+	}
+
+	PolygonFiller& thread_filler_()
+	{
+		thread_local PolygonFiller filler;
+		filler.clear();
+		return filler;
+	}
+
+	std::vector<Vec2f>& thread_points_()
+	{
+		thread_local std::vector<Vec2f> points;
+		points.clear();
+		return points;
+	}
+}
@@ -0,0 +1,70 @@
+#ifndef STROKE_HPP_C81F4A63_2D7B_4E95_A0C3_6B9E1F52D7A8
+#define STROKE_HPP_C81F4A63_2D7B_4E95_A0C3_6B9E1F52D7A8
+
+#include <cstddef>
+
+#include "forward.hpp"
+#include "color.hpp"
+
+#include "../vmlib/vec2.hpp"
+#include "../vmlib/mat22.hpp"
+
+// Shape of the open ends of a stroke
+enum class ELineCap
+{
+	butt,   // ends at the end point
+	square, // extends half the width past the end point
+	round   // half disk around the end point
+};
+
+// Shape of the outer corner where two lines of a stroke meet
+enum class ELineJoin
+{
+	miter, // lines are extended until they meet (see StrokeStyle::miterLimit)
+	bevel, // corner is cut off
+	round  // disk around the corner
+};
+
+struct StrokeStyle
+{
+	float width = 1.f; // in pixels
+
+	ELineCap cap = ELineCap::butt;
+	ELineJoin join = ELineJoin::miter;
+
+	// Miter joins that would extend further than miterLimit * width/2 from
+	// the corner (i.e., at sharp angles) are drawn as bevel joins instead.
+	float miterLimit = 4.f;
+};
+
+/** Thick lines
+ *
+ * A stroke is made of convex pieces: a quad swept along each line, and the
+ * pieces of the joins and caps. The pieces are filled together with a
+ * PolygonFiller (non-zero rule), i.e., as horizontal spans. Every pixel of
+ * the stroke is written once, and pieces meet without gaps.
+ *
+ * A pixel is drawn if its center is inside of the stroke, so strokes that
+ * are less than about a pixel wide may break up. Use draw_line_solid() for
+ * those. Clipped to the surface and the current scissor.
+ */
+void draw_line_thick( Surface&, Vec2f aBegin, Vec2f aEnd, ColorU8_sRGB, StrokeStyle const& );
+
+// Connected lines through aPoints. If aClosed, the last point connects back
+// to the first one, with a join instead of caps.
+void draw_polyline_thick(
+	Surface&,
+	std::size_t aCount, Vec2f const* aPoints,
+	ColorU8_sRGB, StrokeStyle const&,
+	bool aClosed = false
+);
+
+// Thick version of LineStrip::draw(). The strip is closed if its ends meet.
+void draw_thick(
+	Surface&,
+	LineStrip const&, ColorF const&,
+	Mat22f const& aRotation, Vec2f const& aTranslation,
+	StrokeStyle const&
+);
+
+#endif // STROKE_HPP_C81F4A63_2D7B_4E95_A0C3_6B9E1F52D7A8
@@ -0,0 +1,323 @@
+#include "text.hpp"
+
+#include <algorithm>
+
+#include <cassert>
+
+#include "surface.hpp"
+#include "scissor.hpp"
+#include "image_alloc.hpp"
+
+namespace
+{
+	// Glyph bitmaps; one byte per row, top row first. Bit 4 is the leftmost
+	// pixel.
+	struct GlyphBits_
+	{
+		char ch;
+		std::uint8_t rows[7];
+	};
+
+	constexpr GlyphBits_ kGlyphs_[] = {
+		{ ' ', { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 } }, // must be first
+		{ '?', { 0x0E, 0x11, 0x01, 0x02, 0x04, 0x00, 0x04 } }, // must be second
+
+		{ '0', { 0x0E, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0E } },
+		{ '1', { 0x04, 0x0C, 0x04, 0x04, 0x04, 0x04, 0x0E } },
+		{ '2', { 0x0E, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1F } },
+		{ '3', { 0x1F, 0x02, 0x04, 0x02, 0x01, 0x11, 0x0E } },
+		{ '4', { 0x02, 0x06, 0x0A, 0x12, 0x1F, 0x02, 0x02 } },
+		{ '5', { 0x1F, 0x10, 0x1E, 0x01, 0x01, 0x11, 0x0E } },
+		{ '6', { 0x06, 0x08, 0x10, 0x1E, 0x11, 0x11, 0x0E } },
+		{ '7', { 0x1F, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08 } },
+		{ '8', { 0x0E, 0x11, 0x11, 0x0E, 0x11, 0x11, 0x0E } },
+		{ '9', { 0x0E, 0x11, 0x11, 0x0F, 0x01, 0x02, 0x0C } },
+
+		{ 'A', { 0x0E, 0x11, 0x11, 0x11, 0x1F, 0x11, 0x11 } },
+		{ 'B', { 0x1E, 0x11, 0x11, 0x1E, 0x11, 0x11, 0x1E } },
+		{ 'C', { 0x0E, 0x11, 0x10, 0x10, 0x10, 0x11, 0x0E } },
+		{ 'D', { 0x1C, 0x12, 0x11, 0x11, 0x11, 0x12, 0x1C } },
+		{ 'E', { 0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x1F } },
+		{ 'F', { 0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x10 } },
+		{ 'G', { 0x0E, 0x11, 0x10, 0x17, 0x11, 0x11, 0x0F } },
+		{ 'H', { 0x11, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11 } },
+		{ 'I', { 0x0E, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0E } },
+		{ 'J', { 0x07, 0x02, 0x02, 0x02, 0x02, 0x12, 0x0C } },
+		{ 'K', { 0x11, 0x12, 0x14, 0x18, 0x14, 0x12, 0x11 } },
+		{ 'L', { 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x1F } },
+		{ 'M', { 0x11, 0x1B, 0x15, 0x15, 0x11, 0x11, 0x11 } },
+		{ 'N', { 0x11, 0x11, 0x19, 0x15, 0x13, 0x11, 0x11 } },
+		{ 'O', { 0x0E, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E } },
+		{ 'P', { 0x1E, 0x11, 0x11, 0x1E, 0x10, 0x10, 0x10 } },
+		{ 'Q', { 0x0E, 0x11, 0x11, 0x11, 0x15, 0x12, 0x0D } },
+		{ 'R', { 0x1E, 0x11, 0x11, 0x1E, 0x14, 0x12, 0x11 } },
+		{ 'S', { 0x0F, 0x10, 0x10, 0x0E, 0x01, 0x01, 0x1E } },
+		{ 'T', { 0x1F, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04 } },
+		{ 'U', { 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E } },
+		{ 'V', { 0x11, 0x11, 0x11, 0x11, 0x11, 0x0A, 0x04 } },
+		{ 'W', { 0x11, 0x11, 0x11, 0x15, 0x15, 0x15, 0x0A } },
+		{ 'X', { 0x11, 0x11, 0x0A, 0x04, 0x0A, 0x11, 0x11 } },
+		{ 'Y', { 0x11, 0x11, 0x11, 0x0A, 0x04, 0x04, 0x04 } },
+		{ 'Z', { 0x1F, 0x01, 0x02, 0x04, 0x08, 0x10, 0x1F } },
+
+		{ '!', { 0x04, 0x04, 0x04, 0x04, 0x04, 0x00, 0x04 } },
+		{ '"', { 0x0A, 0x0A, 0x0A, 0x00, 0x00, 0x00, 0x00 } },
+		{ '#', { 0x0A, 0x0A, 0x1F, 0x0A, 0x1F, 0x0A, 0x0A } },
+		{ '%', { 0x18, 0x19, 0x02, 0x04, 0x08, 0x13, 0x03 } },
+		{ '\'', { 0x0C, 0x04, 0x08, 0x00, 0x00, 0x00, 0x00 } },
+		{ '(', { 0x02, 0x04, 0x08, 0x08, 0x08, 0x04, 0x02 } },
+		{ ')', { 0x08, 0x04, 0x02, 0x02, 0x02, 0x04, 0x08 } },
+		{ '*', { 0x00, 0x04, 0x15, 0x0E, 0x15, 0x04, 0x00 } },
+		{ '+', { 0x00, 0x04, 0x04, 0x1F, 0x04, 0x04, 0x00 } },
+		{ ',', { 0x00, 0x00, 0x00, 0x00, 0x0C, 0x04, 0x08 } },
+		{ '-', { 0x00, 0x00, 0x00, 0x1F, 0x00, 0x00, 0x00 } },
+		{ '.', { 0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C } },
+		{ '/', { 0x00, 0x01, 0x02, 0x04, 0x08, 0x10, 0x00 } },
+		{ ':', { 0x00, 0x0C, 0x0C, 0x00, 0x0C, 0x0C, 0x00 } },
+		{ ';', { 0x00, 0x0C, 0x0C, 0x00, 0x0C, 0x04, 0x08 } },
+		{ '<', { 0x02, 0x04, 0x08, 0x10, 0x08, 0x04, 0x02 } },
+		{ '=', { 0x00, 0x00, 0x1F, 0x00, 0x1F, 0x00, 0x00 } },
+		{ '>', { 0x08, 0x04, 0x02, 0x01, 0x02, 0x04, 0x08 } },
+		{ '[', { 0x0E, 0x08, 0x08, 0x08, 0x08, 0x08, 0x0E } },
+		{ ']', { 0x0E, 0x02, 0x02, 0x02, 0x02, 0x02, 0x0E } },
+		{ '_', { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x1F } },
+		{ '|', { 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04 } },
+	};
+
+	constexpr std::uint32_t kGlyphCount_ = sizeof(kGlyphs_) / sizeof(kGlyphs_[0]);
+	constexpr std::uint8_t kUnknownGlyph_ = 1;
+
+	static_assert( ' ' == kGlyphs_[0].ch && '?' == kGlyphs_[kUnknownGlyph_].ch );
+
+	// Clip rectangle for drawing: the surface, restricted to the scissor
+	struct Clip_
+	{
+		std::int64_t x0, y0, x1, y1;
+	};
+
+	Clip_ clip_rect_( Surface const& ) noexcept;
+}
+
+BitmapFont::BitmapFont( ColorU8_sRGB aColor, std::uint32_t aScale )
+	: mScale( std::max( aScale, std::uint32_t(1) ) )
+	, mColor( aColor )
+{
+	auto const cellW = glyph_width(), cellH = glyph_height();
+
+	// Bake the atlas: one row of cells. Image row 0 is the bottom row of
+	// the glyphs (see image_view.hpp).
+	mAtlas = create_image( kGlyphCount_ * cellW, cellH );
+
+	auto* pixels = mAtlas->get_image_ptr();
+	for( std::uint32_t g = 0; g < kGlyphCount_; ++g )
+	{
+		for( std::uint32_t y = 0; y < cellH; ++y )
+		{
+			auto const bits = kGlyphs_[g].rows[kGlyphHeight - 1 - y / mScale];
+			for( std::uint32_t x = 0; x < cellW; ++x )
+			{
+				if( !(bits & (0x10u >> (x / mScale))) )
+					continue;
+
+				auto* texel = pixels + 4 * std::size_t(mAtlas->get_linear_index( g * cellW + x, y ));
+				texel[0] = aColor.r;
+				texel[1] = aColor.g;
+				texel[2] = aColor.b;
+				texel[3] = 255;
+			}
+		}
+	}
+
+	// Collect the opaque spans of each glyph from the atlas
+	mGlyphSpans.reserve( kGlyphCount_ + 1 );
+	for( std::uint32_t g = 0; g < kGlyphCount_; ++g )
+	{
+		mGlyphSpans.emplace_back( std::uint32_t(mSpans.size()) );
+
+		auto const view = glyph( g );
+		for( std::uint32_t y = 0; y < cellH; ++y )
+		{
+			auto const* row = view.row( y );
+			for( std::uint32_t x = 0; x < cellW; )
+			{
+				if( row[4*x+3] < 128 )
+				{
+					++x;
+					continue;
+				}
+
+				auto const start = x;
+				while( x < cellW && row[4*x+3] >= 128 )
+					++x;
+
+				mSpans.emplace_back( Span_{ y, start, x } );
+			}
+		}
+	}
+	mGlyphSpans.emplace_back( std::uint32_t(mSpans.size()) );
+
+	// Character map
+	std::fill( std::begin( mGlyphOf ), std::end( mGlyphOf ), kUnknownGlyph_ );
+	for( std::uint32_t g = 0; g < kGlyphCount_; ++g )
+	{
+		auto const ch = kGlyphs_[g].ch;
+		mGlyphOf[std::uint8_t(ch)] = std::uint8_t(g);
+		if( ch >= 'A' && ch <= 'Z' )
+			mGlyphOf[std::uint8_t(ch - 'A' + 'a')] = std::uint8_t(g);
+	}
+}
+
+std::uint32_t BitmapFont::scale() const noexcept
+{
+	return mScale;
+}
+
+std::uint32_t BitmapFont::advance() const noexcept
+{
+	return kAdvance * mScale;
+}
+std::uint32_t BitmapFont::line_height() const noexcept
+{
+	return kLineHeight * mScale;
+}
+std::uint32_t BitmapFont::glyph_width() const noexcept
+{
+	return kGlyphWidth * mScale;
+}
+std::uint32_t BitmapFont::glyph_height() const noexcept
+{
+	return kGlyphHeight * mScale;
+}
+
+std::uint32_t BitmapFont::glyph_index( char aChar ) const noexcept
+{
+	auto const ch = std::uint8_t(aChar);
+	return ch < 128 ? mGlyphOf[ch] : kUnknownGlyph_;
+}
+
+ImageViewRGBA BitmapFont::glyph( std::uint32_t aIndex ) const
+{
+	assert( aIndex < kGlyphCount_ );
+	return make_subview( make_image_view( *mAtlas ), aIndex * glyph_width(), 0, glyph_width(), glyph_height() );
+}
+
+void BitmapFont::draw_glyph( Surface& aSurface, std::uint32_t aIndex, std::int64_t aX, std::int64_t aY ) const
+{
+	assert( aIndex < kGlyphCount_ );
+
+	auto const clip = clip_rect_( aSurface );
+
+	// Skip glyphs that are entirely clipped
+	if( aX >= clip.x1 || aY >= clip.y1 || aX + glyph_width() <= clip.x0 || aY + glyph_height() <= clip.y0 )
+		return;
+
+	auto const* span = mSpans.data() + mGlyphSpans[aIndex];
+	auto const* end = mSpans.data() + mGlyphSpans[aIndex+1];
+	for( ; span != end; ++span )
+	{
+		auto const y = aY + span->y;
+		if( y < clip.y0 || y >= clip.y1 )
+			continue;
+
+		auto const x0 = std::max( aX + span->x0, clip.x0 );
+		auto const x1 = std::min( aX + span->x1, clip.x1 );
+		for( auto x = x0; x < x1; ++x )
+			aSurface.set_pixel_srgb( Surface::Index(x), Surface::Index(y), mColor );
+	}
+}
+
+
+TextRun::TextRun()
+	: mFont( nullptr )
+	, mWidth( 0 )
+	, mHeight( 0 )
+{}
+
+void TextRun::set( BitmapFont const& aFont, std::string_view aText )
+{
+	if( &aFont == mFont && aText == mText )
+		return;
+
+	mFont = &aFont;
+	mText.assign( aText.data(), aText.size() );
+	mGlyphs.clear();
+
+	auto const advance = std::int32_t(aFont.advance());
+	auto const lineHeight = std::int32_t(aFont.line_height());
+	auto const glyphHeight = std::int32_t(aFont.glyph_height());
+
+	std::int32_t x = 0, line = 0;
+	std::int32_t widest = 0;
+	for( auto const ch : aText )
+	{
+		if( '\n' == ch )
+		{
+			x = 0;
+			++line;
+			continue;
+		}
+
+		auto const index = aFont.glyph_index( ch );
+		if( 0 != index )
+			mGlyphs.emplace_back( Glyph_{ index, x, -(line * lineHeight + glyphHeight) } );
+
+		x += advance;
+		widest = std::max( widest, x - advance + std::int32_t(aFont.glyph_width()) );
+	}
+
+	mWidth = std::uint32_t(widest);
+	mHeight = aText.empty() ? 0 : std::uint32_t(line * lineHeight + glyphHeight);
+}
+
+void TextRun::draw( Surface& aSurface, Vec2f aTopLeft ) const
+{
+	if( !mFont )
+		return;
+
+	auto const ox = std::int64_t(aTopLeft.x);
+	auto const oy = std::int64_t(aTopLeft.y);
+
+	for( auto const& glyph : mGlyphs )
+		mFont->draw_glyph( aSurface, glyph.index, ox + glyph.x, oy + glyph.y );
+}
+
+std::string_view TextRun::text() const noexcept
+{
+	return mText;
+}
+
+std::uint32_t TextRun::width() const noexcept
+{
+	return mWidth;
+}
+std::uint32_t TextRun::height() const noexcept
+{
+	return mHeight;
+}
+
+
+void draw_text( Surface& aSurface, BitmapFont const& aFont, std::string_view aText, Vec2f aTopLeft )
+{
+	thread_local TextRun run;
+	run.set( aFont, aText );
+	run.draw( aSurface, aTopLeft );
+}
+
+
+namespace
+{
+	Clip_ clip_rect_( Surface const& aSurface ) noexcept
+	{
+		Clip_ ret{ 0, 0, std::int64_t(aSurface.get_width()), std::int64_t(aSurface.get_height()) };
+
+		if( auto const* scissor = current_scissor() )
+		{
+			ret.x0 = std::max<std::int64_t>( ret.x0, scissor->minX );
+			ret.y0 = std::max<std::int64_t>( ret.y0, scissor->minY );
+			ret.x1 = std::min<std::int64_t>( ret.x1, scissor->maxX );
+			ret.y1 = std::min<std::int64_t>( ret.y1, scissor->maxY );
+		}
+
+		return ret;
+	}
+}
@@ -0,0 +1,131 @@
+#ifndef TEXT_HPP_E3B7A052_9C1D_4F68_B4E2_0D85C6F1A937
+#define TEXT_HPP_E3B7A052_9C1D_4F68_B4E2_0D85C6F1A937
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <string_view>
+
+#include <cstdint>
+
+#include "forward.hpp"
+#include "color.hpp"
+#include "image.hpp"
+#include "image_view.hpp"
+
+#include "../vmlib/vec2.hpp"
+
+/** Bitmap font
+ *
+ * A built-in 5x7 pixel font, baked into an atlas image in one color and at
+ * an integer scale. The font covers digits, letters and common punctuation.
+ * Lowercase letters use the uppercase glyphs; other characters are drawn as
+ * '?'.
+ *
+ * Glyphs are drawn with a masked span blit: when the atlas is baked, each
+ * glyph's opaque pixels are collected into horizontal spans. Drawing a glyph
+ * gives the same result as blit_masked() with the glyph's view, but only
+ * visits the opaque pixels.
+ */
+class BitmapFont
+{
+	public:
+		explicit BitmapFont( ColorU8_sRGB, std::uint32_t aScale = 1 );
+
+		BitmapFont( BitmapFont const& ) = delete;
+		BitmapFont& operator= (BitmapFont const&) = delete;
+
+	public:
+		std::uint32_t scale() const noexcept;
+
+		// In pixels, at the font's scale
+		std::uint32_t advance() const noexcept;
+		std::uint32_t line_height() const noexcept;
+		std::uint32_t glyph_width() const noexcept;
+		std::uint32_t glyph_height() const noexcept;
+
+		// Glyph for a character. Index 0 is the space, which has no pixels.
+		std::uint32_t glyph_index( char ) const noexcept;
+
+		// Glyph's cell in the atlas
+		ImageViewRGBA glyph( std::uint32_t aIndex ) const;
+
+		// Draw a glyph with its bottom-left corner at (aX,aY). Clipped to
+		// the surface and the current scissor.
+		void draw_glyph( Surface&, std::uint32_t aIndex, std::int64_t aX, std::int64_t aY ) const;
+
+	public: // Configuration values
+		static constexpr std::uint32_t kGlyphWidth = 5;
+		static constexpr std::uint32_t kGlyphHeight = 7;
+
+		static constexpr std::uint32_t kAdvance = 6; // glyph width + spacing
+		static constexpr std::uint32_t kLineHeight = 9;
+
+	private:
+		// Opaque pixels [x0, x1) on row y of a glyph's cell (row 0 is the
+		// bottom row)
+		struct Span_
+		{
+			std::uint32_t y;
+			std::uint32_t x0, x1;
+		};
+
+	private:
+		std::uint32_t mScale;
+		std::unique_ptr<ImageRGBA> mAtlas;
+
+		std::vector<Span_> mSpans;
+		std::vector<std::uint32_t> mGlyphSpans; // glyph i: [mGlyphSpans[i], mGlyphSpans[i+1])
+
+		std::uint8_t mGlyphOf[128]; // ASCII to glyph index
+		ColorU8_sRGB mColor;
+};
+
+/** Laid out text
+ *
+ * Keeps a string together with its glyphs and their positions. set() only
+ * lays the string out again if it changed, so a run that is kept across
+ * frames (e.g., a line of an overlay) costs a comparison when its text stays
+ * the same. Storage is reused; set() does not allocate once the run has held
+ * a string that is at least as long.
+ *
+ * Lines are separated by '\n', and go downwards from the run's top-left
+ * corner. The font must outlive the run.
+ */
+class TextRun
+{
+	public:
+		TextRun();
+
+	public:
+		void set( BitmapFont const&, std::string_view );
+
+		void draw( Surface&, Vec2f aTopLeft ) const;
+
+		std::string_view text() const noexcept;
+
+		// Size of the run's bounding box, in pixels
+		std::uint32_t width() const noexcept;
+		std::uint32_t height() const noexcept;
+
+	private:
+		// Glyph with its bottom-left corner at (x, y) relative to the top-
+		// left corner of the run
+		struct Glyph_
+		{
+			std::uint32_t index;
+			std::int32_t x, y;
+		};
+
+	private:
+		BitmapFont const* mFont;
+		std::string mText;
+
+		std::vector<Glyph_> mGlyphs;
+		std::uint32_t mWidth, mHeight;
+};
+
+// Lay out and draw text without keeping the run (see TextRun)
+void draw_text( Surface&, BitmapFont const&, std::string_view, Vec2f aTopLeft );
+
+#endif // TEXT_HPP_E3B7A052_9C1D_4F68_B4E2_0D85C6F1A937
@@ -1,6 +1,8 @@
 #include <benchmark/benchmark.h>
 #include <cmath> // For std::round and std::abs
+#include <vector>
 #include "../draw2d/draw.hpp"
+#include "../draw2d/line_aa.hpp"
 #include "../draw2d/surface.hpp"
 
 // DDA line drawing function
@@ -102,6 +104,108 @@ void line_drawing_bresenham_benchmark(benchmark::State& aState) {
     aState.SetBytesProcessed(static_cast<int64_t>(width + height - 1) * aState.iterations());
 }
 
+void line_drawing_aa_benchmark(benchmark::State& aState) {
+    auto const width = std::uint32_t(aState.range(0));
+    auto const height = std::uint32_t(aState.range(1));
+
+    Surface surface(width, height);
+
+    // Same four cases as line_drawing_bresenham_benchmark
+    Vec2f begin = {0.0f, 0.0f};
+    Vec2f end = {0.0f, 0.0f};
+
+    if (aState.thread_index() == 0) {
+        begin = {0.0f, static_cast<float>(height) / 2.0f};
+        end = {static_cast<float>(width) - 1.0f, static_cast<float>(height) / 2.0f};
+    } else if (aState.thread_index() == 1) {
+        begin = {static_cast<float>(width) / 2.0f, 0.0f};
+        end = {static_cast<float>(width) / 2.0f, static_cast<float>(height) - 1.0f};
+    } else if (aState.thread_index() == 2) {
+        begin = {0.0f, 0.0f};
+        end = {static_cast<float>(width) - 1.0f, static_cast<float>(height) - 1.0f};
+    } else if (aState.thread_index() == 3) {
+        begin = {0.0f, 0.0f};
+        end = {static_cast<float>(height) - 1.0f, static_cast<float>(width) - 1.0f};
+    }
+
+    for (auto _ : aState) {
+        surface.clear();
+        draw_line_aa(surface, begin, end, {255, 255, 255});
+        benchmark::ClobberMemory();
+    }
+
+    aState.SetBytesProcessed(static_cast<int64_t>(width + height - 1) * aState.iterations());
+}
+
+// Many short lines in all directions (a "star" around the surface's center).
+// This is closer to what the simulation draws than a single long line, and
+// shows the per-line setup cost that draw_lines_aa() shares across a batch.
+std::vector<LineSegment> make_star(std::uint32_t width, std::uint32_t height, std::size_t count) {
+    Vec2f const center = {static_cast<float>(width) / 2.0f, static_cast<float>(height) / 2.0f};
+    float const radius = 0.45f * static_cast<float>(std::min(width, height));
+
+    std::vector<LineSegment> lines;
+    for (std::size_t i = 0; i < count; ++i) {
+        float const angle = 6.2831853f * static_cast<float>(i) / static_cast<float>(count);
+        Vec2f const dir = {std::cos(angle), std::sin(angle)};
+        lines.push_back({center + 0.25f * radius * dir, center + radius * dir});
+    }
+
+    return lines;
+}
+
+constexpr std::size_t kStarLines = 256;
+
+void line_star_solid_benchmark(benchmark::State& aState) {
+    auto const width = std::uint32_t(aState.range(0));
+    auto const height = std::uint32_t(aState.range(1));
+
+    Surface surface(width, height);
+    auto const lines = make_star(width, height, kStarLines);
+
+    for (auto _ : aState) {
+        surface.clear();
+        for (auto const& line : lines)
+            draw_line_solid(surface, line.begin, line.end, {255, 255, 255});
+        benchmark::ClobberMemory();
+    }
+
+    aState.SetItemsProcessed(static_cast<int64_t>(lines.size()) * aState.iterations());
+}
+
+void line_star_aa_benchmark(benchmark::State& aState) {
+    auto const width = std::uint32_t(aState.range(0));
+    auto const height = std::uint32_t(aState.range(1));
+
+    Surface surface(width, height);
+    auto const lines = make_star(width, height, kStarLines);
+
+    for (auto _ : aState) {
+        surface.clear();
+        for (auto const& line : lines)
+            draw_line_aa(surface, line.begin, line.end, {255, 255, 255});
+        benchmark::ClobberMemory();
+    }
+
+    aState.SetItemsProcessed(static_cast<int64_t>(lines.size()) * aState.iterations());
+}
+
+void line_star_aa_batch_benchmark(benchmark::State& aState) {
+    auto const width = std::uint32_t(aState.range(0));
+    auto const height = std::uint32_t(aState.range(1));
+
+    Surface surface(width, height);
+    auto const lines = make_star(width, height, kStarLines);
+
+    for (auto _ : aState) {
+        surface.clear();
+        draw_lines_aa(surface, lines.size(), lines.data(), {255, 255, 255});
+        benchmark::ClobberMemory();
+    }
+
+    aState.SetItemsProcessed(static_cast<int64_t>(lines.size()) * aState.iterations());
+}
+
 // Register the benchmark functions
 BENCHMARK(line_drawing_dda_benchmark)
     ->Args({320, 240})
@@ -115,4 +219,25 @@ BENCHMARK(line_drawing_bresenham_benchmark)
     ->Args({1920, 1080})
     ->Args({7680, 4320});
 
+BENCHMARK(line_drawing_aa_benchmark)
+    ->Args({320, 240})
+    ->Args({1280, 720})
+    ->Args({1920, 1080})
+    ->Args({7680, 4320});
+
+BENCHMARK(line_star_solid_benchmark)
+    ->Args({1280, 720})
+    ->Args({1920, 1080})
+    ->Args({7680, 4320});
+
+BENCHMARK(line_star_aa_benchmark)
+    ->Args({1280, 720})
+    ->Args({1920, 1080})
+    ->Args({7680, 4320});
+
+BENCHMARK(line_star_aa_batch_benchmark)
+    ->Args({1280, 720})
+    ->Args({1920, 1080})
+    ->Args({7680, 4320});
+
 BENCHMARK_MAIN();
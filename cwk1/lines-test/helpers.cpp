@@ -113,6 +113,22 @@ std::array<std::size_t,9> count_pixel_neighbours( Surface const& aSurface )
 	return res;
 }
 
+bool is_pixel_set( Surface const& aSurface, Surface::Index aX, Surface::Index aY )
+{
+	auto const* pixel = aSurface.get_surface_ptr() + aSurface.get_linear_index( aX, aY );
+	return 0 != pixel[0] || 0 != pixel[1] || 0 != pixel[2];
+}
+std::size_t count_set_pixels( Surface const& aSurface )
+{
+	std::size_t count = 0;
+	for( Surface::Index y = 0; y < aSurface.get_height(); ++y )
+	{
+		for( Surface::Index x = 0; x < aSurface.get_width(); ++x )
+			count += is_pixel_set( aSurface, x, y ) ? 1 : 0;
+	}
+	return count;
+}
+
 // Helper function to compare a pixel's color to an expected color
 bool pixelMatchesColor(const Surface& surface, const Vec2f& point, const ColorU8_sRGB& expectedColor) {
     // Get the pointer to the surface's pixel data
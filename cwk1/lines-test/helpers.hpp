@@ -16,6 +16,10 @@ std::size_t max_col_pixel_count( Surface const& );
 
 std::array<std::size_t,9> count_pixel_neighbours( Surface const& );
 
+// A pixel is set if any of its color channels is non-zero
+bool is_pixel_set( Surface const&, Surface::Index aX, Surface::Index aY );
+std::size_t count_set_pixels( Surface const& );
+
 // I have implemented this header file!
 bool pixelMatchesColor(const Surface& surface, const Vec2f& point, const ColorU8_sRGB& expectedColor);
 
@@ -0,0 +1,88 @@
+#include <catch2/catch_amalgamated.hpp>
+
+#include <cstdint>
+
+#include "helpers.hpp"
+
+#include "../draw2d/line_aa.hpp"
+#include "../draw2d/scissor.hpp"
+#include "../draw2d/surface.hpp"
+
+namespace
+{
+	std::uint8_t red_at_( Surface const& aSurface, Surface::Index aX, Surface::Index aY )
+	{
+		return aSurface.get_surface_ptr()[aSurface.get_linear_index( aX, aY )];
+	}
+}
+
+TEST_CASE( "Antialiased lines", "[line_aa]" )
+{
+	Surface surface( 64, 64 );
+	surface.clear();
+
+	SECTION( "pixel centers" )
+	{
+		// Through the centers of row 20: full coverage there, none above or
+		// below, and nothing past the end points
+		draw_line_aa( surface, { 10.f, 20.5f }, { 50.f, 20.5f }, { 255, 255, 255 } );
+
+		for( Surface::Index x = 10; x < 50; ++x )
+		{
+			REQUIRE( 255 == red_at_( surface, x, 20 ) );
+			REQUIRE( 0 == red_at_( surface, x, 19 ) );
+			REQUIRE( 0 == red_at_( surface, x, 21 ) );
+		}
+
+		REQUIRE( 0 == red_at_( surface, 9, 20 ) );
+		REQUIRE( 0 == red_at_( surface, 50, 20 ) );
+	}
+
+	SECTION( "coverage" )
+	{
+		// Coverage sums to one in linear light in every column of a shallow
+		// line, and in every row of a steep line
+		Surface steep( 64, 64 );
+		steep.clear();
+
+		draw_line_aa( surface, { 0.f, 10.3f }, { 64.f, 30.7f }, { 255, 255, 255 } );
+		draw_line_aa( steep, { 40.3f, 64.f }, { 55.1f, 0.f }, { 255, 255, 255 } );
+
+		for( Surface::Index i = 2; i < 62; ++i )
+		{
+			float column = 0.f, row = 0.f;
+			for( Surface::Index j = 0; j < 64; ++j )
+			{
+				column += linear_from_srgb( red_at_( surface, i, j ) );
+				row += linear_from_srgb( red_at_( steep, j, i ) );
+			}
+
+			REQUIRE_THAT( column, Catch::Matchers::WithinAbs( 1.0, 0.02 ) );
+			REQUIRE_THAT( row, Catch::Matchers::WithinAbs( 1.0, 0.02 ) );
+		}
+	}
+
+	SECTION( "clipping" )
+	{
+		ScopedScissor scissor( { 10, 10, 20, 20 } );
+
+		LineSegment const lines[] = {
+			{ { -1e30f, -1e30f }, { 1e30f, 1e30f } },
+			{ { -100.f, 12.f }, { 200.f, 18.f } },
+			{ { 15.f, -100.f }, { 15.f, 200.f } }
+		};
+		draw_lines_aa( surface, 3, lines, { 255, 255, 255 } );
+
+		for( Surface::Index y = 0; y < 64; ++y )
+		{
+			for( Surface::Index x = 0; x < 64; ++x )
+			{
+				bool const inside = x >= 10 && x < 20 && y >= 10 && y < 20;
+				if( !inside )
+					REQUIRE( 0 == red_at_( surface, x, y ) );
+			}
+		}
+
+		REQUIRE( 0 != red_at_( surface, 15, 15 ) );
+	}
+}
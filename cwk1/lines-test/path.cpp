@@ -0,0 +1,147 @@
+#include <catch2/catch_amalgamated.hpp>
+
+#include <algorithm>
+
+#include <cmath>
+
+#include "helpers.hpp"
+
+#include "../draw2d/path.hpp"
+#include "../draw2d/surface.hpp"
+
+namespace
+{
+	// Circle of radius aRadius around the origin, from four cubics
+	Path make_circle_( float aRadius )
+	{
+		float const r = aRadius, k = 0.5523f * aRadius;
+
+		Path path;
+		path.move_to( { r, 0.f } )
+			.cubic_to( { r, k }, { k, r }, { 0.f, r } )
+			.cubic_to( { -k, r }, { -r, k }, { -r, 0.f } )
+			.cubic_to( { -r, -k }, { -k, -r }, { 0.f, -r } )
+			.cubic_to( { k, -r }, { r, -k }, { r, 0.f } )
+			.close()
+		;
+		return path;
+	}
+
+	float distance_to_segment_( Vec2f aP, Vec2f aA, Vec2f aB )
+	{
+		auto const ab = aB - aA;
+		auto const t = std::clamp( dot( aP - aA, ab ) / dot( ab, ab ), 0.f, 1.f );
+		return length( aP - (aA + t * ab) );
+	}
+
+	Mat22f const kIdentity{ 1.f, 0.f, 0.f, 1.f };
+}
+
+TEST_CASE( "Path flattening", "[path]" )
+{
+	SECTION( "tolerance" )
+	{
+		Vec2f const p0{ 0.f, 0.f }, c{ 50.f, 120.f }, p1{ 100.f, 0.f };
+
+		Path path;
+		path.move_to( p0 ).quad_to( c, p1 );
+
+		Path::Flattened flat;
+		path.flatten( flat, 0.25f );
+
+		REQUIRE( 1 == flat.contours.size() );
+		REQUIRE( flat.points.size() > 2 );
+
+		// Points on the curve are close to the polyline
+		for( int i = 0; i <= 100; ++i )
+		{
+			float const t = i / 100.f, s = 1.f - t;
+			auto const curve = (s*s) * p0 + (2.f*s*t) * c + (t*t) * p1;
+
+			float best = 1e9f;
+			for( std::size_t j = 1; j < flat.points.size(); ++j )
+				best = std::min( best, distance_to_segment_( curve, flat.points[j-1], flat.points[j] ) );
+
+			REQUIRE( best <= 0.25f + 1e-3f );
+		}
+	}
+
+	SECTION( "adaptive" )
+	{
+		auto const circle = make_circle_( 10.f );
+
+		PathCache cache;
+		auto const small = cache.flatten( circle, kIdentity ).points.size();
+		auto const large = cache.flatten( circle, Mat22f{ 20.f, 0.f, 0.f, 20.f } ).points.size();
+
+		REQUIRE( large > small );
+	}
+}
+
+TEST_CASE( "Path cache", "[path]" )
+{
+	auto circle = make_circle_( 30.f );
+
+	PathCache cache;
+	cache.flatten( circle, kIdentity );
+	REQUIRE( 1 == cache.misses() );
+
+	SECTION( "rotation" )
+	{
+		float const c = std::cos( 0.7f ), s = std::sin( 0.7f );
+		cache.flatten( circle, Mat22f{ c, -s, s, c } );
+
+		REQUIRE( 1 == cache.hits() );
+		REQUIRE( 1 == cache.size() );
+	}
+
+	SECTION( "scale" )
+	{
+		cache.flatten( circle, Mat22f{ 4.f, 0.f, 0.f, 4.f } );
+
+		REQUIRE( 0 == cache.hits() );
+		REQUIRE( 2 == cache.size() );
+	}
+
+	SECTION( "modified" )
+	{
+		circle.line_to( { 0.f, 0.f } );
+		cache.flatten( circle, kIdentity );
+
+		REQUIRE( 0 == cache.hits() );
+		REQUIRE( 2 == cache.misses() );
+	}
+}
+
+TEST_CASE( "Path drawing", "[path]" )
+{
+	Surface surface( 128, 128 );
+	surface.clear();
+
+	auto const circle = make_circle_( 40.f );
+
+	SECTION( "outline" )
+	{
+		draw_path( surface, circle, { 255, 255, 255 }, kIdentity, { 64.f, 64.f } );
+
+		// Closed: every pixel has at least two neighbours
+		auto const counts = count_pixel_neighbours( surface );
+		REQUIRE( 0 == counts[0] );
+		REQUIRE( 0 == counts[1] );
+		REQUIRE( counts[2] > 0 );
+	}
+
+	SECTION( "fill" )
+	{
+		fill_path( surface, circle, { 255, 255, 255 }, kIdentity, { 64.f, 64.f } );
+
+		std::size_t count = 0;
+		auto const* pixels = surface.get_surface_ptr();
+		for( std::size_t i = 0; i < 128*128; ++i )
+			count += 0 != pixels[4*i] ? 1 : 0;
+
+		// Area of the circle, pi r^2, within 1%
+		float const area = 3.14159265f * 40.f * 40.f;
+		REQUIRE( std::abs( float(count) - area ) < 0.01f * area );
+	}
+}
@@ -0,0 +1,120 @@
+#include <catch2/catch_amalgamated.hpp>
+
+#include <algorithm>
+
+#include <cmath>
+
+#include "helpers.hpp"
+
+#include "../draw2d/shape.hpp"
+#include "../draw2d/stroke.hpp"
+#include "../draw2d/surface.hpp"
+
+namespace
+{
+	float distance_to_polyline_( Vec2f aP, std::size_t aCount, Vec2f const* aPoints )
+	{
+		float best = INFINITY;
+		for( std::size_t i = 1; i < aCount; ++i )
+		{
+			auto const ab = aPoints[i] - aPoints[i-1];
+			auto const t = std::clamp( dot( aP - aPoints[i-1], ab ) / dot( ab, ab ), 0.f, 1.f );
+			best = std::min( best, length( aP - (aPoints[i-1] + t * ab) ) );
+		}
+		return best;
+	}
+}
+
+TEST_CASE( "Thick lines", "[stroke]" )
+{
+	Surface surface( 64, 64 );
+	surface.clear();
+
+	SECTION( "caps" )
+	{
+		// Four rows of 40 pixels; square caps add two columns at each end
+		draw_line_thick( surface, { 10.f, 20.f }, { 50.f, 20.f }, { 255, 255, 255 }, { 4.f, ELineCap::butt } );
+		REQUIRE( 4*40 == count_set_pixels( surface ) );
+		REQUIRE( is_pixel_set( surface, 10, 18 ) );
+		REQUIRE( is_pixel_set( surface, 49, 21 ) );
+
+		surface.clear();
+		draw_line_thick( surface, { 10.f, 20.f }, { 50.f, 20.f }, { 255, 255, 255 }, { 4.f, ELineCap::square } );
+		REQUIRE( 4*44 == count_set_pixels( surface ) );
+		REQUIRE( is_pixel_set( surface, 8, 18 ) );
+		REQUIRE( is_pixel_set( surface, 51, 21 ) );
+	}
+
+	SECTION( "round joins" )
+	{
+		// With round joins and caps, the stroke is every point within half
+		// the width of the polyline. No gaps, and no pixels further out.
+		Vec2f const points[] = { { 5.f, 5.f }, { 20.f, 55.f }, { 35.f, 8.f }, { 50.f, 50.f }, { 60.f, 10.f } };
+
+		StrokeStyle style;
+		style.width = 6.f;
+		style.cap = ELineCap::round;
+		style.join = ELineJoin::round;
+
+		draw_polyline_thick( surface, 5, points, { 255, 255, 255 }, style );
+
+		for( Surface::Index y = 0; y < 64; ++y )
+		{
+			for( Surface::Index x = 0; x < 64; ++x )
+			{
+				auto const d = distance_to_polyline_( { x + 0.5f, y + 0.5f }, 5, points );
+				if( d < 0.5f * style.width - 0.3f )
+					REQUIRE( is_pixel_set( surface, x, y ) );
+				if( d > 0.5f * style.width )
+					REQUIRE( !is_pixel_set( surface, x, y ) );
+			}
+		}
+	}
+
+	SECTION( "miter limit" )
+	{
+		// The miter of this spike reaches about 2.1 half widths past the
+		// corner: it is beveled with a lower limit
+		Vec2f const points[] = { { 10.5f, 10.f }, { 32.5f, 50.f }, { 54.5f, 10.f } };
+
+		StrokeStyle style;
+		style.width = 4.f;
+		style.join = ELineJoin::miter;
+		style.miterLimit = 2.f;
+
+		draw_polyline_thick( surface, 3, points, { 255, 255, 255 }, style );
+		REQUIRE( !is_pixel_set( surface, 32, 53 ) );
+
+		surface.clear();
+		style.miterLimit = 2.5f;
+		draw_polyline_thick( surface, 3, points, { 255, 255, 255 }, style );
+		REQUIRE( is_pixel_set( surface, 32, 53 ) );
+	}
+
+	SECTION( "line strip" )
+	{
+		// A closed strip is joined at its ends, like a closed polyline
+		Vec2f const points[] = { { -10.f, -10.f }, { 10.f, -10.f }, { 10.f, 10.f }, { -10.f, 10.f }, { -10.f, -10.f } };
+		LineStrip const strip( 5, points );
+
+		StrokeStyle style;
+		style.width = 3.f;
+
+		draw_thick( surface, strip, { 1.f, 1.f, 1.f }, Mat22f{ 1.f, 0.f, 0.f, 1.f }, Vec2f{ 32.f, 32.f }, style );
+
+		Surface expected( 64, 64 );
+		expected.clear();
+
+		Vec2f moved[4];
+		for( std::size_t i = 0; i < 4; ++i )
+			moved[i] = points[i] + Vec2f{ 32.f, 32.f };
+		draw_polyline_thick( expected, 4, moved, { 255, 255, 255 }, style, true );
+
+		REQUIRE( 23*23 - 17*17 == count_set_pixels( surface ) );
+		for( Surface::Index y = 0; y < 64; ++y )
+		{
+			for( Surface::Index x = 0; x < 64; ++x )
+				REQUIRE( is_pixel_set( expected, x, y ) == is_pixel_set( surface, x, y ) );
+		}
+	}
+}
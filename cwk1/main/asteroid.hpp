@@ -1,11 +1,15 @@
 #ifndef ASTEROID_HPP_477C5E99_10A3_4AEB_8FE5_99A52EDF26EC
 #define ASTEROID_HPP_477C5E99_10A3_4AEB_8FE5_99A52EDF26EC
 
+#include <vector>
+
 #include <cstdlib>
 
 #include "../draw2d/forward.hpp"
 #include "../draw2d/color.hpp"
 
+#include "../vmlib/vec2.hpp"
+
 #include "defaults.hpp"
 
 /* Generate a procedural asteroid
@@ -17,6 +21,11 @@
  * Each asteroid is represented by a triangle fan. This limits the possible
  * shapes to deformed circles where lines going from the mid point to the
  * periphery cannot pass outside of the shape.
+ *
+ * The second overload additionally returns the asteroid's outline, i.e., the
+ * points on its periphery in order (without the center, which is always at
+ * the origin). The TriangleFan does not expose its vertices; the outline is
+ * used for collision tests (see AsteroidField).
  */
 
 #if 1
@@ -32,6 +41,19 @@ TriangleFan make_asteroid(
 	float aColorBaseStddev = 0.2f,
 	float aColorVariation = 0.05f
 );
+
+TriangleFan make_asteroid(
+	std::vector<Vec2f>& aOutline,
+	RNG&,
+	std::size_t aNumPoints = 18,
+	float aRadiusMean = 30.f, 
+	float aRadiusStddev = 5.f,
+	float aSquishStddev = 0.20f,
+	float aDisplaceStddev = 2.5f,
+	ColorF const& aBaseColor = { 0.3f, 0.3f, 0.3f },
+	float aColorBaseStddev = 0.2f,
+	float aColorVariation = 0.05f
+);
 #else
 // This creates a lower resolution asteroid with only 7+1 points.
 TriangleFan make_asteroid(
@@ -45,6 +67,19 @@ TriangleFan make_asteroid(
 	float aColorBaseStddev = 0.2f,
 	float aColorVariation = 0.05f
 );
+
+TriangleFan make_asteroid(
+	std::vector<Vec2f>& aOutline,
+	RNG&,
+	std::size_t aNumPoints = 7,
+	float aRadiusMean = 30.f, 
+	float aRadiusStddev = 5.f,
+	float aSquishStddev = 0.15f,
+	float aDisplaceStddef = 9.f,
+	ColorF const& aBaseColor = { 0.3f, 0.3f, 0.3f },
+	float aColorBaseStddev = 0.2f,
+	float aColorVariation = 0.05f
+);
 #endif
 
 // Note that the same function is used to generate either type of asteroid;
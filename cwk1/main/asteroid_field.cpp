@@ -3,18 +3,59 @@
 #include <random>
 #include <algorithm>
 
+#include <cmath>
 #include <cassert>
 
 #include "../draw2d/shape.hpp"
+#include "../draw2d/surface.hpp"
+#include "../draw2d/command_buffer.hpp"
 
 #include "asteroid.hpp"
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#	define ASTEROID_FIELD_SSE2_ 1
+#	include <emmintrin.h>
+#endif
+
 namespace
 {
 	// C++20 adds a number of standardized mathematical constants:
 	// https://en.cppreference.com/w/cpp/numeric/constants
 	// This defines a custom (worse) one:
 	constexpr float kPI = 3.1415926535897932385f; // pi
+
+	// Unit complex number for the rotation by aAngle
+	Vec2f unit_complex_( float aAngle ) noexcept;
+
+	// Rotation by a unit complex number (see make_rotation_2d()) and scale
+	Mat22f scaled_rotation_( float aScale, Vec2f aRot ) noexcept;
+
+	// Complex multiplication; for unit complex numbers, this adds the angles
+	Vec2f complex_mul_( Vec2f aA, Vec2f aB ) noexcept;
+
+	// Computes aCos[i] = cos(aAngles[i]), aSin[i] = sin(aAngles[i]) with a
+	// polynomial approximation (max. error around 1e-7 for moderate angles),
+	// four at a time with SSE2.
+	void sincos_batch_( float const* aAngles, float* aCos, float* aSin, std::size_t aCount ) noexcept;
+
+	// Exact overlap test between a closed polygon and a triangle fan. The fan
+	// is given by its center and the points on its periphery. The polygon's
+	// edges are tested against the fan's outline; if none cross, the shapes
+	// either don't overlap, or one contains the other completely.
+	bool polygon_overlaps_fan_( std::size_t aPolyCount, Vec2f const* aPoly, Vec2f const& aCenter, std::size_t aFanCount, Vec2f const* aFan ) noexcept;
+
+	// Axis aligned box around aCount points
+	void bounding_box_( std::size_t aCount, Vec2f const* aPoints, Vec2f& aMin, Vec2f& aMax ) noexcept;
+	bool segment_touches_box_( Vec2f aP0, Vec2f aP1, Vec2f aMin, Vec2f aMax ) noexcept;
+
+	// Distance from the origin to the closest edge of the closed outline
+	float inner_radius_( std::size_t aCount, Vec2f const* aOutline ) noexcept;
+
+	bool segments_cross_( Vec2f aP0, Vec2f aP1, Vec2f aQ0, Vec2f aQ1 ) noexcept;
+	bool point_in_fan_( Vec2f aPoint, Vec2f aCenter, std::size_t aFanCount, Vec2f const* aFan ) noexcept;
+	bool point_in_polygon_( Vec2f aPoint, std::size_t aPolyCount, Vec2f const* aPoly ) noexcept;
+
+	float cross_( Vec2f aA, Vec2f aB ) noexcept;
 }
 
 AsteroidField::AsteroidField( RNG& aRNG, std::uint32_t aWidth, std::uint32_t aHeight, float aDensity, float aInitialSpeedStddev, float aMaximumSpeed, float aInitialRotStddev, float aPadding )
@@ -23,7 +64,12 @@ AsteroidField::AsteroidField( RNG& aRNG, std::uint32_t aWidth, std::uint32_t aHe
 	, mInitialRot( aInitialRotStddev )
 	, mPadding( aPadding )
 	, mDensity( aDensity )
-	, mRNG( aRNG )
+	, mStepElapsed( -1.f )
+	, mUpdatesSinceNormalize( 0 )
+	, mExactCollisions( true )
+	, mBounce( false )
+	, mNextId( 0 )
+	, mRNG( fork_rng( aRNG ) )
 {
 	// Compute area of simulation
 	mExactExtent = Vec2f{ float(aWidth), float(aHeight) };
@@ -38,10 +84,32 @@ AsteroidField::AsteroidField( RNG& aRNG, std::uint32_t aWidth, std::uint32_t aHe
 	std::size_t const numAsteroids = std::size_t(numAsteroidsf+0.5f);
 	
 	mAsteroids.resize( numAsteroids );
-	mShapes.reserve( numAsteroids ); // reserve! not resize!
+
+	// Generate the shared shapes, and keep their outlines for collisions
+	mPrototypes.reserve( kPrototypeCount ); // reserve! not resize!
+	mOutlines.reserve( kPrototypeCount );
+	mInstances.resize( kPrototypeCount );
+	mInstanceScales.resize( kPrototypeCount );
+
+	std::vector<Vec2f> outline;
+	for( std::size_t i = 0; i < kPrototypeCount; ++i )
+	{
+		mPrototypes.emplace_back( make_asteroid( outline, mRNG ) );
+
+		float radius = 0.f;
+		for( auto const& point : outline )
+			radius = std::max( radius, length( point ) );
+
+		mOutlines.emplace_back( Outline_{
+			std::uint32_t(mOutlinePoints.size()), std::uint32_t(outline.size()),
+			radius, inner_radius_( outline.size(), outline.data() )
+		} );
+		mOutlinePoints.insert( mOutlinePoints.end(), outline.begin(), outline.end() );
+	}
 
 	using Uniform_ = std::uniform_real_distribution<float>;
 	using Normal_ = std::normal_distribution<float>;
+	using Prototype_ = std::uniform_int_distribution<std::uint32_t>;
 
 	Uniform_ xpos{ mBoundsMin.x, mBoundsMax.x };
 	Uniform_ ypos{ mBoundsMin.y, mBoundsMax.y };
@@ -51,22 +119,30 @@ AsteroidField::AsteroidField( RNG& aRNG, std::uint32_t aWidth, std::uint32_t aHe
 	Normal_ vvel{ 0.f, mInitialSpeed };
 	Normal_ rots{ 0.f, mInitialRot };
 
+	Prototype_ proto( 0, std::uint32_t(mPrototypes.size()-1) );
+	Normal_ scale{ 1.f, kScaleStddev };
+
 	for( std::size_t i = 0; i < numAsteroids; ++i )
 	{
 		auto& astr = mAsteroids[i];
 		astr.pos = Vec2f{ xpos( mRNG ), ypos( mRNG ) };
 		astr.vel = Vec2f{ vvel( mRNG ), vvel( mRNG ) };
 
-		astr.rot = make_rotation_2d( angle( mRNG ) );
+		astr.rot = unit_complex_( angle( mRNG ) );
 		astr.radpersec = rots( mRNG );
 
 		// Don't break the speed limits. The space police will get you!
 		astr.vel.x = std::clamp( astr.vel.x, -mMaximumSpeed, +mMaximumSpeed );
 		astr.vel.y = std::clamp( astr.vel.y, -mMaximumSpeed, +mMaximumSpeed );
 
-		// Create shape
-		mShapes.emplace_back( make_asteroid( mRNG ) );
+		// Pick shape
+		astr.prototype = proto( mRNG );
+		astr.scale = std::clamp( scale( mRNG ), kMinScale, kMaxScale );
+
+		astr.id = mNextId++;
 	}
+
+	rebuild_grid_();
 }
 
 AsteroidField::~AsteroidField() = default;
@@ -75,10 +151,15 @@ AsteroidField::~AsteroidField() = default;
 void AsteroidField::update( float aElapsed, Vec2f const& aTransl )
 {
 	auto const numAsteroids = mAsteroids.size();
-	assert( numAsteroids == mShapes.size() );
+
+	// Per-asteroid rotation steps only need to be recomputed when the time
+	// step changes.
+	if( aElapsed != mStepElapsed )
+		update_rotation_steps_( aElapsed );
 
 	using Uniform_ = std::uniform_real_distribution<float>;
 	using Normal_ = std::normal_distribution<float>;
+	using Prototype_ = std::uniform_int_distribution<std::uint32_t>;
 
 	Uniform_ xpos{ mBoundsMin.x, mBoundsMax.x };
 	Uniform_ ypos{ mBoundsMin.y, mBoundsMax.y };
@@ -88,6 +169,9 @@ void AsteroidField::update( float aElapsed, Vec2f const& aTransl )
 	Normal_ vvel{ 0.f, mInitialSpeed };
 	Normal_ rots{ 0.f, mInitialRot };
 
+	Prototype_ proto( 0, std::uint32_t(mPrototypes.size()-1) );
+	Normal_ scale{ 1.f, kScaleStddev };
+
 	for( std::size_t i = 0; i < numAsteroids; ++i )
 	{
 		auto& astr = mAsteroids[i];
@@ -127,42 +211,64 @@ void AsteroidField::update( float aElapsed, Vec2f const& aTransl )
 
 			astr.vel = Vec2f{ vvel( mRNG ), vvel( mRNG ) };
 
-			astr.rot = make_rotation_2d( angle( mRNG ) );
+			astr.rot = unit_complex_( angle( mRNG ) );
 			astr.radpersec = rots( mRNG );
+			astr.rotstep = unit_complex_( astr.radpersec * aElapsed );
 
 			// Don't break the speed limits. The space police will get you!
 			astr.vel.x = std::clamp( astr.vel.x, -mMaximumSpeed, +mMaximumSpeed );
 			astr.vel.y = std::clamp( astr.vel.y, -mMaximumSpeed, +mMaximumSpeed );
 
-			// Create shape
-			mShapes[i] = make_asteroid( mRNG );
+			// Pick shape. This does not allocate; the shapes are shared.
+			astr.prototype = proto( mRNG );
+			astr.scale = std::clamp( scale( mRNG ), kMinScale, kMaxScale );
+
+			// This is a new asteroid, as far as snapshots are concerned
+			astr.id = mNextId++;
 		}
 		else
 		{
-			astr.rot = make_rotation_2d( astr.radpersec * aElapsed ) * astr.rot;
+			astr.rot = complex_mul_( astr.rotstep, astr.rot );
 		}
 	}
+
+	// Rounding errors slowly change the length of the rotations.
+	if( ++mUpdatesSinceNormalize >= kNormalizeInterval )
+	{
+		for( auto& astr : mAsteroids )
+			astr.rot = astr.rot * (1.f / std::sqrt( dot( astr.rot, astr.rot ) ));
+
+		mUpdatesSinceNormalize = 0;
+	}
+
+	// Collisions. This also rebuilds the grid for hit_test().
+	find_contacts( mContacts );
+
+	if( mBounce )
+	{
+		for( auto const& contact : mContacts )
+			bounce_( mAsteroids[contact.a], mAsteroids[contact.b] );
+	}
 }
 
 void AsteroidField::draw( Surface& aSurface ) const
 {
-	auto const numAsteroids = mAsteroids.size();
-	assert( numAsteroids == mShapes.size() );
+	draw_( aSurface );
+}
 
-	for( std::size_t i = 0; i < numAsteroids; ++i )
-	{
-		auto const& astr = mAsteroids[i];
-		auto const& shape = mShapes[i];
+void AsteroidField::draw( Surface& aSurface, std::vector<Pose> const& aPrevious, std::vector<Pose> const& aCurrent, float aAlpha ) const
+{
+	draw_( aSurface, aPrevious, aCurrent, aAlpha );
+}
 
-		// Performance: culling asteroids here would remove some work; right
-		// now each triangle will be culled individually.
+void AsteroidField::draw( CommandBuffer& aCommands ) const
+{
+	draw_( aCommands );
+}
 
-		shape.draw(
-			aSurface,
-			astr.rot,
-			astr.pos
-		);
-	}
+void AsteroidField::draw( CommandBuffer& aCommands, std::vector<Pose> const& aPrevious, std::vector<Pose> const& aCurrent, float aAlpha ) const
+{
+	draw_( aCommands, aPrevious, aCurrent, aAlpha );
 }
 
 void AsteroidField::resize( std::uint32_t aWidth, std::uint32_t aHeight )
@@ -182,37 +288,30 @@ void AsteroidField::resize( std::uint32_t aWidth, std::uint32_t aHeight )
 	float const numAsteroidsf = mActualExtent.x*mActualExtent.y * mDensity;
 	std::size_t const numAsteroids = std::size_t(numAsteroidsf+0.5f);
 
-	// Remove asteroids now outside
+	// Remove asteroids now outside. The array is compacted in a single pass,
+	// keeping the order of the remaining asteroids.
 	std::size_t activeAsteroids = 0;
-
-	auto jt = mShapes.begin();
-	for( auto it = mAsteroids.begin(); it != mAsteroids.end(); )
+	for( std::size_t i = 0; i < mAsteroids.size(); ++i )
 	{
-		auto const& aster = *it;
-
+		auto const& aster = mAsteroids[i];
 		if( aster.pos.x > mBoundsMax.x || aster.pos.y > mBoundsMax.y )
-		{
-			it = mAsteroids.erase( it );
-			jt = mShapes.erase( jt );
-		}
-		else
-		{
-			++it;
-			++jt;
-			++activeAsteroids;
-		}
+			continue;
+
+		if( i != activeAsteroids )
+			mAsteroids[activeAsteroids] = aster;
+
+		++activeAsteroids;
 	}
 
 	mAsteroids.resize( numAsteroids );
 	activeAsteroids = std::min( activeAsteroids, numAsteroids );
 
-	mShapes.erase( mShapes.begin()+activeAsteroids, mShapes.end() );
-	mShapes.reserve( numAsteroids );
-
-	assert( mShapes.size() == activeAsteroids );
+	// New asteroids need their rotation steps
+	mStepElapsed = -1.f;
 
 	// Generate new asteroids.
 	using Normal_ = std::normal_distribution<float>;
+	using Prototype_ = std::uniform_int_distribution<std::uint32_t>;
 	using Uniform_ = std::uniform_real_distribution<float>;
 
 	if( activeAsteroids < numAsteroids )
@@ -235,6 +334,9 @@ void AsteroidField::resize( std::uint32_t aWidth, std::uint32_t aHeight )
 		Normal_ vvel{ 0.f, mInitialSpeed };
 		Normal_ rots{ 0.f, mInitialRot };
 
+		Prototype_ proto( 0, std::uint32_t(mPrototypes.size()-1) );
+		Normal_ scale{ 1.f, kScaleStddev };
+
 		for( std::size_t i = activeAsteroids; i < numAsteroids; ++i )
 		{
 			Vec2f pos;
@@ -256,19 +358,588 @@ void AsteroidField::resize( std::uint32_t aWidth, std::uint32_t aHeight )
 			astr.pos = pos;
 			astr.vel = Vec2f{ vvel( mRNG ), vvel( mRNG ) };
 
-			astr.rot = make_rotation_2d( angle( mRNG ) );
+			astr.rot = unit_complex_( angle( mRNG ) );
 			astr.radpersec = rots( mRNG );
 
 			// Don't break the speed limits. The space police will get you!
 			astr.vel.x = std::clamp( astr.vel.x, -mMaximumSpeed, +mMaximumSpeed );
 			astr.vel.y = std::clamp( astr.vel.y, -mMaximumSpeed, +mMaximumSpeed );
 
-			// Create shape
-			assert( i == mShapes.size() );
-			mShapes.emplace_back( make_asteroid( mRNG ) );
+			// Pick shape
+			astr.prototype = proto( mRNG );
+			astr.scale = std::clamp( scale( mRNG ), kMinScale, kMaxScale );
+
+			astr.id = mNextId++;
+		}
+	}
+
+	// Asteroids were moved around; the old indices are no longer valid.
+	mContacts.clear();
+
+	rebuild_grid_();
+}
+
+void AsteroidField::snapshot( std::vector<Pose>& aPoses ) const
+{
+	auto const numAsteroids = mAsteroids.size();
+
+	aPoses.resize( numAsteroids );
+	for( std::size_t i = 0; i < numAsteroids; ++i )
+	{
+		auto const& astr = mAsteroids[i];
+		aPoses[i] = Pose{ astr.pos, astr.rot, astr.scale, astr.prototype, astr.id };
+	}
+}
+
+void AsteroidField::find_contacts( std::vector<Contact>& aContacts, EBroadPhase aBroadPhase )
+{
+	aContacts.clear();
+
+	if( EBroadPhase::grid == aBroadPhase )
+	{
+		rebuild_grid_();
+		mGrid.find_overlaps( aContacts );
+	}
+	else
+	{
+		auto const numAsteroids = std::uint32_t(mAsteroids.size());
+
+		update_circles_();
+		for( std::uint32_t i = 0; i < numAsteroids; ++i )
+		{
+			for( std::uint32_t j = i+1; j < numAsteroids; ++j )
+			{
+				auto const d = mCenters[j] - mCenters[i];
+				auto const r = mRadii[i] + mRadii[j];
+				if( dot( d, d ) < r*r )
+					aContacts.emplace_back( Contact{ i, j } );
+			}
 		}
 	}
 
-	assert( mAsteroids.size() == mShapes.size() );
+	// Bounding circles overestimate the shapes; confirm each candidate pair.
+	if( mExactCollisions )
+	{
+		auto const end = std::remove_if( aContacts.begin(), aContacts.end(), [this] (Contact const& aContact) {
+			return !exact_overlap_( aContact.a, aContact.b );
+		} );
+		aContacts.erase( end, aContacts.end() );
+	}
+}
+
+std::vector<AsteroidField::Contact> const& AsteroidField::contacts() const noexcept
+{
+	return mContacts;
+}
+
+bool AsteroidField::hit_test( std::size_t aCount, Vec2f const* aPoints, Mat22f const& aTransform, Vec2f const& aPosition )
+{
+	if( 0 == aCount )
+		return false;
+
+	// Transformed polygon and its bounding circle
+	float radius = 0.f;
+
+	mWorldA.resize( aCount );
+	for( std::size_t i = 0; i < aCount; ++i )
+	{
+		auto const p = aTransform * aPoints[i];
+		radius = std::max( radius, length( p ) );
+		mWorldA[i] = p + aPosition;
+	}
+
+	mHits.clear();
+	mGrid.find_overlaps( aPosition, radius, mHits );
+
+	if( !mExactCollisions )
+		return !mHits.empty();
+
+	for( auto const index : mHits )
+	{
+		world_outline_( index, mWorldB );
+		if( polygon_overlaps_fan_( aCount, mWorldA.data(), mAsteroids[index].pos, mWorldB.size(), mWorldB.data() ) )
+			return true;
+	}
+
+	return false;
+}
+
+void AsteroidField::set_exact_collisions( bool aExact ) noexcept
+{
+	mExactCollisions = aExact;
+}
+bool AsteroidField::exact_collisions() const noexcept
+{
+	return mExactCollisions;
+}
+
+void AsteroidField::set_bounce( bool aBounce ) noexcept
+{
+	mBounce = aBounce;
+}
+bool AsteroidField::bounce() const noexcept
+{
+	return mBounce;
 }
 
+void AsteroidField::update_rotation_steps_( float aElapsed )
+{
+	auto const numAsteroids = mAsteroids.size();
+
+	mAngles.resize( numAsteroids );
+	mCos.resize( numAsteroids );
+	mSin.resize( numAsteroids );
+
+	for( std::size_t i = 0; i < numAsteroids; ++i )
+		mAngles[i] = mAsteroids[i].radpersec * aElapsed;
+
+	sincos_batch_( mAngles.data(), mCos.data(), mSin.data(), numAsteroids );
+
+	for( std::size_t i = 0; i < numAsteroids; ++i )
+		mAsteroids[i].rotstep = Vec2f{ mCos[i], mSin[i] };
+
+	mStepElapsed = aElapsed;
+}
+
+template< class tTarget >
+void AsteroidField::draw_( tTarget& aTarget ) const
+{
+	auto const numAsteroids = mAsteroids.size();
+
+	for( std::size_t i = 0; i < numAsteroids; ++i )
+	{
+		auto const& astr = mAsteroids[i];
+		draw_shape_( aTarget, astr.prototype, astr.scale, astr.rot, astr.pos );
+	}
+
+	flush_( aTarget );
+}
+
+template< class tTarget >
+void AsteroidField::draw_( tTarget& aTarget, std::vector<Pose> const& aPrevious, std::vector<Pose> const& aCurrent, float aAlpha ) const
+{
+	auto const numAsteroids = aCurrent.size();
+	auto const numPrevious = aPrevious.size();
+
+	for( std::size_t i = 0; i < numAsteroids; ++i )
+	{
+		auto const& cur = aCurrent[i];
+
+		// Asteroids that were (re-)spawned since the previous snapshot are
+		// drawn where they are now.
+		if( i >= numPrevious || aPrevious[i].id != cur.id )
+		{
+			draw_shape_( aTarget, cur.prototype, cur.scale, cur.rot, cur.pos );
+			continue;
+		}
+
+		auto const& prev = aPrevious[i];
+
+		// Linear interpolation of the rotation, renormalized. The rotation
+		// per step is small, so this is close enough to the exact angle.
+		auto const pos = prev.pos + aAlpha * (cur.pos - prev.pos);
+		auto rot = prev.rot + aAlpha * (cur.rot - prev.rot);
+		rot = rot * (1.f / std::sqrt( dot( rot, rot ) ));
+
+		draw_shape_( aTarget, cur.prototype, cur.scale, rot, pos );
+	}
+
+	flush_( aTarget );
+}
+
+void AsteroidField::draw_shape_( Surface&, std::uint32_t aPrototype, float aScale, Vec2f aRot, Vec2f aPos ) const
+{
+	assert( aPrototype < mInstances.size() );
+
+	// Asteroids outside of the surface (or the current scissor) are culled
+	// by draw_instances().
+	mInstances[aPrototype].emplace_back( ShapeInstance{
+		scaled_rotation_( aScale, aRot ),
+		aPos
+	} );
+}
+
+void AsteroidField::draw_shape_( CommandBuffer&, std::uint32_t aPrototype, float aScale, Vec2f aRot, Vec2f aPos ) const
+{
+	assert( aPrototype < mInstances.size() );
+
+	mInstances[aPrototype].emplace_back( ShapeInstance{
+		scaled_rotation_( aScale, aRot ),
+		aPos
+	} );
+	mInstanceScales[aPrototype].emplace_back( aScale );
+}
+
+void AsteroidField::flush_( Surface& aSurface ) const
+{
+	auto const numPrototypes = mPrototypes.size();
+	for( std::size_t i = 0; i < numPrototypes; ++i )
+	{
+		auto& instances = mInstances[i];
+		draw_instances( aSurface, mPrototypes[i], instances.size(), instances.data() );
+		instances.clear();
+	}
+}
+
+void AsteroidField::flush_( CommandBuffer& aCommands ) const
+{
+	// Consecutive fans of the same prototype are replayed with
+	// draw_instances(). Asteroids outside of the surface are dropped by
+	// CommandBuffer::bin().
+	auto const numPrototypes = mPrototypes.size();
+	for( std::size_t i = 0; i < numPrototypes; ++i )
+	{
+		auto& instances = mInstances[i];
+		auto& scales = mInstanceScales[i];
+		assert( instances.size() == scales.size() );
+
+		for( std::size_t j = 0; j < instances.size(); ++j )
+		{
+			aCommands.fan(
+				mPrototypes[i],
+				instances[j].transform,
+				instances[j].translation,
+				scales[j] * mOutlines[i].radius
+			);
+		}
+
+		instances.clear();
+		scales.clear();
+	}
+}
+
+void AsteroidField::update_circles_()
+{
+	auto const numAsteroids = mAsteroids.size();
+
+	mCenters.resize( numAsteroids );
+	mRadii.resize( numAsteroids );
+
+	for( std::size_t i = 0; i < numAsteroids; ++i )
+	{
+		auto const& astr = mAsteroids[i];
+
+		assert( astr.prototype < mOutlines.size() );
+		mCenters[i] = astr.pos;
+		mRadii[i] = astr.scale * mOutlines[astr.prototype].radius;
+	}
+}
+
+void AsteroidField::rebuild_grid_()
+{
+	update_circles_();
+	mGrid.build( mCenters.size(), mCenters.data(), mRadii.data(), mBoundsMin, mBoundsMax );
+}
+
+bool AsteroidField::exact_overlap_( std::uint32_t aA, std::uint32_t aB )
+{
+	// Asteroids always overlap if their inner circles do
+	auto const& a = mAsteroids[aA];
+	auto const& b = mAsteroids[aB];
+
+	auto const d = b.pos - a.pos;
+	auto const r = a.scale * mOutlines[a.prototype].inner + b.scale * mOutlines[b.prototype].inner;
+	if( dot( d, d ) < r*r )
+		return true;
+
+	world_outline_( aA, mWorldA );
+	world_outline_( aB, mWorldB );
+
+	return polygon_overlaps_fan_( mWorldA.size(), mWorldA.data(), mAsteroids[aB].pos, mWorldB.size(), mWorldB.data() );
+}
+
+void AsteroidField::world_outline_( std::uint32_t aAsteroid, std::vector<Vec2f>& aOutline ) const
+{
+	auto const& astr = mAsteroids[aAsteroid];
+	auto const& outline = mOutlines[astr.prototype];
+
+	// Same transform as in draw()
+	auto const c = astr.scale * astr.rot.x;
+	auto const s = astr.scale * astr.rot.y;
+
+	aOutline.resize( outline.count );
+	for( std::uint32_t i = 0; i < outline.count; ++i )
+	{
+		auto const v = mOutlinePoints[outline.first + i];
+		aOutline[i] = Vec2f{ c*v.x - s*v.y, s*v.x + c*v.y } + astr.pos;
+	}
+}
+
+void AsteroidField::bounce_( Asteroid_& aA, Asteroid_& aB ) const noexcept
+{
+	auto const delta = aB.pos - aA.pos;
+	auto const dist = length( delta );
+	if( dist <= 0.f )
+		return;
+
+	// Only bounce if the asteroids are approaching each other. Overlapping
+	// asteroids that are already separating are left alone; otherwise they
+	// could get stuck bouncing back and forth.
+	auto const normal = delta / dist;
+	auto const approach = dot( aB.vel - aA.vel, normal );
+	if( approach >= 0.f )
+		return;
+
+	// Elastic collision. The mass is proportional to the area.
+	auto const ra = aA.scale * mOutlines[aA.prototype].radius;
+	auto const rb = aB.scale * mOutlines[aB.prototype].radius;
+	auto const invMassA = 1.f / (ra*ra);
+	auto const invMassB = 1.f / (rb*rb);
+
+	auto const impulse = -2.f * approach / (invMassA + invMassB);
+	aA.vel -= (impulse * invMassA) * normal;
+	aB.vel += (impulse * invMassB) * normal;
+
+	// Don't break the speed limits. The space police will get you!
+	aA.vel.x = std::clamp( aA.vel.x, -mMaximumSpeed, +mMaximumSpeed );
+	aA.vel.y = std::clamp( aA.vel.y, -mMaximumSpeed, +mMaximumSpeed );
+	aB.vel.x = std::clamp( aB.vel.x, -mMaximumSpeed, +mMaximumSpeed );
+	aB.vel.y = std::clamp( aB.vel.y, -mMaximumSpeed, +mMaximumSpeed );
+}
+
+namespace
+{
+	Vec2f unit_complex_( float aAngle ) noexcept
+	{
+		return Vec2f{ std::cos( aAngle ), std::sin( aAngle ) };
+	}
+
+	Mat22f scaled_rotation_( float aScale, Vec2f aRot ) noexcept
+	{
+		auto const c = aScale * aRot.x;
+		auto const s = aScale * aRot.y;
+
+		return Mat22f{
+			c, -s,
+			s,  c
+		};
+	}
+
+	Vec2f complex_mul_( Vec2f aA, Vec2f aB ) noexcept
+	{
+		return Vec2f{
+			aA.x*aB.x - aA.y*aB.y,
+			aA.x*aB.y + aA.y*aB.x
+		};
+	}
+
+	void sincos_batch_( float const* aAngles, float* aCos, float* aSin, std::size_t aCount ) noexcept
+	{
+		// Reduce to r in [-pi/4, pi/4] with x = q*pi/2 + r. pi/2 is split into
+		// three parts (Cody-Waite), such that q*pi/2 is subtracted exactly.
+		// The polynomials are the minimax ones on [-pi/4, pi/4] from Cephes'
+		// sinf() and cosf(). Finally, the quadrant q swaps and negates the
+		// results.
+		constexpr float kTwoOverPi = 0.63661977236758134308f;
+		constexpr float kHalfPi0 = 1.5703125f;
+		constexpr float kHalfPi1 = 4.837512969970703125e-4f;
+		constexpr float kHalfPi2 = 7.54978995489188216e-8f;
+
+		constexpr float kS0 = -1.6666654611e-1f, kS1 = 8.3321608736e-3f, kS2 = -1.9515295891e-4f;
+		constexpr float kC0 = 4.166664568298827e-2f, kC1 = -1.388731625493765e-3f, kC2 = 2.443315711809948e-5f;
+
+		std::size_t i = 0;
+
+#		if defined(ASTEROID_FIELD_SSE2_)
+		__m128i const one = _mm_set1_epi32( 1 ), two = _mm_set1_epi32( 2 );
+
+		for( ; i + 4 <= aCount; i += 4 )
+		{
+			__m128 const x = _mm_loadu_ps( aAngles+i );
+
+			// Rounds to nearest (default rounding mode)
+			__m128i const q = _mm_cvtps_epi32( _mm_mul_ps( x, _mm_set1_ps( kTwoOverPi ) ) );
+			__m128 const qf = _mm_cvtepi32_ps( q );
+
+			__m128 r = _mm_sub_ps( x, _mm_mul_ps( qf, _mm_set1_ps( kHalfPi0 ) ) );
+			r = _mm_sub_ps( r, _mm_mul_ps( qf, _mm_set1_ps( kHalfPi1 ) ) );
+			r = _mm_sub_ps( r, _mm_mul_ps( qf, _mm_set1_ps( kHalfPi2 ) ) );
+
+			__m128 const r2 = _mm_mul_ps( r, r );
+
+			__m128 sp = _mm_add_ps( _mm_set1_ps( kS1 ), _mm_mul_ps( r2, _mm_set1_ps( kS2 ) ) );
+			sp = _mm_add_ps( _mm_set1_ps( kS0 ), _mm_mul_ps( r2, sp ) );
+			__m128 const sr = _mm_add_ps( r, _mm_mul_ps( _mm_mul_ps( r, r2 ), sp ) );
+
+			__m128 cp = _mm_add_ps( _mm_set1_ps( kC1 ), _mm_mul_ps( r2, _mm_set1_ps( kC2 ) ) );
+			cp = _mm_add_ps( _mm_set1_ps( kC0 ), _mm_mul_ps( r2, cp ) );
+			__m128 const cr = _mm_add_ps(
+				_mm_sub_ps( _mm_set1_ps( 1.f ), _mm_mul_ps( _mm_set1_ps( 0.5f ), r2 ) ),
+				_mm_mul_ps( _mm_mul_ps( r2, r2 ), cp )
+			);
+
+			// Odd quadrants swap sin and cos; bit 1 of q (or q+1) flips signs
+			__m128 const swap = _mm_castsi128_ps( _mm_cmpeq_epi32( _mm_and_si128( q, one ), one ) );
+			__m128 const c = _mm_or_ps( _mm_and_ps( swap, sr ), _mm_andnot_ps( swap, cr ) );
+			__m128 const s = _mm_or_ps( _mm_and_ps( swap, cr ), _mm_andnot_ps( swap, sr ) );
+
+			__m128 const cneg = _mm_castsi128_ps( _mm_slli_epi32( _mm_and_si128( _mm_add_epi32( q, one ), two ), 30 ) );
+			__m128 const sneg = _mm_castsi128_ps( _mm_slli_epi32( _mm_and_si128( q, two ), 30 ) );
+
+			_mm_storeu_ps( aCos+i, _mm_xor_ps( c, cneg ) );
+			_mm_storeu_ps( aSin+i, _mm_xor_ps( s, sneg ) );
+		}
+#		endif // ~ ASTEROID_FIELD_SSE2_
+
+		for( ; i < aCount; ++i )
+		{
+			float const x = aAngles[i];
+
+			auto const q = std::int32_t(std::nearbyint( x * kTwoOverPi ));
+			float const qf = float(q);
+			float const r = ((x - qf*kHalfPi0) - qf*kHalfPi1) - qf*kHalfPi2;
+			float const r2 = r*r;
+
+			float const sr = r + r*r2 * (kS0 + r2 * (kS1 + r2 * kS2));
+			float const cr = 1.f - 0.5f*r2 + r2*r2 * (kC0 + r2 * (kC1 + r2 * kC2));
+
+			bool const swap = 0 != (q & 1);
+			float const c = swap ? sr : cr;
+			float const s = swap ? cr : sr;
+
+			aCos[i] = ((q+1) & 2) ? -c : c;
+			aSin[i] = (q & 2) ? -s : s;
+		}
+	}
+
+	bool polygon_overlaps_fan_( std::size_t aPolyCount, Vec2f const* aPoly, Vec2f const& aCenter, std::size_t aFanCount, Vec2f const* aFan ) noexcept
+	{
+		assert( aPolyCount > 0 && aFanCount > 0 );
+
+		// Edges can only cross inside of the intersection of the two bounding
+		// boxes. Usually, only a few edges of either shape reach into it.
+		Vec2f polyMin, polyMax, fanMin, fanMax;
+		bounding_box_( aPolyCount, aPoly, polyMin, polyMax );
+		bounding_box_( aFanCount, aFan, fanMin, fanMax );
+
+		Vec2f const boxMin{ std::max( polyMin.x, fanMin.x ), std::max( polyMin.y, fanMin.y ) };
+		Vec2f const boxMax{ std::min( polyMax.x, fanMax.x ), std::min( polyMax.y, fanMax.y ) };
+
+		if( boxMin.x > boxMax.x || boxMin.y > boxMax.y )
+			return false;
+
+		for( std::size_t i = 0; i < aPolyCount; ++i )
+		{
+			auto const p0 = aPoly[i];
+			auto const p1 = aPoly[i+1 < aPolyCount ? i+1 : 0];
+
+			if( !segment_touches_box_( p0, p1, boxMin, boxMax ) )
+				continue;
+
+			for( std::size_t j = 0; j < aFanCount; ++j )
+			{
+				auto const q0 = aFan[j];
+				auto const q1 = aFan[j+1 < aFanCount ? j+1 : 0];
+
+				if( !segment_touches_box_( q0, q1, boxMin, boxMax ) )
+					continue;
+
+				if( segments_cross_( p0, p1, q0, q1 ) )
+					return true;
+			}
+		}
+
+		// No crossings: check for containment either way
+		return point_in_fan_( aPoly[0], aCenter, aFanCount, aFan )
+			|| point_in_polygon_( aFan[0], aPolyCount, aPoly )
+		;
+	}
+
+	void bounding_box_( std::size_t aCount, Vec2f const* aPoints, Vec2f& aMin, Vec2f& aMax ) noexcept
+	{
+		aMin = aMax = aPoints[0];
+		for( std::size_t i = 1; i < aCount; ++i )
+		{
+			aMin.x = std::min( aMin.x, aPoints[i].x );
+			aMin.y = std::min( aMin.y, aPoints[i].y );
+			aMax.x = std::max( aMax.x, aPoints[i].x );
+			aMax.y = std::max( aMax.y, aPoints[i].y );
+		}
+	}
+
+	bool segment_touches_box_( Vec2f aP0, Vec2f aP1, Vec2f aMin, Vec2f aMax ) noexcept
+	{
+		// Conservative; tests the segment's bounding box.
+		return std::max( aP0.x, aP1.x ) >= aMin.x && std::min( aP0.x, aP1.x ) <= aMax.x
+			&& std::max( aP0.y, aP1.y ) >= aMin.y && std::min( aP0.y, aP1.y ) <= aMax.y
+		;
+	}
+
+	float inner_radius_( std::size_t aCount, Vec2f const* aOutline ) noexcept
+	{
+		float inner = 0.f;
+		for( std::size_t i = 0; i < aCount; ++i )
+		{
+			auto const a = aOutline[i];
+			auto const b = aOutline[i+1 < aCount ? i+1 : 0];
+
+			// Closest point on the edge
+			auto const ab = b - a;
+			auto const len2 = dot( ab, ab );
+			auto const t = len2 > 0.f ? std::clamp( -dot( a, ab ) / len2, 0.f, 1.f ) : 0.f;
+			auto const dist = length( a + t*ab );
+
+			inner = 0 == i ? dist : std::min( inner, dist );
+		}
+
+		return inner;
+	}
+
+	bool segments_cross_( Vec2f aP0, Vec2f aP1, Vec2f aQ0, Vec2f aQ1 ) noexcept
+	{
+		// Each segment's end points must be on different sides of the other
+		// segment.
+		auto const dp = aP1 - aP0;
+		auto const dq = aQ1 - aQ0;
+
+		auto const q0 = cross_( dp, aQ0 - aP0 ), q1 = cross_( dp, aQ1 - aP0 );
+		if( (q0 > 0.f) == (q1 > 0.f) )
+			return false;
+
+		auto const p0 = cross_( dq, aP0 - aQ0 ), p1 = cross_( dq, aP1 - aQ0 );
+		return (p0 > 0.f) != (p1 > 0.f);
+	}
+
+	bool point_in_fan_( Vec2f aPoint, Vec2f aCenter, std::size_t aFanCount, Vec2f const* aFan ) noexcept
+	{
+		// Test each of the fan's triangles (center, j, j+1). The fan may be
+		// wound either way.
+		for( std::size_t j = 0; j < aFanCount; ++j )
+		{
+			auto const a = aFan[j];
+			auto const b = aFan[j+1 < aFanCount ? j+1 : 0];
+
+			auto const e0 = cross_( a - aCenter, aPoint - aCenter );
+			auto const e1 = cross_( b - a, aPoint - a );
+			auto const e2 = cross_( aCenter - b, aPoint - b );
+
+			if( (e0 >= 0.f && e1 >= 0.f && e2 >= 0.f) || (e0 <= 0.f && e1 <= 0.f && e2 <= 0.f) )
+				return true;
+		}
+
+		return false;
+	}
+
+	bool point_in_polygon_( Vec2f aPoint, std::size_t aPolyCount, Vec2f const* aPoly ) noexcept
+	{
+		// Even-odd rule: count the edges crossing a ray towards +x.
+		bool inside = false;
+		for( std::size_t i = 0, j = aPolyCount-1; i < aPolyCount; j = i++ )
+		{
+			auto const a = aPoly[i], b = aPoly[j];
+			if( (a.y > aPoint.y) != (b.y > aPoint.y) )
+			{
+				auto const x = a.x + (aPoint.y - a.y) * (b.x - a.x) / (b.y - a.y);
+				if( aPoint.x < x )
+					inside = !inside;
+			}
+		}
+
+		return inside;
+	}
+
+	float cross_( Vec2f aA, Vec2f aB ) noexcept
+	{
+		return aA.x*aB.y - aA.y*aB.x;
+	}
+}
@@ -3,14 +3,17 @@
 
 #include <vector>
 
+#include <cstdint>
 #include <cstdlib>
 
 #include "../draw2d/forward.hpp"
+#include "../draw2d/instances.hpp"
 
 #include "../vmlib/vec2.hpp"
 #include "../vmlib/mat22.hpp"
 
 #include "defaults.hpp"
+#include "collision_grid.hpp"
 
 /** Asteroid field
  *
@@ -23,11 +26,55 @@
  * a asteroid exits the screen, the player turns around immediately, the same
  * asteroid still exists).
  *
- * With the current implementation, the asteroid field is a purely visual
- * effect.
+ * Each update finds the pairs of colliding asteroids (see contacts()). They
+ * only bounce off each other if enabled with set_bounce(). Each update sorts
+ * the asteroids into a uniform grid (CollisionGrid), which limits the
+ * bounding circle tests to neighbouring asteroids. Pairs whose bounding
+ * circles overlap are then optionally tested exactly, against the triangles
+ * of their fans. The same grid is used to test other shapes, such as the
+ * player's ship, against the asteroids (see hit_test()).
+ *
+ * snapshot() copies what is needed to draw the asteroids. Drawing from
+ * snapshots only reads the shared shapes, which never change after
+ * construction. This allows the field to be updated on a different thread
+ * than the one that draws it (see Simulation).
+ *
+ * Asteroids do not own their shapes. The field generates kPrototypeCount
+ * shapes up front; each asteroid refers to one of them, and draws it with its
+ * own rotation and scale. Respawning an asteroid thus only picks a new index
+ * and scale, and does not allocate.
+ *
+ * Drawing collects the asteroids per prototype. Drawing to a Surface draws
+ * each prototype's asteroids with one draw_instances() call; drawing to a
+ * CommandBuffer records them as consecutive fans, which the buffer replays
+ * with draw_instances() as well. Asteroids are thus drawn grouped by
+ * prototype rather than in index order (they only overlap briefly, while
+ * colliding). The per-prototype lists are scratch space in the field, so a
+ * field must be drawn by one thread at a time.
  */
 class AsteroidField
 {
+	public:
+		// Pair of asteroid indices, with a < b
+		using Contact = CollisionGrid::Pair;
+
+		// Snapshot of a single asteroid. The id changes when an asteroid is
+		// replaced by a new one.
+		struct Pose
+		{
+			Vec2f pos;
+			Vec2f rot;
+			float scale;
+			std::uint32_t prototype;
+			std::uint32_t id;
+		};
+
+		enum class EBroadPhase
+		{
+			grid,
+			allPairs // Reference; tests each pair of asteroids.
+		};
+
 	public:
 		AsteroidField(
 			RNG&,
@@ -50,30 +97,152 @@ class AsteroidField
 
 		void draw( Surface& ) const;
 
+		void snapshot( std::vector<Pose>& ) const;
+
+		// Draw from snapshots, interpolated between aPrevious (aAlpha = 0)
+		// and aCurrent (aAlpha = 1).
+		void draw( Surface&, std::vector<Pose> const& aPrevious, std::vector<Pose> const& aCurrent, float aAlpha ) const;
+
+		// Record the asteroids instead of drawing them. Each asteroid is
+		// recorded with its bounding circle, so that the buffer can be binned
+		// into tiles (see CommandBuffer::bin()). Asteroids of the same
+		// prototype are recorded back to back, so that they replay with
+		// draw_instances().
+		void draw( CommandBuffer& ) const;
+		void draw( CommandBuffer&, std::vector<Pose> const& aPrevious, std::vector<Pose> const& aCurrent, float aAlpha ) const;
+
 		void resize( std::uint32_t aWidth, std::uint32_t aHeight );
 
+	public:
+		// Find the pairs of overlapping asteroids. update() does this each
+		// frame; it is public for testing and benchmarking. The results are
+		// the same for either method, but not necessarily in the same order.
+		void find_contacts( std::vector<Contact>&, EBroadPhase = EBroadPhase::grid );
+
+		// Pairs of overlapping asteroids, as found by the last update().
+		std::vector<Contact> const& contacts() const noexcept;
+
+		// Test a closed polygon (e.g., the ship) against the asteroids. The
+		// points are transformed by aTransform and then moved to aPosition,
+		// like LineStrip::draw() does.
+		bool hit_test(
+			std::size_t aCount, Vec2f const* aPoints,
+			Mat22f const& aTransform, Vec2f const& aPosition
+		);
+
+		// Exact tests against the asteroids' triangles (default), or bounding
+		// circles only.
+		void set_exact_collisions( bool ) noexcept;
+		bool exact_collisions() const noexcept;
+
+		// Collision response: overlapping asteroids bounce off each other
+		// elastically. Off by default, where contacts are only reported.
+		void set_bounce( bool ) noexcept;
+		bool bounce() const noexcept;
+
 	private:
 		struct Asteroid_
 		{
 			Vec2f pos;
 			Vec2f vel;
 			
-			Mat22f rot;
+			// Rotation as a unit complex number (cos, sin). rotstep is the
+			// rotation per update, i.e., by radpersec * mStepElapsed.
+			Vec2f rot;
+			Vec2f rotstep;
 			float radpersec;
+
+			std::uint32_t prototype; // index into mPrototypes
+			float scale;
+
+			std::uint32_t id;
+		};
+
+		// Outline of a prototype, in mOutlinePoints[first .. first+count)
+		struct Outline_
+		{
+			std::uint32_t first, count;
+			float radius; // bounding circle around the origin
+			float inner; // largest circle around the origin inside the outline
 		};
 
+	private:
+		void update_rotation_steps_( float aElapsed );
+
+		template< class tTarget >
+		void draw_( tTarget& ) const;
+		template< class tTarget >
+		void draw_( tTarget&, std::vector<Pose> const&, std::vector<Pose> const&, float ) const;
+
+		void draw_shape_( Surface&, std::uint32_t aPrototype, float aScale, Vec2f aRot, Vec2f aPos ) const;
+		void draw_shape_( CommandBuffer&, std::uint32_t aPrototype, float aScale, Vec2f aRot, Vec2f aPos ) const;
+
+		// Draw what draw_shape_() collected
+		void flush_( Surface& ) const;
+		void flush_( CommandBuffer& ) const;
+
+		void update_circles_();
+		void rebuild_grid_();
+		bool exact_overlap_( std::uint32_t aA, std::uint32_t aB );
+		void world_outline_( std::uint32_t aAsteroid, std::vector<Vec2f>& ) const;
+
+		void bounce_( Asteroid_&, Asteroid_& ) const noexcept;
+
 	private:
 		Vec2f mBoundsMin, mBoundsMax;
 		Vec2f mExactExtent, mActualExtent;
 		
 		std::vector<Asteroid_> mAsteroids;
-		std::vector<TriangleFan> mShapes;
+		std::vector<TriangleFan> mPrototypes;
+
+		std::vector<Outline_> mOutlines; // one per prototype
+		std::vector<Vec2f> mOutlinePoints;
 
 		float mInitialSpeed, mMaximumSpeed;
 		float mInitialRot;
 		float mPadding, mDensity;
 
-		RNG& mRNG;
+		// Time step that the rotation steps were computed for; negative if
+		// they need to be recomputed.
+		float mStepElapsed;
+		unsigned mUpdatesSinceNormalize;
+
+		// Scratch space for update_rotation_steps_()
+		std::vector<float> mAngles, mCos, mSin;
+
+		// Collisions. The grid is rebuilt whenever the asteroids move.
+		bool mExactCollisions;
+		bool mBounce;
+		CollisionGrid mGrid;
+
+		// Scratch space for the collision tests
+		std::vector<Vec2f> mCenters;
+		std::vector<float> mRadii;
+		std::vector<Contact> mContacts;
+		std::vector<std::uint32_t> mHits;
+		std::vector<Vec2f> mWorldA, mWorldB;
+
+		// Scratch space for draw(), one list per prototype
+		mutable std::vector<std::vector<ShapeInstance>> mInstances;
+		mutable std::vector<std::vector<float>> mInstanceScales; // CommandBuffer only
+
+		std::uint32_t mNextId;
+
+		// Forked from the generator passed to the constructor
+		RNG mRNG;
+
+	public: // Configuration values
+		static constexpr std::size_t kPrototypeCount = 32;
+
+		// Per-asteroid scale, relative to the prototype. make_asteroid()
+		// already varies the radius of each prototype; this adds variation
+		// on top of it.
+		static constexpr float kScaleStddev = 0.15f;
+		static constexpr float kMinScale = 0.6f;
+		static constexpr float kMaxScale = 1.4f;
+
+		// Number of updates between renormalizing the rotations
+		static constexpr unsigned kNormalizeInterval = 64;
 };
 
 #endif // ASTEROID_FIELD_HPP_7D5A0B40_4466_4CAC_B7CC_85E8DC927E08
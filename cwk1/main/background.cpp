@@ -1,8 +1,16 @@
 #include "background.hpp"
 
+#include <utility>
+#include <iterator>
+
+#include <cmath>
+
 #include "../draw2d/image.hpp"
+#include "../draw2d/mipmap.hpp"
+
+#include "../support/task_pool.hpp"
 
-Background::Background( RNG& aRNG, std::uint32_t aImageWidth, std::uint32_t aImageHeight )
+Background::Background( RNG& aRNG, std::uint32_t aImageWidth, std::uint32_t aImageHeight, std::unique_ptr<ImageRGBA> aEarthImage, unsigned aSpriteScaleShift, bool aScrolledLayers )
 	: mFarField{
 		{ aRNG, aImageWidth, aImageHeight, kFarColors[0], kFarDensities[0], kFarSpeedMults[0] },
 		{ aRNG, aImageWidth, aImageHeight, kFarColors[1], kFarDensities[1], kFarSpeedMults[1] },
@@ -10,19 +18,37 @@ Background::Background( RNG& aRNG, std::uint32_t aImageWidth, std::uint32_t aIma
 	}
 	, mNearField{ aRNG, aImageWidth, aImageHeight, kNearColor, kNearDensity, kNearSpeedMult }
 {
-	mEarthSprite = load_image( kEarthPath );
+	// Only generate the mip levels that we are going to use.
+	mEarthSprite = std::make_unique<MipChainRGBA>( std::move(aEarthImage), aSpriteScaleShift+1 );
+	mSpriteScale = std::ldexp( 1.f, -int(aSpriteScaleShift) );
+
+	for( auto& pf : mFarField )
+		pf.set_layer_scroll( aScrolledLayers );
+
 	mCurrentPosition = Vec2f{ 0.f, 0.f };
 }
 
 Background::~Background() = default;
 
-void Background::update( Vec2f aPosition, Vec2f aMovementDelta )
+void Background::update( Vec2f aPosition, Vec2f aMovementDelta, TaskPool* aPool )
 {
-	// Update particle fields
-	for( auto& pf : mFarField )
-		pf.update( aMovementDelta );
+	// Update particle fields. Each field has its own generator, so they are
+	// independent of each other.
+	ParticleField* const fields[] = { &mFarField[0], &mFarField[1], &mFarField[2], &mNearField };
+	static_assert( 3 == kFarLayers );
 
-	mNearField.update( aMovementDelta );
+	if( aPool )
+	{
+		aPool->parallel_for( "particles.update", 0, std::size(fields), 1, [&] (std::size_t aBegin, std::size_t aEnd) {
+			for( auto i = aBegin; i < aEnd; ++i )
+				fields[i]->update( aMovementDelta );
+		} );
+	}
+	else
+	{
+		for( auto* pf : fields )
+			pf->update( aMovementDelta );
+	}
 
 	// Store current position
 	mCurrentPosition = aPosition;
@@ -35,7 +61,7 @@ void Background::draw( Surface& aSurface )
 		pf.draw( aSurface );
 
 	// Draw earth sprite
-	blit_masked( aSurface, *mEarthSprite, kEarthCoord - mCurrentPosition );
+	blit_masked_scaled( aSurface, *mEarthSprite, mSpriteScale * (kEarthCoord - mCurrentPosition), mSpriteScale );
 
 	// Draw near field = dirt layer
 	mNearField.draw( aSurface );
@@ -11,14 +11,28 @@
 #include "defaults.hpp"
 #include "particle_field.hpp"
 
+class TaskPool;
+
 class Background final
 {
 	public:
-		Background( RNG&, std::uint32_t aImageWidth, std::uint32_t aImageHeight );
+		// aEarthImage is the image loaded from kEarthPath. It is passed in,
+		// rather than loaded here, so that it can be loaded asynchronously
+		// (see ImageLoader) while the rest of the program is set up.
+		//
+		// aSpriteScaleShift scales sprites by 2^-shift. This is intended to
+		// match the --fbshift option, such that sprites keep their on-screen
+		// size when the framebuffer is reduced. Downscaled sprites are drawn
+		// from a mip level of matching size.
+		//
+		// aScrolledLayers scrolls the far fields, see
+		// ParticleField::set_layer_scroll().
+		Background( RNG&, std::uint32_t aImageWidth, std::uint32_t aImageHeight, std::unique_ptr<ImageRGBA> aEarthImage, unsigned aSpriteScaleShift = 0, bool aScrolledLayers = false );
 		~Background();
 
 	public:
-		void update( Vec2f aPosition, Vec2f aMovementDelta );
+		// With a pool, the particle fields are updated in parallel.
+		void update( Vec2f aPosition, Vec2f aMovementDelta, TaskPool* = nullptr );
 
 		void draw( Surface& );
 
@@ -28,7 +42,8 @@ class Background final
 		ParticleField mFarField[3];
 		ParticleField mNearField;
 		
-		std::unique_ptr<ImageRGBA> mEarthSprite;
+		std::unique_ptr<MipChainRGBA> mEarthSprite;
+		float mSpriteScale;
 
 		Vec2f mCurrentPosition;
  
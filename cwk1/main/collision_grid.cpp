@@ -0,0 +1,184 @@
+#include "collision_grid.hpp"
+
+#include <algorithm>
+
+#include <cmath>
+#include <cassert>
+
+namespace
+{
+	// Strict test; touching circles do not overlap.
+	bool circles_overlap_( Vec2f const& aCA, float aRA, Vec2f const& aCB, float aRB ) noexcept;
+}
+
+CollisionGrid::CollisionGrid() noexcept
+	: mMin{ 0.f, 0.f }
+	, mCellSize( 1.f )
+	, mInvCellSize( 1.f )
+	, mMaxRadius( 0.f )
+	, mCellsX( 1 )
+	, mCellsY( 1 )
+	, mCellStart{ 0, 0 }
+{}
+
+void CollisionGrid::build( std::size_t aCount, Vec2f const* aCenters, float const* aRadii, Vec2f const& aMin, Vec2f const& aMax )
+{
+	assert( aCount < std::size_t(~std::uint32_t(0)) );
+
+	mMaxRadius = 0.f;
+	for( std::size_t i = 0; i < aCount; ++i )
+		mMaxRadius = std::max( mMaxRadius, aRadii[i] );
+
+	// Cells must be at least as large as the largest possible sum of two
+	// radii.
+	auto const extent = aMax - aMin;
+	auto const maxExtent = std::max( std::max( extent.x, extent.y ), 1.f );
+
+	mMin = aMin;
+	mCellSize = std::max( 2.f*mMaxRadius, maxExtent / kMaxCellsPerAxis );
+	mInvCellSize = 1.f / mCellSize;
+
+	mCellsX = std::clamp( std::uint32_t(std::ceil( extent.x * mInvCellSize )), 1u, kMaxCellsPerAxis );
+	mCellsY = std::clamp( std::uint32_t(std::ceil( extent.y * mInvCellSize )), 1u, kMaxCellsPerAxis );
+
+	auto const cellCount = std::size_t(mCellsX) * mCellsY;
+
+	// The cell count changes with the largest radius. Grow the cells
+	// geometrically, so that this does not allocate each time it goes up.
+	if( cellCount+1 > mCellStart.capacity() )
+		mCellStart.reserve( std::max( cellCount+1, 2*mCellStart.capacity() ) );
+
+	// Counting sort. First count the entries per cell ...
+	mCellOf.resize( aCount );
+	mCellStart.assign( cellCount+1, 0 );
+
+	for( std::size_t i = 0; i < aCount; ++i )
+	{
+		auto const cell = cell_y_( aCenters[i].y ) * mCellsX + cell_x_( aCenters[i].x );
+		mCellOf[i] = cell;
+		++mCellStart[cell];
+	}
+
+	// ... then compute where each cell ends ...
+	for( std::size_t c = 1; c <= cellCount; ++c )
+		mCellStart[c] += mCellStart[c-1];
+
+	// ... and place the entries back to front. Each cell's end moves to its
+	// start, and the entries keep their relative order.
+	mEntries.resize( aCount );
+	for( std::size_t i = aCount; i-- > 0; )
+	{
+		auto const slot = --mCellStart[mCellOf[i]];
+		mEntries[slot] = Entry_{ aCenters[i], aRadii[i], std::uint32_t(i) };
+	}
+
+	assert( mCellStart[cellCount] == aCount );
+}
+
+void CollisionGrid::find_overlaps( std::vector<Pair>& aPairs ) const
+{
+	// Each pair of neighbouring cells is visited once: every cell is matched
+	// with itself and with the four neighbours that follow it (right, and the
+	// three below).
+	for( std::uint32_t cy = 0; cy < mCellsY; ++cy )
+	{
+		for( std::uint32_t cx = 0; cx < mCellsX; ++cx )
+		{
+			auto const cell = cy * mCellsX + cx;
+			if( mCellStart[cell] == mCellStart[cell+1] )
+				continue;
+
+			overlaps_between_( cell, cell, aPairs );
+
+			if( cx+1 < mCellsX )
+				overlaps_between_( cell, cell+1, aPairs );
+
+			if( cy+1 < mCellsY )
+			{
+				auto const below = cell + mCellsX;
+
+				if( cx > 0 )
+					overlaps_between_( cell, below-1, aPairs );
+
+				overlaps_between_( cell, below, aPairs );
+
+				if( cx+1 < mCellsX )
+					overlaps_between_( cell, below+1, aPairs );
+			}
+		}
+	}
+}
+
+void CollisionGrid::find_overlaps( Vec2f const& aCenter, float aRadius, std::vector<std::uint32_t>& aIndices ) const
+{
+	// Entries are sorted by their centers; overlapping ones are at most
+	// aRadius + mMaxRadius away.
+	auto const reach = aRadius + mMaxRadius;
+
+	auto const x0 = cell_x_( aCenter.x - reach ), x1 = cell_x_( aCenter.x + reach );
+	auto const y0 = cell_y_( aCenter.y - reach ), y1 = cell_y_( aCenter.y + reach );
+
+	for( auto cy = y0; cy <= y1; ++cy )
+	{
+		// Cells of a row are contiguous
+		auto const begin = mCellStart[cy * mCellsX + x0];
+		auto const end = mCellStart[cy * mCellsX + x1 + 1];
+
+		for( auto i = begin; i < end; ++i )
+		{
+			auto const& entry = mEntries[i];
+			if( circles_overlap_( aCenter, aRadius, entry.center, entry.radius ) )
+				aIndices.emplace_back( entry.index );
+		}
+	}
+}
+
+std::size_t CollisionGrid::size() const noexcept
+{
+	return mEntries.size();
+}
+float CollisionGrid::cell_size() const noexcept
+{
+	return mCellSize;
+}
+
+std::uint32_t CollisionGrid::cell_x_( float aX ) const noexcept
+{
+	// Clamp as float first; this also deals with very large values.
+	auto const x = std::clamp( (aX - mMin.x) * mInvCellSize, 0.f, float(mCellsX-1) );
+	return std::uint32_t(x);
+}
+std::uint32_t CollisionGrid::cell_y_( float aY ) const noexcept
+{
+	auto const y = std::clamp( (aY - mMin.y) * mInvCellSize, 0.f, float(mCellsY-1) );
+	return std::uint32_t(y);
+}
+
+void CollisionGrid::overlaps_between_( std::uint32_t aCellA, std::uint32_t aCellB, std::vector<Pair>& aPairs ) const
+{
+	auto const beginA = mCellStart[aCellA], endA = mCellStart[aCellA+1];
+	auto const beginB = mCellStart[aCellB], endB = mCellStart[aCellB+1];
+
+	for( auto i = beginA; i < endA; ++i )
+	{
+		auto const& ea = mEntries[i];
+
+		// Within the same cell, only test each pair once
+		for( auto j = (aCellA == aCellB ? i+1 : beginB); j < endB; ++j )
+		{
+			auto const& eb = mEntries[j];
+			if( circles_overlap_( ea.center, ea.radius, eb.center, eb.radius ) )
+				aPairs.emplace_back( Pair{ std::min( ea.index, eb.index ), std::max( ea.index, eb.index ) } );
+		}
+	}
+}
+
+namespace
+{
+	bool circles_overlap_( Vec2f const& aCA, float aRA, Vec2f const& aCB, float aRB ) noexcept
+	{
+		auto const d = aCB - aCA;
+		auto const r = aRA + aRB;
+		return dot( d, d ) < r*r;
+	}
+}
@@ -0,0 +1,88 @@
+#ifndef COLLISION_GRID_HPP_4E8B2D16_A0C3_4F57_9B1E_6D3A72C85F04
+#define COLLISION_GRID_HPP_4E8B2D16_A0C3_4F57_9B1E_6D3A72C85F04
+
+#include <vector>
+
+#include <cstdint>
+#include <cstdlib>
+
+#include "../vmlib/vec2.hpp"
+
+/** Uniform grid over a set of circles
+ *
+ * The grid is rebuilt from scratch with build(), in linear time (counting
+ * sort by cell). The cell size is at least the largest diameter, so two
+ * overlapping circles are always in the same or in directly neighbouring
+ * cells. Circles whose centers lie outside of the grid's area are sorted into
+ * the nearest border cell; this does not affect the results.
+ *
+ * The grid only deals with bounding circles. More precise tests are up to the
+ * user (see AsteroidField).
+ */
+class CollisionGrid final
+{
+	public:
+		// Pair of circle indices, with a < b
+		struct Pair
+		{
+			std::uint32_t a, b;
+		};
+
+	public:
+		CollisionGrid() noexcept;
+
+	public:
+		void build(
+			std::size_t aCount,
+			Vec2f const* aCenters,
+			float const* aRadii,
+			Vec2f const& aMin, Vec2f const& aMax
+		);
+
+		// Find all pairs of overlapping circles. Results are appended to
+		// aPairs.
+		void find_overlaps( std::vector<Pair>& aPairs ) const;
+
+		// Find the circles overlapping the circle at aCenter with radius
+		// aRadius. Results are appended to aIndices.
+		void find_overlaps( Vec2f const& aCenter, float aRadius, std::vector<std::uint32_t>& aIndices ) const;
+
+	public:
+		std::size_t size() const noexcept;
+		float cell_size() const noexcept;
+
+	private:
+		struct Entry_
+		{
+			Vec2f center;
+			float radius;
+			std::uint32_t index;
+		};
+
+	private:
+		std::uint32_t cell_x_( float ) const noexcept;
+		std::uint32_t cell_y_( float ) const noexcept;
+
+		void overlaps_between_( std::uint32_t aCellA, std::uint32_t aCellB, std::vector<Pair>& ) const;
+
+	private:
+		Vec2f mMin;
+		float mCellSize, mInvCellSize;
+		float mMaxRadius;
+
+		std::uint32_t mCellsX, mCellsY;
+
+		// Entries of cell c are mEntries[mCellStart[c] .. mCellStart[c+1])
+		std::vector<std::uint32_t> mCellStart;
+		std::vector<Entry_> mEntries;
+
+		// Scratch space for build()
+		std::vector<std::uint32_t> mCellOf;
+
+	public: // Configuration values
+		// Upper limit for the number of cells along each axis. Cells are made
+		// larger if necessary, which only costs some extra circle tests.
+		static constexpr std::uint32_t kMaxCellsPerAxis = 1024;
+};
+
+#endif // COLLISION_GRID_HPP_4E8B2D16_A0C3_4F57_9B1E_6D3A72C85F04
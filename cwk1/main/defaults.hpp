@@ -4,12 +4,35 @@
 #include <chrono>
 #include <random>
 
-/* Select default random number generator
+#include "rng.hpp"
+
+/* Compile-time configuration:
+ * Select default random number generator. 
+ *
+ * COUNTER uses CounterRNG (see rng.hpp). It is fast, supports generating
+ * numbers in batches, and its results are reproducible per seed, independently
+ * of how the work is split between threads.
  *
- * We don't need very high quality random numbers in this case, so we can
- * opt for a fast (but fairly low quality) LCG-based generator.
+ * MINSTD uses std::minstd_rand, a fast (but fairly low quality) LCG-based
+ * generator, with the standard <random> distributions. It is inherently
+ * serial.
  */
+#define MAIN_CFG_RNG_COUNTER 1
+#define MAIN_CFG_RNG_MINSTD 2
+
+// The default is to use COUNTER. You can change the following to pick a
+// different generator.
+#if !defined(MAIN_CFG_RNG)
+#	define MAIN_CFG_RNG MAIN_CFG_RNG_COUNTER
+#endif
+
+#if MAIN_CFG_RNG == MAIN_CFG_RNG_COUNTER
+using RNG = CounterRNG;
+#elif MAIN_CFG_RNG == MAIN_CFG_RNG_MINSTD
 using RNG = std::minstd_rand;
+#else
+#	error "Unknown MAIN_CFG_RNG"
+#endif // ~ MAIN_CFG_RNG
 
 /* Select default clock
  *
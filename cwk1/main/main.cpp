@@ -1,7 +1,10 @@
 #include <glad.h>
 #include <GLFW/glfw3.h>
 
+#include <memory>
 #include <random>
+#include <utility>
+#include <algorithm>
 #include <typeinfo>
 #include <stdexcept>
 
@@ -11,10 +14,17 @@
 #include "../draw2d/surface.hpp"
 #include "../draw2d/draw.hpp"
 #include "../draw2d/shape.hpp"
+#include "../draw2d/image.hpp"
+#include "../draw2d/image_loader.hpp"
+#include "../draw2d/command_buffer.hpp"
 
 #include "../support/error.hpp"
 #include "../support/context.hpp"
 #include "../support/runconfig.hpp"
+#include "../support/profiler.hpp"
+#include "../support/task_pool.hpp"
+#include "../support/frame_arena.hpp"
+#include "../support/alloc_counter.hpp"
 
 #include "../vmlib/vec2.hpp"
 #include "../vmlib/mat22.hpp"
@@ -23,12 +33,27 @@
 #include "state.hpp"
 #include "spaceship.hpp"
 #include "background.hpp"
+#include "simulation.hpp"
+#include "stats_overlay.hpp"
 #include "asteroid_field.hpp"
 
 namespace
 {
 	constexpr char const* kWindowTitle = "COMP3811-Coursework 1";
 
+	// Asteroids are recorded, and then replayed in screen tiles, in parallel.
+	// Each task replays a few tiles; more tasks than threads even out the
+	// load a bit.
+	constexpr std::size_t kDrawTasksPerThread = 4;
+
+	// Interval for printing timings (--profile)
+	constexpr float kProfileIntervalSeconds = 5.f;
+
+	// Frames after start-up or a resize that may allocate. Later frames
+	// should not (checked in debug builds, see alloc_counter.hpp).
+	constexpr std::uint64_t kWarmUpFrames = 60;
+	constexpr std::uint64_t kMaxAllocationWarnings = 10;
+
 	void glfw_callback_error_( int, char const* );
 
 	void glfw_callback_key_( GLFWwindow*, int, int, int, int );
@@ -51,6 +76,12 @@ int main( int aArgc, char* aArgv[] ) try
 	// Parse command line arguments
 	RuntimeConfig const config = parse_command_line( aArgc, aArgv );
 
+	// Start loading assets. These are decoded in the background while the
+	// window and OpenGL context are set up. There is a single image, so the
+	// loader only needs one thread; it is destroyed once the image arrives.
+	auto loader = std::make_unique<ImageLoader>( 1 );
+	auto earthImage = loader->load( Background::kEarthPath );
+
 	// Initialize GLFW
 	if( GLFW_TRUE != glfwInit() )
 	{
@@ -151,13 +182,84 @@ int main( int aArgc, char* aArgv[] ) try
 
 	glViewport( 0, 0, iwidth, iheight );
 
+	// Threads for the work in each frame
+	Profiler profiler;
+	Profiler* const prof = config.profile ? &profiler : nullptr;
+
+	TaskPool pool( config.threads, prof );
+
 	// Resources
 	RNG rng( std::random_device{}() );
 
-	Background background( rng, fbwidth, fbheight );
+	auto earth = earthImage.get();
+	loader.reset();
+
+	Background background( rng, fbwidth, fbheight, std::move(earth), config.framebufferScaleShift, config.scrolledLayers );
 	AsteroidField asteroids( rng, fbwidth, fbheight );
 
 	auto const spaceship = make_spaceship_shape();
+	auto const spaceshipOutline = make_spaceship_outline();
+
+	// Fixed time step simulation on a separate thread. Without it, the
+	// simulation is updated once per frame in the main loop.
+	std::unique_ptr<Simulation> simulation;
+	if( config.simulationRate > 0 )
+		simulation = std::make_unique<Simulation>( asteroids, fbwidth, fbheight, spaceshipOutline, config.simulationRate );
+
+	Simulation::Snapshot previous, current;
+	Vec2f lastPosition{ 0.f, 0.f };
+
+	// Updates without the simulation thread. The background and asteroids
+	// are independent of each other; the ship's collisions need the updated
+	// asteroids. The graph is set up once, and reads its inputs from frame.
+	struct FrameInputs_
+	{
+		float dt = 0.f;
+		Vec2f position{ 0.f, 0.f }, movement{ 0.f, 0.f };
+		Mat22f rot{};
+		Vec2f offs{ 0.f, 0.f };
+		bool hit = false;
+	} frame;
+
+	TaskGraph updateGraph;
+	{
+		updateGraph.add( "background.update", [&] {
+			background.update( frame.position, frame.movement, &pool );
+		} );
+
+		auto const updateAsteroids = updateGraph.add( "asteroids.update", [&] {
+			asteroids.update( frame.dt, frame.movement );
+		} );
+		updateGraph.add( "ship.hit_test", [&] {
+			frame.hit = asteroids.hit_test( spaceshipOutline.size(), spaceshipOutline.data(), frame.rot, frame.offs );
+		}, { updateAsteroids } );
+	}
+
+	// Scratch memory for the current frame
+	FrameArena frameArena;
+
+	// Draw commands. The asteroids are recorded each frame, into the frame
+	// arena. The ship never changes, so it is recorded once (in either
+	// color), and replayed with the current transform.
+	Mat22f const identity{
+		1.f, 0.f,
+		0.f, 1.f
+	};
+
+	CommandBuffer shipCommands[2];
+	shipCommands[0].strip( spaceship, ColorF{ 0.2f, 0.4f, 0.7f }, identity, Vec2f{ 0.f, 0.f } );
+	shipCommands[1].strip( spaceship, ColorF{ 0.9f, 0.2f, 0.1f }, identity, Vec2f{ 0.f, 0.f } );
+
+	// On-screen statistics (--stats)
+	std::unique_ptr<StatsOverlay> stats;
+	if( config.stats )
+		stats = std::make_unique<StatsOverlay>( fbwidth, fbheight );
+
+	std::uint64_t profiledFrames = 0;
+	auto profileStart = Clock::now();
+
+	std::uint64_t steadyFrames = 0;
+	std::uint64_t allocationWarnings = 0;
 
 
 	// Main loop
@@ -165,6 +267,9 @@ int main( int aArgc, char* aArgv[] ) try
 
 	while( !glfwWindowShouldClose( window ) )
 	{
+		auto const allocationsBefore = allocation_count();
+		frameArena.reset();
+
 		// Let GLFW process events
 		glfwPollEvents();
 		
@@ -201,11 +306,19 @@ int main( int aArgc, char* aArgv[] ) try
 				fbheight = std::uint32_t(iheight / hs) >> config.framebufferScaleShift;
 
 				// Resize things
+				steadyFrames = 0;
+
 				context.resize( fbwidth, fbheight );
 
 				surface = Surface( fbwidth, fbheight );
 				background.resize( fbwidth, fbheight );
-				asteroids.resize( fbwidth, fbheight );
+				if( simulation )
+					simulation->resize( fbwidth, fbheight );
+				else
+					asteroids.resize( fbwidth, fbheight );
+
+				if( stats )
+					stats->resize( fbwidth, fbheight );
 			}
 		}
 
@@ -214,26 +327,127 @@ int main( int aArgc, char* aArgv[] ) try
 		auto const dt = std::chrono::duration_cast<Secondsf>(now - lastUpdateTime).count();
 		lastUpdateTime = now;
 
-		state_update( state, dt );
+		auto const rot = make_rotation_2d( state.player.angle );
+		auto const offs = Vec2f{ fbwidth*0.5f, fbheight*0.5f };
+
+		float alpha = 1.f;
+		bool hit = false; // The ship turns red while it touches an asteroid.
+
+		if( simulation )
+		{
+			simulation->set_controls( state.player.angle, state.player.accelerationMagnitude );
+			alpha = simulation->acquire( previous, current, now );
+
+			// The background only depends on the player's movement. It is
+			// updated per frame, from the interpolated position.
+			auto const position = previous.playerPosition + alpha * (current.playerPosition - previous.playerPosition);
+			{
+				ProfileScope scope( prof, "background.update" );
+				background.update( position, position - lastPosition, &pool );
+			}
+			lastPosition = position;
+
+			hit = current.shipHit;
+		}
+		else
+		{
+			state_update( state, dt );
 
-		background.update( state.player.position, state.thisFrame.movement );
-		asteroids.update( state.thisFrame.dt, state.thisFrame.movement );
+			frame.dt = state.thisFrame.dt;
+			frame.position = state.player.position;
+			frame.movement = state.thisFrame.movement;
+			frame.rot = rot;
+			frame.offs = offs;
+
+			updateGraph.run( pool );
+			hit = frame.hit;
+		}
 	
+		auto const updated = Clock::now();
+
 		// Draw scene
 		surface.clear();
 
-		background.draw( surface );
-		asteroids.draw( surface );
+		{
+			ProfileScope scope( prof, "background.draw" );
+			background.draw( surface );
+		}
+
+		CommandBuffer asteroidCommands( &frameArena );
+		{
+			ProfileScope scope( prof, "asteroids.record" );
+
+			if( simulation )
+				asteroids.draw( asteroidCommands, previous.asteroids, current.asteroids, alpha );
+			else
+				asteroids.draw( asteroidCommands );
+
+			asteroidCommands.bin( fbwidth, fbheight );
+		}
+
+		auto const tiles = asteroidCommands.tile_count();
+		auto const grain = std::max( std::size_t(1), tiles / (pool.thread_count() * kDrawTasksPerThread) );
+		pool.parallel_for( "asteroids.draw", 0, tiles, grain, [&] (std::size_t aBegin, std::size_t aEnd) {
+			for( auto tile = aBegin; tile < aEnd; ++tile )
+				asteroidCommands.replay_tile( surface, tile );
+		} );
+
 		surface.set_pixel_srgb(0, 0, {255, 255, 0});
 
-		auto const rot = make_rotation_2d( state.player.angle );
-		auto const offs = Vec2f{ fbwidth*0.5f, fbheight*0.5f };
-		spaceship.draw( surface, { 0.2f, 0.4f, 0.7f }, rot, offs );
+		shipCommands[hit ? 1 : 0].replay( surface, rot, offs );
+
+		auto const drawn = Clock::now();
+
+		if( stats )
+			stats->draw( surface );
+
+		auto const overlaid = Clock::now();
 
 		context.draw( surface );
 
 		// Display results
 		glfwSwapBuffers( window );
+
+		if( stats )
+		{
+			auto const presented = Clock::now();
+
+			stats->record( StatsOverlay::EStage::update, updated - now );
+			stats->record( StatsOverlay::EStage::draw, drawn - updated );
+			stats->record( StatsOverlay::EStage::overlay, overlaid - drawn );
+			stats->record( StatsOverlay::EStage::present, presented - overlaid );
+			stats->end_frame( presented );
+		}
+
+		// Heap allocations (debug builds only)
+		if constexpr( kAllocationCounting )
+		{
+			auto const allocations = allocation_count() - allocationsBefore;
+			if( allocations && steadyFrames >= kWarmUpFrames && allocationWarnings < kMaxAllocationWarnings )
+			{
+				std::fprintf( stderr, "Warning: %llu heap allocation(s) in a steady-state frame%s\n",
+					static_cast<unsigned long long>(allocations),
+					++allocationWarnings == kMaxAllocationWarnings ? " (further warnings are suppressed)" : ""
+				);
+			}
+		}
+
+		++steadyFrames;
+
+		// Timings
+		if( prof )
+		{
+			++profiledFrames;
+			if( now - profileStart >= std::chrono::duration_cast<Clock::duration>( Secondsf( kProfileIntervalSeconds ) ) )
+			{
+				std::printf( "Timings over %llu frames (%zu threads):\n", static_cast<unsigned long long>(profiledFrames), pool.thread_count() );
+				profiler.print( stdout, profiledFrames );
+
+				profiler.reset();
+				profiledFrames = 0;
+				profileStart = now;
+			}
+		}
 	}
 
 	// Cleanup.
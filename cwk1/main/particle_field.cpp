@@ -1,15 +1,75 @@
 #include "particle_field.hpp"
 
+#include <limits>
+#include <algorithm>
+
+#include <cmath>
+#include <cassert>
+
+#include "../draw2d/points.hpp"
 #include "../draw2d/surface.hpp"
 
-#include <cassert> 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#	define PARTICLE_FIELD_SSE2_ 1
+#	include <emmintrin.h>
+#endif
+
+namespace
+{
+	// Limits for the number of fractional bits in the fixed16 storage.
+	constexpr unsigned kMinFracBits = 2;
+	constexpr unsigned kMaxFracBits = 8;
+
+	// If more than one in this many particles respawn in a single update,
+	// all particles are sorted instead of moving the respawned ones into
+	// place individually.
+	constexpr std::size_t kFullSortRatio = 8;
+
+	// Fixed point representation of aExtent, see EParticleStorage. Returns
+	// false if the extent does not fit with at least kMinFracBits.
+	bool make_fixed_axis_( float aExtent, unsigned& aFracBits, std::uint16_t& aMaxValue ) noexcept;
 
-ParticleField::ParticleField( RNG& aRNG, std::uint32_t aImageWidth, std::uint32_t aImageHeight, ColorF const& aParticleColor, float aParticleDensity, float aParticleSpeedMult, float aPadding )
-	: mColor( linear_to_srgb( aParticleColor ) )
+	// Movement in fixed point units. The rounding error is accumulated in
+	// aCarry.
+	std::int32_t fixed_step_( float aDelta, float aScale, float& aCarry ) noexcept;
+
+	// Index of the aRank-th particle in Y order, see ParticleField::mFirst.
+	std::size_t ring_index_( std::size_t aRank, std::size_t aFirst, std::size_t aCount ) noexcept;
+
+	// Y coordinate stored relative to aScroll, see FixedAxis_::scroll. The
+	// order functions below compare these. Fixed point values wrap around;
+	// float positions are never scrolled.
+	float scrolled_y_( float aY, float aScroll ) noexcept;
+	float scrolled_y_( std::uint16_t aY, std::uint16_t aScroll ) noexcept;
+
+	// Move the aMovedCount particles listed in aMoved (ascending indices) to
+	// their place in the Y-sorted order of the others. aScratch must have
+	// room for aMovedCount elements. The ring must start at index zero.
+	template< typename tCoord >
+	void reinsert_sorted_( tCoord* aX, tCoord* aY, tCoord aScrollY, std::size_t aCount, std::uint32_t const* aMoved, std::size_t aMovedCount, Vec2f* aScratch ) noexcept;
+
+	// See ParticleField::merge_first_() and merge_last_(). aScratch must have
+	// room for aMovedCount elements.
+	template< typename tCoord >
+	void merge_first_sorted_( tCoord* aX, tCoord* aY, tCoord aScrollY, std::size_t aCount, std::size_t aFirst, std::size_t aMovedCount, Vec2f* aScratch ) noexcept;
+	template< typename tCoord >
+	void merge_last_sorted_( tCoord* aX, tCoord* aY, tCoord aScrollY, std::size_t aCount, std::size_t aFirst, std::size_t aMovedCount, Vec2f* aScratch ) noexcept;
+
+	// Sort all particles by Y. aScratch must have room for aCount elements.
+	template< typename tCoord >
+	void sort_coords_by_y_( tCoord* aX, tCoord* aY, tCoord aScrollY, std::size_t aCount, Vec2f* aScratch ) noexcept;
+}
+
+ParticleField::ParticleField( RNG& aRNG, std::uint32_t aImageWidth, std::uint32_t aImageHeight, ColorF const& aParticleColor, float aParticleDensity, float aParticleSpeedMult, float aPadding, EParticleStorage aStorage )
+	: mFirst( 0 )
+	, mRequestedStorage( aStorage )
+	, mStorage( EParticleStorage::float32 )
+	, mLayerScroll( false )
+	, mColor( linear_to_srgb( aParticleColor ) )
 	, mParticleSpeedMult( aParticleSpeedMult )
 	, mParticleDensity( aParticleDensity )
 	, mPadding( aPadding )
-	, mRNG( aRNG )
+	, mRNG( fork_rng( aRNG ) )
 {
 	// Store extents
 	mVisibleExtent.x = float(aImageWidth);
@@ -20,90 +80,57 @@ ParticleField::ParticleField( RNG& aRNG, std::uint32_t aImageWidth, std::uint32_
 
 	// Allocate particles
 	Vec2f const extent = mBoxMax - mBoxMin;
-	
+
 	float const totalArea = extent.x * extent.y;
 	float const particleCountf = totalArea * mParticleDensity;
 	std::size_t const particleCount = std::size_t(particleCountf+0.5f);
 
-	mParticles.resize( particleCount );
+	mParticlesX.resize( particleCount );
+	mParticlesY.resize( particleCount );
+
+	mRespawn.resize( particleCount );
+	mRandom.resize( 2*particleCount );
+	mMoved.resize( particleCount );
 
 	// Initialize particles
-	std::uniform_real_distribution<float> xdist( mBoxMin.x, mBoxMax.x );
-	std::uniform_real_distribution<float> ydist( mBoxMin.y, mBoxMax.y );
+	fill_uniform( mRNG, mParticlesX.data(), particleCount, mBoxMin.x, mBoxMax.x );
+	fill_uniform( mRNG, mParticlesY.data(), particleCount, mBoxMin.y, mBoxMax.y );
 
-	for( auto& p : mParticles )
-	{
-		p.x = xdist(mRNG);
-		p.y = ydist(mRNG);
-	}
+	sort_by_y_();
+	to_requested_storage_();
 }
 
 
 void ParticleField::update( Vec2f aDelta ) noexcept
 {
-	// Note: the delta here is reversed -- the particles move in the 
+	// Note: the delta here is reversed -- the particles move in the
 	// opposite direction as the "player".
 	auto const delta = -mParticleSpeedMult * aDelta;
 
-	std::uniform_real_distribution<float> xdist( mBoxMin.x, mBoxMax.x );
-	std::uniform_real_distribution<float> ydist( mBoxMin.y, mBoxMax.y );
-
-	float const padX = std::max( std::abs(aDelta.x), mPadding );
-	float const padY = std::max( std::abs(aDelta.y), mPadding );
+	std::size_t const respawnCount = EParticleStorage::fixed16 == mStorage
+		? update_fixed_( delta )
+		: update_float_( delta )
+	;
 
-	std::uniform_real_distribution<float> xpad( 0.f, padX );
-	std::uniform_real_distribution<float> ypad( 0.f, padY );
-
-
-	for( auto& particle : mParticles )
-	{
-		Vec2f p = particle + delta;
-
-		if( p.x < mBoxMin.x )
-		{
-			p.x = mBoxMax.x - xpad(mRNG);
-			p.y = ydist(mRNG);
-		}
-		else if( p.x > mBoxMax.x )
-		{
-			p.x = mBoxMin.x + xpad(mRNG);
-			p.y = ydist(mRNG);
-		}
-
-		if( p.y < mBoxMin.y )
-		{
-			p.x = xdist(mRNG);
-			p.y = mBoxMax.y - ypad(mRNG);
-		}
-		else if( p.y > mBoxMax.y )
-		{
-			p.x = xdist(mRNG);
-			p.y = mBoxMin.y + ypad(mRNG);
-		}
-
-		particle = p;
-	}
+	if( respawnCount )
+		respawn_( respawnCount, delta );
 }
 
 void ParticleField::draw( Surface& aSurface ) const
 {
-	for( auto const& particle : mParticles )
-	{
-		auto const p = particle + Vec2f{ .5f, .5f };
-
-		if( p.x < 0.f || p.y < 0.f )
-			continue;
-		
-		std::uint32_t const xpos = std::uint32_t( p.x + .5f );
-		std::uint32_t const ypos = std::uint32_t( p.y + .5f );
-
-		if( xpos < aSurface.get_width() && ypos < aSurface.get_height() )
-			aSurface.set_pixel_srgb( xpos, ypos, mColor );
-	}
+	if( EParticleStorage::fixed16 == mStorage )
+		draw_fixed_( aSurface );
+	else
+		draw_float_( aSurface );
 }
 
 void ParticleField::resize( std::uint32_t aImageWidth, std::uint32_t aImageHeight )
 {
+	// Resizing is rare; do it in floating point. The fixed point
+	// representation depends on the size of the box, and is recomputed below.
+	to_float_storage_();
+	unwrap_();
+
 	auto const oldMax = mBoxMax;
 
 	// New extents and particle count
@@ -113,24 +140,50 @@ void ParticleField::resize( std::uint32_t aImageWidth, std::uint32_t aImageHeigh
 	mBoxMax = mVisibleExtent + Vec2f{ mPadding, mPadding };
 
 	Vec2f const extent = mBoxMax - mBoxMin;
-	
+
 	float const totalArea = extent.x * extent.y;
 	float const particleCountf = totalArea * mParticleDensity;
 	std::size_t const particleCount = std::size_t(particleCountf+0.5f);
 
-	// Remove particles now outside
+	// Remove particles now outside (keeping the order of the remaining ones)
 	std::size_t activeParticles = 0;
-	for( auto it = mParticles.begin(); it != mParticles.end(); )
+	for( std::size_t i = 0; i < mParticlesX.size(); ++i )
+	{
+		if( mParticlesX[i] > mBoxMax.x || mParticlesY[i] > mBoxMax.y )
+			continue;
+
+		mParticlesX[activeParticles] = mParticlesX[i];
+		mParticlesY[activeParticles] = mParticlesY[i];
+		++activeParticles;
+	}
+
+	// Drop any excess evenly. The particles are sorted by Y, so truncating
+	// would remove the top-most ones and leave an empty band. Instead, keep
+	// particleCount of them at an even stride (keeping their order).
+	if( activeParticles > particleCount )
 	{
-		auto const& part = *it;
+		std::size_t kept = 0;
+		for( std::size_t i = 0; i < activeParticles; ++i )
+		{
+			// Keep particle i iff floor((i+1)*n/N) > floor(i*n/N)
+			if( (i+1) * particleCount / activeParticles == i * particleCount / activeParticles )
+				continue;
+
+			mParticlesX[kept] = mParticlesX[i];
+			mParticlesY[kept] = mParticlesY[i];
+			++kept;
+		}
 
-		if( part.x > mBoxMax.x || part.y > mBoxMax.y )
-			it = mParticles.erase( it );
-		else
-			++it, ++activeParticles;
+		assert( kept == particleCount );
+		activeParticles = kept;
 	}
 
-	mParticles.resize( particleCount ); // This may kill a few visible particles..
+	mParticlesX.resize( particleCount );
+	mParticlesY.resize( particleCount );
+
+	mRespawn.resize( particleCount );
+	mRandom.resize( 2*particleCount );
+	mMoved.resize( particleCount );
 
 	// Add new particles (if necessary)
 	if( activeParticles < particleCount )
@@ -164,7 +217,817 @@ void ParticleField::resize( std::uint32_t aImageWidth, std::uint32_t aImageHeigh
 				pos.y = yay( mRNG );
 			}
 
-			mParticles[i] = pos;
+			mParticlesX[i] = pos.x;
+			mParticlesY[i] = pos.y;
+		}
+	}
+
+	// The remaining particles are still sorted; only the new ones need to be
+	// put into place.
+	if( activeParticles < particleCount )
+	{
+		std::size_t const added = particleCount - activeParticles;
+		for( std::size_t i = 0; i < added; ++i )
+			mRespawn[i] = std::uint32_t(activeParticles + i);
+
+		restore_order_( added );
+	}
+
+	to_requested_storage_();
+}
+
+EParticleStorage ParticleField::storage() const noexcept
+{
+	return mStorage;
+}
+
+void ParticleField::set_layer_scroll( bool aEnabled ) noexcept
+{
+	if( !aEnabled && EParticleStorage::fixed16 == mStorage )
+	{
+		// Fold the offset back into the positions
+		for( auto& x : mFixedX )
+			x = std::uint16_t(x + mFixedAxisX.scroll);
+		for( auto& y : mFixedY )
+			y = std::uint16_t(y + mFixedAxisY.scroll);
+
+		mFixedAxisX.scroll = 0;
+		mFixedAxisY.scroll = 0;
+	}
+
+	mLayerScroll = aEnabled;
+}
+bool ParticleField::layer_scroll() const noexcept
+{
+	return mLayerScroll;
+}
+
+
+std::size_t ParticleField::update_float_( Vec2f aDelta ) noexcept
+{
+	std::size_t const count = mParticlesX.size();
+
+	float* const xs = mParticlesX.data();
+	float* const ys = mParticlesY.data();
+
+	// Move all particles, and collect the indices of the ones that left the
+	// box. The index is written unconditionally and the output position only
+	// advances for particles that left, which keeps the loop free of
+	// data-dependent branches. mRespawn holds one entry per particle, so this
+	// never writes out of bounds.
+	std::uint32_t* const respawn = mRespawn.data();
+	std::size_t respawnCount = 0;
+
+	std::size_t i = 0;
+
+#	if defined(PARTICLE_FIELD_SSE2_)
+	__m128 const dx = _mm_set1_ps( aDelta.x );
+	__m128 const dy = _mm_set1_ps( aDelta.y );
+	__m128 const minX = _mm_set1_ps( mBoxMin.x ), maxX = _mm_set1_ps( mBoxMax.x );
+	__m128 const minY = _mm_set1_ps( mBoxMin.y ), maxY = _mm_set1_ps( mBoxMax.y );
+
+	for( ; i + 4 <= count; i += 4 )
+	{
+		__m128 const x = _mm_add_ps( _mm_loadu_ps( xs+i ), dx );
+		__m128 const y = _mm_add_ps( _mm_loadu_ps( ys+i ), dy );
+
+		_mm_storeu_ps( xs+i, x );
+		_mm_storeu_ps( ys+i, y );
+
+		__m128 const outX = _mm_or_ps( _mm_cmplt_ps( x, minX ), _mm_cmpgt_ps( x, maxX ) );
+		__m128 const outY = _mm_or_ps( _mm_cmplt_ps( y, minY ), _mm_cmpgt_ps( y, maxY ) );
+
+		// Respawns are rare; skip the bookkeeping if all four stayed inside.
+		unsigned const mask = unsigned(_mm_movemask_ps( _mm_or_ps( outX, outY ) ));
+		if( 0 != mask )
+		{
+			for( unsigned j = 0; j < 4; ++j )
+			{
+				respawn[respawnCount] = std::uint32_t(i+j);
+				respawnCount += (mask >> j) & 1u;
+			}
+		}
+	}
+#	endif // ~ PARTICLE_FIELD_SSE2_
+
+	for( ; i < count; ++i )
+	{
+		float const x = xs[i] + aDelta.x;
+		float const y = ys[i] + aDelta.y;
+
+		xs[i] = x;
+		ys[i] = y;
+
+		bool const outside = (x < mBoxMin.x) | (x > mBoxMax.x) | (y < mBoxMin.y) | (y > mBoxMax.y);
+
+		respawn[respawnCount] = std::uint32_t(i);
+		respawnCount += outside;
+	}
+
+	return respawnCount;
+}
+
+std::size_t ParticleField::update_fixed_( Vec2f aDelta ) noexcept
+{
+	std::size_t const count = mFixedX.size();
+
+	std::uint16_t* const xs = mFixedX.data();
+	std::uint16_t* const ys = mFixedY.data();
+
+	auto const stepX = fixed_step_( aDelta.x, mFixedAxisX.scale, mFixedAxisX.carry );
+	auto const stepY = fixed_step_( aDelta.y, mFixedAxisY.scale, mFixedAxisY.carry );
+
+	if( mLayerScroll )
+		return scroll_fixed_( stepX, stepY );
+
+	// The box is [1, maxValue] on each axis. Positions are moved with
+	// saturating arithmetic: particles that leave the box towards the minimum
+	// end up at 0, the ones leaving towards the maximum end up above
+	// maxValue. Only one of the positive and negative parts of each step is
+	// non-zero.
+	auto const addX = std::uint16_t(std::max( stepX, 0 )), subX = std::uint16_t(std::max( -stepX, 0 ));
+	auto const addY = std::uint16_t(std::max( stepY, 0 )), subY = std::uint16_t(std::max( -stepY, 0 ));
+
+	auto const maxX = mFixedAxisX.maxValue;
+	auto const maxY = mFixedAxisY.maxValue;
+
+	// See update_float_() for how the respawn list is built.
+	std::uint32_t* const respawn = mRespawn.data();
+	std::size_t respawnCount = 0;
+
+	std::size_t i = 0;
+
+#	if defined(PARTICLE_FIELD_SSE2_)
+	__m128i const vaddX = _mm_set1_epi16( short(addX) ), vsubX = _mm_set1_epi16( short(subX) );
+	__m128i const vaddY = _mm_set1_epi16( short(addY) ), vsubY = _mm_set1_epi16( short(subY) );
+	__m128i const vmaxX = _mm_set1_epi16( short(maxX) ), vmaxY = _mm_set1_epi16( short(maxY) );
+	__m128i const zero = _mm_setzero_si128();
+
+	for( ; i + 8 <= count; i += 8 )
+	{
+		__m128i x = _mm_loadu_si128( reinterpret_cast<__m128i const*>(xs+i) );
+		__m128i y = _mm_loadu_si128( reinterpret_cast<__m128i const*>(ys+i) );
+
+		x = _mm_subs_epu16( _mm_adds_epu16( x, vaddX ), vsubX );
+		y = _mm_subs_epu16( _mm_adds_epu16( y, vaddY ), vsubY );
+
+		_mm_storeu_si128( reinterpret_cast<__m128i*>(xs+i), x );
+		_mm_storeu_si128( reinterpret_cast<__m128i*>(ys+i), y );
+
+		// Inside iff v != 0 and max(v - maxValue, 0) == 0. SSE2 lacks
+		// unsigned 16-bit compares; the saturating subtract stands in.
+		__m128i const lo = _mm_or_si128( _mm_cmpeq_epi16( x, zero ), _mm_cmpeq_epi16( y, zero ) );
+		__m128i const in = _mm_and_si128(
+			_mm_cmpeq_epi16( _mm_subs_epu16( x, vmaxX ), zero ),
+			_mm_cmpeq_epi16( _mm_subs_epu16( y, vmaxY ), zero )
+		);
+
+		// Two mask bits per 16-bit lane
+		unsigned const mask = unsigned(_mm_movemask_epi8( _mm_andnot_si128( in, _mm_cmpeq_epi16( zero, zero ) ) ))
+			| unsigned(_mm_movemask_epi8( lo ));
+
+		if( 0 != mask )
+		{
+			for( unsigned j = 0; j < 8; ++j )
+			{
+				respawn[respawnCount] = std::uint32_t(i+j);
+				respawnCount += (mask >> (2*j)) & 1u;
+			}
+		}
+	}
+#	endif // ~ PARTICLE_FIELD_SSE2_
+
+	for( ; i < count; ++i )
+	{
+		int const x = std::clamp( int(xs[i]) + stepX, 0, 0xffff );
+		int const y = std::clamp( int(ys[i]) + stepY, 0, 0xffff );
+
+		xs[i] = std::uint16_t(x);
+		ys[i] = std::uint16_t(y);
+
+		bool const outside = (0 == x) | (x > maxX) | (0 == y) | (y > maxY);
+
+		respawn[respawnCount] = std::uint32_t(i);
+		respawnCount += outside;
+	}
+
+	return respawnCount;
+}
+
+std::size_t ParticleField::scroll_fixed_( std::int32_t aStepX, std::int32_t aStepY ) noexcept
+{
+	std::size_t const count = mFixedX.size();
+
+	std::uint16_t* const xs = mFixedX.data();
+	std::uint16_t* const ys = mFixedY.data();
+
+	auto const scrollX = mFixedAxisX.scroll;
+	auto const scrollY = mFixedAxisY.scroll;
+
+	// A particle at v (in [1, maxValue]) leaves the box iff v+step is not in
+	// [1, maxValue], i.e., iff v <= -step or v > maxValue-step. These are
+	// the particles that update_fixed_() finds.
+	auto const loX = std::uint16_t(std::clamp( -aStepX, 0, 0xffff ));
+	auto const loY = std::uint16_t(std::clamp( -aStepY, 0, 0xffff ));
+	auto const hiX = std::uint16_t(std::clamp( int(mFixedAxisX.maxValue) - aStepX, 0, 0xffff ));
+	auto const hiY = std::uint16_t(std::clamp( int(mFixedAxisY.maxValue) - aStepY, 0, 0xffff ));
+
+	// See update_fixed_() for how the respawn list is built. The positions
+	// are only read.
+	std::uint32_t* const respawn = mRespawn.data();
+	std::size_t respawnCount = 0;
+
+	std::size_t i = 0;
+
+#	if defined(PARTICLE_FIELD_SSE2_)
+	__m128i const vscrollX = _mm_set1_epi16( short(scrollX) ), vscrollY = _mm_set1_epi16( short(scrollY) );
+	__m128i const vloX = _mm_set1_epi16( short(loX) ), vloY = _mm_set1_epi16( short(loY) );
+	__m128i const vhiX = _mm_set1_epi16( short(hiX) ), vhiY = _mm_set1_epi16( short(hiY) );
+	__m128i const zero = _mm_setzero_si128();
+
+	for( ; i + 8 <= count; i += 8 )
+	{
+		// Wrapping adds
+		__m128i const x = _mm_add_epi16( _mm_loadu_si128( reinterpret_cast<__m128i const*>(xs+i) ), vscrollX );
+		__m128i const y = _mm_add_epi16( _mm_loadu_si128( reinterpret_cast<__m128i const*>(ys+i) ), vscrollY );
+
+		// Unsigned compares with saturating subtracts, as in update_fixed_():
+		// v <= lo iff max(v-lo, 0) == 0, and v <= hi likewise.
+		__m128i const low = _mm_or_si128(
+			_mm_cmpeq_epi16( _mm_subs_epu16( x, vloX ), zero ),
+			_mm_cmpeq_epi16( _mm_subs_epu16( y, vloY ), zero )
+		);
+		__m128i const in = _mm_and_si128(
+			_mm_cmpeq_epi16( _mm_subs_epu16( x, vhiX ), zero ),
+			_mm_cmpeq_epi16( _mm_subs_epu16( y, vhiY ), zero )
+		);
+
+		unsigned const mask = unsigned(_mm_movemask_epi8( _mm_andnot_si128( in, _mm_cmpeq_epi16( zero, zero ) ) ))
+			| unsigned(_mm_movemask_epi8( low ));
+
+		if( 0 != mask )
+		{
+			for( unsigned j = 0; j < 8; ++j )
+			{
+				respawn[respawnCount] = std::uint32_t(i+j);
+				respawnCount += (mask >> (2*j)) & 1u;
+			}
+		}
+	}
+#	endif // ~ PARTICLE_FIELD_SSE2_
+
+	for( ; i < count; ++i )
+	{
+		auto const x = std::uint16_t(xs[i] + scrollX);
+		auto const y = std::uint16_t(ys[i] + scrollY);
+
+		bool const outside = (x <= loX) | (x > hiX) | (y <= loY) | (y > hiY);
+
+		respawn[respawnCount] = std::uint32_t(i);
+		respawnCount += outside;
+	}
+
+	// Advance the offset. Particles that left are moved like update_fixed_()
+	// does (saturating), such that respawn_() sees the same positions.
+	auto const newScrollX = std::uint16_t(scrollX + aStepX);
+	auto const newScrollY = std::uint16_t(scrollY + aStepY);
+
+	for( std::size_t r = 0; r < respawnCount; ++r )
+	{
+		auto const j = respawn[r];
+
+		int const x = std::clamp( int(std::uint16_t(xs[j] + scrollX)) + aStepX, 0, 0xffff );
+		int const y = std::clamp( int(std::uint16_t(ys[j] + scrollY)) + aStepY, 0, 0xffff );
+
+		xs[j] = std::uint16_t(x - newScrollX);
+		ys[j] = std::uint16_t(y - newScrollY);
+	}
+
+	mFixedAxisX.scroll = newScrollX;
+	mFixedAxisY.scroll = newScrollY;
+
+	return respawnCount;
+}
+
+void ParticleField::draw_float_( Surface& aSurface ) const
+{
+	// A particle at position p is drawn at round(p+0.5), and skipped if
+	// p+0.5 is negative (see draw_points()). The ring is drawn in two parts,
+	// to keep the Y order (see mFirst).
+	std::size_t const count = mParticlesX.size();
+	draw_points( aSurface, mParticlesX.data() + mFirst, mParticlesY.data() + mFirst, count - mFirst, mColor, Vec2f{ .5f, .5f } );
+	draw_points( aSurface, mParticlesX.data(), mParticlesY.data(), mFirst, mColor, Vec2f{ .5f, .5f } );
+}
+
+void ParticleField::draw_fixed_( Surface& aSurface ) const
+{
+	// Same rounding as draw_float_(): a particle at position p covers pixel
+	// floor(p+1), unless p+0.5 is negative. In fixed point,
+	// s = (p+1) * 2^fracBits = v + offset, and p+0.5 < 0 iff s < 2^fracBits/2.
+	auto const fx = mFixedAxisX.fracBits;
+	auto const fy = mFixedAxisY.fracBits;
+
+	std::int32_t const offX = std::int32_t(std::lround( (mBoxMin.x + 1.f) * mFixedAxisX.scale )) - 1;
+	std::int32_t const offY = std::int32_t(std::lround( (mBoxMin.y + 1.f) * mFixedAxisY.scale )) - 1;
+
+	auto const scrollX = mFixedAxisX.scroll;
+	auto const scrollY = mFixedAxisY.scroll;
+
+	std::int32_t const halfX = std::int32_t(1) << (fx-1);
+	std::int32_t const halfY = std::int32_t(1) << (fy-1);
+
+	auto const width = aSurface.get_width();
+	auto const height = aSurface.get_height();
+
+	std::size_t const count = mFixedX.size();
+	for( std::size_t rank = 0; rank < count; ++rank )
+	{
+		auto const i = ring_index_( rank, mFirst, count );
+
+		std::int32_t const sx = std::int32_t(std::uint16_t(mFixedX[i] + scrollX)) + offX;
+		std::int32_t const sy = std::int32_t(std::uint16_t(mFixedY[i] + scrollY)) + offY;
+
+		if( sx < halfX || sy < halfY )
+			continue;
+
+		auto const xpos = std::uint32_t(sx >> fx);
+		auto const ypos = std::uint32_t(sy >> fy);
+
+		if( xpos < width && ypos < height )
+			aSurface.set_pixel_srgb( xpos, ypos, mColor );
+	}
+}
+
+void ParticleField::respawn_( std::size_t aCount, Vec2f aDelta ) noexcept
+{
+	// Particles that left the box re-enter on the opposite side. They are
+	// placed within the strip that this frame's movement uncovered there,
+	// which keeps the field uniformly filled at any speed. Two random numbers
+	// are needed per particle; generate all of them in one go.
+	assert( 2*aCount <= mRandom.size() );
+	fill_uniform( mRNG, mRandom.data(), 2*aCount );
+
+	float const* random = mRandom.data();
+
+	Vec2f const extent = mBoxMax - mBoxMin;
+
+	float const padX = std::min( std::abs(aDelta.x), extent.x );
+	float const padY = std::min( std::abs(aDelta.y), extent.y );
+
+	std::size_t const count = particle_count_();
+	bool const fixed = EParticleStorage::fixed16 == mStorage;
+
+	auto const fixed_y = [&] (std::size_t aIndex) {
+		return std::uint16_t(mFixedY[aIndex] + mFixedAxisY.scroll);
+	};
+
+	auto const below = [&] (std::size_t aIndex) {
+		return fixed ? 0 == fixed_y( aIndex ) : mParticlesY[aIndex] < mBoxMin.y;
+	};
+	auto const above = [&] (std::size_t aIndex) {
+		return fixed ? fixed_y( aIndex ) > mFixedAxisY.maxValue : mParticlesY[aIndex] > mBoxMax.y;
+	};
+
+	// Particles that left through the bottom (top) re-enter at the top
+	// (bottom), anywhere along X.
+	auto const respawn_vertical = [&] (std::size_t aIndex, bool aBelow) {
+		float const r0 = *random++;
+		float const r1 = *random++;
+
+		set_position_( aIndex, Vec2f{
+			mBoxMin.x + r0 * extent.x,
+			aBelow ? mBoxMax.y - r1 * padY : mBoxMin.y + r1 * padY
+		} );
+	};
+
+	// Particles that left through the sides (left or right) re-enter on the
+	// right or left, anywhere in [aMinY, aMaxY].
+	auto const respawn_horizontal = [&] (std::size_t aIndex, float aMinY, float aMaxY) {
+		float const r0 = *random++;
+		float const r1 = *random++;
+
+		set_position_( aIndex, Vec2f{
+			position_( aIndex ).x < mBoxMin.x ? mBoxMax.x - r0 * padX : mBoxMin.x + r0 * padX,
+			aMinY + r1 * (aMaxY - aMinY)
+		} );
+	};
+
+	// Large movements respawn a good part of the field. Sorting all of it is
+	// cheaper then.
+	if( kFullSortRatio * aCount > count )
+	{
+		for( std::size_t i = 0; i < aCount; ++i )
+		{
+			auto const index = mRespawn[i];
+			if( below( index ) || above( index ) )
+				respawn_vertical( index, below( index ) );
+			else
+				respawn_horizontal( index, mBoxMin.y, mBoxMax.y );
+		}
+
+		sort_by_y_();
+		return;
+	}
+
+	// Particles that left through the bottom (top) are the first (last) ones
+	// in Y order.
+	std::size_t belowCount = 0;
+	while( belowCount < count && below( ring_index_( belowCount, mFirst, count ) ) )
+		++belowCount;
+
+	std::size_t aboveCount = 0;
+	while( belowCount + aboveCount < count && above( ring_index_( count-1 - aboveCount, mFirst, count ) ) )
+		++aboveCount;
+
+	// Particles that left through the sides keep their place in Y order:
+	// the new Y is picked uniformly between the neighbours' Ys. Given the
+	// other particles, this is how the particle's Y is distributed in a
+	// uniformly random (sorted) field, so the field stays uniform. Nothing
+	// needs to be moved.
+	auto const y_at = [&] (std::size_t aRank) {
+		return position_( ring_index_( aRank, mFirst, count ) ).y;
+	};
+
+	for( std::size_t i = 0; i < aCount; ++i )
+	{
+		auto const rank = (mRespawn[i] + count - mFirst) % count;
+		if( rank < belowCount || rank >= count - aboveCount )
+			continue;
+
+		float const minY = rank > belowCount ? y_at( rank-1 ) : mBoxMin.y;
+		float const maxY = rank+1 < count - aboveCount ? y_at( rank+1 ) : mBoxMax.y;
+
+		respawn_horizontal( mRespawn[i], minY, maxY );
+	}
+
+	// The first ones become the last ones by advancing the start of the
+	// ring. They are then merged with the particles in the top strip only.
+	// Same for the last ones.
+	if( belowCount )
+	{
+		mFirst = ring_index_( belowCount, mFirst, count );
+
+		for( std::size_t rank = count - belowCount; rank < count; ++rank )
+			respawn_vertical( ring_index_( rank, mFirst, count ), true );
+
+		merge_last_( belowCount );
+	}
+
+	if( aboveCount )
+	{
+		mFirst = ring_index_( count - aboveCount, mFirst, count );
+
+		for( std::size_t rank = 0; rank < aboveCount; ++rank )
+			respawn_vertical( ring_index_( rank, mFirst, count ), false );
+
+		merge_first_( aboveCount );
+	}
+}
+
+void ParticleField::restore_order_( std::size_t aCount ) noexcept
+{
+	assert( aCount <= mMoved.size() );
+	assert( 0 == mFirst );
+
+	if( EParticleStorage::fixed16 == mStorage )
+		reinsert_sorted_( mFixedX.data(), mFixedY.data(), mFixedAxisY.scroll, mFixedX.size(), mRespawn.data(), aCount, mMoved.data() );
+	else
+		reinsert_sorted_( mParticlesX.data(), mParticlesY.data(), 0.f, mParticlesX.size(), mRespawn.data(), aCount, mMoved.data() );
+}
+
+void ParticleField::sort_by_y_() noexcept
+{
+	assert( particle_count_() <= mMoved.size() );
+
+	mFirst = 0;
+
+	if( EParticleStorage::fixed16 == mStorage )
+		sort_coords_by_y_( mFixedX.data(), mFixedY.data(), mFixedAxisY.scroll, mFixedX.size(), mMoved.data() );
+	else
+		sort_coords_by_y_( mParticlesX.data(), mParticlesY.data(), 0.f, mParticlesX.size(), mMoved.data() );
+}
+
+void ParticleField::unwrap_() noexcept
+{
+	if( EParticleStorage::fixed16 == mStorage )
+	{
+		std::rotate( mFixedX.begin(), mFixedX.begin() + std::ptrdiff_t(mFirst), mFixedX.end() );
+		std::rotate( mFixedY.begin(), mFixedY.begin() + std::ptrdiff_t(mFirst), mFixedY.end() );
+	}
+	else
+	{
+		std::rotate( mParticlesX.begin(), mParticlesX.begin() + std::ptrdiff_t(mFirst), mParticlesX.end() );
+		std::rotate( mParticlesY.begin(), mParticlesY.begin() + std::ptrdiff_t(mFirst), mParticlesY.end() );
+	}
+
+	mFirst = 0;
+}
+
+void ParticleField::merge_first_( std::size_t aCount ) noexcept
+{
+	assert( aCount <= mMoved.size() );
+
+	if( EParticleStorage::fixed16 == mStorage )
+		merge_first_sorted_( mFixedX.data(), mFixedY.data(), mFixedAxisY.scroll, mFixedX.size(), mFirst, aCount, mMoved.data() );
+	else
+		merge_first_sorted_( mParticlesX.data(), mParticlesY.data(), 0.f, mParticlesX.size(), mFirst, aCount, mMoved.data() );
+}
+void ParticleField::merge_last_( std::size_t aCount ) noexcept
+{
+	assert( aCount <= mMoved.size() );
+
+	if( EParticleStorage::fixed16 == mStorage )
+		merge_last_sorted_( mFixedX.data(), mFixedY.data(), mFixedAxisY.scroll, mFixedX.size(), mFirst, aCount, mMoved.data() );
+	else
+		merge_last_sorted_( mParticlesX.data(), mParticlesY.data(), 0.f, mParticlesX.size(), mFirst, aCount, mMoved.data() );
+}
+
+std::size_t ParticleField::particle_count_() const noexcept
+{
+	return EParticleStorage::fixed16 == mStorage ? mFixedX.size() : mParticlesX.size();
+}
+
+void ParticleField::to_float_storage_()
+{
+	if( EParticleStorage::float32 == mStorage )
+		return;
+
+	std::size_t const count = mFixedX.size();
+
+	mParticlesX.resize( count );
+	mParticlesY.resize( count );
+
+	for( std::size_t i = 0; i < count; ++i )
+	{
+		auto const p = position_( i );
+		mParticlesX[i] = p.x;
+		mParticlesY[i] = p.y;
+	}
+
+	mFixedX.clear();
+	mFixedY.clear();
+
+	mStorage = EParticleStorage::float32;
+}
+
+void ParticleField::to_requested_storage_()
+{
+	assert( EParticleStorage::float32 == mStorage );
+
+	if( EParticleStorage::fixed16 != mRequestedStorage )
+		return;
+
+	Vec2f const extent = mBoxMax - mBoxMin;
+
+	FixedAxis_ ax{}, ay{};
+	if( !make_fixed_axis_( extent.x, ax.fracBits, ax.maxValue ) || !make_fixed_axis_( extent.y, ay.fracBits, ay.maxValue ) )
+		return; // too large, stay with float32
+
+	ax.scale = std::ldexp( 1.f, int(ax.fracBits) );
+	ay.scale = std::ldexp( 1.f, int(ay.fracBits) );
+
+	mFixedAxisX = ax;
+	mFixedAxisY = ay;
+
+	std::size_t const count = mParticlesX.size();
+
+	mFixedX.resize( count );
+	mFixedY.resize( count );
+
+	mStorage = EParticleStorage::fixed16;
+
+	for( std::size_t i = 0; i < count; ++i )
+		set_position_( i, Vec2f{ mParticlesX[i], mParticlesY[i] } );
+
+	// Release the float storage
+	mParticlesX = std::vector<float>();
+	mParticlesY = std::vector<float>();
+}
+
+Vec2f ParticleField::position_( std::size_t aIndex ) const noexcept
+{
+	if( EParticleStorage::float32 == mStorage )
+		return Vec2f{ mParticlesX[aIndex], mParticlesY[aIndex] };
+
+	auto const x = std::uint16_t(mFixedX[aIndex] + mFixedAxisX.scroll);
+	auto const y = std::uint16_t(mFixedY[aIndex] + mFixedAxisY.scroll);
+
+	return Vec2f{
+		mBoxMin.x + float(int(x) - 1) / mFixedAxisX.scale,
+		mBoxMin.y + float(int(y) - 1) / mFixedAxisY.scale
+	};
+}
+
+void ParticleField::set_position_( std::size_t aIndex, Vec2f aPosition ) noexcept
+{
+	if( EParticleStorage::float32 == mStorage )
+	{
+		mParticlesX[aIndex] = aPosition.x;
+		mParticlesY[aIndex] = aPosition.y;
+		return;
+	}
+
+	auto const fx = 1.f + (aPosition.x - mBoxMin.x) * mFixedAxisX.scale;
+	auto const fy = 1.f + (aPosition.y - mBoxMin.y) * mFixedAxisY.scale;
+
+	auto const x = std::clamp( std::lround( fx ), 1l, long(mFixedAxisX.maxValue) );
+	auto const y = std::clamp( std::lround( fy ), 1l, long(mFixedAxisY.maxValue) );
+
+	mFixedX[aIndex] = std::uint16_t(x - mFixedAxisX.scroll);
+	mFixedY[aIndex] = std::uint16_t(y - mFixedAxisY.scroll);
+}
+
+namespace
+{
+	bool make_fixed_axis_( float aExtent, unsigned& aFracBits, std::uint16_t& aMaxValue ) noexcept
+	{
+		// Leave room for the minimum (1) and for values above the maximum,
+		// which mark particles that left the box.
+		constexpr float kLimit = float(std::numeric_limits<std::uint16_t>::max() - 2);
+
+		for( unsigned bits = kMaxFracBits+1; bits-- > kMinFracBits; )
+		{
+			float const range = std::ceil( aExtent * std::ldexp( 1.f, int(bits) ) );
+			if( range + 1.f <= kLimit )
+			{
+				aFracBits = bits;
+				aMaxValue = std::uint16_t(range + 1.f);
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	std::int32_t fixed_step_( float aDelta, float aScale, float& aCarry ) noexcept
+	{
+		float const exact = aDelta * aScale + aCarry;
+
+		// Anything larger than the box moves all particles out of it anyway.
+		constexpr float kMaxStep = float(std::numeric_limits<std::uint16_t>::max());
+		if( !(std::abs( exact ) < kMaxStep) )
+		{
+			aCarry = 0.f;
+			return std::int32_t(std::copysign( kMaxStep, exact ));
+		}
+
+		float const rounded = std::nearbyint( exact );
+		aCarry = exact - rounded;
+		return std::int32_t(rounded);
+	}
+
+	std::size_t ring_index_( std::size_t aRank, std::size_t aFirst, std::size_t aCount ) noexcept
+	{
+		assert( aRank < aCount && aFirst < aCount );
+
+		auto const index = aFirst + aRank;
+		return index < aCount ? index : index - aCount;
+	}
+
+	float scrolled_y_( float aY, float aScroll ) noexcept
+	{
+		return aY + aScroll;
+	}
+	float scrolled_y_( std::uint16_t aY, std::uint16_t aScroll ) noexcept
+	{
+		return float(std::uint16_t(aY + aScroll));
+	}
+
+	template< typename tCoord >
+	void reinsert_sorted_( tCoord* aX, tCoord* aY, tCoord aScrollY, std::size_t aCount, std::uint32_t const* aMoved, std::size_t aMovedCount, Vec2f* aScratch ) noexcept
+	{
+		if( 0 == aMovedCount )
+			return;
+
+		// Take out the moved particles. The coordinates are stored as floats;
+		// 16-bit fixed point values are represented exactly.
+		for( std::size_t i = 0; i < aMovedCount; ++i )
+			aScratch[i] = Vec2f{ float(aX[aMoved[i]]), float(aY[aMoved[i]]) };
+
+		std::sort( aScratch, aScratch + aMovedCount, [aScrollY] (Vec2f const& aA, Vec2f const& aB) {
+			return scrolled_y_( tCoord(aA.y), aScrollY ) < scrolled_y_( tCoord(aB.y), aScrollY );
+		} );
+
+		// Close the gaps (stable). Everything before the first moved particle
+		// is already in place.
+		std::size_t out = aMoved[0];
+		std::size_t next = 0;
+		for( std::size_t i = aMoved[0]; i < aCount; ++i )
+		{
+			if( next < aMovedCount && aMoved[next] == i )
+			{
+				++next;
+				continue;
+			}
+
+			aX[out] = aX[i];
+			aY[out] = aY[i];
+			++out;
+		}
+
+		assert( out + aMovedCount == aCount );
+
+		// Merge from the back, into the space freed up at the end.
+		std::size_t kept = out, moved = aMovedCount, dest = aCount;
+		while( moved > 0 )
+		{
+			--dest;
+			if( kept > 0 && scrolled_y_( aY[kept-1], aScrollY ) > scrolled_y_( tCoord(aScratch[moved-1].y), aScrollY ) )
+			{
+				--kept;
+				aX[dest] = aX[kept];
+				aY[dest] = aY[kept];
+			}
+			else
+			{
+				--moved;
+				aX[dest] = tCoord(aScratch[moved].x);
+				aY[dest] = tCoord(aScratch[moved].y);
+			}
+		}
+	}
+
+	template< typename tCoord >
+	void merge_first_sorted_( tCoord* aX, tCoord* aY, tCoord aScrollY, std::size_t aCount, std::size_t aFirst, std::size_t aMovedCount, Vec2f* aScratch ) noexcept
+	{
+		auto const at = [&] (std::size_t aR) { return ring_index_( aR, aFirst, aCount ); };
+
+		// See reinsert_sorted_() regarding the scratch space
+		for( std::size_t i = 0; i < aMovedCount; ++i )
+			aScratch[i] = Vec2f{ float(aX[at(i)]), float(aY[at(i)]) };
+
+		std::sort( aScratch, aScratch + aMovedCount, [aScrollY] (Vec2f const& aA, Vec2f const& aB) {
+			return scrolled_y_( tCoord(aA.y), aScrollY ) < scrolled_y_( tCoord(aB.y), aScrollY );
+		} );
+
+		// Merge from the front, into the space freed up at the front. This
+		// stops once the last moved particle is placed, so only the kept
+		// particles below it are touched.
+		std::size_t kept = aMovedCount, moved = 0, dest = 0;
+		for( ; moved < aMovedCount; ++dest )
+		{
+			auto const to = at( dest );
+			if( kept < aCount && scrolled_y_( aY[at(kept)], aScrollY ) < scrolled_y_( tCoord(aScratch[moved].y), aScrollY ) )
+			{
+				auto const from = at( kept++ );
+				aX[to] = aX[from];
+				aY[to] = aY[from];
+			}
+			else
+			{
+				aX[to] = tCoord(aScratch[moved].x);
+				aY[to] = tCoord(aScratch[moved].y);
+				++moved;
+			}
+		}
+	}
+	template< typename tCoord >
+	void merge_last_sorted_( tCoord* aX, tCoord* aY, tCoord aScrollY, std::size_t aCount, std::size_t aFirst, std::size_t aMovedCount, Vec2f* aScratch ) noexcept
+	{
+		auto const at = [&] (std::size_t aR) { return ring_index_( aR, aFirst, aCount ); };
+
+		std::size_t kept = aCount - aMovedCount;
+		for( std::size_t i = 0; i < aMovedCount; ++i )
+			aScratch[i] = Vec2f{ float(aX[at(kept+i)]), float(aY[at(kept+i)]) };
+
+		std::sort( aScratch, aScratch + aMovedCount, [aScrollY] (Vec2f const& aA, Vec2f const& aB) {
+			return scrolled_y_( tCoord(aA.y), aScrollY ) < scrolled_y_( tCoord(aB.y), aScrollY );
+		} );
+
+		// Merge from the back; see merge_first_sorted_().
+		std::size_t moved = aMovedCount, dest = aCount;
+		while( moved > 0 )
+		{
+			auto const to = at( --dest );
+			if( kept > 0 && scrolled_y_( aY[at(kept-1)], aScrollY ) > scrolled_y_( tCoord(aScratch[moved-1].y), aScrollY ) )
+			{
+				auto const from = at( --kept );
+				aX[to] = aX[from];
+				aY[to] = aY[from];
+			}
+			else
+			{
+				--moved;
+				aX[to] = tCoord(aScratch[moved].x);
+				aY[to] = tCoord(aScratch[moved].y);
+			}
+		}
+	}
+
+	template< typename tCoord >
+	void sort_coords_by_y_( tCoord* aX, tCoord* aY, tCoord aScrollY, std::size_t aCount, Vec2f* aScratch ) noexcept
+	{
+		for( std::size_t i = 0; i < aCount; ++i )
+			aScratch[i] = Vec2f{ float(aX[i]), float(aY[i]) };
+
+		std::sort( aScratch, aScratch + aCount, [aScrollY] (Vec2f const& aA, Vec2f const& aB) {
+			return scrolled_y_( tCoord(aA.y), aScrollY ) < scrolled_y_( tCoord(aB.y), aScrollY );
+		} );
+
+		for( std::size_t i = 0; i < aCount; ++i )
+		{
+			aX[i] = tCoord(aScratch[i].x);
+			aY[i] = tCoord(aScratch[i].y);
 		}
 	}
 }
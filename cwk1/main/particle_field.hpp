@@ -3,6 +3,7 @@
 
 #include <vector>
 
+#include <cstdint>
 #include <cstdlib>
 
 #include "../draw2d/forward.hpp"
@@ -12,6 +13,27 @@
 
 #include "defaults.hpp"
 
+/** Particle position storage
+ *
+ * float32 stores positions as 32-bit floats.
+ *
+ * fixed16 stores positions as unsigned 16-bit fixed point numbers, relative
+ * to the minimum corner of the particle box. The number of fractional bits is
+ * picked per axis, as large as possible (up to 8) such that the box fits into
+ * 16 bits. This halves the memory traffic of update() and draw(). If the box
+ * is too large to leave at least two fractional bits (i.e., more than about
+ * 16k pixels), the field falls back to float32.
+ *
+ * Per-frame movement is rounded to the fixed point resolution. The rounding
+ * error is carried over into the next frame, so slow movements accumulate
+ * correctly instead of stalling or drifting.
+ */
+enum class EParticleStorage
+{
+	float32,
+	fixed16
+};
+
 class ParticleField final
 {
 	public:
@@ -21,7 +43,8 @@ class ParticleField final
 			ColorF const& aParticleColor,
 			float aParticleDensity,
 			float aParticleSpeedMult = 1.f,
-			float aPadding = 50.f
+			float aPadding = 50.f,
+			EParticleStorage aStorage = EParticleStorage::fixed16
 		);
 
 	public:
@@ -30,9 +53,108 @@ class ParticleField final
 		void draw( Surface& ) const;
 
 		void resize( std::uint32_t aImageWidth, std::uint32_t aImageHeight );
+
+		// Storage that is in use; this may differ from the requested one
+		// (see EParticleStorage).
+		EParticleStorage storage() const noexcept;
+
+		// Scrolled layer mode. All particles move by the same amount each
+		// frame, so instead of moving each particle, the field stores the
+		// positions relative to a shared scroll offset, and update() only
+		// advances the offset. Each particle keeps its own fractional bits
+		// (its sub-pixel phase), so particles still cross pixel boundaries
+		// on their own frames. update() reads the positions once to find the
+		// particles that left the box; only those (the newly exposed border
+		// strips) are written. draw() adds the offset back in.
+		//
+		// With fixed16 storage, the positions are integers and the offset is
+		// exact, so the mode gives the same particles, and the same pixels,
+		// as moving each particle. With float32 storage, the setting is
+		// remembered but not used.
+		//
+		// Note: draw() still visits each particle, since the particles cross
+		// pixel boundaries on different frames. The mode only makes update()
+		// cheaper, and drawing dominates (see sim-benchmark). It is therefore
+		// off by default.
+		void set_layer_scroll( bool aEnabled ) noexcept;
+		bool layer_scroll() const noexcept;
 	
 	private:
-		std::vector<Vec2f> mParticles;
+		struct FixedAxis_
+		{
+			unsigned fracBits;
+			float scale; // 2^fracBits
+			std::uint16_t maxValue; // box maximum; the box minimum is 1
+			float carry; // rounding error of the last movement
+			std::uint16_t scroll; // see set_layer_scroll(); zero otherwise
+		};
+
+	private:
+		std::size_t update_float_( Vec2f aDelta ) noexcept;
+		std::size_t update_fixed_( Vec2f aDelta ) noexcept;
+		std::size_t scroll_fixed_( std::int32_t aStepX, std::int32_t aStepY ) noexcept;
+
+		void draw_float_( Surface& ) const;
+		void draw_fixed_( Surface& ) const;
+
+		void respawn_( std::size_t aCount, Vec2f aDelta ) noexcept;
+		void restore_order_( std::size_t aCount ) noexcept;
+		void sort_by_y_() noexcept;
+		void unwrap_() noexcept;
+
+		// Sort the first/last aCount particles in Y order, and merge them
+		// with the others.
+		void merge_first_( std::size_t aCount ) noexcept;
+		void merge_last_( std::size_t aCount ) noexcept;
+
+		std::size_t particle_count_() const noexcept;
+
+		void to_float_storage_();
+		void to_requested_storage_();
+
+		Vec2f position_( std::size_t ) const noexcept;
+		void set_position_( std::size_t, Vec2f ) noexcept;
+
+
+	private:
+		// Particle positions, stored as separate arrays of x and y coordinates
+		// (structure-of-arrays), such that update() can process several
+		// particles at once with SIMD instructions. Only one of the float or
+		// the fixed point arrays is used, depending on mStorage.
+		//
+		// Particles are kept sorted by their Y coordinate, such that draw()
+		// sweeps over the surface's rows in memory order, instead of writing
+		// to random locations. All particles move by the same amount, which
+		// does not change their order; only respawned particles need to be
+		// put back into place (see respawn_()).
+		//
+		// The arrays are used as a ring: the particle with the smallest Y is
+		// at index mFirst, and the order wraps around at the end. Particles
+		// that leave through the bottom re-enter at the top, i.e., they go
+		// from the first to the last places in Y order. With the ring, this
+		// only advances mFirst, instead of moving all other particles.
+		std::size_t mFirst;
+
+		std::vector<float> mParticlesX;
+		std::vector<float> mParticlesY;
+
+		// Fixed point positions are stored relative to the axes' scroll
+		// offsets (modulo 2^16), see set_layer_scroll().
+		std::vector<std::uint16_t> mFixedX;
+		std::vector<std::uint16_t> mFixedY;
+		FixedAxis_ mFixedAxisX, mFixedAxisY;
+
+		EParticleStorage mRequestedStorage;
+		EParticleStorage mStorage;
+
+		bool mLayerScroll;
+
+		// Scratch space for update(): indices of particles that left the box,
+		// and random numbers for their new positions. Kept around to avoid
+		// allocating them each frame.
+		std::vector<std::uint32_t> mRespawn;
+		std::vector<float> mRandom;
+		std::vector<Vec2f> mMoved;
 
 		ColorU8_sRGB mColor;
 
@@ -43,7 +165,9 @@ class ParticleField final
 		Vec2f mVisibleExtent;
 		Vec2f mBoxMin, mBoxMax;
 
-		RNG& mRNG;
+		// Each field owns a generator forked from the one passed to the
+		// constructor, see fork_rng().
+		RNG mRNG;
 };
 
 #endif // PARTICLE_FIELD_HPP_5A795E6D_C839_4944_9020_1AF0FEFE3EFC
@@ -0,0 +1,46 @@
+#include "rng.hpp"
+
+#include <cmath>
+
+namespace
+{
+	constexpr float kTwoPI = 6.2831853071795864769f; // 2*pi
+
+	// 24 random bits -> float in [0,1). Floats have a 24-bit significand, so
+	// every value is exactly representable.
+	constexpr float kUnit24 = 1.f / float(1u << 24);
+}
+
+void CounterRNG::fill_uniform( float* aOut, std::size_t aCount, float aMin, float aMax ) noexcept
+{
+	float const scale = (aMax - aMin) * kUnit24;
+
+	// Each output only depends on its counter; there is no serial dependency
+	// between loop iterations.
+	std::uint64_t const base = mCounter;
+	for( std::size_t i = 0; i < aCount; ++i )
+	{
+		auto const bits = at( base + i );
+		aOut[i] = aMin + float(bits >> 40) * scale;
+	}
+
+	mCounter += aCount;
+}
+
+void CounterRNG::fill_normal( float* aOut, std::size_t aCount, float aMean, float aStddev ) noexcept
+{
+	std::uint64_t const base = mCounter;
+	for( std::size_t i = 0; i < aCount; ++i )
+	{
+		auto const bits = at( base + i );
+
+		// u1 in (0,1] to avoid log(0); u2 in [0,1)
+		float const u1 = float((bits >> 40) + 1) * kUnit24;
+		float const u2 = float((bits >> 16) & 0xffffff) * kUnit24;
+
+		float const r = std::sqrt( -2.f * std::log( u1 ) );
+		aOut[i] = aMean + aStddev * r * std::cos( kTwoPI * u2 );
+	}
+
+	mCounter += aCount;
+}
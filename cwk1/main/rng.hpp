@@ -0,0 +1,95 @@
+#ifndef RNG_HPP_4E7B1C93_2A6D_4F58_8D0E_A5C39F71B2D6
+#define RNG_HPP_4E7B1C93_2A6D_4F58_8D0E_A5C39F71B2D6
+
+#include <random>
+
+#include <cstddef>
+#include <cstdint>
+
+/** Counter-based random number generator
+ *
+ * The n-th output is a pure function of the key (derived from the seed) and
+ * the counter value n. This uses the SplitMix64 output function, i.e.,
+ *
+ *   output(n) = mix64( key + (n+1) * golden_gamma )
+ *
+ * which passes BigCrush and is much faster than the standard distributions
+ * on top of std::minstd_rand. It is not suitable for cryptography.
+ *
+ * Because outputs only depend on the counter, the generator can skip ahead in
+ * constant time (discard()), and a batch of outputs can be split between
+ * threads without changing the results: a copy of the generator that discards
+ * k values produces exactly the values from index k onwards. The batch fill
+ * functions consume exactly one counter value per generated number, so the
+ * same seed always produces the same numbers, regardless of how the work is
+ * divided up.
+ *
+ * CounterRNG satisfies the UniformRandomBitGenerator requirements, so it also
+ * works with the <random> distributions.
+ */
+class CounterRNG final
+{
+	public:
+		using result_type = std::uint64_t;
+
+		static constexpr result_type min() noexcept { return 0; }
+		static constexpr result_type max() noexcept { return ~result_type(0); }
+
+	public:
+		explicit CounterRNG( std::uint64_t aSeed = 0 ) noexcept;
+
+	public:
+		result_type operator() () noexcept;
+
+		// Output for counter value aCounter. Does not advance the generator.
+		result_type at( std::uint64_t aCounter ) const noexcept;
+
+		void seed( std::uint64_t ) noexcept;
+		void discard( std::uint64_t ) noexcept;
+
+		std::uint64_t counter() const noexcept;
+
+		// Create an independent generator, e.g., for a subsystem that should
+		// not be affected by how many numbers other subsystems draw.
+		CounterRNG fork() noexcept;
+
+	public:
+		// Fill aOut with aCount floats uniformly distributed in [aMin,aMax)
+		void fill_uniform( float* aOut, std::size_t aCount, float aMin = 0.f, float aMax = 1.f ) noexcept;
+
+		// Fill aOut with aCount normally distributed floats (Box-Muller; the
+		// two uniform inputs are taken from the same 64-bit output)
+		void fill_normal( float* aOut, std::size_t aCount, float aMean = 0.f, float aStddev = 1.f ) noexcept;
+
+	private:
+		std::uint64_t mKey;
+		std::uint64_t mCounter;
+};
+
+/** Batch generation for any generator
+ *
+ * These use the batch functions of CounterRNG, and fall back to the <random>
+ * distributions for other generators (e.g., when RNG is configured to be
+ * std::minstd_rand; see defaults.hpp).
+ */
+template< class tRNG >
+void fill_uniform( tRNG&, float* aOut, std::size_t aCount, float aMin = 0.f, float aMax = 1.f );
+template< class tRNG >
+void fill_normal( tRNG&, float* aOut, std::size_t aCount, float aMean = 0.f, float aStddev = 1.f );
+
+void fill_uniform( CounterRNG&, float* aOut, std::size_t aCount, float aMin = 0.f, float aMax = 1.f ) noexcept;
+void fill_normal( CounterRNG&, float* aOut, std::size_t aCount, float aMean = 0.f, float aStddev = 1.f ) noexcept;
+
+/** Derive an independent generator from aParent
+ *
+ * Each subsystem (e.g., each particle field) owns a forked generator, so the
+ * numbers it sees do not depend on the order in which the subsystems are
+ * updated, or on which thread they are updated.
+ */
+template< class tRNG >
+tRNG fork_rng( tRNG& aParent );
+
+CounterRNG fork_rng( CounterRNG& aParent ) noexcept;
+
+#include "rng.inl"
+#endif // RNG_HPP_4E7B1C93_2A6D_4F58_8D0E_A5C39F71B2D6
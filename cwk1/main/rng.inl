@@ -0,0 +1,95 @@
+namespace detail
+{
+	constexpr std::uint64_t kRNGGamma = 0x9e3779b97f4a7c15ull;
+
+	inline
+	std::uint64_t splitmix64_mix( std::uint64_t aZ ) noexcept
+	{
+		aZ = (aZ ^ (aZ >> 30)) * 0xbf58476d1ce4e5b9ull;
+		aZ = (aZ ^ (aZ >> 27)) * 0x94d049bb133111ebull;
+		return aZ ^ (aZ >> 31);
+	}
+}
+
+inline
+CounterRNG::CounterRNG( std::uint64_t aSeed ) noexcept
+{
+	seed( aSeed );
+}
+
+inline
+CounterRNG::result_type CounterRNG::operator() () noexcept
+{
+	return at( mCounter++ );
+}
+
+inline
+CounterRNG::result_type CounterRNG::at( std::uint64_t aCounter ) const noexcept
+{
+	return detail::splitmix64_mix( mKey + (aCounter+1) * detail::kRNGGamma );
+}
+
+inline
+void CounterRNG::seed( std::uint64_t aSeed ) noexcept
+{
+	// Mix the seed, so that similar seeds (e.g., 1, 2, 3) give unrelated keys
+	mKey = detail::splitmix64_mix( aSeed ^ 0x6a09e667f3bcc909ull );
+	mCounter = 0;
+}
+
+inline
+void CounterRNG::discard( std::uint64_t aCount ) noexcept
+{
+	mCounter += aCount;
+}
+
+inline
+std::uint64_t CounterRNG::counter() const noexcept
+{
+	return mCounter;
+}
+
+inline
+CounterRNG CounterRNG::fork() noexcept
+{
+	return CounterRNG( (*this)() );
+}
+
+
+template< class tRNG > inline
+void fill_uniform( tRNG& aRNG, float* aOut, std::size_t aCount, float aMin, float aMax )
+{
+	std::uniform_real_distribution<float> dist( aMin, aMax );
+	for( std::size_t i = 0; i < aCount; ++i )
+		aOut[i] = dist( aRNG );
+}
+template< class tRNG > inline
+void fill_normal( tRNG& aRNG, float* aOut, std::size_t aCount, float aMean, float aStddev )
+{
+	std::normal_distribution<float> dist( aMean, aStddev );
+	for( std::size_t i = 0; i < aCount; ++i )
+		aOut[i] = dist( aRNG );
+}
+
+inline
+void fill_uniform( CounterRNG& aRNG, float* aOut, std::size_t aCount, float aMin, float aMax ) noexcept
+{
+	aRNG.fill_uniform( aOut, aCount, aMin, aMax );
+}
+inline
+void fill_normal( CounterRNG& aRNG, float* aOut, std::size_t aCount, float aMean, float aStddev ) noexcept
+{
+	aRNG.fill_normal( aOut, aCount, aMean, aStddev );
+}
+
+template< class tRNG > inline
+tRNG fork_rng( tRNG& aParent )
+{
+	return tRNG( typename tRNG::result_type( aParent() ) );
+}
+
+inline
+CounterRNG fork_rng( CounterRNG& aParent ) noexcept
+{
+	return aParent.fork();
+}
@@ -0,0 +1,162 @@
+#include "simulation.hpp"
+
+#include <utility>
+#include <algorithm>
+
+#include "../vmlib/mat22.hpp"
+
+Simulation::Simulation( AsteroidField& aAsteroids, std::uint32_t aWidth, std::uint32_t aHeight, std::vector<Vec2f> aShipOutline, unsigned aStepsPerSecond )
+	: mAsteroids( aAsteroids )
+	, mShipOutline( std::move(aShipOutline) )
+	, mStep( std::chrono::duration_cast<Clock::duration>( std::chrono::duration<double>( 1.0 / std::max( 1u, aStepsPerSecond ) ) ) )
+	, mStepCount( 0 )
+	, mWidth( aWidth )
+	, mHeight( aHeight )
+	, mNewWidth( aWidth )
+	, mNewHeight( aHeight )
+{
+	// Both published snapshots start out as the initial state
+	mCurrent.time = Clock::now();
+	mAsteroids.snapshot( mCurrent.asteroids );
+	mPrevious = mCurrent;
+
+	mThread = std::thread( [this] { run_(); } );
+}
+
+Simulation::~Simulation()
+{
+	{
+		std::unique_lock<std::mutex> lock( mMutex );
+		mStopping = true;
+	}
+
+	mCondition.notify_all();
+	mThread.join();
+}
+
+
+void Simulation::set_controls( float aAngle, float aAccelerationMagnitude )
+{
+	std::unique_lock<std::mutex> lock( mMutex );
+	mAngle = aAngle;
+	mAcceleration = aAccelerationMagnitude;
+}
+
+void Simulation::resize( std::uint32_t aWidth, std::uint32_t aHeight )
+{
+	std::unique_lock<std::mutex> lock( mMutex );
+	mResized = true;
+	mNewWidth = aWidth;
+	mNewHeight = aHeight;
+}
+
+float Simulation::acquire( Snapshot& aPrevious, Snapshot& aCurrent, Clock::time_point aNow )
+{
+	{
+		std::unique_lock<std::mutex> lock( mMutex );
+
+		if( mError )
+			std::rethrow_exception( mError );
+
+		// Copy assignment reuses the vectors' storage
+		aPrevious = mPrevious;
+		aCurrent = mCurrent;
+	}
+
+	if( aPrevious.step == aCurrent.step )
+		return 1.f;
+
+	// Show the state from one step ago. By then, the snapshot after it is
+	// usually available.
+	auto const shown = aNow - mStep;
+	auto const alpha = Secondsf(shown - aPrevious.time).count() / Secondsf(aCurrent.time - aPrevious.time).count();
+	return std::clamp( alpha, 0.f, 1.f );
+}
+
+Secondsf Simulation::step_duration() const noexcept
+{
+	return std::chrono::duration_cast<Secondsf>(mStep);
+}
+
+
+void Simulation::run_()
+{
+	try
+	{
+		auto const maxLag = std::chrono::duration_cast<Clock::duration>( Secondsf( kMaxLagSeconds ) );
+
+		// Not shared; only the simulation thread modifies mCurrent
+		auto next = mCurrent.time;
+
+		for( ;; )
+		{
+			next += mStep;
+
+			bool resized;
+			std::uint32_t width, height;
+
+			{
+				std::unique_lock<std::mutex> lock( mMutex );
+				mCondition.wait_until( lock, next, [this] { return mStopping; } );
+
+				if( mStopping )
+					return;
+
+				mState.player.angle = mAngle;
+				mState.player.accelerationMagnitude = mAcceleration;
+
+				resized = mResized;
+				width = mNewWidth;
+				height = mNewHeight;
+				mResized = false;
+			}
+
+			if( resized )
+			{
+				mWidth = width;
+				mHeight = height;
+				mAsteroids.resize( width, height );
+			}
+
+			step_( next );
+
+			// Publish: the current snapshot becomes the previous one, and the
+			// old previous one is reused for the next step.
+			{
+				std::unique_lock<std::mutex> lock( mMutex );
+				std::swap( mPrevious, mBack );
+				std::swap( mPrevious, mCurrent );
+			}
+
+			// Don't try to catch up after long stalls (e.g., when the process
+			// was suspended). Skip ahead instead.
+			auto const now = Clock::now();
+			if( now - next > maxLag )
+				next = now;
+		}
+	}
+	catch( ... )
+	{
+		std::unique_lock<std::mutex> lock( mMutex );
+		mError = std::current_exception();
+	}
+}
+
+void Simulation::step_( Clock::time_point aTime )
+{
+	auto const dt = std::chrono::duration_cast<Secondsf>(mStep).count();
+
+	state_update( mState, dt );
+	mAsteroids.update( mState.thisFrame.dt, mState.thisFrame.movement );
+
+	// The ship is always at the center of the screen
+	auto const rot = make_rotation_2d( mState.player.angle );
+	auto const offs = Vec2f{ mWidth*0.5f, mHeight*0.5f };
+
+	mBack.step = ++mStepCount;
+	mBack.time = aTime;
+	mBack.playerPosition = mState.player.position;
+	mBack.shipHit = mAsteroids.hit_test( mShipOutline.size(), mShipOutline.data(), rot, offs );
+
+	mAsteroids.snapshot( mBack.asteroids );
+}
@@ -0,0 +1,114 @@
+#ifndef SIMULATION_HPP_2A6D9E13_85B7_4C0F_B3E8_51F7C4A09D62
+#define SIMULATION_HPP_2A6D9E13_85B7_4C0F_B3E8_51F7C4A09D62
+
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <exception>
+#include <condition_variable>
+
+#include <cstdint>
+
+#include "../vmlib/vec2.hpp"
+
+#include "state.hpp"
+#include "defaults.hpp"
+#include "asteroid_field.hpp"
+
+/** Fixed time step simulation on a dedicated thread
+ *
+ * The simulation advances the player and the asteroid field in fixed steps of
+ * 1/aStepsPerSecond seconds, independently of the frame rate. After each
+ * step, it publishes a snapshot of the results. The renderer picks up the two
+ * most recent snapshots with acquire() and interpolates between them. This
+ * delays what is shown by up to one step, but motion stays smooth even if
+ * frame rate and simulation rate don't match.
+ *
+ * Snapshots are double buffered: the simulation thread fills a third one
+ * while the renderer copies the published pair. The mutex is only held to
+ * swap or copy the snapshots, so update and draw overlap.
+ *
+ * The AsteroidField belongs to the simulation thread while the Simulation
+ * exists. The renderer may only use the snapshot version of
+ * AsteroidField::draw(). Inputs are passed with set_controls() and resize().
+ */
+class Simulation final
+{
+	public:
+		struct Snapshot
+		{
+			std::uint64_t step = 0;
+			Clock::time_point time; // time that the snapshot corresponds to
+
+			Vec2f playerPosition = { 0.f, 0.f };
+			bool shipHit = false;
+
+			std::vector<AsteroidField::Pose> asteroids;
+		};
+
+	public:
+		Simulation(
+			AsteroidField&,
+			std::uint32_t aWidth, std::uint32_t aHeight,
+			std::vector<Vec2f> aShipOutline,
+			unsigned aStepsPerSecond
+		);
+		~Simulation();
+
+		Simulation( Simulation const& ) = delete;
+		Simulation& operator= (Simulation const&) = delete;
+
+	public:
+		// Player controls, see state_update()
+		void set_controls( float aAngle, float aAccelerationMagnitude );
+
+		// The asteroid field is resized before the next step
+		void resize( std::uint32_t aWidth, std::uint32_t aHeight );
+
+		// Copy the two most recent snapshots, and return the interpolation
+		// factor between them for aNow. If the simulation thread failed, this
+		// rethrows its exception.
+		float acquire( Snapshot& aPrevious, Snapshot& aCurrent, Clock::time_point aNow );
+
+	public:
+		Secondsf step_duration() const noexcept;
+
+	private:
+		void run_();
+		void step_( Clock::time_point aTime );
+
+	private:
+		AsteroidField& mAsteroids;
+		std::vector<Vec2f> mShipOutline;
+
+		Clock::duration mStep;
+
+		// Simulation thread only
+		State mState;
+		std::uint64_t mStepCount;
+		std::uint32_t mWidth, mHeight;
+		Snapshot mBack;
+
+		// Shared; protected by mMutex
+		std::mutex mMutex;
+		std::condition_variable mCondition;
+
+		float mAngle = 0.f, mAcceleration = 0.f;
+
+		bool mResized = false;
+		std::uint32_t mNewWidth, mNewHeight;
+
+		Snapshot mPrevious, mCurrent;
+
+		bool mStopping = false;
+		std::exception_ptr mError;
+
+		std::thread mThread;
+
+	public: // Configuration values
+		// If the simulation falls behind by more than this, it skips ahead
+		// instead of trying to catch up.
+		static constexpr float kMaxLagSeconds = 0.25f;
+};
+
+#endif // SIMULATION_HPP_2A6D9E13_85B7_4C0F_B3E8_51F7C4A09D62
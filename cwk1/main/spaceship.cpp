@@ -1,5 +1,7 @@
 #include "spaceship.hpp"
 
+#include <iterator>
+
 #include <cstdio>
 
 #include "../draw2d/shape.hpp"
@@ -44,6 +46,12 @@
 #define SPACESHIP SPACESHIP_CUSTOM
 
 LineStrip make_spaceship_shape()
+{
+    auto const outline = make_spaceship_outline();
+    return LineStrip( outline.size(), outline.data() );
+}
+
+std::vector<Vec2f> make_spaceship_outline()
 {
 #if SPACESHIP == SPACESHIP_CUSTOM
     static constexpr Vec2f customPoints[] = {
@@ -60,7 +68,7 @@ LineStrip make_spaceship_shape()
         { -20.0f, -40.0f }, // Start of the wing curve back to the nose
         { 0.0f, 0.0f } // Back to the nose to close the shape
     };
-    return LineStrip(customPoints);
+    return std::vector<Vec2f>( std::begin(customPoints), std::end(customPoints) );
 #elif SPACESHIP == SPACESHIP_DEFAULT
     static constexpr float xs[] = { 250.f, 200.f, 150.f, 100.f, 000.f, 040.f, -50.f, -140.f, -170.f };
     static constexpr float ys[] = { 190.f, 180.f, 70.f, 50.f, 30.f, 20.f };
@@ -87,7 +95,7 @@ LineStrip make_spaceship_shape()
         { 0.2f * xs[0], 0.2f * -ys[5] },
         { 0.2f * xs[0], 0.2f * +ys[5] }
     };
-    return LineStrip(defaultPoints);
+    return std::vector<Vec2f>( std::begin(defaultPoints), std::end(defaultPoints) );
 #endif
 }
 
@@ -1,8 +1,17 @@
 #ifndef SPACESHIP_HPP_30CB4518_A56A_4057_8B9A_49A9A868E9C2
 #define SPACESHIP_HPP_30CB4518_A56A_4057_8B9A_49A9A868E9C2
 
+#include <vector>
+
 #include "../draw2d/forward.hpp"
 
+#include "../vmlib/vec2.hpp"
+
 LineStrip make_spaceship_shape();
 
+// Points of the spaceship's shape; the LineStrip returned by
+// make_spaceship_shape() connects these in order. The last point repeats the
+// first one to close the shape.
+std::vector<Vec2f> make_spaceship_outline();
+
 #endif // SPACESHIP_HPP_30CB4518_A56A_4057_8B9A_49A9A868E9C2
@@ -0,0 +1,88 @@
+#include "stats_overlay.hpp"
+
+#include <string>
+#include <algorithm>
+
+#include <cstdio>
+
+#include "../draw2d/surface.hpp"
+
+namespace
+{
+	using Millisecondsf_ = std::chrono::duration<float, std::milli>;
+}
+
+StatsOverlay::StatsOverlay( std::uint32_t aWidth, std::uint32_t aHeight )
+	: mHeight( 0 )
+	, mStageTotals{}
+	, mFrames( 0 )
+	, mWindowStart( Clock::now() )
+{
+	resize( aWidth, aHeight );
+	mText.set( *mFont, "FPS --" );
+}
+
+void StatsOverlay::resize( std::uint32_t, std::uint32_t aHeight )
+{
+	mHeight = aHeight;
+
+	auto const scale = 1 + aHeight / kScaleHeight;
+	if( mFont && mFont->scale() == scale )
+		return;
+
+	mFont = std::make_unique<BitmapFont>( kColor, scale );
+
+	// Lay the current text out with the new font
+	std::string const text( mText.text() );
+	mText.set( *mFont, text );
+}
+
+void StatsOverlay::record( EStage aStage, Clock::duration aTime )
+{
+	mStageTotals[std::size_t(aStage)] += aTime;
+}
+
+void StatsOverlay::end_frame( Clock::time_point aNow )
+{
+	++mFrames;
+
+	auto const elapsed = std::chrono::duration_cast<Millisecondsf_>( aNow - mWindowStart ).count();
+	if( elapsed < 1000.f * kRefreshSeconds )
+		return;
+
+	auto const frames = float(mFrames);
+	auto const average = [&] (EStage aStage) {
+		return std::chrono::duration_cast<Millisecondsf_>( mStageTotals[std::size_t(aStage)] ).count() / frames;
+	};
+
+	char buffer[256];
+	std::snprintf( buffer, sizeof(buffer),
+		"FPS %6.1f %6.2f MS\n"
+		"UPDATE  %6.2f MS\n"
+		"DRAW    %6.2f MS\n"
+		"PRESENT %6.2f MS\n"
+		"STATS   %6.2f MS",
+		1000.f * frames / elapsed, elapsed / frames,
+		average( EStage::update ),
+		average( EStage::draw ),
+		average( EStage::present ),
+		average( EStage::overlay )
+	);
+
+	mText.set( *mFont, buffer );
+
+	std::fill( std::begin( mStageTotals ), std::end( mStageTotals ), Clock::duration{} );
+	mFrames = 0;
+	mWindowStart = aNow;
+
+	// Formatting is part of the overlay's cost; it is counted towards the
+	// next window.
+	mStageTotals[std::size_t(EStage::overlay)] = Clock::now() - aNow;
+}
+
+void StatsOverlay::draw( Surface& aSurface ) const
+{
+	// Top-left corner; y points upwards
+	auto const margin = float(kMargin * mFont->scale());
+	mText.draw( aSurface, Vec2f{ margin, float(mHeight) - margin } );
+}
@@ -0,0 +1,77 @@
+#ifndef STATS_OVERLAY_HPP_9D0F4B6E_73A2_4C18_A5E9_2B61C8F0D374
+#define STATS_OVERLAY_HPP_9D0F4B6E_73A2_4C18_A5E9_2B61C8F0D374
+
+#include <chrono>
+#include <memory>
+
+#include <cstdint>
+
+#include "../draw2d/forward.hpp"
+#include "../draw2d/text.hpp"
+
+/** Frame statistics overlay
+ *
+ * Shows the frame rate and the average time of the main stages of a frame
+ * in the top-left corner of the surface. The averages are taken over
+ * kRefreshSeconds; the text is only formatted and laid out again at that
+ * rate. Other frames just draw the laid out glyphs.
+ *
+ * The font is scaled with the surface height, so that the text remains
+ * readable on large (e.g., 4K and 8K) surfaces.
+ */
+class StatsOverlay
+{
+	public:
+		using Clock = std::chrono::steady_clock;
+
+		enum class EStage
+		{
+			update,
+			draw,
+			present,
+			overlay,
+
+			count
+		};
+
+	public:
+		StatsOverlay( std::uint32_t aWidth, std::uint32_t aHeight );
+
+		StatsOverlay( StatsOverlay const& ) = delete;
+		StatsOverlay& operator= (StatsOverlay const&) = delete;
+
+	public:
+		void resize( std::uint32_t aWidth, std::uint32_t aHeight );
+
+		// Add the time of a stage to the current frame
+		void record( EStage, Clock::duration );
+
+		// End the current frame. Refreshes the text every kRefreshSeconds.
+		void end_frame( Clock::time_point aNow );
+
+		void draw( Surface& ) const;
+
+	public: // Configuration values
+		static constexpr float kRefreshSeconds = 0.5f;
+
+		// The font is scaled by one more for each kScaleHeight pixels of
+		// surface height
+		static constexpr std::uint32_t kScaleHeight = 1080;
+
+		// Distance from the surface's edges, in font pixels
+		static constexpr std::uint32_t kMargin = 4;
+
+		static constexpr ColorU8_sRGB kColor{ 255, 255, 128 };
+
+	private:
+		std::uint32_t mHeight;
+
+		std::unique_ptr<BitmapFont> mFont;
+		TextRun mText;
+
+		Clock::duration mStageTotals[std::size_t(EStage::count)];
+		std::uint64_t mFrames;
+		Clock::time_point mWindowStart;
+};
+
+#endif // STATS_OVERLAY_HPP_9D0F4B6E_73A2_4C18_A5E9_2B61C8F0D374
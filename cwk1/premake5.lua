@@ -107,14 +107,24 @@ project "draw2d"
 
 project "support"
 	local sources = { 
+		"support/alloc_counter.cpp",
 		"support/checkpoint.cpp",
 		--"support/context.cpp", -- separate implementation on Apple
 		"support/error.cpp",
+		"support/frame_arena.cpp",
+		"support/profiler.cpp",
 		"support/runconfig.cpp",
+		"support/task_pool.cpp",
+		"support/alloc_counter.hpp",
 		"support/checkpoint.hpp",
 		"support/context.hpp",
 		"support/error.hpp",
+		"support/frame_arena.hpp",
+		"support/frame_arena.inl",
+		"support/profiler.hpp",
 		"support/runconfig.hpp",
+		"support/task_pool.hpp",
+		"support/task_pool.inl",
 	}
 
 	kind "StaticLib"
@@ -219,7 +229,9 @@ project "triangles-test"
 
 	links "vmlib"
 	links "draw2d"
+	links "support"
 
+	links "x-stb"
 	links "x-catch2"
 
 project "blit-benchmark"
@@ -260,4 +272,36 @@ project "lines-benchmark"
 
 	links "x-benchmark"
 
+project "sim-benchmark"
+	local sources = { 
+		"sim-benchmark/**.cpp",
+		"sim-benchmark/**.hpp",
+		"sim-benchmark/**.hxx",
+		"sim-benchmark/**.inl",
+
+		-- Simulation code from main (without main.cpp, which needs a window)
+		"main/asteroid.cpp",
+		"main/asteroid.hpp",
+		"main/asteroid_field.cpp",
+		"main/asteroid_field.hpp",
+		"main/collision_grid.cpp",
+		"main/collision_grid.hpp",
+		"main/defaults.hpp",
+		"main/particle_field.cpp",
+		"main/particle_field.hpp",
+		"main/rng.cpp",
+		"main/rng.hpp",
+		"main/rng.inl"
+	}
+
+	kind "ConsoleApp"
+	location "sim-benchmark"
+
+	files( sources )
+
+	links "vmlib"
+	links "draw2d"
+
+	links "x-benchmark"
+
 --EOF
@@ -0,0 +1,418 @@
+#include <benchmark/benchmark.h>
+
+#include <random>
+#include <vector>
+
+#include <cmath>
+#include <cstdint>
+
+#include "../draw2d/shape.hpp"
+#include "../draw2d/surface.hpp"
+#include "../draw2d/instances.hpp"
+#include "../draw2d/multisample.hpp"
+
+#include "../main/defaults.hpp"
+#include "../main/asteroid.hpp"
+#include "../main/particle_field.hpp"
+#include "../main/asteroid_field.hpp"
+
+namespace
+{
+	// Interactive resizing: the window is dragged smaller by kResizeSteps
+	// steps of kResizeStep pixels, and then back to its original size.
+	constexpr std::uint32_t kResizeSteps = 16;
+	constexpr std::uint32_t kResizeStep = 8;
+
+	template< class tField >
+	void resize_sequence_( tField& aField, std::uint32_t aWidth, std::uint32_t aHeight )
+	{
+		for( std::uint32_t i = 1; i <= kResizeSteps; ++i )
+			aField.resize( aWidth - i*kResizeStep, aHeight - i*kResizeStep );
+		for( std::uint32_t i = kResizeSteps; i-- > 0; )
+			aField.resize( aWidth - i*kResizeStep, aHeight - i*kResizeStep );
+	}
+
+	enum class EAntialiasing_
+	{
+		none,
+		msaa4x,    // MultisampleSurface + resolve()
+		doubled    // twice the resolution + 2x2 box filter (in linear light)
+	};
+
+	void downsample_2x_( Surface const& aSource, Surface& aTarget )
+	{
+		static auto const linear = [] {
+			std::vector<float> ret( 256 );
+			for( std::uint32_t i = 0; i < 256; ++i )
+				ret[i] = linear_from_srgb( std::uint8_t(i) );
+			return ret;
+		}();
+
+		auto const* src = aSource.get_surface_ptr();
+		for( Surface::Index y = 0; y < aTarget.get_height(); ++y )
+		{
+			for( Surface::Index x = 0; x < aTarget.get_width(); ++x )
+			{
+				auto const i0 = aSource.get_linear_index( 2*x, 2*y ), i1 = aSource.get_linear_index( 2*x, 2*y+1 );
+
+				float sum[3];
+				for( std::size_t c = 0; c < 3; ++c )
+					sum[c] = linear[src[i0+c]] + linear[src[i0+4+c]] + linear[src[i1+c]] + linear[src[i1+4+c]];
+
+				aTarget.set_pixel_srgb( x, y, linear_to_srgb( ColorF{ 0.25f*sum[0], 0.25f*sum[1], 0.25f*sum[2] } ) );
+			}
+		}
+	}
+}
+
+void benchmark_particle_field_resize( benchmark::State& aState, float aDensity )
+{
+	auto const width = std::uint32_t(aState.range(0));
+	auto const height = std::uint32_t(aState.range(1));
+
+	RNG rng( 0 );
+	ParticleField field( rng, width, height, ColorF{ 1.f, 1.f, 1.f }, aDensity );
+
+	for( auto _ : aState )
+	{
+		resize_sequence_( field, width, height );
+		benchmark::ClobberMemory();
+	}
+
+	aState.SetItemsProcessed( 2 * kResizeSteps * aState.iterations() );
+}
+
+void benchmark_particle_field_update( benchmark::State& aState, float aDensity, bool aScrolled )
+{
+	auto const width = std::uint32_t(aState.range(0));
+	auto const height = std::uint32_t(aState.range(1));
+
+	RNG rng( 0 );
+	ParticleField field( rng, width, height, ColorF{ 1.f, 1.f, 1.f }, aDensity );
+	field.set_layer_scroll( aScrolled );
+
+	// Diagonal movement, such that particles leave through all kinds of
+	// edges (the sign flips every few frames).
+	std::size_t frame = 0;
+	for( auto _ : aState )
+	{
+		float const sign = (frame++ & 64) ? -1.f : 1.f;
+		field.update( Vec2f{ sign * 7.3f, sign * 4.1f } );
+		benchmark::ClobberMemory();
+	}
+
+	aState.SetItemsProcessed( aState.iterations() );
+}
+
+void benchmark_particle_field_frame( benchmark::State& aState, float aDensity, bool aScrolled )
+{
+	auto const width = std::uint32_t(aState.range(0));
+	auto const height = std::uint32_t(aState.range(1));
+
+	RNG rng( 0 );
+	ParticleField field( rng, width, height, ColorF{ 1.f, 1.f, 1.f }, aDensity );
+	field.set_layer_scroll( aScrolled );
+
+	Surface surface( width, height );
+	surface.clear();
+
+	// Slow drift, like the background's far fields. The surface is not
+	// cleared; the particles just overwrite pixels.
+	for( auto _ : aState )
+	{
+		field.update( Vec2f{ 1.3f, 0.7f } );
+		field.draw( surface );
+		benchmark::ClobberMemory();
+	}
+
+	aState.SetItemsProcessed( aState.iterations() );
+}
+
+void benchmark_asteroid_field_resize( benchmark::State& aState, float aDensity )
+{
+	auto const width = std::uint32_t(aState.range(0));
+	auto const height = std::uint32_t(aState.range(1));
+
+	RNG rng( 0 );
+	AsteroidField field( rng, width, height, aDensity );
+
+	for( auto _ : aState )
+	{
+		resize_sequence_( field, width, height );
+		benchmark::ClobberMemory();
+	}
+
+	aState.SetItemsProcessed( 2 * kResizeSteps * aState.iterations() );
+}
+
+void benchmark_asteroid_field_update( benchmark::State& aState, float aDensity, bool aVaryingStep )
+{
+	auto const width = std::uint32_t(aState.range(0));
+	auto const height = std::uint32_t(aState.range(1));
+
+	RNG rng( 0 );
+	AsteroidField field( rng, width, height, aDensity );
+
+	// A varying time step forces the rotation steps to be recomputed each
+	// update.
+	float const steps[2] = { 1.f/60.f, aVaryingStep ? 1.f/59.f : 1.f/60.f };
+
+	std::size_t frame = 0;
+	for( auto _ : aState )
+	{
+		field.update( steps[frame++ & 1], Vec2f{ 1.f, 0.5f } );
+		benchmark::ClobberMemory();
+	}
+}
+
+void benchmark_asteroid_contacts( benchmark::State& aState, float aDensity, AsteroidField::EBroadPhase aBroadPhase, bool aExact )
+{
+	auto const width = std::uint32_t(aState.range(0));
+	auto const height = std::uint32_t(aState.range(1));
+
+	RNG rng( 0 );
+	AsteroidField field( rng, width, height, aDensity );
+	field.set_exact_collisions( aExact );
+
+	std::vector<AsteroidField::Contact> contacts;
+	for( auto _ : aState )
+	{
+		field.find_contacts( contacts, aBroadPhase );
+		benchmark::DoNotOptimize( contacts.data() );
+		benchmark::ClobberMemory();
+	}
+
+	aState.counters["contacts"] = double(contacts.size());
+}
+
+void benchmark_fan_instances( benchmark::State& aState, bool aInstanced, EInstanceFill aFill )
+{
+	auto const width = std::uint32_t(aState.range(0));
+	auto const height = std::uint32_t(aState.range(1));
+	auto const count = std::size_t(aState.range(2));
+
+	Surface surface( width, height );
+	surface.clear();
+
+	RNG rng( 0 );
+	auto const shape = make_asteroid( rng );
+
+	// Random instances, some of which overlap the edges (or are entirely
+	// outside) of the surface
+	std::uniform_real_distribution<float> xpos( -64.f, width + 64.f );
+	std::uniform_real_distribution<float> ypos( -64.f, height + 64.f );
+	std::uniform_real_distribution<float> angle( 0.f, 6.2831853f );
+	std::uniform_real_distribution<float> scale( 0.5f, 1.5f );
+
+	std::vector<ShapeInstance> instances( count );
+	for( auto& inst : instances )
+	{
+		float const a = angle( rng ), s = scale( rng );
+		float const c = s * std::cos( a ), d = s * std::sin( a );
+
+		inst.transform = Mat22f{ c, -d, d, c };
+		inst.translation = Vec2f{ xpos( rng ), ypos( rng ) };
+	}
+
+	for( auto _ : aState )
+	{
+		if( aInstanced )
+		{
+			draw_instances( surface, shape, instances.size(), instances.data(), aFill );
+		}
+		else
+		{
+			for( auto const& inst : instances )
+				shape.draw( surface, inst.transform, inst.translation );
+		}
+
+		benchmark::ClobberMemory();
+	}
+
+	aState.SetItemsProcessed( count * aState.iterations() );
+}
+
+void benchmark_fan_antialiasing( benchmark::State& aState, EAntialiasing_ aMode )
+{
+	auto const width = std::uint32_t(aState.range(0));
+	auto const height = std::uint32_t(aState.range(1));
+	auto const count = std::size_t(aState.range(2));
+
+	Surface surface( width, height );
+	MultisampleSurface multisample( aMode == EAntialiasing_::msaa4x ? width : 1, aMode == EAntialiasing_::msaa4x ? height : 1 );
+	Surface doubled( aMode == EAntialiasing_::doubled ? 2*width : 1, aMode == EAntialiasing_::doubled ? 2*height : 1 );
+
+	RNG rng( 0 );
+	auto const shape = make_asteroid( rng );
+
+	std::uniform_real_distribution<float> xpos( 0.f, float(width) );
+	std::uniform_real_distribution<float> ypos( 0.f, float(height) );
+	std::uniform_real_distribution<float> angle( 0.f, 6.2831853f );
+
+	// Same instances, scaled for the doubled surface
+	std::vector<ShapeInstance> instances( count ), scaled( count );
+	for( std::size_t i = 0; i < count; ++i )
+	{
+		float const a = angle( rng );
+		float const c = std::cos( a ), d = std::sin( a );
+
+		instances[i].transform = Mat22f{ c, -d, d, c };
+		instances[i].translation = Vec2f{ xpos( rng ), ypos( rng ) };
+
+		scaled[i].transform = Mat22f{ 2.f*c, -2.f*d, 2.f*d, 2.f*c };
+		scaled[i].translation = 2.f * instances[i].translation;
+	}
+
+	for( auto _ : aState )
+	{
+		switch( aMode )
+		{
+			case EAntialiasing_::none:
+				surface.clear();
+				for( auto const& inst : instances )
+					shape.draw( surface, inst.transform, inst.translation );
+				break;
+
+			case EAntialiasing_::msaa4x:
+			{
+				multisample.clear();
+				{
+					ScopedMultisample scope( multisample );
+					for( auto const& inst : instances )
+						shape.draw( surface, inst.transform, inst.translation );
+				}
+				multisample.resolve( surface );
+				break;
+			}
+
+			case EAntialiasing_::doubled:
+				doubled.clear();
+				for( auto const& inst : scaled )
+					shape.draw( doubled, inst.transform, inst.translation );
+				downsample_2x_( doubled, surface );
+				break;
+		}
+
+		benchmark::ClobberMemory();
+	}
+
+	aState.SetItemsProcessed( count * aState.iterations() );
+}
+
+// Densities: the background's near field, and a much denser field.
+BENCHMARK_CAPTURE( benchmark_particle_field_resize, near, 0.00013f )
+	->Args( { 1920, 1080 } )
+	->Args( { 3840, 2160 } )
+;
+BENCHMARK_CAPTURE( benchmark_particle_field_resize, dense, 0.01f )
+	->Args( { 1920, 1080 } )
+	->Args( { 3840, 2160 } )
+;
+
+// Moving each particle vs. scrolled layers (see
+// ParticleField::set_layer_scroll())
+BENCHMARK_CAPTURE( benchmark_particle_field_update, near, 0.00013f, false )
+	->Args( { 1920, 1080 } )
+	->Args( { 3840, 2160 } )
+;
+BENCHMARK_CAPTURE( benchmark_particle_field_update, near_scrolled, 0.00013f, true )
+	->Args( { 1920, 1080 } )
+	->Args( { 3840, 2160 } )
+;
+BENCHMARK_CAPTURE( benchmark_particle_field_update, dense, 0.01f, false )
+	->Args( { 1920, 1080 } )
+	->Args( { 3840, 2160 } )
+;
+BENCHMARK_CAPTURE( benchmark_particle_field_update, dense_scrolled, 0.01f, true )
+	->Args( { 1920, 1080 } )
+	->Args( { 3840, 2160 } )
+;
+
+BENCHMARK_CAPTURE( benchmark_particle_field_frame, far, 8e-5f, false )
+	->Args( { 1920, 1080 } )
+	->Args( { 3840, 2160 } )
+;
+BENCHMARK_CAPTURE( benchmark_particle_field_frame, far_scrolled, 8e-5f, true )
+	->Args( { 1920, 1080 } )
+	->Args( { 3840, 2160 } )
+;
+BENCHMARK_CAPTURE( benchmark_particle_field_frame, dense, 0.01f, false )
+	->Args( { 1920, 1080 } )
+	->Args( { 3840, 2160 } )
+;
+BENCHMARK_CAPTURE( benchmark_particle_field_frame, dense_scrolled, 0.01f, true )
+	->Args( { 1920, 1080 } )
+	->Args( { 3840, 2160 } )
+;
+
+// Densities: the default asteroid field, and a much denser field.
+BENCHMARK_CAPTURE( benchmark_asteroid_field_resize, default, 1e-5f )
+	->Args( { 1920, 1080 } )
+	->Args( { 3840, 2160 } )
+;
+BENCHMARK_CAPTURE( benchmark_asteroid_field_resize, dense, 1e-3f )
+	->Args( { 1920, 1080 } )
+	->Args( { 3840, 2160 } )
+;
+
+BENCHMARK_CAPTURE( benchmark_asteroid_field_update, fixed_dt, 1e-3f, false )
+	->Args( { 3840, 2160 } )
+;
+BENCHMARK_CAPTURE( benchmark_asteroid_field_update, varying_dt, 1e-3f, true )
+	->Args( { 3840, 2160 } )
+;
+
+// Broad phase. 1e-3 gives about 12k asteroids at 4K, 3e-3 about 37k. The
+// all-pairs reference is quadratic, and skips the largest case.
+BENCHMARK_CAPTURE( benchmark_asteroid_contacts, grid_bounds, 1e-3f, AsteroidField::EBroadPhase::grid, false )
+	->Args( { 1920, 1080 } )
+	->Args( { 3840, 2160 } )
+	->Unit( benchmark::kMicrosecond )
+;
+BENCHMARK_CAPTURE( benchmark_asteroid_contacts, all_pairs_bounds, 1e-3f, AsteroidField::EBroadPhase::allPairs, false )
+	->Args( { 1920, 1080 } )
+	->Args( { 3840, 2160 } )
+	->Unit( benchmark::kMicrosecond )
+;
+BENCHMARK_CAPTURE( benchmark_asteroid_contacts, grid_exact, 1e-3f, AsteroidField::EBroadPhase::grid, true )
+	->Args( { 1920, 1080 } )
+	->Args( { 3840, 2160 } )
+	->Unit( benchmark::kMicrosecond )
+;
+BENCHMARK_CAPTURE( benchmark_asteroid_contacts, grid_bounds_dense, 3e-3f, AsteroidField::EBroadPhase::grid, false )
+	->Args( { 3840, 2160 } )
+	->Unit( benchmark::kMicrosecond )
+;
+
+// Instanced drawing vs. one TriangleFan::draw() per instance
+BENCHMARK_CAPTURE( benchmark_fan_instances, loop, false, EInstanceFill::exact )
+	->Args( { 1920, 1080, 1000 } )
+	->Args( { 1920, 1080, 10000 } )
+	->Unit( benchmark::kMicrosecond )
+;
+BENCHMARK_CAPTURE( benchmark_fan_instances, instanced, true, EInstanceFill::exact )
+	->Args( { 1920, 1080, 1000 } )
+	->Args( { 1920, 1080, 10000 } )
+	->Unit( benchmark::kMicrosecond )
+;
+BENCHMARK_CAPTURE( benchmark_fan_instances, instanced_shared, true, EInstanceFill::shared )
+	->Args( { 1920, 1080, 1000 } )
+	->Args( { 1920, 1080, 10000 } )
+	->Unit( benchmark::kMicrosecond )
+;
+
+// Antialiasing the asteroids: 4x MSAA vs. drawing at twice the resolution
+BENCHMARK_CAPTURE( benchmark_fan_antialiasing, none, EAntialiasing_::none )
+	->Args( { 1920, 1080, 1000 } )
+	->Unit( benchmark::kMillisecond )
+;
+BENCHMARK_CAPTURE( benchmark_fan_antialiasing, msaa4x, EAntialiasing_::msaa4x )
+	->Args( { 1920, 1080, 1000 } )
+	->Unit( benchmark::kMillisecond )
+;
+BENCHMARK_CAPTURE( benchmark_fan_antialiasing, doubled, EAntialiasing_::doubled )
+	->Args( { 1920, 1080, 1000 } )
+	->Unit( benchmark::kMillisecond )
+;
+
+BENCHMARK_MAIN();
@@ -0,0 +1,55 @@
+#include "alloc_counter.hpp"
+
+#include <atomic>
+#include <new>
+
+#include <cstdlib>
+
+namespace
+{
+	std::atomic<std::uint64_t> gAllocations{ 0 };
+}
+
+std::uint64_t allocation_count() noexcept
+{
+	return gAllocations.load( std::memory_order_relaxed );
+}
+
+#if !defined(NDEBUG)
+/* Replacements of the global allocation functions. Only the basic forms are
+ * replaced; the standard library implements the array and nothrow forms
+ * with these. Over-aligned allocations are not counted.
+ *
+ * The linker takes operator new from the first library that defines it, so
+ * the replacements are used by every (debug) program that links support,
+ * whether it calls allocation_count() or not.
+ */
+void* operator new( std::size_t aSize )
+{
+	gAllocations.fetch_add( 1, std::memory_order_relaxed );
+
+	// Like the standard operator new: call the new-handler until the
+	// allocation succeeds, and only throw if there is none.
+	for( ;; )
+	{
+		if( void* ptr = std::malloc( aSize ? aSize : 1 ) )
+			return ptr;
+
+		auto const handler = std::get_new_handler();
+		if( !handler )
+			throw std::bad_alloc();
+
+		handler();
+	}
+}
+
+void operator delete( void* aPtr ) noexcept
+{
+	std::free( aPtr );
+}
+
+void operator delete( void* aPtr, std::size_t ) noexcept
+{
+	std::free( aPtr );
+}
+#endif // ~ !NDEBUG
@@ -0,0 +1,24 @@
+#ifndef ALLOC_COUNTER_HPP_A81C3F06_4E9D_4B52_B7E3_0D6F92C154A8
+#define ALLOC_COUNTER_HPP_A81C3F06_4E9D_4B52_B7E3_0D6F92C154A8
+
+#include <cstdint>
+
+/** Heap allocation counter
+ *
+ * Debug builds replace the global operator new (see alloc_counter.cpp), and
+ * count the calls from all threads. This is used to check that steady-state
+ * frames do not allocate.
+ *
+ * Release builds do not count. There, kAllocationCounting is false, and
+ * allocation_count() always returns zero.
+ */
+#if !defined(NDEBUG)
+constexpr bool kAllocationCounting = true;
+#else // NDEBUG
+constexpr bool kAllocationCounting = false;
+#endif // ~ NDEBUG
+
+// Number of calls to the global operator new so far
+std::uint64_t allocation_count() noexcept;
+
+#endif // ALLOC_COUNTER_HPP_A81C3F06_4E9D_4B52_B7E3_0D6F92C154A8
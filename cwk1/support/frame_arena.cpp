@@ -0,0 +1,118 @@
+#include "frame_arena.hpp"
+
+#include <algorithm>
+
+#include <cassert>
+#include <cstdint>
+
+namespace
+{
+	// Offset of the first address at or after aBase + aOffset that is
+	// aligned to aAlignment
+	std::size_t aligned_offset_( std::byte const* aBase, std::size_t aOffset, std::size_t aAlignment ) noexcept;
+}
+
+FrameArena::FrameArena( std::size_t aBlockSize, std::pmr::memory_resource* aUpstream )
+	: mUpstream( aUpstream )
+	, mOffset( 0 )
+	, mUsed( 0 )
+{
+	assert( mUpstream );
+	add_block_( aBlockSize );
+}
+
+FrameArena::~FrameArena()
+{
+	release_blocks_();
+}
+
+
+void FrameArena::reset()
+{
+	// Merge the blocks of a frame that overflowed into one. Replacing the
+	// blocks allocates, but only until the arena is large enough.
+	if( mBlocks.size() > 1 )
+	{
+		std::size_t total = 0;
+		for( auto const& block : mBlocks )
+			total += block.size;
+
+		release_blocks_();
+		add_block_( total );
+	}
+
+	mOffset = 0;
+	mUsed = 0;
+}
+
+std::size_t FrameArena::used() const noexcept
+{
+	return mUsed;
+}
+
+std::size_t FrameArena::capacity() const noexcept
+{
+	std::size_t total = 0;
+	for( auto const& block : mBlocks )
+		total += block.size;
+
+	return total;
+}
+
+
+void* FrameArena::do_allocate( std::size_t aBytes, std::size_t aAlignment )
+{
+	assert( !mBlocks.empty() );
+
+	auto offset = aligned_offset_( mBlocks.back().data, mOffset, aAlignment );
+	if( offset + aBytes > mBlocks.back().size )
+	{
+		add_block_( std::max( aBytes + aAlignment, 2 * mBlocks.back().size ) );
+		mOffset = 0;
+
+		offset = aligned_offset_( mBlocks.back().data, 0, aAlignment );
+	}
+
+	mUsed += offset - mOffset + aBytes;
+	mOffset = offset + aBytes;
+
+	return mBlocks.back().data + offset;
+}
+
+void FrameArena::do_deallocate( void*, std::size_t, std::size_t ) noexcept
+{
+	// Memory is only released by reset()
+}
+
+bool FrameArena::do_is_equal( std::pmr::memory_resource const& aOther ) const noexcept
+{
+	return this == &aOther;
+}
+
+
+void FrameArena::add_block_( std::size_t aMinSize )
+{
+	auto const size = std::max( aMinSize, std::size_t(1) );
+	auto* data = static_cast<std::byte*>(mUpstream->allocate( size, alignof(std::max_align_t) ));
+
+	mBlocks.emplace_back( Block_{ data, size } );
+}
+
+void FrameArena::release_blocks_() noexcept
+{
+	for( auto const& block : mBlocks )
+		mUpstream->deallocate( block.data, block.size, alignof(std::max_align_t) );
+
+	mBlocks.clear();
+}
+
+
+namespace
+{
+	std::size_t aligned_offset_( std::byte const* aBase, std::size_t aOffset, std::size_t aAlignment ) noexcept
+	{
+		auto const base = reinterpret_cast<std::uintptr_t>(aBase);
+		auto const addr = (base + aOffset + aAlignment - 1) / aAlignment * aAlignment;
+		return std::size_t(addr - base);
+	}
+}
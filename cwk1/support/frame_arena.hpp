@@ -0,0 +1,83 @@
+#ifndef FRAME_ARENA_HPP_5D20B7E4_93A1_4C6F_8E0B_2A7F41C9D356
+#define FRAME_ARENA_HPP_5D20B7E4_93A1_4C6F_8E0B_2A7F41C9D356
+
+#include <vector>
+#include <memory_resource>
+
+#include <cstddef>
+
+/** Per-frame arena allocator
+ *
+ * Hands out memory by bumping an offset through large blocks. Individual
+ * deallocations are ignored; reset() releases everything at once. The main
+ * loop owns an arena and resets it at the start of each frame, so scratch
+ * memory for the frame does not go through the global allocator.
+ *
+ * FrameArena is a std::pmr::memory_resource. Standard containers use it via
+ * std::pmr, e.g.,
+ *
+ *   std::pmr::vector<Vec2f> points( &arena );
+ *
+ * Anything that uses the arena must be destroyed (or stop using its memory)
+ * before the next reset().
+ *
+ * A frame that needs more than the current block gets further blocks from
+ * the upstream resource. reset() replaces these with a single block that is
+ * large enough for the whole frame, so the arena stops allocating after the
+ * first few frames.
+ *
+ * The arena is not thread safe. Tasks that need scratch memory should get it
+ * before they are started.
+ */
+class FrameArena final : public std::pmr::memory_resource
+{
+	public: // Configuration values
+		static constexpr std::size_t kDefaultBlockSize = 256*1024;
+
+	public:
+		explicit FrameArena(
+			std::size_t aBlockSize = kDefaultBlockSize,
+			std::pmr::memory_resource* aUpstream = std::pmr::new_delete_resource()
+		);
+		~FrameArena();
+
+		FrameArena( FrameArena const& ) = delete;
+		FrameArena& operator= (FrameArena const&) = delete;
+
+	public:
+		void reset();
+
+		// Uninitialized array of aCount elements
+		template< typename tType >
+		tType* allocate_array( std::size_t aCount );
+
+	public:
+		std::size_t used() const noexcept; // bytes, since the last reset()
+		std::size_t capacity() const noexcept; // bytes, in all blocks
+
+	private:
+		void* do_allocate( std::size_t aBytes, std::size_t aAlignment ) override;
+		void do_deallocate( void*, std::size_t, std::size_t ) noexcept override;
+		bool do_is_equal( std::pmr::memory_resource const& ) const noexcept override;
+
+	private:
+		struct Block_
+		{
+			std::byte* data;
+			std::size_t size;
+		};
+
+		void add_block_( std::size_t aMinSize );
+		void release_blocks_() noexcept;
+
+	private:
+		std::pmr::memory_resource* mUpstream;
+
+		std::vector<Block_> mBlocks; // allocations come from mBlocks.back()
+		std::size_t mOffset; // into mBlocks.back()
+
+		std::size_t mUsed;
+};
+
+#include "frame_arena.inl"
+#endif // FRAME_ARENA_HPP_5D20B7E4_93A1_4C6F_8E0B_2A7F41C9D356
@@ -0,0 +1,5 @@
+template< typename tType > inline
+tType* FrameArena::allocate_array( std::size_t aCount )
+{
+	return static_cast<tType*>(allocate( aCount * sizeof(tType), alignof(tType) ));
+}
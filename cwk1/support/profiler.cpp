@@ -0,0 +1,95 @@
+#include "profiler.hpp"
+
+#include <algorithm>
+
+namespace
+{
+	double milliseconds_( Profiler::Clock::duration ) noexcept;
+}
+
+Profiler::Profiler() = default;
+Profiler::~Profiler() = default;
+
+void Profiler::record( char const* aLabel, Clock::duration aDuration )
+{
+	std::unique_lock<std::mutex> lock( mMutex );
+
+	auto& stats = mStats[aLabel];
+	++stats.count;
+	stats.total += aDuration;
+	stats.longest = std::max( stats.longest, aDuration );
+}
+
+std::vector<Profiler::Entry> Profiler::entries() const
+{
+	std::vector<Entry> ret;
+
+	{
+		std::unique_lock<std::mutex> lock( mMutex );
+
+		ret.reserve( mStats.size() );
+		for( auto const& [label, stats] : mStats )
+		{
+			if( stats.count )
+				ret.emplace_back( Entry{ std::string(label), stats.count, stats.total, stats.longest } );
+		}
+	}
+
+	std::sort( ret.begin(), ret.end(), [] (Entry const& aA, Entry const& aB) {
+		return aA.label < aB.label;
+	} );
+
+	return ret;
+}
+
+void Profiler::reset()
+{
+	std::unique_lock<std::mutex> lock( mMutex );
+
+	for( auto& entry : mStats )
+		entry.second = Stats_{};
+}
+
+void Profiler::print( std::FILE* aOut, std::uint64_t aFrames ) const
+{
+	for( auto const& entry : entries() )
+	{
+		auto const total = milliseconds_( entry.total );
+
+		std::fprintf( aOut, "  %-24s %8llu x %8.3f ms avg, %8.3f ms max",
+			entry.label.c_str(),
+			static_cast<unsigned long long>(entry.count),
+			total / entry.count,
+			milliseconds_( entry.longest )
+		);
+
+		if( aFrames )
+			std::fprintf( aOut, ", %8.3f ms/frame", total / aFrames );
+
+		std::fprintf( aOut, "\n" );
+	}
+}
+
+
+ProfileScope::ProfileScope( Profiler* aProfiler, char const* aLabel ) noexcept
+	: mProfiler( aProfiler )
+	, mLabel( aLabel )
+{
+	if( mProfiler )
+		mStart = Profiler::Clock::now();
+}
+
+ProfileScope::~ProfileScope()
+{
+	if( mProfiler )
+		mProfiler->record( mLabel, Profiler::Clock::now() - mStart );
+}
+
+
+namespace
+{
+	double milliseconds_( Profiler::Clock::duration aDuration ) noexcept
+	{
+		return std::chrono::duration<double, std::milli>( aDuration ).count();
+	}
+}
@@ -0,0 +1,91 @@
+#ifndef PROFILER_HPP_C5E1A3F8_0B27_4D94_8E6A_9F42D17B30C6
+#define PROFILER_HPP_C5E1A3F8_0B27_4D94_8E6A_9F42D17B30C6
+
+#include <mutex>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <string_view>
+#include <unordered_map>
+
+#include <cstdio>
+#include <cstdint>
+
+/** Simple profiler
+ *
+ * Accumulates the time spent in labelled sections of code. Sections are
+ * usually timed with ProfileScope; TaskPool times each task with the task's
+ * label. Sections may be recorded from any thread.
+ *
+ * The profiler is meant for coarse sections (e.g., tasks that run a few
+ * times per frame), as each record takes a lock. Labels are not copied; they
+ * must outlive the profiler (they are usually string literals). Recording a
+ * label that was seen before does not allocate.
+ */
+class Profiler final
+{
+	public:
+		using Clock = std::chrono::steady_clock;
+
+		struct Entry
+		{
+			std::string label;
+			std::uint64_t count;
+			Clock::duration total;
+			Clock::duration longest;
+		};
+
+	public:
+		Profiler();
+		~Profiler();
+
+		Profiler( Profiler const& ) = delete;
+		Profiler& operator= (Profiler const&) = delete;
+
+	public:
+		void record( char const* aLabel, Clock::duration );
+
+		// Entries sorted by label
+		std::vector<Entry> entries() const;
+
+		// Zero all statistics. Labels are kept, but are not reported again
+		// until they are recorded.
+		void reset();
+
+		// Print one line per label: count, total and average time. Times
+		// per frame are printed if aFrames is non-zero.
+		void print( std::FILE*, std::uint64_t aFrames = 0 ) const;
+
+	private:
+		struct Stats_
+		{
+			std::uint64_t count = 0;
+			Clock::duration total{};
+			Clock::duration longest{};
+		};
+
+		mutable std::mutex mMutex;
+		std::unordered_map<std::string_view, Stats_> mStats;
+};
+
+/** Time a section of code
+ *
+ * Records the time between construction and destruction with the profiler.
+ * A null profiler disables the timing.
+ */
+class ProfileScope final
+{
+	public:
+		ProfileScope( Profiler*, char const* aLabel ) noexcept;
+		~ProfileScope();
+
+		ProfileScope( ProfileScope const& ) = delete;
+		ProfileScope& operator= (ProfileScope const&) = delete;
+
+	private:
+		Profiler* mProfiler;
+		char const* mLabel;
+		Profiler::Clock::time_point mStart;
+};
+
+#endif // PROFILER_HPP_C5E1A3F8_0B27_4D94_8E6A_9F42D17B30C6
@@ -27,6 +27,18 @@ RuntimeConfig parse_command_line( int aArgc, char const* const* aArgv )
 				synopsis_( aArgv[0] );
 				std::exit( 0 );
 			}
+			else if( 0 == std::strcmp( "profile", name ) )
+			{
+				config.profile = true;
+			}
+			else if( 0 == std::strcmp( "stats", name ) )
+			{
+				config.stats = true;
+			}
+			else if( 0 == std::strcmp( "layerscroll", name ) )
+			{
+				config.scrolledLayers = true;
+			}
 			else
 			{
 				throw Error( "Error while parsing command line\n" 
@@ -50,6 +62,30 @@ RuntimeConfig parse_command_line( int aArgc, char const* const* aArgv )
 
 				config.framebufferScaleShift = shift;
 			}
+			else if( 0 == std::strcmp( "simrate", name ) )
+			{
+				unsigned rate = 0;
+				if( 1 != std::sscanf( value, "%u%c", &rate, &dummy ) )
+				{
+					throw Error( "Error while parsing command line\n" 
+						"Value '%s' not valid for --simrate; expected unsigned integer\n"
+						"Use --help to print available command line options", name );
+				}
+
+				config.simulationRate = rate;
+			}
+			else if( 0 == std::strcmp( "threads", name ) )
+			{
+				unsigned threads = 0;
+				if( 1 != std::sscanf( value, "%u%c", &threads, &dummy ) )
+				{
+					throw Error( "Error while parsing command line\n" 
+						"Value '%s' not valid for --threads; expected unsigned integer\n"
+						"Use --help to print available command line options", name );
+				}
+
+				config.threads = threads;
+			}
 			else if( 0 == std::strcmp( "geometry", name ) )
 			{
 				unsigned width = 0, height = 0;
@@ -88,10 +124,19 @@ namespace
 
 Where <flag> may be one off the following
   help         : print this help and exit successfully
+  profile      : print timings of the frame's tasks every few seconds
+  stats        : show the frame rate and stage timings on screen
+  layerscroll  : scroll the far background layers as a whole, instead of
+                 moving each particle (same output)
 
 and where <option> and <value> may be the following
   geometry    <width>x<height>    set initial window size to (width, height)
   fbshift     <shift>             scale framebuffer by 2^-<shift> (unsigned int)
+  simrate     <steps>             fixed simulation steps per second, on a
+                                  separate thread (default 120); 0 updates
+                                  once per frame instead
+  threads     <count>             threads for work in each frame, including
+                                  the main thread; 0 (default) uses all
 
 Example:
   %s --geometry=1920x1080 --fbshift=1
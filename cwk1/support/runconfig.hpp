@@ -5,6 +5,9 @@ namespace cfg
 {
 	constexpr unsigned kInitialWindowWidth = 1280;
 	constexpr unsigned kInitialWindowHeight = 720;
+
+	// Fixed simulation steps per second (see Simulation)
+	constexpr unsigned kSimulationRate = 120;
 }
 
 struct RuntimeConfig
@@ -13,6 +16,24 @@ struct RuntimeConfig
 	unsigned initialWindowHeight = cfg::kInitialWindowHeight;
 
 	unsigned framebufferScaleShift = 0;
+
+	// Zero updates the simulation once per frame, on the main thread, with
+	// the frame's time step.
+	unsigned simulationRate = cfg::kSimulationRate;
+
+	// Threads for parallel work in each frame, including the main thread.
+	// Zero uses all available hardware threads.
+	unsigned threads = 0;
+
+	// Print timings periodically (see Profiler)
+	bool profile = false;
+
+	// Show frame statistics on screen (see StatsOverlay)
+	bool stats = false;
+
+	// Scroll the far background layers instead of moving each particle
+	// (see ParticleField::set_layer_scroll())
+	bool scrolledLayers = false;
 };
 
 RuntimeConfig parse_command_line( int aArgc, char const* const* aArgv );
@@ -0,0 +1,317 @@
+#include "task_pool.hpp"
+
+#include <utility>
+#include <algorithm>
+
+#include <cassert>
+
+#include "error.hpp"
+#include "profiler.hpp"
+
+namespace
+{
+	// Pool and queue of the current thread, if it is a pool thread
+	thread_local TaskPool const* tlPool = nullptr;
+	thread_local std::size_t tlQueue = 0;
+}
+
+TaskGroup::TaskGroup() noexcept
+	: mRemaining( 0 )
+{}
+
+TaskGroup::~TaskGroup()
+{
+	assert( 0 == mRemaining.load() );
+}
+
+
+TaskPool::TaskPool( std::size_t aThreads, Profiler* aProfiler )
+	: mProfiler( aProfiler )
+	, mQueued( 0 )
+	, mStopping( false )
+{
+	if( 0 == aThreads )
+		aThreads = std::max( 1u, std::thread::hardware_concurrency() );
+
+	// The thread calling wait() is the remaining one
+	auto const workers = aThreads - 1;
+
+	mQueues.reserve( workers + 1 );
+	for( std::size_t i = 0; i < workers + 1; ++i )
+		mQueues.emplace_back( std::make_unique<Queue_>() );
+
+	mThreads.reserve( workers );
+	for( std::size_t i = 0; i < workers; ++i )
+		mThreads.emplace_back( [this, i] { worker_( i+1 ); } );
+}
+
+TaskPool::~TaskPool()
+{
+	{
+		std::unique_lock<std::mutex> lock( mSleepMutex );
+		mStopping = true;
+	}
+
+	mWake.notify_all();
+
+	for( auto& thread : mThreads )
+		thread.join();
+}
+
+
+void TaskPool::run( TaskGroup& aGroup, char const* aLabel, Task aTask )
+{
+	aGroup.mRemaining.fetch_add( 1, std::memory_order_relaxed );
+
+	auto& queue = *mQueues[own_queue_()];
+
+	{
+		std::unique_lock<std::mutex> lock( queue.mutex );
+		push_( queue, Job_{ std::move(aTask), &aGroup, aLabel } );
+		mQueued.fetch_add( 1 );
+	}
+
+	// Taking the lock ensures that a thread that just found no work is
+	// already waiting, and receives the notification.
+	{
+		std::unique_lock<std::mutex> lock( mSleepMutex );
+	}
+
+	mWake.notify_one();
+}
+
+void TaskPool::wait( TaskGroup& aGroup )
+{
+	auto const self = own_queue_();
+
+	while( aGroup.mRemaining.load() > 0 )
+	{
+		Job_ job;
+		if( try_pop_( self, job ) )
+		{
+			execute_( job );
+			continue;
+		}
+
+		// Nothing to do, but other threads are still busy with the group's
+		// tasks. They may queue more tasks, or finish the group.
+		std::unique_lock<std::mutex> lock( mSleepMutex );
+		mWake.wait( lock, [this, &aGroup] {
+			return 0 == aGroup.mRemaining.load() || mQueued.load() > 0;
+		} );
+	}
+
+	if( aGroup.mError )
+	{
+		auto error = std::exchange( aGroup.mError, nullptr );
+		std::rethrow_exception( error );
+	}
+}
+
+std::size_t TaskPool::thread_count() const noexcept
+{
+	return mThreads.size() + 1;
+}
+
+
+std::size_t TaskPool::own_queue_() const noexcept
+{
+	return this == tlPool ? tlQueue : 0;
+}
+
+bool TaskPool::try_pop_( std::size_t aQueue, Job_& aJob )
+{
+	if( 0 == mQueued.load() )
+		return false;
+
+	// Own queue first, newest task ...
+	{
+		auto& queue = *mQueues[aQueue];
+		std::unique_lock<std::mutex> lock( queue.mutex );
+		if( queue.count )
+		{
+			pop_newest_( queue, aJob );
+			mQueued.fetch_sub( 1 );
+			return true;
+		}
+	}
+
+	// ... then steal the oldest task from one of the others
+	auto const count = mQueues.size();
+	for( std::size_t i = 1; i < count; ++i )
+	{
+		auto& queue = *mQueues[(aQueue + i) % count];
+		std::unique_lock<std::mutex> lock( queue.mutex );
+		if( queue.count )
+		{
+			pop_oldest_( queue, aJob );
+			mQueued.fetch_sub( 1 );
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void TaskPool::push_( Queue_& aQueue, Job_&& aJob )
+{
+	auto const capacity = aQueue.jobs.size();
+	if( aQueue.count == capacity )
+	{
+		// Grow, and unwrap the ring while moving the jobs over
+		std::vector<Job_> jobs( std::max( std::size_t(8), 2 * capacity ) );
+		for( std::size_t i = 0; i < aQueue.count; ++i )
+			jobs[i] = std::move(aQueue.jobs[(aQueue.head + i) % capacity]);
+
+		aQueue.jobs = std::move(jobs);
+		aQueue.head = 0;
+	}
+
+	aQueue.jobs[(aQueue.head + aQueue.count) % aQueue.jobs.size()] = std::move(aJob);
+	++aQueue.count;
+}
+
+void TaskPool::pop_newest_( Queue_& aQueue, Job_& aJob ) noexcept
+{
+	assert( aQueue.count > 0 );
+
+	--aQueue.count;
+	aJob = std::move(aQueue.jobs[(aQueue.head + aQueue.count) % aQueue.jobs.size()]);
+}
+
+void TaskPool::pop_oldest_( Queue_& aQueue, Job_& aJob ) noexcept
+{
+	assert( aQueue.count > 0 );
+
+	aJob = std::move(aQueue.jobs[aQueue.head]);
+	aQueue.head = (aQueue.head + 1) % aQueue.jobs.size();
+	--aQueue.count;
+}
+
+void TaskPool::execute_( Job_& aJob )
+{
+	auto* group = aJob.group;
+	assert( group );
+
+	{
+		ProfileScope scope( mProfiler, aJob.label );
+
+		try
+		{
+			aJob.task();
+		}
+		catch( ... )
+		{
+			std::unique_lock<std::mutex> lock( group->mErrorMutex );
+			if( !group->mError )
+				group->mError = std::current_exception();
+		}
+	}
+
+	// Release the task's captures before the group is finished; the waiting
+	// thread may destroy what they refer to right after.
+	aJob.task = nullptr;
+
+	if( 1 == group->mRemaining.fetch_sub( 1 ) )
+		wake_all_();
+}
+
+void TaskPool::worker_( std::size_t aQueue )
+{
+	tlPool = this;
+	tlQueue = aQueue;
+
+	for( ;; )
+	{
+		Job_ job;
+		if( try_pop_( aQueue, job ) )
+		{
+			execute_( job );
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock( mSleepMutex );
+		mWake.wait( lock, [this] { return mStopping || mQueued.load() > 0; } );
+
+		// Finish all queued tasks before stopping
+		if( mStopping && 0 == mQueued.load() )
+			return;
+	}
+}
+
+void TaskPool::wake_all_()
+{
+	{
+		std::unique_lock<std::mutex> lock( mSleepMutex );
+	}
+
+	mWake.notify_all();
+}
+
+
+TaskGraph::TaskGraph()
+	: mPool( nullptr )
+	, mGroup( nullptr )
+{}
+
+TaskGraph::~TaskGraph() = default;
+
+TaskGraph::Node TaskGraph::add( char const* aLabel, TaskPool::Task aTask, std::initializer_list<Node> aDependencies )
+{
+	auto const index = mNodes.size();
+
+	for( auto const dep : aDependencies )
+	{
+		if( dep >= index )
+			throw Error( "TaskGraph: node '%s' depends on unknown node %zu", aLabel, dep );
+	}
+
+	auto& node = mNodes.emplace_back();
+	node.label = aLabel;
+	node.task = std::move(aTask);
+	node.dependencies = aDependencies.size();
+	node.remaining.store( 0 );
+
+	for( auto const dep : aDependencies )
+		mNodes[dep].successors.emplace_back( index );
+
+	return index;
+}
+
+void TaskGraph::run( TaskPool& aPool )
+{
+	for( auto& node : mNodes )
+		node.remaining.store( node.dependencies );
+
+	TaskGroup group;
+	mPool = &aPool;
+	mGroup = &group;
+
+	for( Node i = 0; i < mNodes.size(); ++i )
+	{
+		if( 0 == mNodes[i].dependencies )
+			submit_( i );
+	}
+
+	aPool.wait( group );
+}
+
+std::size_t TaskGraph::size() const noexcept
+{
+	return mNodes.size();
+}
+
+void TaskGraph::submit_( Node aNode )
+{
+	mPool->run( *mGroup, mNodes[aNode].label, [this, aNode] {
+		auto& node = mNodes[aNode];
+		node.task();
+
+		// The last dependency to finish starts the successor
+		for( auto const succ : node.successors )
+		{
+			if( 1 == mNodes[succ].remaining.fetch_sub( 1 ) )
+				submit_( succ );
+		}
+	} );
+}
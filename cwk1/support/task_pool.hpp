@@ -0,0 +1,193 @@
+#ifndef TASK_POOL_HPP_7B3E90D4_1C6F_4A28_95D1_E8A24F6C07B9
+#define TASK_POOL_HPP_7B3E90D4_1C6F_4A28_95D1_E8A24F6C07B9
+
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <exception>
+#include <functional>
+#include <initializer_list>
+#include <condition_variable>
+
+#include <cstddef>
+
+class Profiler;
+
+/** Group of tasks that are waited for together
+ *
+ * See TaskPool::run() and TaskPool::wait(). A group must be waited for before
+ * it is destroyed.
+ */
+class TaskGroup final
+{
+	public:
+		TaskGroup() noexcept;
+		~TaskGroup();
+
+		TaskGroup( TaskGroup const& ) = delete;
+		TaskGroup& operator= (TaskGroup const&) = delete;
+
+	private:
+		friend class TaskPool;
+
+		std::atomic<std::size_t> mRemaining;
+
+		std::mutex mErrorMutex;
+		std::exception_ptr mError; // first exception thrown by a task
+};
+
+/** Work-stealing thread pool
+ *
+ * Each thread has its own queue of tasks. Tasks submitted from a pool thread
+ * go to that thread's queue, which it works on last-in first-out. Idle
+ * threads steal the oldest tasks from the other queues. Tasks submitted from
+ * outside of the pool (e.g., the main loop) go to a separate queue, which is
+ * only ever stolen from.
+ *
+ * The thread that waits for a group (TaskPool::wait()) runs tasks while it
+ * waits. A pool with N threads therefore only starts N-1 workers, and a pool
+ * with a single thread runs all tasks in wait().
+ *
+ * With a Profiler, each task is timed under its label.
+ *
+ * Queues are ring buffers that only grow, so running tasks does not allocate
+ * once the queues have reached their working size. A task allocates if its
+ * captures do not fit into std::function's small buffer (typically two
+ * pointers); parallel_for() and TaskGraph keep theirs below that.
+ */
+class TaskPool final
+{
+	public:
+		using Task = std::function<void()>;
+
+	public:
+		// aThreads = 0 uses std::thread::hardware_concurrency() threads. This
+		// includes the thread calling wait(); see above.
+		explicit TaskPool( std::size_t aThreads = 0, Profiler* = nullptr );
+		~TaskPool();
+
+		TaskPool( TaskPool const& ) = delete;
+		TaskPool& operator= (TaskPool const&) = delete;
+
+	public:
+		// Queue a task in aGroup. aLabel must outlive the task; it is usually
+		// a string literal.
+		void run( TaskGroup&, char const* aLabel, Task );
+
+		// Run tasks until all tasks of the group have finished. If any of the
+		// group's tasks threw, the first exception is rethrown.
+		void wait( TaskGroup& );
+
+		// Call aFunc( begin, end ) for chunks of at most aGrain elements of
+		// [aBegin, aEnd), in parallel, and wait for all of them.
+		template< class tFunc >
+		void parallel_for( char const* aLabel, std::size_t aBegin, std::size_t aEnd, std::size_t aGrain, tFunc&& aFunc );
+
+	public:
+		std::size_t thread_count() const noexcept;
+
+	private:
+		struct Job_
+		{
+			Task task;
+			TaskGroup* group;
+			char const* label;
+		};
+
+		// Ring buffer of jobs; jobs[(head + i) % jobs.size()] for i < count
+		struct Queue_
+		{
+			std::mutex mutex;
+			std::vector<Job_> jobs;
+			std::size_t head = 0, count = 0;
+		};
+
+	private:
+		std::size_t own_queue_() const noexcept;
+		bool try_pop_( std::size_t aQueue, Job_& );
+
+		static void push_( Queue_&, Job_&& );
+		static void pop_newest_( Queue_&, Job_& ) noexcept;
+		static void pop_oldest_( Queue_&, Job_& ) noexcept;
+
+		void execute_( Job_& );
+		void worker_( std::size_t aQueue );
+
+		void wake_all_();
+
+	private:
+		Profiler* mProfiler;
+
+		// Queue 0 is for threads outside of the pool; worker i uses queue i+1.
+		std::vector<std::unique_ptr<Queue_>> mQueues;
+
+		// Number of queued tasks, over all queues
+		std::atomic<std::size_t> mQueued;
+
+		// Idle threads sleep on mWake. mSleepMutex protects mStopping and
+		// orders wake-ups against the checks before sleeping.
+		std::mutex mSleepMutex;
+		std::condition_variable mWake;
+		bool mStopping;
+
+		std::vector<std::thread> mThreads;
+};
+
+/** Graph of tasks with dependencies
+ *
+ * Nodes are added once; the graph can then be run any number of times (e.g.,
+ * once per frame). A node's task starts once all the nodes it depends on have
+ * finished. Independent nodes run in parallel.
+ */
+class TaskGraph final
+{
+	public:
+		using Node = std::size_t;
+
+	public:
+		TaskGraph();
+		~TaskGraph();
+
+		TaskGraph( TaskGraph const& ) = delete;
+		TaskGraph& operator= (TaskGraph const&) = delete;
+
+	public:
+		// Dependencies must refer to nodes added earlier. aLabel must outlive
+		// the graph.
+		Node add( char const* aLabel, TaskPool::Task, std::initializer_list<Node> aDependencies = {} );
+
+		// Run all nodes, and wait for them to finish. If a task throws, the
+		// nodes that depend on it are skipped, and the exception is rethrown.
+		void run( TaskPool& );
+
+		std::size_t size() const noexcept;
+
+	private:
+		struct Node_
+		{
+			char const* label;
+			TaskPool::Task task;
+
+			std::vector<Node> successors;
+			std::size_t dependencies;
+
+			std::atomic<std::size_t> remaining;
+		};
+
+	private:
+		void submit_( Node );
+
+	private:
+		std::deque<Node_> mNodes; // deque: nodes are not movable
+
+		// Pool and group of the current run(); tasks only capture the graph
+		// and the node.
+		TaskPool* mPool;
+		TaskGroup* mGroup;
+};
+
+#include "task_pool.inl"
+#endif // TASK_POOL_HPP_7B3E90D4_1C6F_4A28_95D1_E8A24F6C07B9
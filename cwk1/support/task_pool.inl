@@ -0,0 +1,24 @@
+#include <algorithm>
+#include <type_traits>
+
+template< class tFunc > inline
+void TaskPool::parallel_for( char const* aLabel, std::size_t aBegin, std::size_t aEnd, std::size_t aGrain, tFunc&& aFunc )
+{
+	// Tasks capture the loop and the start of their chunk. That fits into
+	// std::function without allocating.
+	struct Loop_
+	{
+		std::remove_reference_t<tFunc>* func;
+		std::size_t grain, end;
+	} const loop{ &aFunc, std::max( aGrain, std::size_t(1) ), aEnd };
+
+	TaskGroup group;
+	for( auto begin = aBegin; begin < aEnd; begin += loop.grain )
+	{
+		run( group, aLabel, [&loop, begin] {
+			(*loop.func)( begin, std::min( loop.end - begin, loop.grain ) + begin );
+		} );
+	}
+
+	wait( group );
+}
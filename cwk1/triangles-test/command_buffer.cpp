@@ -0,0 +1,162 @@
+#include <catch2/catch_amalgamated.hpp>
+
+#include <vector>
+
+#include <cstdint>
+
+#include "helpers.hpp"
+
+#include "../draw2d/draw.hpp"
+#include "../draw2d/blit.hpp"
+#include "../draw2d/shape.hpp"
+#include "../draw2d/surface.hpp"
+#include "../draw2d/command_buffer.hpp"
+
+namespace
+{
+	constexpr Mat22f kIdentity_{ 1.f, 0.f, 0.f, 1.f };
+}
+
+TEST_CASE( "Command buffer", "[commands]" )
+{
+	// Half-transparent checker board, to exercise the blending of blits
+	std::vector<std::uint8_t> pixels( 24*16*4 );
+	for( std::size_t i = 0; i < 24*16; ++i )
+	{
+		auto const x = i % 24, y = i / 24;
+		pixels[i*4+0] = std::uint8_t(10*x);
+		pixels[i*4+1] = std::uint8_t(15*y);
+		pixels[i*4+2] = 200;
+		pixels[i*4+3] = (x/4 + y/4) % 2 ? 255 : 100;
+	}
+	ImageViewRGBA const image{ pixels.data(), 24, 16, 24*4 };
+
+	TriangleFan const fan( {
+		{ { 0.f, 0.f }, { 1.f, 1.f, 1.f } },
+		{ { 30.f, 0.f }, { 1.f, 0.f, 0.f } },
+		{ { 0.f, 30.f }, { 0.f, 1.f, 0.f } },
+		{ { -30.f, 0.f }, { 0.f, 0.f, 1.f } }
+	} );
+
+	Vec2f const stripPoints[] = { { -20.f, -20.f }, { 20.f, -10.f }, { 0.f, 25.f } };
+	LineStrip const strip( stripPoints );
+
+	Mat22f const rotation{ 0.8f, -0.6f, 0.6f, 0.8f };
+
+	Surface direct( 200, 150 );
+	direct.clear();
+
+	Surface replayed( 200, 150 );
+	replayed.clear();
+
+	SECTION( "tiles equal drawing directly" )
+	{
+		draw_triangle_solid( direct, { -10.f, 5.f }, { 190.f, 20.f }, { 60.f, 160.f }, { 0, 128, 255 } );
+		draw_line_solid( direct, { 3.5f, 140.5f }, { 197.f, 2.f }, { 255, 255, 0 } );
+		draw_rectangle_solid( direct, { 120.f, 60.f }, { 170.f, 130.f }, { 255, 0, 128 } );
+		fan.draw( direct, rotation, { 130.f, 70.f } );
+		strip.draw( direct, { 1.f, 1.f, 1.f }, rotation, { 64.f, 64.f } );
+		blit_masked( direct, image, { 120.f, 120.f } );
+		blit_masked_affine( direct, image, rotation, { 128.f, 128.f }, EBlitFilter::nearest );
+
+		CommandBuffer commands;
+		commands.triangle( { -10.f, 5.f }, { 190.f, 20.f }, { 60.f, 160.f }, { 0, 128, 255 } );
+		commands.line( { 3.5f, 140.5f }, { 197.f, 2.f }, { 255, 255, 0 } );
+		commands.rectangle( { 120.f, 60.f }, { 170.f, 130.f }, { 255, 0, 128 } );
+		commands.fan( fan, rotation, { 130.f, 70.f }, 31.f );
+		commands.strip( strip, { 1.f, 1.f, 1.f }, rotation, { 64.f, 64.f }, 29.f );
+		commands.blit( image, { 120.f, 120.f } );
+		commands.blit( image, rotation, { 128.f, 128.f } );
+
+		// Tiles smaller than the shapes, and partial tiles at the edges
+		commands.bin( 200, 150, 32 );
+		REQUIRE( 7*5 == commands.tile_count() );
+
+		for( std::size_t tile = 0; tile < commands.tile_count(); ++tile )
+			commands.replay_tile( replayed, tile );
+
+		REQUIRE( same_pixels( replayed, direct ) );
+
+		Surface whole( 200, 150 );
+		whole.clear();
+		commands.replay( whole );
+		REQUIRE( same_pixels( whole, direct ) );
+	}
+
+	SECTION( "runs of fans equal drawing them one by one" )
+	{
+		TriangleFan const other( {
+			{ { 0.f, 0.f }, { 0.f, 0.f, 0.f } },
+			{ { 12.f, -4.f }, { 1.f, 1.f, 0.f } },
+			{ { 0.f, 15.f }, { 0.f, 1.f, 1.f } },
+			{ { -9.f, -6.f }, { 1.f, 0.f, 1.f } }
+		} );
+
+		// Overlapping fans: a run longer than a batch, a run of another
+		// fan, a single fan, and a run that is split by a line
+		CommandBuffer commands;
+		auto const record = [&] (TriangleFan const& aFan, int aIndex) {
+			float const s = 0.3f + 0.01f * float(aIndex % 50);
+			Mat22f const t{ s * rotation._00, s * rotation._01, s * rotation._10, s * rotation._11 };
+			Vec2f const v{ float((aIndex * 37) % 230) - 15.f, float((aIndex * 53) % 170) - 10.f };
+
+			aFan.draw( direct, t, v );
+			commands.fan( aFan, t, v, 31.f * s );
+		};
+
+		for( int i = 0; i < 150; ++i )
+			record( fan, i );
+		for( int i = 0; i < 20; ++i )
+			record( other, i );
+		record( fan, 7 );
+		for( int i = 0; i < 10; ++i )
+		{
+			if( 5 == i )
+			{
+				draw_line_solid( direct, { 3.5f, 140.5f }, { 197.f, 2.f }, { 255, 255, 0 } );
+				commands.line( { 3.5f, 140.5f }, { 197.f, 2.f }, { 255, 255, 0 } );
+			}
+			record( other, 30 + i );
+		}
+
+		commands.replay( replayed );
+		REQUIRE( same_pixels( replayed, direct ) );
+
+		replayed.clear();
+		commands.bin( 200, 150, 64 );
+		for( std::size_t tile = 0; tile < commands.tile_count(); ++tile )
+			commands.replay_tile( replayed, tile );
+		REQUIRE( same_pixels( replayed, direct ) );
+	}
+
+	SECTION( "layers order the replay" )
+	{
+		// Drawn in layer order: the red rectangle first, then the green one
+		draw_rectangle_solid( direct, { 10.f, 10.f }, { 100.f, 100.f }, { 255, 0, 0 } );
+		draw_rectangle_solid( direct, { 50.f, 50.f }, { 150.f, 120.f }, { 0, 255, 0 } );
+		draw_line_solid( direct, { 0.f, 0.5f }, { 199.f, 149.5f }, { 0, 0, 255 } );
+
+		// Recorded out of order
+		CommandBuffer commands;
+		commands.set_layer( 2 );
+		commands.line( { 0.f, 0.5f }, { 199.f, 149.5f }, { 0, 0, 255 } );
+		commands.set_layer( 1 );
+		commands.rectangle( { 50.f, 50.f }, { 150.f, 120.f }, { 0, 255, 0 } );
+		commands.set_layer( 0 );
+		commands.rectangle( { 10.f, 10.f }, { 100.f, 100.f }, { 255, 0, 0 } );
+
+		commands.replay( replayed );
+		REQUIRE( same_pixels( replayed, direct ) );
+
+		replayed.clear();
+		commands.bin( 200, 150, 64 );
+		for( std::size_t tile = 0; tile < commands.tile_count(); ++tile )
+			commands.replay_tile( replayed, tile );
+		REQUIRE( same_pixels( replayed, direct ) );
+
+		replayed.clear();
+		commands.sort_by_type();
+		commands.replay( replayed );
+		REQUIRE( same_pixels( replayed, direct ) );
+	}
+}
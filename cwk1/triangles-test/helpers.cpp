@@ -1,5 +1,7 @@
 #include "helpers.hpp"
 
+#include <cstring>
+
 #include "../draw2d/color.hpp"
 #include "../draw2d/surface.hpp"
 
@@ -89,4 +91,28 @@ BarycentricCoordinates compute_barycentric_coordinates(Vec2f p, Vec2f a, Vec2f b
     bary.w3 = 1.0f - bary.w1 - bary.w2;
 
     return bary;
-}
\ No newline at end of file
+}
+
+bool is_pixel_set( Surface const& aSurface, std::uint32_t aX, std::uint32_t aY )
+{
+	auto const* pixel = aSurface.get_surface_ptr() + aSurface.get_linear_index( aX, aY );
+	return 0 != pixel[0] || 0 != pixel[1] || 0 != pixel[2];
+}
+std::size_t count_set_pixels( Surface const& aSurface )
+{
+	std::size_t count = 0;
+	for( std::uint32_t y = 0; y < aSurface.get_height(); ++y )
+	{
+		for( std::uint32_t x = 0; x < aSurface.get_width(); ++x )
+			count += is_pixel_set( aSurface, x, y ) ? 1 : 0;
+	}
+	return count;
+}
+bool same_pixels( Surface const& aA, Surface const& aB )
+{
+	if( aA.get_width() != aB.get_width() || aA.get_height() != aB.get_height() )
+		return false;
+
+	auto const bytes = std::size_t(aA.get_width()) * aA.get_height() * 4;
+	return 0 == std::memcmp( aA.get_surface_ptr(), aB.get_surface_ptr(), bytes );
+}
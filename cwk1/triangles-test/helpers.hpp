@@ -1,6 +1,9 @@
 #ifndef HELPERS_HPP_DD37133A_D9CE_4998_AA48_41DA09E1517C
 #define HELPERS_HPP_DD37133A_D9CE_4998_AA48_41DA09E1517C
 
+#include <cstddef>
+#include <cstdint>
+
 #include "../draw2d/forward.hpp"
 #include "../draw2d/../vmlib/vec2.hpp" // Include Vec2f definition from the correct location.
 
@@ -14,4 +17,11 @@ BarycentricCoordinates compute_barycentric_coordinates(Vec2f p, Vec2f a, Vec2f b
 ColorU8_sRGB find_most_red_pixel( Surface const& );
 ColorU8_sRGB find_least_red_nonzero_pixel( Surface const& );
 
+// A pixel is set if any of its color channels is non-zero
+bool is_pixel_set( Surface const&, std::uint32_t aX, std::uint32_t aY );
+std::size_t count_set_pixels( Surface const& );
+
+// Same size and identical pixels (all four channels)
+bool same_pixels( Surface const&, Surface const& );
+
 #endif // HELPERS_HPP_DD37133A_D9CE_4998_AA48_41DA09E1517C
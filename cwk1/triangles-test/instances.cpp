@@ -0,0 +1,270 @@
+#include <catch2/catch_amalgamated.hpp>
+
+#include <random>
+#include <vector>
+#include <iterator>
+#include <algorithm>
+
+#include <cmath>
+
+#include "helpers.hpp"
+
+#include "../draw2d/draw.hpp"
+#include "../draw2d/color.hpp"
+#include "../draw2d/shape.hpp"
+#include "../draw2d/scissor.hpp"
+#include "../draw2d/surface.hpp"
+#include "../draw2d/instances.hpp"
+
+namespace
+{
+	// Rotations, non-uniform scales, shears and reflections; some of the
+	// instances are partially or entirely outside of the surface
+	std::vector<ShapeInstance> random_instances_( std::size_t aCount, float aWidth, float aHeight )
+	{
+		std::minstd_rand rng( 7 );
+		std::uniform_real_distribution<float> x( -60.f, aWidth + 60.f ), y( -60.f, aHeight + 60.f );
+		std::uniform_real_distribution<float> m( -2.f, 2.f );
+
+		std::vector<ShapeInstance> ret( aCount );
+		for( auto& inst : ret )
+		{
+			inst.transform = Mat22f{ m( rng ), m( rng ), m( rng ), m( rng ) };
+			inst.translation = Vec2f{ x( rng ), y( rng ) };
+		}
+		return ret;
+	}
+
+	// draw_triangle_interp() as it was before rows were limited to the
+	// triangle: every sample of the bounding box is tested.
+	void draw_triangle_interp_every_sample_( Surface& aSurface, Vec2f aP0, Vec2f aP1, Vec2f aP2, ColorF aC0, ColorF aC1, ColorF aC2 )
+	{
+		float minX = std::max(0.0f, std::min({aP0.x, aP1.x, aP2.x}));
+		float minY = std::max(0.0f, std::min({aP0.y, aP1.y, aP2.y}));
+		float maxX = std::min(static_cast<float>(aSurface.get_width() - 1), std::max({aP0.x, aP1.x, aP2.x}));
+		float maxY = std::min(static_cast<float>(aSurface.get_height() - 1), std::max({aP0.y, aP1.y, aP2.y}));
+
+		float denom = (aP1.y - aP2.y) * (aP0.x - aP2.x) + (aP2.x - aP1.x) * (aP0.y - aP2.y);
+
+		for (float y = minY; y <= maxY; y += 1.0f) {
+			for (float x = minX; x <= maxX; x += 1.0f) {
+				float w0 = ((aP1.y - aP2.y) * (x - aP2.x) + (aP2.x - aP1.x) * (y - aP2.y)) / denom;
+				float w1 = ((aP2.y - aP0.y) * (x - aP2.x) + (aP0.x - aP2.x) * (y - aP2.y)) / denom;
+				float w2 = 1.0f - w0 - w1;
+
+				if (w0 >= 0 && w1 >= 0 && w2 >= 0) {
+					ColorF interpolatedColor = aC0 * w0 + aC1 * w1 + aC2 * w2;
+					aSurface.set_pixel_srgb(static_cast<Surface::Index>(x), static_cast<Surface::Index>(y), linear_to_srgb(interpolatedColor));
+				}
+			}
+		}
+	}
+
+	// Reference for EInstanceFill::shared: pixel centers, tested and
+	// interpolated in double precision. Only the pixels in aRect are drawn.
+	void draw_triangle_centers_( Surface& aSurface, ScissorRect const& aRect, Vec2f aP0, Vec2f aP1, Vec2f aP2, ColorF aC0, ColorF aC1, ColorF aC2 )
+	{
+		double const x0 = aP0.x, y0 = aP0.y, x1 = aP1.x, y1 = aP1.y, x2 = aP2.x, y2 = aP2.y;
+		double const denom = (y1 - y2) * (x0 - x2) + (x2 - x1) * (y0 - y2);
+		if( 0.0 == denom )
+			return;
+
+		for( Surface::Index y = aRect.minY; y < aRect.maxY; ++y )
+		{
+			for( Surface::Index x = aRect.minX; x < aRect.maxX; ++x )
+			{
+				double const cx = x + 0.5, cy = y + 0.5;
+				double const w0 = ((y1 - y2) * (cx - x2) + (x2 - x1) * (cy - y2)) / denom;
+				double const w1 = ((y2 - y0) * (cx - x2) + (x0 - x2) * (cy - y2)) / denom;
+				double const w2 = 1.0 - w0 - w1;
+
+				if( w0 >= 0.0 && w1 >= 0.0 && w2 >= 0.0 )
+				{
+					ColorF const color{
+						float(aC0.r * w0 + aC1.r * w1 + aC2.r * w2),
+						float(aC0.g * w0 + aC1.g * w1 + aC2.g * w2),
+						float(aC0.b * w0 + aC1.b * w1 + aC2.b * w2)
+					};
+					aSurface.set_pixel_srgb( x, y, linear_to_srgb( color ) );
+				}
+			}
+		}
+	}
+}
+
+TEST_CASE( "Instanced drawing", "[instances]" )
+{
+	TriangleFan const fan( {
+		{ { 0.f, 0.f }, { 1.f, 1.f, 1.f } },
+		{ { 20.f, 0.f }, { 1.f, 0.f, 0.f } },
+		{ { 12.f, 15.f }, { 0.f, 1.f, 0.f } },
+		{ { 0.5f, 25.f }, { 0.f, 0.f, 1.f } },
+		{ { -18.f, 9.f }, { 1.f, 1.f, 0.f } },
+		{ { -10.f, -14.f }, { 0.f, 1.f, 1.f } },
+		{ { 7.25f, -19.f }, { 1.f, 0.f, 1.f } }
+	} );
+
+	Vec2f const stripPoints[] = { { -20.f, -5.f }, { 0.f, 18.f }, { 22.f, -3.5f }, { 4.f, -20.f } };
+	LineStrip const strip( stripPoints );
+
+	auto const instances = random_instances_( 300, 320.f, 240.f );
+
+	Surface direct( 320, 240 );
+	direct.clear();
+
+	Surface instanced( 320, 240 );
+	instanced.clear();
+
+	SECTION( "triangle fan" )
+	{
+		for( auto const& inst : instances )
+			fan.draw( direct, inst.transform, inst.translation );
+
+		draw_instances( instanced, fan, instances.size(), instances.data() );
+
+		REQUIRE( same_pixels( instanced, direct ) );
+	}
+
+	SECTION( "triangle fan with a scissor" )
+	{
+		ScopedScissor scissor( { 37, 21, 250, 199 } );
+
+		for( auto const& inst : instances )
+			fan.draw( direct, inst.transform, inst.translation );
+
+		draw_instances( instanced, fan, instances.size(), instances.data() );
+
+		REQUIRE( same_pixels( instanced, direct ) );
+	}
+
+	SECTION( "line strip" )
+	{
+		ColorF const color{ 0.25f, 0.5f, 1.f };
+
+		for( auto const& inst : instances )
+			strip.draw( direct, color, inst.transform, inst.translation );
+
+		draw_instances( instanced, strip, color, instances.size(), instances.data() );
+
+		REQUIRE( same_pixels( instanced, direct ) );
+	}
+}
+
+TEST_CASE( "Triangle rows", "[instances][triangle]" )
+{
+	// draw_triangle_interp() only tests the samples near the triangle, and
+	// converts to sRGB with a table. The pixels must not change.
+	std::minstd_rand rng( 3 );
+	std::uniform_real_distribution<float> pos( -40.f, 200.f ), offset( -60.f, 60.f );
+	std::uniform_real_distribution<float> col( 0.f, 1.f );
+
+	Surface surface( 160, 120 );
+	surface.clear();
+
+	Surface reference( 160, 120 );
+	reference.clear();
+
+	for( int i = 0; i < 3000; ++i )
+	{
+		Vec2f p0{ pos( rng ), pos( rng ) };
+		Vec2f p1 = p0 + Vec2f{ offset( rng ), offset( rng ) };
+		Vec2f p2 = p0 + Vec2f{ offset( rng ), offset( rng ) };
+
+		// Vertices on pixel centers and edges, thin slivers, and huge
+		// triangles
+		if( 0 == i % 5 )
+		{
+			p0 = Vec2f{ std::floor( p0.x ), std::floor( p0.y ) };
+			p1 = Vec2f{ std::floor( p1.x ) + 0.5f, std::floor( p1.y ) };
+			p2 = Vec2f{ p0.x, std::floor( p2.y ) + 0.5f };
+		}
+		if( 0 == i % 7 )
+			p2 = p0 + 1.001f * (p1 - p0) + Vec2f{ 0.f, 0.01f };
+		if( 0 == i % 97 )
+			p1 = Vec2f{ 1e7f, p1.y };
+
+		ColorF const c0{ col( rng ), col( rng ), col( rng ) };
+		ColorF const c1{ col( rng ), col( rng ), col( rng ) };
+		ColorF const c2{ col( rng ), col( rng ), col( rng ) };
+
+		draw_triangle_interp( surface, p0, p1, p2, c0, c1, c2 );
+		draw_triangle_interp_every_sample_( reference, p0, p1, p2, c0, c1, c2 );
+	}
+
+	REQUIRE( same_pixels( surface, reference ) );
+}
+
+TEST_CASE( "Instanced drawing with a shared setup", "[instances]" )
+{
+	TriangleFan::PosAndCol const vertices[] = {
+		{ { 0.f, 0.f }, { 1.f, 1.f, 1.f } },
+		{ { 20.f, 0.f }, { 1.f, 0.f, 0.f } },
+		{ { 12.f, 15.f }, { 0.f, 1.f, 0.f } },
+		{ { 0.5f, 25.f }, { 0.f, 0.f, 1.f } },
+		{ { -18.f, 9.f }, { 1.f, 1.f, 0.f } },
+		{ { -10.f, -14.f }, { 0.f, 1.f, 1.f } },
+		{ { 7.25f, -19.f }, { 1.f, 0.f, 1.f } }
+	};
+	constexpr std::size_t count = std::size( vertices );
+
+	TriangleFan const fan( vertices );
+
+	auto const instances = random_instances_( 300, 320.f, 240.f );
+
+	Surface reference( 320, 240 );
+	reference.clear();
+
+	Surface instanced( 320, 240 );
+	instanced.clear();
+
+	auto const draw_both = [&] (ScissorRect const& aRect) {
+		ScopedScissor scissor( aRect );
+		for( auto const& inst : instances )
+		{
+			auto const center = inst.transform * vertices[0].pos + inst.translation;
+			for( std::size_t i = 1; i < count; ++i )
+			{
+				auto const j = 1 + i % (count - 1);
+				draw_triangle_centers_( reference, aRect, center,
+					inst.transform * vertices[i].pos + inst.translation,
+					inst.transform * vertices[j].pos + inst.translation,
+					vertices[0].col, vertices[i].col, vertices[j].col
+				);
+			}
+		}
+
+		draw_instances( instanced, fan, instances.size(), instances.data(), EInstanceFill::shared );
+	};
+
+	SECTION( "whole surface" )
+	{
+		draw_both( { 0, 0, 320, 240 } );
+	}
+	SECTION( "with a scissor" )
+	{
+		draw_both( { 37, 21, 250, 199 } );
+	}
+
+	// Pixels differ where rounding decides: along the edges, and by a step
+	// in the colors
+	std::size_t set = 0, coverage = 0, colors = 0;
+	for( Surface::Index y = 0; y < 240; ++y )
+	{
+		for( Surface::Index x = 0; x < 320; ++x )
+		{
+			auto const* a = instanced.get_surface_ptr() + instanced.get_linear_index( x, y );
+			auto const* b = reference.get_surface_ptr() + reference.get_linear_index( x, y );
+
+			set += is_pixel_set( reference, x, y ) ? 1 : 0;
+			if( is_pixel_set( instanced, x, y ) != is_pixel_set( reference, x, y ) )
+				++coverage;
+			else if( std::abs( a[0] - b[0] ) > 1 || std::abs( a[1] - b[1] ) > 1 || std::abs( a[2] - b[2] ) > 1 )
+				++colors;
+		}
+	}
+
+	INFO( set << " set, " << coverage << " coverage, " << colors << " colors" );
+	REQUIRE( set > 10000 );
+	REQUIRE( coverage <= set / 1000 );
+	REQUIRE( colors <= set / 1000 );
+}
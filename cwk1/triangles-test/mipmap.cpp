@@ -0,0 +1,65 @@
+#include <catch2/catch_amalgamated.hpp>
+
+#include <utility>
+
+#include "../draw2d/image.hpp"
+#include "../draw2d/mipmap.hpp"
+#include "../draw2d/image_alloc.hpp"
+
+TEST_CASE( "Mip levels of odd-sized images", "[mipmap]" )
+{
+	// 5x3, opaque black, with a white last column and a red last row (the
+	// corner is white)
+	auto image = create_image( 5, 3 );
+	for( ImageRGBA::Index y = 0; y < 3; ++y )
+	{
+		for( ImageRGBA::Index x = 0; x < 5; ++x )
+		{
+			auto* texel = image->get_image_ptr() + 4 * std::size_t(image->get_linear_index( x, y ));
+			texel[0] = (4 == x || 2 == y) ? 255 : 0;
+			texel[1] = 4 == x ? 255 : 0;
+			texel[2] = 4 == x ? 255 : 0;
+			texel[3] = 255;
+		}
+	}
+
+	SECTION( "level sizes" )
+	{
+		MipChainRGBA const chain( std::move(image) );
+
+		REQUIRE( 4 == chain.level_count() );
+		REQUIRE( 3 == chain.level( 1 ).get_width() );
+		REQUIRE( 2 == chain.level( 1 ).get_height() );
+		REQUIRE( 2 == chain.level( 2 ).get_width() );
+		REQUIRE( 1 == chain.level( 2 ).get_height() );
+		REQUIRE( 1 == chain.level( 3 ).get_width() );
+		REQUIRE( 1 == chain.level( 3 ).get_height() );
+	}
+
+	SECTION( "last row and column are kept" )
+	{
+		auto const half = downsample_box_2x( *image );
+		REQUIRE( 3 == half->get_width() );
+		REQUIRE( 2 == half->get_height() );
+
+		// The last column only covers source column 4
+		auto const white = half->get_pixel( 2, 0 );
+		REQUIRE( 255 == int(white.r) );
+		REQUIRE( 255 == int(white.g) );
+		REQUIRE( 255 == int(white.b) );
+		REQUIRE( 255 == int(white.a) );
+
+		// The last row only covers source row 2
+		auto const red = half->get_pixel( 0, 1 );
+		REQUIRE( 255 == int(red.r) );
+		REQUIRE( 0 == int(red.g) );
+		REQUIRE( 0 == int(red.b) );
+
+		// Neither: black
+		auto const black = half->get_pixel( 1, 0 );
+		REQUIRE( 0 == int(black.r) );
+		REQUIRE( 0 == int(black.g) );
+		REQUIRE( 0 == int(black.b) );
+		REQUIRE( 255 == int(black.a) );
+	}
+}
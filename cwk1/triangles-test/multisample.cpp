@@ -0,0 +1,122 @@
+#include <catch2/catch_amalgamated.hpp>
+
+#include <cstdint>
+
+#include "helpers.hpp"
+
+#include "../draw2d/draw.hpp"
+#include "../draw2d/shape.hpp"
+#include "../draw2d/scissor.hpp"
+#include "../draw2d/surface.hpp"
+#include "../draw2d/multisample.hpp"
+
+namespace
+{
+	std::uint8_t red_at_( Surface const& aSurface, Surface::Index aX, Surface::Index aY )
+	{
+		return aSurface.get_surface_ptr()[aSurface.get_linear_index( aX, aY )];
+	}
+
+	// Number of white samples of a pixel, on black
+	int covered_samples_( Surface const& aSurface, Surface::Index aX, Surface::Index aY )
+	{
+		auto const coverage = linear_from_srgb( red_at_( aSurface, aX, aY ) );
+		return int(coverage * MultisampleSurface::kSamples + 0.5f);
+	}
+}
+
+TEST_CASE( "Multisampling", "[msaa]" )
+{
+	Surface surface( 64, 64 );
+	surface.clear();
+
+	MultisampleSurface multisample( 64, 64 );
+	multisample.clear();
+
+	SECTION( "coverage" )
+	{
+		// Edge through the pixel centers of column 20: half of the samples
+		// of those pixels are covered
+		multisample.triangle_solid( { 5.f, 5.f }, { 20.5f, 5.f }, { 20.5f, 60.f }, { 255, 255, 255 } );
+		multisample.resolve( surface );
+
+		REQUIRE( 2 == covered_samples_( surface, 20, 50 ) );
+		REQUIRE( 4 == covered_samples_( surface, 19, 50 ) );
+		REQUIRE( 0 == covered_samples_( surface, 21, 50 ) );
+	}
+
+	SECTION( "shared edges" )
+	{
+		// The shared edge goes through a sample of each pixel of column 20.
+		// That sample belongs to exactly one of the triangles.
+		Vec2f const a{ 10.f, 10.f }, b{ 20.375f, 10.f }, c{ 20.375f, 40.f }, d{ 30.f, 10.f };
+
+		multisample.triangle_solid( a, b, c, { 255, 255, 255 } );
+		multisample.resolve( surface );
+		auto const left = covered_samples_( surface, 20, 20 );
+
+		multisample.clear();
+		multisample.triangle_solid( b, d, c, { 255, 255, 255 } );
+		multisample.resolve( surface );
+		auto const right = covered_samples_( surface, 20, 20 );
+
+		REQUIRE( 4 == left + right );
+
+		// Drawn together, there is no seam
+		multisample.clear();
+		multisample.triangle_solid( a, b, c, { 255, 255, 255 } );
+		multisample.triangle_solid( b, d, c, { 255, 255, 255 } );
+		multisample.resolve( surface );
+
+		for( Surface::Index y = 12; y < 30; ++y )
+			REQUIRE( 255 == red_at_( surface, 20, y ) );
+	}
+
+	SECTION( "draw calls" )
+	{
+		// With a ScopedMultisample, draw_triangle_*() and shapes draw into
+		// the multisample surface, not the surface that they are given
+		TriangleFan const fan{ {
+			{ { 0.f, 0.f }, { 1.f, 1.f, 1.f } },
+			{ { 20.f, 0.f }, { 1.f, 1.f, 1.f } },
+			{ { 0.f, 20.f }, { 1.f, 1.f, 1.f } },
+			{ { -20.f, 0.f }, { 1.f, 1.f, 1.f } }
+		} };
+
+		{
+			ScopedMultisample scope( multisample );
+			fan.draw( surface, Mat22f{ 1.f, 0.f, 0.f, 1.f }, Vec2f{ 32.f, 32.f } );
+			draw_triangle_solid( surface, { 2.f, 2.f }, { 8.f, 2.f }, { 2.f, 8.f }, { 255, 255, 255 } );
+		}
+
+		for( Surface::Index y = 0; y < 64; ++y )
+		{
+			for( Surface::Index x = 0; x < 64; ++x )
+				REQUIRE( 0 == red_at_( surface, x, y ) );
+		}
+
+		multisample.resolve( surface );
+		REQUIRE( 255 == red_at_( surface, 32, 40 ) );
+		REQUIRE( 255 == red_at_( surface, 3, 3 ) );
+		REQUIRE( 0 == red_at_( surface, 32, 30 ) );
+	}
+
+	SECTION( "scissor" )
+	{
+		{
+			ScopedScissor scissor( { 10, 10, 20, 20 } );
+			multisample.triangle_solid( { -1e30f, -1e30f }, { 1e30f, 0.f }, { 0.f, 1e30f }, { 255, 255, 255 } );
+		}
+
+		multisample.resolve( surface );
+
+		for( Surface::Index y = 0; y < 64; ++y )
+		{
+			for( Surface::Index x = 0; x < 64; ++x )
+			{
+				bool const inside = x >= 10 && x < 20 && y >= 10 && y < 20;
+				REQUIRE( (inside ? 255 : 0) == red_at_( surface, x, y ) );
+			}
+		}
+	}
+}
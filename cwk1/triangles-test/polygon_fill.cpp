@@ -0,0 +1,139 @@
+#include <catch2/catch_amalgamated.hpp>
+
+#include <vector>
+
+#include "helpers.hpp"
+
+#include "../draw2d/shape.hpp"
+#include "../draw2d/surface.hpp"
+#include "../draw2d/polygon.hpp"
+
+TEST_CASE( "Polygon fill", "[polygon]" )
+{
+	Surface surface( 320, 240 );
+	surface.clear();
+
+	SECTION( "rectangle" )
+	{
+		// Pixel centers inside of [10,50) x [20,40)
+		Vec2f const rect[] = { { 10.f, 20.f }, { 50.f, 20.f }, { 50.f, 40.f }, { 10.f, 40.f } };
+		fill_polygon( surface, 4, rect, { 255, 255, 255 } );
+
+		REQUIRE( 40*20 == count_set_pixels( surface ) );
+		REQUIRE( is_pixel_set( surface, 10, 20 ) );
+		REQUIRE( is_pixel_set( surface, 49, 39 ) );
+		REQUIRE( !is_pixel_set( surface, 50, 39 ) );
+		REQUIRE( !is_pixel_set( surface, 49, 40 ) );
+	}
+
+	SECTION( "shared edge" )
+	{
+		// Two triangles that share a diagonal cover each pixel exactly once
+		Vec2f const a[] = { { 13.3f, 17.1f }, { 201.7f, 33.9f }, { 87.2f, 190.6f } };
+		Vec2f const b[] = { { 201.7f, 33.9f }, { 230.5f, 170.2f }, { 87.2f, 190.6f } };
+
+		Surface first( 320, 240 ), second( 320, 240 );
+		first.clear();
+		second.clear();
+
+		fill_polygon( first, 3, a, { 255, 255, 255 } );
+		fill_polygon( second, 3, b, { 255, 255, 255 } );
+
+		Vec2f const quad[] = { a[0], a[1], b[1], b[2] };
+		fill_polygon( surface, 4, quad, { 255, 255, 255 } );
+
+		REQUIRE( count_set_pixels( first ) + count_set_pixels( second ) == count_set_pixels( surface ) );
+	}
+
+	SECTION( "concave" )
+	{
+		// A "C" shape, opening to the right
+		Vec2f const shape[] = {
+			{ 20.f, 20.f }, { 120.f, 20.f }, { 120.f, 50.f }, { 60.f, 50.f },
+			{ 60.f, 150.f }, { 120.f, 150.f }, { 120.f, 180.f }, { 20.f, 180.f }
+		};
+		fill_polygon( surface, 8, shape, { 255, 255, 255 } );
+
+		REQUIRE( is_pixel_set( surface, 100, 30 ) ); // upper arm
+		REQUIRE( is_pixel_set( surface, 100, 170 ) ); // lower arm
+		REQUIRE( is_pixel_set( surface, 40, 100 ) ); // back
+		REQUIRE( !is_pixel_set( surface, 100, 100 ) ); // opening
+	}
+
+	SECTION( "outside" )
+	{
+		Vec2f const shape[] = { { -100.f, -50.f }, { 1000.f, -20.f }, { -40.f, 900.f } };
+		fill_polygon( surface, 3, shape, { 255, 255, 255 } );
+
+		REQUIRE( is_pixel_set( surface, 0, 0 ) );
+		REQUIRE( is_pixel_set( surface, 200, 100 ) );
+	}
+}
+
+TEST_CASE( "Polygon fill rules", "[polygon]" )
+{
+	Surface surface( 320, 240 );
+	surface.clear();
+
+	// Self-intersecting star; its center is enclosed twice
+	Vec2f const star[] = {
+		{ 160.f, 20.f }, { 220.f, 200.f }, { 60.f, 90.f }, { 260.f, 90.f }, { 100.f, 200.f }
+	};
+
+	SECTION( "even-odd" )
+	{
+		fill_polygon( surface, 5, star, { 255, 255, 255 }, EFillRule::evenOdd );
+
+		REQUIRE( !is_pixel_set( surface, 160, 120 ) );
+		REQUIRE( is_pixel_set( surface, 160, 50 ) );
+	}
+
+	SECTION( "non-zero" )
+	{
+		fill_polygon( surface, 5, star, { 255, 255, 255 }, EFillRule::nonZero );
+
+		REQUIRE( is_pixel_set( surface, 160, 120 ) );
+		REQUIRE( is_pixel_set( surface, 160, 50 ) );
+	}
+
+	SECTION( "hole" )
+	{
+		// The inner square runs the other way, and is a hole with either rule
+		Vec2f const outer[] = { { 20.f, 20.f }, { 200.f, 20.f }, { 200.f, 200.f }, { 20.f, 200.f } };
+		Vec2f const inner[] = { { 80.f, 80.f }, { 80.f, 140.f }, { 140.f, 140.f }, { 140.f, 80.f } };
+
+		PolygonFiller filler;
+		filler.add_contour( 4, outer );
+		filler.add_contour( 4, inner );
+		filler.fill( surface, { 255, 255, 255 }, EFillRule::nonZero );
+
+		REQUIRE( is_pixel_set( surface, 50, 50 ) );
+		REQUIRE( !is_pixel_set( surface, 110, 110 ) );
+	}
+}
+
+TEST_CASE( "Polygon fill from LineStrip", "[polygon]" )
+{
+	Vec2f const points[] = {
+		{ 0.f, 0.f }, { 40.f, 10.f }, { 10.f, 20.f }, { 40.f, 30.f }, { 0.f, 40.f }
+	};
+	LineStrip const strip( points );
+
+	Mat22f const transform{ 2.f, 0.5f, -0.5f, 2.f };
+	Vec2f const translation{ 100.3f, 60.7f };
+
+	// Open strips are closed by the filler
+	Surface fromStrip( 320, 240 ), fromPoints( 320, 240 );
+	fromStrip.clear();
+	fromPoints.clear();
+
+	fill_polygon( fromStrip, strip, { 255, 255, 255 }, transform, translation );
+
+	std::vector<Vec2f> transformed;
+	for( auto const& p : points )
+		transformed.emplace_back( transform * p + translation );
+	fill_polygon( fromPoints, transformed.size(), transformed.data(), { 255, 255, 255 } );
+
+	REQUIRE( count_set_pixels( fromStrip ) > 0 );
+	REQUIRE( same_pixels( fromStrip, fromPoints ) );
+}
@@ -0,0 +1,92 @@
+#include <catch2/catch_amalgamated.hpp>
+
+#include "helpers.hpp"
+
+#include "../draw2d/draw.hpp"
+#include "../draw2d/scissor.hpp"
+#include "../draw2d/surface.hpp"
+
+namespace
+{
+	void draw_scene_( Surface& aSurface )
+	{
+		draw_triangle_solid( aSurface, { -20.f, 10.f }, { 150.f, -30.f }, { 90.f, 110.f }, { 255, 128, 0 } );
+		draw_triangle_interp( aSurface, { 10.f, 90.f }, { 120.f, 40.f }, { 60.f, 5.f }, { 1.f, 0.f, 0.f }, { 0.f, 1.f, 0.f }, { 0.f, 0.f, 1.f } );
+		draw_line_solid( aSurface, { -5.f, 3.5f }, { 133.f, 97.5f }, { 255, 255, 255 } );
+	}
+}
+
+TEST_CASE( "Scissor", "[scissor]" )
+{
+	Surface surface( 128, 96 );
+	surface.clear();
+
+	SECTION( "nested scissors intersect" )
+	{
+		{
+			ScopedScissor outer( { 10, 10, 40, 40 } );
+			{
+				ScopedScissor inner( { 30, 0, 100, 20 } );
+
+				auto const* rect = current_scissor();
+				REQUIRE( rect );
+				REQUIRE( 30 == rect->minX );
+				REQUIRE( 10 == rect->minY );
+				REQUIRE( 40 == rect->maxX );
+				REQUIRE( 20 == rect->maxY );
+
+				draw_triangle_solid( surface, { -1e3f, -1e3f }, { 1e3f, -1e3f }, { 0.f, 1e3f }, { 255, 255, 255 } );
+			}
+
+			// Restored
+			REQUIRE( 10 == current_scissor()->minX );
+			REQUIRE( 40 == current_scissor()->maxY );
+		}
+
+		REQUIRE( !current_scissor() );
+
+		for( Surface::Index y = 0; y < 96; ++y )
+		{
+			for( Surface::Index x = 0; x < 128; ++x )
+			{
+				bool const inside = x >= 30 && x < 40 && y >= 10 && y < 20;
+				auto const red = surface.get_surface_ptr()[surface.get_linear_index( x, y )];
+				REQUIRE( (inside ? 255 : 0) == red );
+			}
+		}
+	}
+
+	SECTION( "disjoint nested scissors are empty" )
+	{
+		{
+			ScopedScissor outer( { 0, 0, 20, 20 } );
+			ScopedScissor inner( { 50, 50, 60, 60 } );
+
+			auto const* rect = current_scissor();
+			REQUIRE( rect->minX == rect->maxX );
+			REQUIRE( rect->minY == rect->maxY );
+
+			draw_triangle_solid( surface, { -1e3f, -1e3f }, { 1e3f, -1e3f }, { 0.f, 1e3f }, { 255, 255, 255 } );
+		}
+
+		Surface black( 128, 96 );
+		black.clear();
+		REQUIRE( same_pixels( surface, black ) );
+	}
+
+	SECTION( "bands equal drawing directly" )
+	{
+		Surface direct( 128, 96 );
+		direct.clear();
+		draw_scene_( direct );
+
+		// Uneven band heights, so that band edges fall inside of shapes
+		for( std::uint32_t y = 0; y < 96; y += 13 )
+		{
+			ScopedScissor band( { 0, y, 128, y+13 < 96 ? y+13 : 96 } );
+			draw_scene_( surface );
+		}
+
+		REQUIRE( same_pixels( surface, direct ) );
+	}
+}
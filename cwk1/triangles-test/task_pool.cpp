@@ -0,0 +1,119 @@
+#include <catch2/catch_amalgamated.hpp>
+
+#include <atomic>
+#include <vector>
+#include <stdexcept>
+
+#include "helpers.hpp"
+
+#include "../draw2d/draw.hpp"
+#include "../draw2d/scissor.hpp"
+#include "../draw2d/surface.hpp"
+
+#include "../support/task_pool.hpp"
+
+TEST_CASE( "Task pool", "[taskpool]" )
+{
+	TaskPool pool( 4 );
+	REQUIRE( 4 == pool.thread_count() );
+
+	SECTION( "parallel_for covers each index once" )
+	{
+		std::vector<std::atomic<int>> hits( 1000 );
+		for( auto& hit : hits )
+			hit = 0;
+
+		pool.parallel_for( "test", 0, hits.size(), 7, [&] ( std::size_t aBegin, std::size_t aEnd ) {
+			for( auto i = aBegin; i < aEnd; ++i )
+				++hits[i];
+		} );
+
+		for( auto const& hit : hits )
+			REQUIRE( 1 == hit.load() );
+	}
+
+	SECTION( "tasks of a group" )
+	{
+		std::atomic<int> sum{ 0 };
+
+		TaskGroup group;
+		for( int i = 1; i <= 100; ++i )
+			pool.run( group, "test", [&sum,i] { sum += i; } );
+		pool.wait( group );
+
+		REQUIRE( 5050 == sum.load() );
+	}
+
+	SECTION( "exceptions are rethrown" )
+	{
+		TaskGroup group;
+		pool.run( group, "test", [] { throw std::runtime_error( "task" ); } );
+		pool.run( group, "test", [] {} );
+		REQUIRE_THROWS_AS( pool.wait( group ), std::runtime_error );
+
+		// The pool still works afterwards
+		std::atomic<int> count{ 0 };
+		pool.parallel_for( "test", 0, 64, 1, [&] ( std::size_t, std::size_t ) { ++count; } );
+		REQUIRE( 64 == count.load() );
+	}
+
+	SECTION( "graph dependencies" )
+	{
+		// a -> b, a -> c, (b, c) -> d
+		std::atomic<int> step{ 0 };
+		int a = -1, b = -1, c = -1, d = -1;
+
+		TaskGraph graph;
+		auto const na = graph.add( "a", [&] { a = step++; } );
+		auto const nb = graph.add( "b", [&] { b = step++; }, { na } );
+		auto const nc = graph.add( "c", [&] { c = step++; }, { na } );
+		graph.add( "d", [&] { d = step++; }, { nb, nc } );
+		REQUIRE( 4 == graph.size() );
+
+		// Graphs can be run repeatedly
+		for( int run = 0; run < 3; ++run )
+		{
+			step = 0;
+			graph.run( pool );
+
+			REQUIRE( 0 == a );
+			REQUIRE( (b == 1 || b == 2) );
+			REQUIRE( (c == 1 || c == 2) );
+			REQUIRE( 3 == d );
+		}
+	}
+
+	SECTION( "graph skips nodes after a failure" )
+	{
+		bool ranAfter = false;
+
+		TaskGraph graph;
+		auto const first = graph.add( "fail", [] { throw std::runtime_error( "node" ); } );
+		graph.add( "after", [&] { ranAfter = true; }, { first } );
+
+		REQUIRE_THROWS_AS( graph.run( pool ), std::runtime_error );
+		REQUIRE( !ranAfter );
+	}
+
+	SECTION( "banded drawing equals drawing directly" )
+	{
+		auto const draw = [] ( Surface& aSurface ) {
+			draw_triangle_solid( aSurface, { -20.f, 10.f }, { 150.f, -30.f }, { 90.f, 110.f }, { 255, 128, 0 } );
+			draw_triangle_interp( aSurface, { 10.f, 90.f }, { 120.f, 40.f }, { 60.f, 5.f }, { 1.f, 0.f, 0.f }, { 0.f, 1.f, 0.f }, { 0.f, 0.f, 1.f } );
+			draw_line_solid( aSurface, { -5.f, 3.5f }, { 133.f, 97.5f }, { 255, 255, 255 } );
+		};
+
+		Surface direct( 128, 96 );
+		direct.clear();
+		draw( direct );
+
+		Surface banded( 128, 96 );
+		banded.clear();
+		pool.parallel_for( "bands", 0, 96, 5, [&] ( std::size_t aBegin, std::size_t aEnd ) {
+			ScopedScissor band( { 0, std::uint32_t(aBegin), 128, std::uint32_t(aEnd) } );
+			draw( banded );
+		} );
+
+		REQUIRE( same_pixels( banded, direct ) );
+	}
+}
@@ -0,0 +1,108 @@
+#include <catch2/catch_amalgamated.hpp>
+
+#include <string_view>
+
+#include <cstdint>
+
+#include "helpers.hpp"
+
+#include "../draw2d/blit.hpp"
+#include "../draw2d/text.hpp"
+#include "../draw2d/surface.hpp"
+
+namespace
+{
+	// Reference: each glyph's atlas cell drawn with blit_masked(), laid out
+	// independently of TextRun
+	void blit_text_( Surface& aSurface, BitmapFont const& aFont, std::string_view aText, float aLeft, float aTop )
+	{
+		auto x = aLeft;
+		auto y = aTop - float(aFont.glyph_height());
+		for( auto const ch : aText )
+		{
+			if( '\n' == ch )
+			{
+				x = aLeft;
+				y -= float(aFont.line_height());
+				continue;
+			}
+
+			blit_masked( aSurface, aFont.glyph( aFont.glyph_index( ch ) ), { x, y } );
+			x += float(aFont.advance());
+		}
+	}
+}
+
+TEST_CASE( "Text matches blitting the glyphs", "[text]" )
+{
+	auto const scale = GENERATE( 1u, 2u );
+	BitmapFont const font( { 255, 200, 0 }, scale );
+
+	// Mixed case, unknown characters (drawn as '?') and several lines
+	constexpr std::string_view text = "Hello, World!\n0123 {~} 456789\nxyz_|%";
+
+	Surface surface( 96, 64 );
+	surface.clear();
+
+	Surface blitted( 96, 64 );
+	blitted.clear();
+
+	TextRun run;
+	run.set( font, text );
+
+	SECTION( "inside" )
+	{
+		run.draw( surface, { 2.f, 60.f } );
+		blit_text_( blitted, font, text, 2.f, 60.f );
+
+		REQUIRE( count_set_pixels( surface ) > 0 );
+	}
+
+	// Glyphs that straddle an edge are clipped to the surface, and glyphs
+	// that are entirely outside of it are skipped
+	SECTION( "clipped left" )
+	{
+		run.draw( surface, { -9.f, 40.f } );
+		blit_text_( blitted, font, text, -9.f, 40.f );
+	}
+	SECTION( "clipped right" )
+	{
+		run.draw( surface, { 70.f, 40.f } );
+		blit_text_( blitted, font, text, 70.f, 40.f );
+	}
+	SECTION( "clipped bottom" )
+	{
+		run.draw( surface, { 5.f, 11.f } );
+		blit_text_( blitted, font, text, 5.f, 11.f );
+	}
+	SECTION( "clipped top" )
+	{
+		run.draw( surface, { 5.f, 68.f } );
+		blit_text_( blitted, font, text, 5.f, 68.f );
+	}
+	SECTION( "clipped at all edges" )
+	{
+		Surface small( 20, 10 );
+		small.clear();
+
+		Surface smallBlitted( 20, 10 );
+		smallBlitted.clear();
+
+		run.draw( small, { -3.f, 13.f } );
+		blit_text_( smallBlitted, font, text, -3.f, 13.f );
+
+		REQUIRE( count_set_pixels( small ) > 0 );
+		REQUIRE( same_pixels( small, smallBlitted ) );
+	}
+	SECTION( "entirely outside" )
+	{
+		run.draw( surface, { 100.f, 40.f } );
+		run.draw( surface, { -400.f, 40.f } );
+		run.draw( surface, { 5.f, -1.f } );
+		run.draw( surface, { 5.f, 200.f } );
+
+		REQUIRE( 0 == count_set_pixels( surface ) );
+	}
+
+	REQUIRE( same_pixels( surface, blitted ) );
+}